@@ -82,7 +82,7 @@ def schedule(sch, target = 'cuda'):
 sys.meta_path.insert(0, AKGMetaPathFinder())
 
 from . import autodiff
-from .build_module import build, build_to_func, lower, build_config
+from .build_module import build, build_to_func, build_multi_version, lower, build_config
 from .autodiff import differentiate
 from .autodiff import get_variables
 from .autodiff import register_variables
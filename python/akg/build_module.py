@@ -163,3 +163,21 @@ def build(inputs, args, target='cce', shape_params=None, name="default_function"
                             attrs=attrs, polyhedral=polyhedral, target=target)
 
     return _api_internal._BuildToModule(tmp_rst, target)
+
+
+@vc_util.check_input_type((list, tuple), (list, tuple), (list, tuple), str, str)
+def build_multi_version(variants, dims, keys, name, target="llvm"):
+    """
+    Build the variants of a kernel into one module, whose function name calls the variant of the runtime shape.
+
+    Args:
+        variants (Union[list, tuple]): build_to_func results specialized to each of keys, then the generic one.
+        dims (Union[list, tuple]): [arg index, dim index] of the tensor arguments for each value of a key.
+        keys (Union[list, tuple]): the values of dims each specialized variant is built for.
+        name (str): name of the dispatcher, the entry of the module.
+        target (str): llvm only.
+
+    Returns:
+        Module.
+    """
+    return _api_internal._BuildMultiVersionModule(variants, dims, keys, name, target)
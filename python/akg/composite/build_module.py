@@ -182,13 +182,18 @@ def _set_attrs(desc_d, attrs, poly):
 
 
 def _get_online_tune_attr(desc_s, attrs, repo_path, use_new_space=True):
-    try:
-        import auto_tune
-    except ImportError:
-        raise ImportError("Import auto_tune fail, please install auto_tune using pip")
-
     desc_d = json.loads(desc_s)
-    if "buffer_stitch" in desc_d:
+    if desc_d["process"] != "cpu":
+        try:
+            import auto_tune
+        except ImportError:
+            raise ImportError("Import auto_tune fail, please install auto_tune using pip")
+
+    if desc_d["process"] == "cpu":
+        # Cpu kernels are tuned natively on this machine.
+        from .tune_cpu import tune_cpu
+        best_config = tune_cpu(desc_s, attrs, repo_path, trials=64 * max(int(attrs["online_tuning"]), 1))
+    elif "buffer_stitch" in desc_d:
         best_config = auto_tune.tune_stitch_segment(desc_s,
                                                     repo_path=repo_path)
     elif use_new_space:
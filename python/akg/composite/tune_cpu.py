@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+# coding: utf-8
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Offline tiling tuner of cpu composite kernels, the best dims go to repository_cpu.json"""
+import os
+import json
+import time
+import random
+import logging
+import tempfile
+import numpy as np
+from akg import tvm
+from akg.utils.kernel_exec import ReturnType
+from .build_module import build, generate_trait, get_tiling_space, get_repository_file_path, read_repo_file
+
+# Build attrs of online tuning, they must not reach the builds of the tuner.
+TUNING_KEYS = ["online_tuning", "help_tiling", "tuning", "use_new_space"]
+
+
+class CpuTuner:
+    """
+    Evolutionary search over the tiling space that poly enumerates for a cpu kernel. A config is the c1 tile of each
+    axis, children come from uniform crossover and mutation of the faster configs and have to be in the space. Each
+    config is built, checked against the expect and timed on this machine, until the trials or the seconds run out.
+
+    With a cost model, the tuner lowers pool_size configs of the space instead, ranks them by the model and only
+    measures the top trials of them. The features and run times of the measured configs are kept in records, to train
+    the model with, also without a model when record is set.
+    """
+
+    def __init__(self, desc_s, attrs=None, trials=64, time_limit=600, population=8, number=10, repeat=5, seed=0,
+                 cost_model=None, pool_size=1024, record=False):
+        self.desc_s = desc_s
+        self.attrs = {k: v for k, v in (attrs or {}).items() if k not in TUNING_KEYS}
+        self.trials = trials
+        self.time_limit = time_limit
+        self.population = population
+        self.number = number
+        self.repeat = repeat
+        self.rand = random.Random(seed)
+        self.costs = {}
+        self.baseline = None
+        self.cost_model = cost_model
+        self.pool_size = pool_size
+        self.record = record or cost_model is not None
+        self.records = []
+        self._inputs = None
+
+    def _space(self):
+        spaces = get_tiling_space(self.desc_s, level=2, attr=dict(self.attrs))
+        self.index = spaces["index"]
+        space = [tuple(c) for c in spaces.get("tuning_space", [])]
+        self.space = set(space)
+        # The tiles each axis takes in the space, for mutation.
+        self.axis_tiles = [sorted(set(c[i] for c in space)) for i in range(len(self.index))]
+        return space
+
+    def to_dim(self, config):
+        return " ".join("{} {} {} {}".format(b, a, t, t) for (b, a), t in zip(self.index, config))
+
+    def _measure(self, attrs):
+        """Seconds of one run of the kernel built with attrs, None when it fails or is wrong."""
+        from akg.utils.op_test import gen_json_data
+        from akg.utils.result_analysis import get_compare_tolerance
+        try:
+            mod = build(self.desc_s, dict(attrs))
+        except Exception as e:  # pylint: disable=broad-except
+            logging.info("Build failed with %s: %s", attrs, e)
+            return None
+        if self._inputs is None:
+            self._inputs = gen_json_data(self.desc_s)
+        input_for_mod, expect, output_indexes = self._inputs
+        expect = expect if isinstance(expect, (list, tuple)) else [expect]
+        ctx = tvm.cpu(0)
+        args = [tvm.nd.array(a, ctx) for a in input_for_mod]
+        mod(*args)
+        outputs = [args[len(args) + i if i < 0 else i].asnumpy() for i in output_indexes]
+        for output, exp, tol in zip(outputs, expect, get_compare_tolerance(self.desc_s, output_indexes)):
+            if not np.allclose(output, exp, rtol=tol, atol=tol, equal_nan=True):
+                logging.info("Wrong result with %s", attrs)
+                return None
+        ftimer = mod.time_evaluator(mod.entry_name, ctx, number=self.number, repeat=self.repeat)
+        return min(ftimer(*args).results)
+
+    def _feature(self, config):
+        """Features of the stmt lowered with config, None when it fails to lower."""
+        try:
+            return build(self.desc_s, dict(self.attrs, dim=self.to_dim(config), ret_mode=ReturnType.FEAT))
+        except Exception as e:  # pylint: disable=broad-except
+            logging.info("Lower failed with dim [%s]: %s", self.to_dim(config), e)
+            return None
+
+    def _measure_config(self, config, feature=None):
+        if config not in self.costs:
+            cost = self._measure(dict(self.attrs, dim=self.to_dim(config)))
+            self.costs[config] = float("inf") if cost is None else cost
+            logging.info("Trial %d: dim [%s] %s s", len(self.costs), self.to_dim(config), self.costs[config])
+            if self.record and feature is None and cost is not None:
+                feature = self._feature(config)
+            if feature is not None and cost is not None:
+                self.records.append((json.loads(self.desc_s)["op"], feature, cost))
+        return self.costs[config]
+
+    def _search_by_model(self, space, trials, start):
+        pool = self.rand.sample(space, min(self.pool_size, len(space)))
+        features = [self._feature(c) for c in pool]
+        lowered = [i for i, f in enumerate(features) if f is not None]
+        order = self.cost_model.rank([features[i] for i in lowered])
+        for i in order[:trials]:
+            if time.time() - start >= self.time_limit:
+                break
+            self._measure_config(pool[lowered[i]], features[lowered[i]])
+
+    def _child(self, space):
+        """A config of the space not measured yet, bred from two of the fastest ones when possible."""
+        ranked = sorted((c for c in self.costs if self.costs[c] != float("inf")), key=self.costs.get)
+        parents = ranked[:self.population]
+        for _ in range(32):
+            if len(parents) < 2:
+                break
+            a, b = self.rand.sample(parents, 2)
+            child = [self.rand.choice(pair) for pair in zip(a, b)]
+            for i, tiles in enumerate(self.axis_tiles):
+                if self.rand.random() < 1.0 / len(child):
+                    child[i] = self.rand.choice(tiles)
+            child = tuple(child)
+            if child in self.space and child not in self.costs:
+                return child
+        unmeasured = [c for c in space if c not in self.costs]
+        return self.rand.choice(unmeasured) if unmeasured else None
+
+    def tune(self):
+        """The best attrs found, None when no config beats the auto tiling."""
+        start = time.time()
+        self.baseline = self._measure(self.attrs)
+        logging.info("Auto tiling: %s s", self.baseline)
+        space = self._space()
+        if not space:
+            logging.info("Empty tiling space, nothing to tune")
+            return None
+        trials = min(self.trials, len(space))
+        if self.cost_model is not None:
+            self._search_by_model(space, trials, start)
+        else:
+            for config in self.rand.sample(space, min(self.population, trials)):
+                self._measure_config(config)
+            while len(self.costs) < trials and time.time() - start < self.time_limit:
+                config = self._child(space)
+                if config is None:
+                    break
+                self._measure_config(config)
+        if not self.costs:
+            return None
+        best = min(self.costs, key=self.costs.get)
+        if self.costs[best] == float("inf") or (self.baseline is not None and self.costs[best] >= self.baseline):
+            return None
+        logging.info("Best dim [%s]: %s s, auto tiling %s s", self.to_dim(best), self.costs[best], self.baseline)
+        return {"dim": self.to_dim(best)}
+
+
+def update_repository(repo_path, desc_s, attrs):
+    """Write attrs of the kernel into the repository, keyed by compute, shape and dtype like the build looks up."""
+    desc_d = json.loads(desc_s)
+    compute, shape, dtype = generate_trait(desc_d)
+    if any(op["name"] == "BatchMatMul" for op in desc_d["op_desc"]):
+        shape = "any_shape"
+    repo = read_repo_file(repo_path)
+    repo.setdefault(compute, {}).setdefault(shape, {})[dtype] = attrs
+    fd, tmp_path = tempfile.mkstemp(dir=os.path.dirname(os.path.abspath(repo_path)), suffix=".json")
+    with os.fdopen(fd, "w") as f:
+        f.write(json.dumps(repo, sort_keys=True, indent=4))
+    os.chmod(tmp_path, os.stat(repo_path).st_mode if os.path.exists(repo_path) else 0o644)
+    os.replace(tmp_path, repo_path)
+
+
+def tune_cpu(desc_s, attrs=None, repo_path=None, **kwargs):
+    """
+    Tune the tiling of a cpu composite kernel and store it in the cpu repository.
+
+    Args:
+       desc_s    : str of compute description
+       attrs     : dict of build attributes kept in every trial
+       repo_path : repository to update, MS_GRAPH_KERNEL_TILING or repository_cpu.json by default
+       kwargs    : budget and search options of CpuTuner
+
+    Returns:
+       dict of the best attrs, empty when the auto tiling stays the best.
+    """
+    best = CpuTuner(desc_s, attrs, **kwargs).tune()
+    if not best:
+        return {}
+    if repo_path is None:
+        repo_path = os.getenv("MS_GRAPH_KERNEL_TILING") or get_repository_file_path("repository_cpu.json")
+    update_repository(repo_path, desc_s, best)
+    return best
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+# coding: utf-8
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+cost model that ranks tiling candidates by the features of their lowered stmts, without running them
+"""
+import json
+import random
+import numpy as np
+
+import akg.tvm
+
+
+def kernel_feature(stmt_features):
+    """
+    Fixed length feature of a kernel from the per store rows that get_features_from_stmts returns: the rows summed in
+    linear scale, their max and the number of rows.
+    """
+    rows = np.asarray(stmt_features, dtype="float32")
+    rows = rows.reshape(-1, rows.shape[-1])
+    total = np.log2(1 + np.sum(np.exp2(rows) - 1, axis=0))
+    return np.concatenate([total, rows.max(axis=0), [np.log2(1 + len(rows))]]).astype("float32")
+
+
+class CostModel:
+    """Gradient boosted trees in akg that predict the log of the run time of a kernel from its features."""
+
+    def __init__(self, num_trees=200, max_depth=6, min_leaf=2, learning_rate=0.1, model=None):
+        if model is None:
+            model = akg.tvm.get_global_func("akg_cost_model_create")(num_trees, max_depth, min_leaf, learning_rate)
+        self.model = model
+
+    def fit(self, features, costs):
+        x = np.stack([kernel_feature(f) for f in features])
+        y = np.log(np.asarray(costs, dtype="float64")).astype("float32")
+        akg.tvm.get_global_func("akg_cost_model_train")(self.model, akg.tvm.nd.array(x), akg.tvm.nd.array(y))
+        return self
+
+    def predict(self, features):
+        """Predicted seconds of each kernel."""
+        if not features:
+            return np.zeros(0)
+        x = np.stack([kernel_feature(f) for f in features])
+        return np.exp(akg.tvm.get_global_func("akg_cost_model_predict")(self.model, akg.tvm.nd.array(x)).asnumpy())
+
+    def rank(self, features, top_k=None):
+        """Indexes of the kernels from the fastest predicted."""
+        order = np.argsort(self.predict(features), kind="stable").tolist()
+        return order if top_k is None else order[:top_k]
+
+    def save(self, path):
+        with open(path, "w") as f:
+            f.write(akg.tvm.get_global_func("akg_cost_model_save")(self.model))
+
+    @classmethod
+    def load(cls, path):
+        with open(path, "r") as f:
+            return cls(model=akg.tvm.get_global_func("akg_cost_model_load")(f.read()))
+
+
+def save_records(path, records):
+    """Append (kernel, features, seconds) records as json lines."""
+    with open(path, "a") as f:
+        for kernel, features, cost in records:
+            f.write(json.dumps({"kernel": kernel, "features": np.asarray(features).tolist(), "cost": cost}) + "\n")
+
+
+def load_records(path):
+    with open(path, "r") as f:
+        return [(r["kernel"], np.asarray(r["features"], dtype="float32"), r["cost"])
+                for r in map(json.loads, f) if np.isfinite(r["cost"])]
+
+
+def split_records(records, held_out=0.2, seed=0):
+    """Split the records by kernel, so the held out kernels are never seen in training."""
+    kernels = sorted(set(r[0] for r in records))
+    random.Random(seed).shuffle(kernels)
+    test = set(kernels[:max(1, int(len(kernels) * held_out))]) if len(kernels) > 1 else set()
+    return [r for r in records if r[0] not in test], [r for r in records if r[0] in test]
+
+
+def evaluate(model, records, top_k=8):
+    """
+    Accuracy of the model on records, per kernel and averaged over kernels.
+
+    Returns:
+       dict of rmse of the log run time, pairwise ranking accuracy, recall of the best config in the top_k predicted,
+       and regret, the run time of the best predicted config over the best run time.
+    """
+    by_kernel = {}
+    for kernel, features, cost in records:
+        by_kernel.setdefault(kernel, []).append((features, cost))
+    errors, pairs, recalls, regrets = [], [], [], []
+    for kernel_records in by_kernel.values():
+        costs = np.array([c for _, c in kernel_records])
+        predicted = model.predict([f for f, _ in kernel_records])
+        errors.extend(np.log(predicted) - np.log(costs))
+        if len(costs) < 2:
+            continue
+        i, j = np.triu_indices(len(costs), 1)
+        differ = costs[i] != costs[j]
+        if differ.any():
+            pairs.append(np.mean((costs[i] < costs[j])[differ] == (predicted[i] < predicted[j])[differ]))
+        order = np.argsort(predicted, kind="stable")
+        recalls.append(float(np.argmin(costs) in order[:top_k]))
+        regrets.append(costs[order[0]] / costs.min())
+
+    def mean(values):
+        return float(np.mean(values)) if len(values) else float("nan")
+    return {"kernels": len(by_kernel), "records": len(records), "rmse_log": float(np.sqrt(mean(np.square(errors)))),
+            "pairwise_accuracy": mean(pairs), "top%d_recall" % top_k: mean(recalls), "regret": mean(regrets)}
@@ -15,6 +15,7 @@
 # limitations under the License.
 
 """dynamic shape function"""
+from collections import Counter
 import akg
 import akg.tvm
 from akg.utils.format_transform import get_shape
@@ -122,3 +123,27 @@ def create_dynamic_shape_node(tensor_name, pos, dyn_shape_limit=-1, poly_upper_b
                              pos=pos,
                              dyn_shape_limit=dyn_shape_limit,
                              poly_upper_bound=poly_upper_bound)
+
+
+def shape_buckets_from_trace(trace, max_buckets=8, coverage=0.9):
+    """
+    Pick the shapes worth a specialized kernel from the shapes seen at runtime, see op_build_multi_version.
+
+    Args:
+        trace (iterable): the values of the dynamic dims of each call, an integer or a tuple of integers.
+        max_buckets (int): the most buckets returned.
+        coverage (float): stop once the buckets cover this fraction of the calls.
+
+    Returns:
+        list of tuple, the most frequent shape first.
+    """
+    counts = Counter(tuple(to_expanded_list(key)) for key in trace)
+    total = sum(counts.values())
+    buckets = []
+    covered = 0
+    for key, count in sorted(counts.items(), key=lambda item: (-item[1], item[0])):
+        if len(buckets) >= max_buckets or covered >= coverage * total:
+            break
+        buckets.append(key)
+        covered += count
+    return buckets
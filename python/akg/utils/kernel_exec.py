@@ -84,6 +84,7 @@ class ReturnType(IntEnum):
     FEAT = 1
     MOD = 2
     MOD_AND_FEAT = 3
+    FUNC = 4
 
 
 def debug_mode(debug_flag):
@@ -1159,6 +1160,9 @@ def op_build(op_func, input_shapes, input_types, op_attrs=None, kernel_name="",
                               dump_code, tuning)
     elif target_name == LLVM:
         with akg.build_config(dump_pass_ir=dump_ir, unroll_explicit=True):
+            if ret_mode == ReturnType.FUNC:
+                return akg.build_to_func(s, op_var, shape_var, name=kernel_name, attrs=attrs,
+                                         polyhedral=polyhedral, binds=binds, target=target)
             mod = akg.build(s, op_var, target, shape_var, name=kernel_name, attrs=attrs,
                             polyhedral=polyhedral, binds=binds)
             source_code = mod.get_source()
@@ -1176,6 +1180,71 @@ def op_build(op_func, input_shapes, input_types, op_attrs=None, kernel_name="",
     return mod
 
 
+def op_build_multi_version(op_func, input_shapes, input_types, buckets, op_attrs=None, kernel_name="",
+                           attrs=None, dump_ir=True, polyhedral=True):
+    """
+    Return a cpu module of op_func with a kernel specialized to each shape bucket and the generic kernel of the dynamic
+    shape. Calling the module runs the kernel whose bucket equals the sizes of the dynamic dims, the generic one when
+    none does. The kernels are called through the packed function of the module only.
+
+    Args:
+        op_func (function returning an op or (op, [op_vars])): The op build function.
+        input_shapes (iterable of iterable of int): the dim sizes for input for op, akg.tvm.var for the dynamic dims.
+        input_types (iterable of iterable of str): the dtypes for each input.
+        buckets (iterable): the values of the shape vars, in the order they first appear in input_shapes, of each
+            specialized kernel, e.g. from akg.utils.dynamic_shape.shape_buckets_from_trace.
+        op_attrs (list or tuple): extra attributes for the op.
+        kernel_name (str): name of op.
+        attrs (dict): attrs of the generic kernel, those of the specialized ones drop the dynamic shape attrs.
+        dump_ir (bool): True by default.
+        polyhedral (bool): True by default.
+
+    Return:
+        module.
+    """
+    shape_vars = []
+    dims = []
+    arg = 0
+    for shape in input_shapes:
+        for tensor_shape in (shape if shape and isinstance(shape[0], (list, tuple)) else [shape]):
+            if not isinstance(tensor_shape, (list, tuple)):
+                raise TypeError("Shapes of a multi-version kernel should be lists or tuples")
+            for i, dim in enumerate(tensor_shape):
+                if isinstance(dim, akg.tvm.expr.Var) and not any(dim.same_as(var) for var in shape_vars):
+                    shape_vars.append(dim)
+                    dims.append([arg, i])
+            arg += 1
+    if not shape_vars:
+        raise ValueError("Shapes of a multi-version kernel should have dynamic dims")
+
+    def _specialize(shape, key):
+        if isinstance(shape, (list, tuple)):
+            return [_specialize(dim, key) for dim in shape]
+        for var, value in zip(shape_vars, key):
+            if isinstance(shape, akg.tvm.expr.Var) and shape.same_as(var):
+                return value
+        return shape
+
+    kernel_name = kernel_name if kernel_name else op_func.__name__
+    attrs = dict(attrs) if attrs else {}
+    attrs.setdefault("target", LLVM)
+    static_attrs = {k: v for k, v in attrs.items()
+                    if k not in ("dynamic", "partial_dynamic", "dynamic_shape", "dynamic_shape_bound")}
+    keys = []
+    funcs = []
+    for i, bucket in enumerate(buckets):
+        key = [int(v) for v in (bucket if isinstance(bucket, (list, tuple)) else [bucket])]
+        if len(key) != len(shape_vars):
+            raise ValueError("Bucket %s should give the %d shape vars %s" % (str(bucket), len(shape_vars), shape_vars))
+        keys.append(key)
+        funcs.append(op_build(op_func, _specialize(input_shapes, key), input_types, op_attrs,
+                              "%s_b%d" % (kernel_name, i), dict(static_attrs), dump_ir=dump_ir, dump_code=False,
+                              polyhedral=polyhedral, ret_mode=ReturnType.FUNC))
+    funcs.append(op_build(op_func, input_shapes, input_types, op_attrs, kernel_name + "_dynamic", attrs,
+                          dump_ir=dump_ir, dump_code=False, polyhedral=polyhedral, ret_mode=ReturnType.FUNC))
+    return akg.build_multi_version(funcs, dims, keys, kernel_name, attrs["target"])
+
+
 def get_runtime_mode():
     """get runtime mode."""
     env_dic = os.environ
@@ -144,5 +144,8 @@ REGISTER_PASS(TileCoverCorrect);
 REGISTER_PASS(ReconstructLayout);
 REGISTER_PASS(GemmFactor);
 REGISTER_PASS(ReductionFactor);
+REGISTER_PASS(CpuStoragePlan);
+REGISTER_PASS(ScheduleCsrLoop);
+REGISTER_PASS(ScheduleTotLoop);
 }  // namespace ir
 }  // namespace akg
@@ -0,0 +1,54 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include "common/cost_model.h"
+
+namespace akg {
+namespace ir {
+namespace poly {
+
+using namespace air;
+// Store features of the stmts in the packed format of python/akg/utils/auto_tuning.py, the auto tune lib replaces it
+// with its own features. Buffers are not cached or dumped.
+TVM_REGISTER_GLOBAL("get_features_from_stmts").set_body([](TVMArgs args, TVMRetValue *ret) {
+  Array<Stmt> stmts = args[1];
+  std::vector<float> features;
+  std::vector<int> sizes;
+  for (const auto &stmt : stmts) {
+    auto rows = ExtractStoreFeatures(stmt);
+    // A zero row for a stmt without stores, which keeps the length of the rows.
+    if (rows.empty()) {
+      rows.emplace_back(kStoreFeatureLen, 0.0f);
+    }
+    features.push_back(static_cast<float>(rows.size()));
+    for (const auto &row : rows) {
+      features.insert(features.end(), row.begin(), row.end());
+    }
+    sizes.push_back(static_cast<int>(1 + rows.size() * kStoreFeatureLen));
+  }
+  // No throughputs.
+  sizes.push_back(0);
+  int n = static_cast<int>(stmts.size());
+  std::string packed(sizeof(int) * (1 + sizes.size()) + sizeof(float) * features.size(), '\0');
+  std::memcpy(&packed[0], &n, sizeof(int));
+  std::memcpy(&packed[sizeof(int)], sizes.data(), sizeof(int) * sizes.size());
+  std::memcpy(&packed[sizeof(int) * (1 + sizes.size())], features.data(), sizeof(float) * features.size());
+  *ret = TVMByteArray{packed.data(), packed.size()};
+});
+}  // namespace poly
+}  // namespace ir
+}  // namespace akg
@@ -17,9 +17,14 @@
 #include <tvm/node/serialization.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
 #include <iostream>
+#include <map>
 #include <numeric>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -30,13 +35,133 @@
 #include "codegen/lower.h"
 #include "ir_pass.h"
 #include "schedule_pass.h"
+#include "codegen/compile_profiler.h"
+#include "common/common_util.h"
+#include "common/target_info.h"
 #include "codegen/pass_mgr.h"
 #include "composite/utils/util.h"
 
 namespace akg {
-AttrMap g_attrs;
-Array<NodeRef> g_external_call_name;
-CsrMap g_csr;
+thread_local AttrMap g_attrs;
+thread_local Array<NodeRef> g_external_call_name;
+thread_local CsrMap g_csr;
+thread_local std::unordered_map<std::string, size_t> g_compile_counters;
+thread_local DebugHooks g_debug_hooks = DebugHooks::FromEnv();
+thread_local std::shared_ptr<std::atomic<bool>> g_poly_fallback = CompileContext().poly_fallback;
+
+DebugHooks DebugHooks::FromEnv() {
+  DebugHooks hooks;
+  const char *dump_c_pass = getenv("DUMP_C_PASS");
+  if (dump_c_pass != nullptr) {
+    hooks.dump_c_pass_ids = common::Split(std::string(dump_c_pass), ",");
+    hooks.dump_c_pass_names.insert(hooks.dump_c_pass_ids.begin(), hooks.dump_c_pass_ids.end());
+  }
+  const char *replace_schedule = getenv("AKG_REPLACE_POLY_SCHEDULE");
+  hooks.replace_poly_schedule = replace_schedule == nullptr || std::string(replace_schedule) != "0";
+  return hooks;
+}
+
+const DebugHooks &DebugHooks::Current() { return g_debug_hooks; }
+
+CompileContext CompileContext::Current() {
+  CompileContext context;
+  context.attrs = g_attrs;
+  context.csr = g_csr;
+  context.external_call_name = g_external_call_name;
+  context.counters = g_compile_counters;
+  context.debug_hooks = g_debug_hooks;
+  context.poly_fallback = g_poly_fallback;
+  return context;
+}
+
+CompileScope::CompileScope(const CompileContext &context) : saved_(CompileContext::Current()) {
+  g_attrs = context.attrs;
+  g_csr = context.csr;
+  g_external_call_name = context.external_call_name;
+  g_compile_counters = context.counters;
+  g_debug_hooks = context.debug_hooks;
+  g_poly_fallback = context.poly_fallback;
+}
+
+CompileScope::~CompileScope() {
+  g_attrs = saved_.attrs;
+  g_csr = saved_.csr;
+  g_external_call_name = saved_.external_call_name;
+  g_compile_counters = saved_.counters;
+  g_debug_hooks = saved_.debug_hooks;
+  g_poly_fallback = saved_.poly_fallback;
+}
+
+size_t NextCompileId(const std::string &key) { return g_compile_counters[key]++; }
+
+void SetPolyFallback() { *g_poly_fallback = true; }
+
+bool PolyFellBack() { return *g_poly_fallback; }
+
+namespace {
+thread_local bool g_in_parallel_compile = false;
+
+size_t CompileThreadNum(size_t task_num) {
+  size_t thread_num = std::thread::hardware_concurrency();
+  const char *env = getenv("AKG_COMPILE_THREADS");
+  if (env != nullptr) {
+    thread_num = static_cast<size_t>(std::max(atoi(env), 1));
+  }
+  return std::max(std::min(thread_num, task_num), static_cast<size_t>(1));
+}
+}  // namespace
+
+void ParallelCompile(size_t task_num, const std::function<void(size_t)> &task) {
+  const CompileContext context = CompileContext::Current();
+  std::vector<std::exception_ptr> errors(task_num);
+  std::vector<std::unordered_map<std::string, size_t>> task_counters(task_num);
+  auto run_task = [&context, &task, &errors, &task_counters](size_t idx) {
+    try {
+      CompileScope compile_scope(context);
+      task(idx);
+      task_counters[idx] = g_compile_counters;
+    } catch (...) {
+      errors[idx] = std::current_exception();
+    }
+  };
+
+  size_t thread_num = g_in_parallel_compile ? 1 : CompileThreadNum(task_num);
+  if (thread_num == 1) {
+    for (size_t i = 0; i < task_num; ++i) {
+      run_task(i);
+    }
+  } else {
+    BuildConfig config = BuildConfig::Current();
+    std::atomic<size_t> next_task{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_num; ++t) {
+      threads.emplace_back([&config, &next_task, &run_task, task_num]() {
+        air::With<BuildConfig> config_scope(config);
+        g_in_parallel_compile = true;
+        for (size_t i = next_task++; i < task_num; i = next_task++) {
+          run_task(i);
+        }
+      });
+    }
+    for (auto &t : threads) {
+      t.join();
+    }
+  }
+
+  // Continue after the ids of every task.
+  for (const auto &counters : task_counters) {
+    for (const auto &counter : counters) {
+      auto &next = g_compile_counters[counter.first];
+      next = std::max(next, counter.second);
+    }
+  }
+
+  for (auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
 
 Tensor CreatePlaceholder(const NodeRef &arg) {
   auto n = air::make_node<PlaceholderOpNode>();
@@ -491,6 +616,7 @@ NodeRef LowerFunc(Stmt &stmt, const std::string &name, const BuildConfig &config
 NodeRef Lower(Schedule sch, const Array<NodeRef> &in_args, const Array<NodeRef> &shape_vars, const std::string &name,
               const Map<Tensor, Buffer> &in_binds, const Map<std::string, NodeRef> &in_attrs, bool simple_mode,
               bool polyhedral, bool tuning, const std::string &target, const BuildConfig &config, bool get_stmt) {
+  CompileScope compile_scope;
   LowerData data = LowerDataNode::make(sch, in_args, in_binds, in_attrs, target, name, config, polyhedral, tuning,
                                        simple_mode, shape_vars);
   return LowerImpl::Instance().Run(data, get_stmt);
@@ -558,16 +684,20 @@ void BuildForDevice(const Array<LoweredFunc> &flist, const std::string &target_n
     out_flist->push_back(func);
   }
   if (!fdevice.empty()) {
+    ProfileScope profile("backend", "codegen." + target->target_name);
     *out_mdev = air::codegen::Build(fdevice, target_name, g_external_call_name);
   }
   return;
 }
 
-BuildRst BuildRstNode::make(const NodeRef &rst, const std::string &kernel_name) {
+BuildRst BuildRstNode::make(const NodeRef &rst, const std::string &kernel_name, const std::string &cpu_info,
+                            bool kernel_cost) {
   NodePtr<BuildRstNode> node = make_node<BuildRstNode>();
 
   node->rst = rst;
   node->kernel_name = kernel_name;
+  node->cpu_info = cpu_info;
+  node->kernel_cost = kernel_cost;
 
   return BuildRst(node);
 }
@@ -595,7 +725,9 @@ BuildRst BuildToFunc(const Schedule &inputs, const Array<NodeRef> &in_args, cons
   }
 
   auto rst = Lower(inputs, args, shape_vars, name, binds, attrs, false, polyhedral, false, target, config);
-  return BuildRstNode::make(rst, name);
+  AttrMap lower_attrs;
+  lower_attrs = attrs;
+  return BuildRstNode::make(rst, name, lower_attrs.GetStr("cpu_info", ""), lower_attrs.GetBool("kernel_cost", false));
 }
 
 namespace {
@@ -629,18 +761,25 @@ void CreateCode(const std::string &code, const std::string &kernel_name, const s
     }
   }
 }
+
+// The llvm target of the cpu_info attr, the kernel_cost attr asks the llvm module for the cost metadata.
+std::string LLVMTarget(const std::string &target_name, const std::string &cpu_info, bool kernel_cost) {
+  std::string target = air::GetLLVMTarget(target_name, air::GetCpuInfo(cpu_info));
+  return kernel_cost ? target + " -kernel-cost" : target;
+}
 }  // namespace
 
 air::runtime::Module BuildToModule(const NodeRef &ref, const std::string &target_name) {
   CHECK(!target_name.empty()) << "target_name is empty.";
   std::string host_name = kAkgTargetHostName;
   Target target_platform = Target::Create(target_name);
+  auto build_rst = Downcast<BuildRst>(ref);
   if (target_platform->target_name == "llvm") {
-    host_name = target_name;
+    host_name = LLVMTarget(target_name, build_rst->cpu_info, build_rst->kernel_cost);
   }
 
-  auto build_rst = Downcast<BuildRst>(ref);
   auto res = build_rst->rst;
+  ProfileScope profile("backend", "BuildToModule", build_rst->kernel_name);
 
   Array<LoweredFunc> lowered_func_list;
   if (res->IsInstance<LoweredFuncNode>()) {
@@ -672,22 +811,137 @@ air::runtime::Module BuildToModule(const NodeRef &ref, const std::string &target
   }
 
   // Generate a unified host module.
-  air::runtime::Module mhost = air::codegen::Build(fhost_all, host_name, g_external_call_name);
+  air::runtime::Module mhost;
+  {
+    ProfileScope host_profile("backend", "codegen.host");
+    mhost = air::codegen::Build(fhost_all, host_name, g_external_call_name);
+  }
 
   // Import all modules.
   for (const auto &mdev : device_modules) {
     mhost.Import(mdev);
   }
 
+  DumpModuleCode(mhost, build_rst->kernel_name, target_name);
+  return mhost;
+}
+
+void DumpModuleCode(const air::runtime::Module &module, const std::string &kernel_name, const std::string &target_name) {
   const char *akg_dump_code = getenv("MS_DEV_DUMP_CODE");
   if (akg_dump_code != nullptr) {
-    auto mods = mhost->imports();
-    auto mod = mods.empty() ? mhost : mods[0];
+    auto mods = module->imports();
+    auto mod = mods.empty() ? module : mods[0];
     CHECK(mod.defined());
-    CreateCode(mod->GetSource(), build_rst->kernel_name, target_name);
+    CreateCode(mod->GetSource(), kernel_name, target_name);
   }
+}
 
-  return mhost;
+namespace {
+// Packed function that calls the variant of the key read from the shapes of its tensor arguments, the generic variant
+// when no key matches. It forwards its packed arguments as they are: the variants share its signature and are called
+// directly in the same llvm module. For a single key dim llvm turns the chain of compares into a switch.
+LoweredFunc MakeShapeDispatcher(const std::string &name, const Array<LoweredFunc> &variants,
+                                const Array<Array<Integer>> &dims, const Array<Array<Integer>> &keys) {
+  CHECK_EQ(variants.size(), keys.size() + 1) << "Expect a variant per key and a generic one for " << name;
+  Var args("args", Handle());
+  Var type_ids("arg_type_ids", Handle());
+  Var num_args("num_args", Int(32));
+  auto Dispatch = [&](const LoweredFunc &variant) {
+    Var rc(variant->name + ".rc", Int(32));
+    Expr call = Call::make(Int(32), variant->name, {args, type_ids, num_args}, Call::Extern);
+    Expr error = Call::make(Int(32), air::ir::intrinsic::tvm_throw_last_error, {}, Call::Intrinsic);
+    return LetStmt::make(rc, call, IfThenElse::make(rc != 0, Evaluate::make(error)));
+  };
+
+  std::map<int64_t, Var> shapes;
+  std::vector<Expr> key;
+  for (const auto &dim : dims) {
+    CHECK_EQ(dim.size(), 2U) << "Expect the argument and the dim of a key of " << name;
+    int64_t arg = dim[0]->value;
+    if (shapes.count(arg) == 0) {
+      shapes.emplace(arg, Var("arg" + std::to_string(arg) + ".shape", Handle()));
+    }
+    key.push_back(Load::make(Int(64), shapes.at(arg), static_cast<int>(dim[1]->value), const_true()));
+  }
+  Stmt body = Dispatch(variants[keys.size()]);
+  for (size_t i = keys.size(); i > 0; --i) {
+    const auto &values = keys[i - 1];
+    CHECK_EQ(values.size(), key.size()) << "Expect " << key.size() << " values in the keys of " << name;
+    Expr match;
+    for (size_t j = 0; j < key.size(); ++j) {
+      Expr equal = key[j] == make_const(Int(64), values[j]->value);
+      match = match.defined() ? (match && equal) : equal;
+    }
+    body = IfThenElse::make(match, Dispatch(variants[i - 1]), body);
+  }
+
+  for (auto it = shapes.rbegin(); it != shapes.rend(); ++it) {
+    int arg = static_cast<int>(it->first);
+    Var handle("arg" + std::to_string(arg), Handle());
+    body = LetStmt::make(it->second,
+                         Call::make(Handle(), air::ir::intrinsic::tvm_struct_get,
+                                    {handle, 0, static_cast<int>(air::ir::intrinsic::kArrShape)}, Call::PureIntrinsic),
+                         body);
+    body = LetStmt::make(handle,
+                         Call::make(Handle(), air::ir::intrinsic::tvm_struct_get,
+                                    {args, arg, static_cast<int>(air::ir::intrinsic::kTVMValueContent)},
+                                    Call::PureIntrinsic),
+                         body);
+    Expr code = Load::make(Int(32), type_ids, arg, const_true());
+    body = AssertStmt::make(code == kHandle || code == kNDArrayContainer || code == kArrayHandle,
+                            name + ": Expect arg[" + std::to_string(arg) + "] to be a tensor", body);
+  }
+  if (!shapes.empty()) {
+    int count = static_cast<int>(shapes.rbegin()->first) + 1;
+    body = AssertStmt::make(num_args >= count, name + ": num_args should be at least " + std::to_string(count), body);
+  }
+
+  NodePtr<LoweredFuncNode> n = make_node<LoweredFuncNode>();
+  n->name = name;
+  n->args = {args, type_ids, num_args};
+  n->func_type = air::LoweredFuncType::kHostFunc;
+  n->is_packed_func = true;
+  n->is_restricted = false;
+  n->body = body;
+  return LoweredFunc(n);
+}
+}  // namespace
+
+air::runtime::Module BuildMultiVersionModule(const Array<NodeRef> &variants, const Array<Array<Integer>> &dims,
+                                             const Array<Array<Integer>> &keys, const std::string &name,
+                                             const std::string &target_name) {
+  CHECK_EQ(Target::Create(target_name)->target_name, "llvm") << "Multi-version kernels are only built for llvm.";
+  ProfileScope profile("backend", "BuildMultiVersionModule", name);
+  Array<LoweredFunc> funcs;
+  std::string cpu_info;
+  bool kernel_cost = false;
+  for (const auto &variant : variants) {
+    auto build_rst = Downcast<BuildRst>(variant);
+    auto rst = build_rst->rst;
+    CHECK(rst.defined() && rst->IsInstance<LoweredFuncNode>()) << "Variant of " << name << " is not a lowered func.";
+    auto func = Downcast<LoweredFunc>(rst);
+    CHECK_NE(func->name, name) << "Variant named as the dispatcher " << name;
+    CHECK(funcs.empty() || build_rst->cpu_info == cpu_info) << "Variants of " << name << " differ in the cpu_info attr.";
+    cpu_info = build_rst->cpu_info;
+    kernel_cost = kernel_cost || build_rst->kernel_cost;
+    funcs.push_back(func);
+  }
+
+  // One llvm module is emitted for one target.
+  std::string llvm_target = LLVMTarget(target_name, cpu_info, kernel_cost);
+  Array<LoweredFunc> fhost;
+  air::runtime::Module mdev;
+  BuildForDevice(funcs, target_name, llvm_target, &fhost, &mdev);
+  CHECK_EQ(fhost.size(), funcs.size());
+  CHECK(!mdev.defined());
+
+  // The dispatcher goes first to be the entry of the module.
+  Array<LoweredFunc> fhost_all{MakeShapeDispatcher(name, fhost, dims, keys)};
+  for (const auto &func : fhost) {
+    fhost_all.push_back(func);
+  }
+  ProfileScope host_profile("backend", "codegen.host");
+  return air::codegen::Build(fhost_all, llvm_target, g_external_call_name);
 }
 
 air::runtime::Module BuildModule(const Schedule &inputs, const Array<NodeRef> &in_args,
@@ -702,6 +956,7 @@ air::runtime::Module BuildModule(const Schedule &inputs, const Array<NodeRef> &i
 
 TVM_REGISTER_API("_BuildModule").set_body_typed(BuildModule);
 TVM_REGISTER_API("_BuildToFunc").set_body_typed(BuildToFunc);
+TVM_REGISTER_API("_BuildMultiVersionModule").set_body_typed(BuildMultiVersionModule);
 TVM_REGISTER_API("_BuildToModule").set_body([](const TVMArgs &args, TVMRetValue *ret) {
   if (args.size() == 1) {
     *ret = BuildToModule(args[0]);
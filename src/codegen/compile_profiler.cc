@@ -0,0 +1,254 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "codegen/compile_profiler.h"
+#include <malloc.h>
+#include <unistd.h>
+#include <tvm/runtime/registry.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <tuple>
+#include <utility>
+
+namespace akg {
+namespace {
+thread_local ProfileScope *tl_scope = nullptr;
+thread_local std::string tl_kernel;
+thread_local int tl_tid = -1;
+std::atomic<int> next_tid{0};
+
+int ThreadId() {
+  if (tl_tid < 0) {
+    tl_tid = next_tid++;
+  }
+  return tl_tid;
+}
+
+std::string JsonEscape(const std::string &str) {
+  std::stringstream ss;
+  for (unsigned char c : str) {
+    if (c == '"' || c == '\\') {
+      ss << '\\' << c;
+    } else if (c < 0x20) {
+      ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+    } else {
+      ss << c;
+    }
+  }
+  return ss.str();
+}
+
+double Ms(int64_t us) { return static_cast<double>(us) / 1000; }
+}  // namespace
+
+CompileProfiler::CompileProfiler() : epoch_(std::chrono::steady_clock::now()) {
+  const char *path = getenv(kCompileProfileEnv);
+  if (path != nullptr && path[0] != '\0') {
+    dump_path_ = path;
+    enabled_ = true;
+  }
+}
+
+CompileProfiler::~CompileProfiler() {
+  if (dump_path_.empty()) {
+    return;
+  }
+  static_cast<void>(Dump(dump_path_));
+  std::ofstream of(dump_path_ + ".summary");
+  if (of.is_open()) {
+    of << Summary();
+  }
+}
+
+CompileProfiler &CompileProfiler::Instance() {
+  static CompileProfiler instance;
+  return instance;
+}
+
+void CompileProfiler::SetKernel(const std::string &kernel) { tl_kernel = kernel; }
+
+int64_t CompileProfiler::HeapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  return static_cast<int64_t>(mallinfo2().uordblks);
+#elif defined(__GLIBC__)
+  return static_cast<int64_t>(static_cast<unsigned int>(mallinfo().uordblks));
+#else
+  return 0;
+#endif
+}
+
+int64_t CompileProfiler::NowUs() const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch_).count();
+}
+
+void CompileProfiler::Record(Event &&event) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  events_.push_back(std::move(event));
+}
+
+void CompileProfiler::RecordCounter(const std::string &name, int64_t value) {
+  Counter counter{name, tl_kernel, NowUs(), value, ThreadId()};
+  std::lock_guard<std::mutex> lock(mutex_);
+  counters_.push_back(std::move(counter));
+}
+
+void CompileProfiler::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  events_.clear();
+  counters_.clear();
+}
+
+std::string CompileProfiler::Summary() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // (category, name) -> (calls, total, self, max)
+  std::map<std::pair<std::string, std::string>, std::tuple<int64_t, int64_t, int64_t, int64_t>> passes;
+  std::map<std::string, int64_t> kernels;
+  int64_t begin = events_.empty() ? 0 : events_.front().start_us;
+  int64_t end = begin;
+  for (const auto &event : events_) {
+    auto &pass = passes[{event.category, event.name}];
+    std::get<0>(pass) += 1;
+    std::get<1>(pass) += event.dur_us;
+    std::get<2>(pass) += event.self_us;
+    std::get<3>(pass) = std::max(std::get<3>(pass), event.dur_us);
+    kernels[event.kernel.empty() ? "-" : event.kernel] += event.self_us;
+    begin = std::min(begin, event.start_us);
+    end = std::max(end, event.start_us + event.dur_us);
+  }
+  std::vector<std::pair<std::pair<std::string, std::string>, std::tuple<int64_t, int64_t, int64_t, int64_t>>> rows(
+    passes.begin(), passes.end());
+  std::sort(rows.begin(), rows.end(),
+            [](const decltype(rows)::value_type &a, const decltype(rows)::value_type &b) {
+              return std::get<2>(a.second) > std::get<2>(b.second);
+            });
+  std::vector<std::pair<std::string, int64_t>> kernel_rows(kernels.begin(), kernels.end());
+  std::sort(kernel_rows.begin(), kernel_rows.end(),
+            [](const std::pair<std::string, int64_t> &a, const std::pair<std::string, int64_t> &b) {
+              return a.second > b.second;
+            });
+
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(3);
+  ss << "Compile profile: " << events_.size() << " events, " << Ms(end - begin) << " ms wall\n";
+  ss << std::left << std::setw(10) << "category" << std::setw(48) << "name" << std::right << std::setw(8) << "calls"
+     << std::setw(14) << "total(ms)" << std::setw(14) << "self(ms)" << std::setw(14) << "max(ms)"
+     << "\n";
+  for (const auto &row : rows) {
+    ss << std::left << std::setw(10) << row.first.first << std::setw(48) << row.first.second << std::right
+       << std::setw(8) << std::get<0>(row.second) << std::setw(14) << Ms(std::get<1>(row.second)) << std::setw(14)
+       << Ms(std::get<2>(row.second)) << std::setw(14) << Ms(std::get<3>(row.second)) << "\n";
+  }
+  ss << std::left << std::setw(58) << "kernel" << std::right << std::setw(14) << "self(ms)"
+     << "\n";
+  for (const auto &row : kernel_rows) {
+    ss << std::left << std::setw(58) << row.first << std::right << std::setw(14) << Ms(row.second) << "\n";
+  }
+  if (counters_.empty()) {
+    return ss.str();
+  }
+  // (name, kernel) -> max
+  std::map<std::pair<std::string, std::string>, int64_t> counters;
+  for (const auto &counter : counters_) {
+    auto key = std::make_pair(counter.name, counter.kernel.empty() ? "-" : counter.kernel);
+    auto it = counters.emplace(key, counter.value).first;
+    it->second = std::max(it->second, counter.value);
+  }
+  ss << std::left << std::setw(24) << "counter" << std::setw(48) << "kernel" << std::right << std::setw(14) << "max"
+     << "\n";
+  for (const auto &row : counters) {
+    ss << std::left << std::setw(24) << row.first.first << std::setw(48) << row.first.second << std::right
+       << std::setw(14) << row.second << "\n";
+  }
+  return ss.str();
+}
+
+std::string CompileProfiler::ChromeTrace() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::stringstream ss;
+  ss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  for (const auto &event : events_) {
+    ss << (first ? "" : ",") << "\n{\"name\":\"" << JsonEscape(event.name) << "\",\"cat\":\""
+       << JsonEscape(event.category) << "\",\"ph\":\"X\",\"ts\":" << event.start_us << ",\"dur\":" << event.dur_us
+       << ",\"pid\":" << getpid() << ",\"tid\":" << event.tid << ",\"args\":{\"kernel\":\""
+       << JsonEscape(event.kernel) << "\",\"self_us\":" << event.self_us << "}}";
+    first = false;
+  }
+  for (const auto &counter : counters_) {
+    ss << (first ? "" : ",") << "\n{\"name\":\"" << JsonEscape(counter.name)
+       << "\",\"cat\":\"counter\",\"ph\":\"C\",\"ts\":" << counter.ts_us << ",\"pid\":" << getpid()
+       << ",\"tid\":" << counter.tid << ",\"args\":{\"value\":" << counter.value << ",\"kernel\":\""
+       << JsonEscape(counter.kernel) << "\"}}";
+    first = false;
+  }
+  ss << "]}\n";
+  return ss.str();
+}
+
+bool CompileProfiler::Dump(const std::string &path) const {
+  std::ofstream of(path);
+  if (!of.is_open()) {
+    return false;
+  }
+  of << ChromeTrace();
+  return of.good();
+}
+
+ProfileScope::ProfileScope(const char *category, const std::string &name, const std::string &kernel)
+    : category_(category) {
+  auto &profiler = CompileProfiler::Instance();
+  if (!profiler.Enabled()) {
+    return;
+  }
+  active_ = true;
+  name_ = name;
+  outer_kernel_ = tl_kernel;
+  if (!kernel.empty()) {
+    tl_kernel = kernel;
+  }
+  parent_ = tl_scope;
+  tl_scope = this;
+  start_us_ = profiler.NowUs();
+}
+
+ProfileScope::~ProfileScope() {
+  if (!active_) {
+    return;
+  }
+  auto &profiler = CompileProfiler::Instance();
+  int64_t dur = profiler.NowUs() - start_us_;
+  if (parent_ != nullptr) {
+    parent_->child_us_ += dur;
+  }
+  tl_scope = parent_;
+  profiler.Record({category_, name_, tl_kernel, start_us_, dur, dur - child_us_, ThreadId()});
+  tl_kernel = outer_kernel_;
+}
+
+TVM_REGISTER_GLOBAL("akg_compile_profiler_enable").set_body_typed<void(bool)>([](bool enable) {
+  CompileProfiler::Instance().Enable(enable);
+});
+TVM_REGISTER_GLOBAL("akg_compile_profiler_reset").set_body_typed<void()>([]() { CompileProfiler::Instance().Reset(); });
+TVM_REGISTER_GLOBAL("akg_compile_profiler_summary").set_body_typed<std::string()>([]() {
+  return CompileProfiler::Instance().Summary();
+});
+TVM_REGISTER_GLOBAL("akg_compile_profiler_dump").set_body_typed<bool(std::string)>([](std::string path) {
+  return CompileProfiler::Instance().Dump(path);
+});
+}  // namespace akg
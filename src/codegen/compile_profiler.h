@@ -0,0 +1,105 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef CODEGEN_COMPILE_PROFILER_H_
+#define CODEGEN_COMPILE_PROFILER_H_
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace akg {
+constexpr auto kCompileProfileEnv = "AKG_COMPILE_PROFILE";
+
+/*
+ * Compile time profiler of Halide IR passes, poly schedule passes, isl codegen, lower stages, lower tree nodes and
+ * backend codegen. Scopes nest per thread and are attributed to the kernel being lowered, as are counters like the heap
+ * poly holds. It is enabled by akg_compile_profiler_enable
+ * or AKG_COMPILE_PROFILE=<file>, which writes the Chrome trace (chrome://tracing) to <file> and the summary table to
+ * <file>.summary when the process exits.
+ */
+class CompileProfiler {
+ public:
+  struct Event {
+    std::string category;
+    std::string name;
+    std::string kernel;
+    int64_t start_us;
+    int64_t dur_us;
+    int64_t self_us;  // dur_us without the nested scopes
+    int tid;
+  };
+  struct Counter {
+    std::string name;
+    std::string kernel;
+    int64_t ts_us;
+    int64_t value;
+    int tid;
+  };
+
+  static CompileProfiler &Instance();
+  // Attributes the scopes of this thread to kernel until the enclosing scope ends.
+  static void SetKernel(const std::string &kernel);
+  // Bytes of heap in use by the process, 0 where malloc can not tell.
+  static int64_t HeapInUse();
+
+  bool Enabled() const { return enabled_; }
+  void Enable(bool enable) { enabled_ = enable; }
+  int64_t NowUs() const;
+  void Record(Event &&event);
+  void RecordCounter(const std::string &name, int64_t value);
+  void Reset();
+  // Per pass calls, total, self and max time sorted by self time, self time per kernel, then the max of each counter
+  // per kernel.
+  std::string Summary() const;
+  std::string ChromeTrace() const;
+  bool Dump(const std::string &path) const;
+
+ private:
+  CompileProfiler();
+  ~CompileProfiler();
+  CompileProfiler(const CompileProfiler &) = delete;
+  CompileProfiler &operator=(const CompileProfiler &) = delete;
+
+  std::atomic<bool> enabled_{false};
+  std::string dump_path_;
+  std::chrono::steady_clock::time_point epoch_;
+  mutable std::mutex mutex_;
+  std::vector<Event> events_;
+  std::vector<Counter> counters_;
+};
+
+// Times its lifetime as one event when the profiler is enabled.
+class ProfileScope {
+ public:
+  ProfileScope(const char *category, const std::string &name, const std::string &kernel = "");
+  ~ProfileScope();
+
+ private:
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
+  bool active_{false};
+  const char *category_;
+  std::string name_;
+  std::string outer_kernel_;
+  int64_t start_us_{0};
+  int64_t child_us_{0};
+  ProfileScope *parent_{nullptr};
+};
+}  // namespace akg
+#endif  // CODEGEN_COMPILE_PROFILER_H_
@@ -25,8 +25,8 @@
 #include "build_module.h"
 
 namespace akg {
-extern AttrMap g_attrs;
-extern CsrMap g_csr;
+extern thread_local AttrMap g_attrs;
+extern thread_local CsrMap g_csr;
 
 // Use to store the necessary for Lower.
 class LowerData;
@@ -139,6 +139,12 @@ inline StageResult LowerPoly(Stmt &stmt, LowerData &data) {
     Array<NodeRef> poly_res = NEXT_PASS(AutoPoly, stmt, data->binds_0, data->target, false, spec_gemm_attrs, data->sch);
     CHECK_EQ(poly_res.size(), 2);
     stmt = air::Downcast<Stmt>(poly_res[0]);
+    if (g_attrs.GetBool(kPolySkipped, false)) {
+      // Poly exceeded its compile budget, the later stages lower stmt as without poly.
+      data->polyhedral = false;
+      g_attrs.Set(kEnablePolySch, air::make_const(Int(32), false));
+      return {stmt, false};
+    }
     g_attrs.Set(kEnablePolySch, air::make_const(Int(32), true));
   }
   return {stmt, false};
@@ -34,6 +34,10 @@
 
 namespace akg {
 StageResult LLVMLowerBegin(Stmt &, LowerData &data) {
+  // The loops of csr kernels are bounded by indptr, they are scheduled by ScheduleCsrLoop after flattening.
+  if (g_attrs.GetBool("is_csr", false)) {
+    data->polyhedral = false;
+  }
   Stmt stmt = LowerInitWithSchedule(data);
 
   if (!data->polyhedral) {
@@ -80,6 +84,9 @@ StageResult LLVMLowerBeforeFlattern(Stmt &stmt, LowerData &data) {
 StageResult LLVMLowerFlattern(Stmt &stmt, LowerData &data) { return LowerFlattern(stmt, data); }
 
 StageResult LLVMBeforeLowerFunc(Stmt &stmt, LowerData &data) {
+  stmt = NEXT_PASS_IF(g_attrs.GetBool("is_csr", false), ScheduleCsrLoop, stmt);
+  stmt = NEXT_PASS_IF(g_attrs.GetBool(kEnableTotSchedule, true), ScheduleTotLoop, stmt, data->binds_0);
+  stmt = NEXT_PASS_IF(g_attrs.GetBool(kEnableCpuStoragePlan, true), CpuStoragePlan, stmt, data->name);
   stmt = NEXT_PASS_IF(!data->simple_mode, LoopPartition, stmt, data->config->partition_const_loop);
   stmt = NEXT_PASS_IF(data->config->disable_vectorize, SkipVectorize, stmt);
   stmt = NEXT_PASS_IF(!data->config->disable_vectorize, VectorizeLoop, stmt);
@@ -16,10 +16,8 @@
 
 #include "codegen/pass_mgr.h"
 
-#include <unordered_set>
-#include <chrono>
-
-#include "common/common_util.h"
+#include "build_module.h"
+#include "codegen/compile_profiler.h"
 
 namespace akg {
 void PassMgr::InitializeSubName() {
@@ -33,20 +31,16 @@ TVMRetValue PassMgr::Run() const {
 
   TVMRetValue res;
 
-  auto start_time = std::chrono::steady_clock::now();
-  packed_func->CallPacked(TVMArgs(args_values_.data(), args_types_.data(), args_values_.size() - 1), &res);
-  CHECK(res.type_code() != kNull) << "PassMgr " << tl_pass_id_ << "_" << sub_name_ << " result illegal.";
-
+  auto call = [this, packed_func, &res]() {
+    packed_func->CallPacked(TVMArgs(args_values_.data(), args_types_.data(), args_values_.size() - 1), &res);
+  };
   if (enable_timer_) {
-    auto end_time = std::chrono::steady_clock::now();
-    int64_t elapsed = std::chrono::duration_cast<std::chrono::seconds>(end_time - start_time).count();
-    PassTimer *pass_timer = PassTimer::GetInstance();
-    if (pass_timer == nullptr) {
-      LOG(INFO) << "Failed to initialize PassTimer.";
-    } else {
-      pass_timer->AddItem(sub_name_, elapsed);
-    }
+    ProfileScope scope("pass", sub_name_);
+    call();
+  } else {
+    call();
   }
+  CHECK(res.type_code() != kNull) << "PassMgr " << tl_pass_id_ << "_" << sub_name_ << " result illegal.";
 
   tl_pass_id_++;
   return res;
@@ -70,26 +64,17 @@ void PassMgr::DumpIr(std::function<void(std::ostream &os)> print) const {
   of.close();
 }
 
-static std::unordered_set<std::string> VectorToSet(const std::vector<std::string> &list) {
-  std::unordered_set<std::string> set;
-  for (const auto &s : list) {
-    set.insert(s);
-  }
-  return set;
-}
-
 bool PassMgr::ShouldDumpC() const {
-  const char *dump_c_pass_cstr = std::getenv("DUMP_C_PASS");
-  if (dump_c_pass_cstr == nullptr) {
+  const auto &hooks = DebugHooks::Current();
+  if (hooks.dump_c_pass_ids.empty()) {
     return false;
   }
-  auto dump_c_passes = common::Split(std::string(dump_c_pass_cstr), ",");
-  auto dump_c_passes_set = VectorToSet(dump_c_passes);
-  if (dump_c_passes_set.count(sub_name_) > 0) {
+  if (hooks.dump_c_pass_names.count(sub_name_) > 0) {
     return true;
   }
-  for (const auto &pass : dump_c_passes) {
-    if (pass.find(std::to_string(tl_pass_id_)) == 0) {
+  auto pass_id = std::to_string(tl_pass_id_);
+  for (const auto &pass : hooks.dump_c_pass_ids) {
+    if (pass.find(pass_id) == 0) {
       return true;
     }
   }
@@ -16,6 +16,7 @@
 #include "codegen/stage_lower.h"
 #include <algorithm>
 #include <functional>
+#include "codegen/compile_profiler.h"
 
 namespace akg {
 namespace lower {
@@ -136,6 +137,8 @@ StageLower &StageLower::RunTo(StageType to) {
     return *this;
   }
 
+  // Keep the attrs of an enclosing lowering, this stage lower may run nested in another one.
+  AttrMap outer_attrs = g_attrs;
   if (data_->attrs.defined()) {
     g_attrs = data_->attrs;
   }
@@ -147,6 +150,7 @@ StageLower &StageLower::RunTo(StageType to) {
       break;
     }
     LOG(INFO) << "Run stage " << stage;
+    ProfileScope profile("stage", stage.name);
     auto res = stage.func(stmt, data_);
     node_ref_ = res.first;
     if (res.second) {
@@ -164,7 +168,7 @@ StageLower &StageLower::RunTo(StageType to) {
 
   cur_stage_ = StageManager::Instance().NextStageType(data_->target, to);
 
-  g_attrs = AttrMap();
+  g_attrs = outer_attrs;
   return *this;
 }
 }  // namespace lower
@@ -44,8 +44,8 @@
 #include "codegen/lower.h"
 
 namespace akg {
-extern AttrMap g_attrs;
-extern CsrMap g_csr;
+extern thread_local AttrMap g_attrs;
+extern thread_local CsrMap g_csr;
 namespace lower {
 enum class StageType : int16_t {
   Begin = 0,
@@ -132,43 +132,4 @@ std::string AttrMap::GetStr(const std::string &attr_name, const std::string &dft
   }
   return dft_value;
 }
-
-void PassTimer::AddItem(const std::string &pass_name, int64_t elapsed_seconds) {
-  auto iter = pass_time_.find(pass_name);
-  if (iter != pass_time_.end()) {
-    iter->second += elapsed_seconds;
-  } else {
-    pass_time_[pass_name] = elapsed_seconds;
-  }
-}
-
-std::string PassTimer::ToString() const {
-  std::stringstream buf;
-  buf << "PassName - Time";
-  if (pass_time_.empty()) {
-    return buf.str();
-  }
-
-  std::vector<std::pair<std::string, int64_t>> timers;
-  for (auto iter = pass_time_.begin(); iter != pass_time_.end(); ++iter) {
-    timers.push_back(*iter);
-  }
-  sort(timers.begin(), timers.end(),
-       [](const std::pair<std::string, int64_t> t1, const std::pair<std::string, int64_t> t2) {
-         return t1.second > t2.second;
-       });
-  if (timers.size() > kMaxNumOfPassTimeToPrint) {
-    timers.resize(kMaxNumOfPassTimeToPrint);
-  }
-
-  for (auto iter : timers) {
-    buf << "\n" << iter.first << " - " << iter.second << " s";
-  }
-  return buf.str();
-}
-
-std::ostream &operator<<(std::ostream &os, const PassTimer &time) {
-  os << time.ToString();
-  return os;
-}
 }  // namespace akg
@@ -83,8 +83,6 @@ constexpr auto kEnableCSE = "enable_common_subexpr_elim";
 constexpr auto kEnableFeatureLibrary = "enable_feature_library";
 constexpr auto kEnableFeatureLibraryPrePoly = "enable_feature_library_pre_poly";
 constexpr auto kEnableHoistCondWrite = "enable_hoist_cond_write";
-constexpr double kUsPerSecond = 1e6;
-constexpr size_t kMaxNumOfPassTimeToPrint = 5;
 constexpr auto kIsDynamic = "is_dynamic";
 constexpr auto kEnableConvAnalyzeAlign = "enable_conv_analyze_align";
 constexpr auto kEnableHoistAllocate = "enable_hoist_allocate";
@@ -102,10 +100,16 @@ constexpr auto kErrorInfo = "";
 constexpr auto kErrorScope = "";
 constexpr auto kAllocBits = "alloc_bits";
 constexpr auto kEnablePolySch = "enable_poly_sch";
+// Set by poly when it exceeded its compile budget and had to fall back.
+constexpr auto kPolyFallback = "poly_fallback";
+constexpr auto kPolySkipped = "poly_skipped";
 constexpr auto kEnableFuseAxis = "enable_fuse_axis";
 constexpr auto kEnableAtomicAdd = "enable_atomic_add";
 constexpr auto kEnableSwizzleGPU = "enable_swizzle_gpu";
 constexpr auto kEnableElementwiseFlatten = "enable_elementwise_flatten";
+constexpr auto kReduceAccumulators = "reduce_accumulators";
+constexpr auto kEnableCpuStoragePlan = "enable_cpu_storage_plan";
+constexpr auto kEnableTotSchedule = "enable_tot_schedule";
 
 static std::unordered_map<std::string, int> help_tiling_level = {
   {"None", 0},
@@ -136,27 +140,6 @@ class CsrMap : public Map<NodeRef, NodeRef> {
   }
 };
 
-class PassTimer {
- public:
-  ~PassTimer() = default;
-
-  void AddItem(const std::string &pass_name, int64_t elapsed_seconds);
-  void Clear() { pass_time_.clear(); }
-  std::string ToString() const;
-
-  static PassTimer *GetInstance() {
-    static PassTimer pass_timer;
-    return &pass_timer;
-  }
-
- private:
-  PassTimer() { Clear(); }
-
-  std::unordered_map<std::string, int64_t> pass_time_;
-};
-
-std::ostream &operator<<(std::ostream &os, const PassTimer &time);
-
 std::string DumpC(const Stmt &stmt, const Array<Buffer> &extern_buffer);
 }  // namespace akg
 
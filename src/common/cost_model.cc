@@ -0,0 +1,417 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "common/cost_model.h"
+#include <tvm/arithmetic.h>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <unordered_set>
+
+namespace akg {
+namespace {
+float Log2p(double x) { return static_cast<float>(std::log2(1.0 + std::max(x, 0.0))); }
+
+// Operations and loads of the value of a store.
+class ValueCounter : public IRVisitor {
+ public:
+  struct Access {
+    const Object *buffer;
+    Expr index;
+    Type type;
+  };
+
+  void Visit_(const Add *op) final { Count(op->type, op); }
+  void Visit_(const Sub *op) final { Count(op->type, op); }
+  void Visit_(const Mul *op) final { Count(op->type, op); }
+  void Visit_(const Div *op) final { Count(op->type, op); }
+  void Visit_(const Mod *op) final { Count(op->type, op); }
+  void Visit_(const FloorDiv *op) final { Count(op->type, op); }
+  void Visit_(const FloorMod *op) final { Count(op->type, op); }
+  void Visit_(const Min *op) final { Count(op->type, op); }
+  void Visit_(const Max *op) final { Count(op->type, op); }
+  void Visit_(const Select *op) final { Count(op->type, op); }
+
+  void Visit_(const Load *op) final {
+    loads.push_back({op->buffer_var.get(), op->index, op->type});
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Call *op) final {
+    if (op->call_type == Call::Halide) {
+      loads.push_back({op->func.get(), op->args.empty() ? Expr(0) : op->args[op->args.size() - 1], op->type});
+    } else if (op->call_type == Call::PureIntrinsic || op->call_type == Call::PureExtern) {
+      (op->type.is_float() ? float_ops : int_ops) += op->type.lanes();
+    }
+    IRVisitor::Visit_(op);
+  }
+
+  int64_t float_ops{0};
+  int64_t int_ops{0};
+  std::vector<Access> loads;
+
+ private:
+  template <typename T>
+  void Count(const Type &type, const T *op) {
+    (type.is_float() ? float_ops : int_ops) += type.lanes();
+    IRVisitor::Visit_(op);
+  }
+};
+
+// Elements index moves by per iteration of var, -1 when it is not linear in var.
+int64_t Stride(const Expr &index, const Var &var) {
+  if (auto ramp = index.as<Ramp>()) {
+    auto stride = ramp->stride.as<IntImm>();
+    return stride != nullptr ? stride->value : -1;
+  }
+  if (!var.defined()) {
+    return 0;
+  }
+  auto coeff = air::arith::DetectLinearEquation(index, {var});
+  if (coeff.size() != 2) {
+    return -1;
+  }
+  auto stride = coeff[0].as<IntImm>();
+  return stride != nullptr ? stride->value : -1;
+}
+
+class StoreFeatureExtractor : public IRVisitor {
+ public:
+  void Visit_(const For *op) final {
+    auto extent = op->extent.as<IntImm>();
+    loops_.push_back({op->loop_var, extent != nullptr ? extent->value : 1, op->for_type});
+    IRVisitor::Visit_(op);
+    loops_.pop_back();
+  }
+
+  void Visit_(const Store *op) final {
+    AddRow(op->buffer_var.get(), op->index, op->value);
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Provide *op) final {
+    AddRow(op->func.get(), op->args.empty() ? Expr(0) : op->args[op->args.size() - 1], op->value);
+    IRVisitor::Visit_(op);
+  }
+
+  std::vector<std::vector<float>> rows;
+
+ private:
+  struct Loop {
+    Var var;
+    int64_t extent;
+    ForType type;
+  };
+
+  void AddRow(const Object *buffer, const Expr &index, const Expr &value) {
+    double trip = 1;
+    double parallel = 1;
+    double unrolled = 1;
+    int64_t vectorized = 1;
+    for (const auto &loop : loops_) {
+      trip *= loop.extent;
+      if (loop.type == ForType::Parallel) {
+        parallel *= loop.extent;
+      } else if (loop.type == ForType::Unrolled) {
+        unrolled *= loop.extent;
+      } else if (loop.type == ForType::Vectorized) {
+        vectorized *= loop.extent;
+      }
+    }
+    Var inner = loops_.empty() ? Var() : loops_.back().var;
+    int64_t inner_extent = loops_.empty() ? 1 : loops_.back().extent;
+
+    ValueCounter counter;
+    counter.Visit(value);
+    double load_bytes = 0;
+    int unit_loads = 0;
+    int invariant_loads = 0;
+    bool reduction = false;
+    std::unordered_set<const Object *> buffers{buffer};
+    for (const auto &load : counter.loads) {
+      load_bytes += load.type.bytes() * load.type.lanes();
+      auto stride = Stride(load.index, inner);
+      unit_loads += stride == 1;
+      invariant_loads += stride == 0;
+      reduction = reduction || load.buffer == buffer;
+      buffers.insert(load.buffer);
+    }
+    auto num_loads = static_cast<double>(counter.loads.size());
+    rows.push_back({Log2p(trip),
+                    Log2p(trip * counter.float_ops),
+                    Log2p(trip * counter.int_ops),
+                    Log2p(trip * load_bytes),
+                    Log2p(trip * value.type().bytes() * value.type().lanes()),
+                    Log2p(inner_extent),
+                    Log2p(std::max<int64_t>(value.type().lanes(), vectorized)),
+                    Log2p(parallel),
+                    Log2p(unrolled),
+                    Log2p(loops_.size()),
+                    Log2p(num_loads),
+                    num_loads > 0 ? static_cast<float>(unit_loads / num_loads) : 0,
+                    num_loads > 0 ? static_cast<float>(invariant_loads / num_loads) : 0,
+                    Stride(index, inner) == 1 ? 1.0f : 0.0f,
+                    reduction ? 1.0f : 0.0f,
+                    Log2p(buffers.size())});
+  }
+
+  std::vector<Loop> loops_;
+};
+
+const float *FloatData(const air::runtime::NDArray &array, int ndim) {
+  CHECK(array->dtype.code == kDLFloat && array->dtype.bits == 32) << "Cost model data must be float32";
+  CHECK(array->ndim == ndim && array->strides == nullptr) << "Cost model data must be compact with " << ndim << " dims";
+  return reinterpret_cast<const float *>(static_cast<const char *>(array->data) + array->byte_offset);
+}
+
+std::vector<std::vector<float>> Rows(const air::runtime::NDArray &array) {
+  auto data = FloatData(array, 2);
+  std::vector<std::vector<float>> rows;
+  for (int64_t i = 0; i < array->shape[0]; ++i) {
+    rows.emplace_back(data + i * array->shape[1], data + (i + 1) * array->shape[1]);
+  }
+  return rows;
+}
+}  // namespace
+
+std::vector<std::vector<float>> ExtractStoreFeatures(const Stmt &stmt) {
+  StoreFeatureExtractor extractor;
+  extractor.Visit(stmt);
+  return extractor.rows;
+}
+
+void CostModelNode::Train(const std::vector<std::vector<float>> &x, const std::vector<float> &y) {
+  CHECK_EQ(x.size(), y.size());
+  trees_.clear();
+  base_ = 0;
+  num_features_ = 0;
+  if (x.empty()) {
+    return;
+  }
+  size_t dim = x[0].size();
+  num_features_ = dim;
+  for (const auto &row : x) {
+    CHECK_EQ(row.size(), dim) << "Rows of different lengths";
+  }
+  base_ = std::accumulate(y.begin(), y.end(), 0.0f) / y.size();
+  // The samples sorted by each feature, once for all trees.
+  std::vector<std::vector<int>> order(dim, std::vector<int>(x.size()));
+  for (size_t f = 0; f < dim; ++f) {
+    std::iota(order[f].begin(), order[f].end(), 0);
+    std::stable_sort(order[f].begin(), order[f].end(), [&x, f](int a, int b) { return x[a][f] < x[b][f]; });
+  }
+  std::vector<float> prediction(x.size(), base_);
+  std::vector<float> residual(x.size());
+  for (int t = 0; t < num_trees; ++t) {
+    for (size_t i = 0; i < x.size(); ++i) {
+      residual[i] = y[i] - prediction[i];
+    }
+    trees_.push_back(GrowTree(x, order, residual));
+    for (size_t i = 0; i < x.size(); ++i) {
+      prediction[i] += PredictTree(trees_.back(), x[i]);
+    }
+  }
+}
+
+CostModelNode::Tree CostModelNode::GrowTree(const std::vector<std::vector<float>> &x,
+                                            const std::vector<std::vector<int>> &order,
+                                            const std::vector<float> &residual) const {
+  struct Split {
+    double gain{1e-12};
+    int feature{-1};
+    float threshold{0};
+  };
+  Tree tree(1);
+  std::vector<int> node_of(x.size(), 0);
+  std::vector<bool> open{true};
+  for (int depth = 0; depth < max_depth; ++depth) {
+    std::vector<double> sum(tree.size(), 0);
+    std::vector<int> count(tree.size(), 0);
+    for (size_t i = 0; i < x.size(); ++i) {
+      sum[node_of[i]] += residual[i];
+      ++count[node_of[i]];
+    }
+    std::vector<Split> best(tree.size());
+    for (size_t f = 0; f < order.size(); ++f) {
+      std::vector<double> left_sum(tree.size(), 0);
+      std::vector<int> left_count(tree.size(), 0);
+      std::vector<float> last(tree.size(), 0);
+      for (int i : order[f]) {
+        int node = node_of[i];
+        if (!open[node]) {
+          continue;
+        }
+        float value = x[i][f];
+        int lc = left_count[node];
+        int rc = count[node] - lc;
+        if (lc >= min_leaf && rc >= min_leaf && value > last[node]) {
+          double ls = left_sum[node];
+          double rs = sum[node] - ls;
+          double gain = ls * ls / lc + rs * rs / rc - sum[node] * sum[node] / count[node];
+          if (gain > best[node].gain) {
+            float threshold = last[node] + (value - last[node]) / 2;
+            best[node] = {gain, static_cast<int>(f), threshold > last[node] ? threshold : value};
+          }
+        }
+        left_sum[node] += residual[i];
+        ++left_count[node];
+        last[node] = value;
+      }
+    }
+    bool grown = false;
+    size_t level_size = tree.size();
+    for (size_t node = 0; node < level_size; ++node) {
+      if (!open[node]) {
+        continue;
+      }
+      open[node] = false;
+      if (best[node].feature < 0) {
+        continue;
+      }
+      tree[node].feature = best[node].feature;
+      tree[node].threshold = best[node].threshold;
+      tree[node].left = static_cast<int>(tree.size());
+      tree[node].right = static_cast<int>(tree.size()) + 1;
+      tree.resize(tree.size() + 2);
+      open.resize(tree.size(), true);
+      grown = true;
+    }
+    if (!grown) {
+      break;
+    }
+    for (size_t i = 0; i < x.size(); ++i) {
+      const auto &node = tree[node_of[i]];
+      if (node.feature >= 0) {
+        node_of[i] = x[i][node.feature] < node.threshold ? node.left : node.right;
+      }
+    }
+  }
+  std::vector<double> sum(tree.size(), 0);
+  std::vector<int> count(tree.size(), 0);
+  for (size_t i = 0; i < x.size(); ++i) {
+    sum[node_of[i]] += residual[i];
+    ++count[node_of[i]];
+  }
+  for (size_t node = 0; node < tree.size(); ++node) {
+    if (count[node] > 0) {
+      tree[node].value = static_cast<float>(learning_rate * sum[node] / count[node]);
+    }
+  }
+  return tree;
+}
+
+float CostModelNode::PredictTree(const Tree &tree, const std::vector<float> &x) {
+  int node = 0;
+  while (tree[node].feature >= 0) {
+    node = x[tree[node].feature] < tree[node].threshold ? tree[node].left : tree[node].right;
+  }
+  return tree[node].value;
+}
+
+float CostModelNode::Predict(const std::vector<float> &x) const {
+  CHECK(trees_.empty() || x.size() == num_features_)
+    << "Rows of " << x.size() << " features for a cost model of " << num_features_;
+  float y = base_;
+  for (const auto &tree : trees_) {
+    y += PredictTree(tree, x);
+  }
+  return y;
+}
+
+std::string CostModelNode::Save() const {
+  std::ostringstream os;
+  os << std::setprecision(std::numeric_limits<float>::max_digits10);
+  os << num_trees << " " << max_depth << " " << min_leaf << " " << learning_rate << " " << base_ << " "
+     << num_features_ << " " << trees_.size() << "\n";
+  for (const auto &tree : trees_) {
+    os << tree.size() << "\n";
+    for (const auto &node : tree) {
+      os << node.feature << " " << node.threshold << " " << node.value << " " << node.left << " " << node.right
+         << "\n";
+    }
+  }
+  return os.str();
+}
+
+void CostModelNode::Load(const std::string &text) {
+  std::istringstream is(text);
+  size_t num_saved = 0;
+  is >> num_trees >> max_depth >> min_leaf >> learning_rate >> base_ >> num_features_ >> num_saved;
+  CHECK(!is.fail()) << "Invalid cost model";
+  trees_.assign(num_saved, Tree());
+  for (auto &tree : trees_) {
+    size_t size = 0;
+    is >> size;
+    CHECK(!is.fail() && size > 0) << "Invalid cost model";
+    tree.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+      auto &node = tree[i];
+      is >> node.feature >> node.threshold >> node.value >> node.left >> node.right;
+      // Splits read features of the rows the model was trained on and point to nodes after them.
+      auto child = [i, size](int n) { return n > 0 && static_cast<size_t>(n) > i && static_cast<size_t>(n) < size; };
+      CHECK(node.feature < 0 ||
+            (static_cast<size_t>(node.feature) < num_features_ && child(node.left) && child(node.right)))
+        << "Invalid cost model, node " << i << " splits on feature " << node.feature << " of " << num_features_
+        << " into " << node.left << " and " << node.right;
+    }
+  }
+  CHECK(!is.fail()) << "Invalid cost model";
+}
+
+TVM_REGISTER_NODE_TYPE(CostModelNode);
+
+TVM_REGISTER_GLOBAL("akg_cost_model_create")
+  .set_body_typed<CostModel(int, int, int, double)>([](int num_trees, int max_depth, int min_leaf, double rate) {
+    auto n = make_node<CostModelNode>();
+    n->num_trees = num_trees;
+    n->max_depth = max_depth;
+    n->min_leaf = std::max(min_leaf, 1);
+    n->learning_rate = rate;
+    return CostModel(n);
+  });
+
+TVM_REGISTER_GLOBAL("akg_cost_model_train")
+  .set_body_typed<void(CostModel, air::runtime::NDArray, air::runtime::NDArray)>(
+    [](CostModel model, air::runtime::NDArray x, air::runtime::NDArray y) {
+      auto targets = FloatData(y, 1);
+      const_cast<CostModelNode *>(model.operator->())->Train(Rows(x), {targets, targets + y->shape[0]});
+    });
+
+TVM_REGISTER_GLOBAL("akg_cost_model_predict")
+  .set_body_typed<air::runtime::NDArray(CostModel, air::runtime::NDArray)>(
+    [](CostModel model, air::runtime::NDArray x) {
+      auto rows = Rows(x);
+      auto out = air::runtime::NDArray::Empty({static_cast<int64_t>(rows.size())}, DLDataType{kDLFloat, 32, 1},
+                                              DLContext{kDLCPU, 0});
+      auto data = static_cast<float *>(out->data);
+      for (size_t i = 0; i < rows.size(); ++i) {
+        data[i] = model->Predict(rows[i]);
+      }
+      return out;
+    });
+
+TVM_REGISTER_GLOBAL("akg_cost_model_save").set_body_typed<std::string(CostModel)>([](CostModel model) {
+  return model->Save();
+});
+
+TVM_REGISTER_GLOBAL("akg_cost_model_load").set_body_typed<CostModel(std::string)>([](std::string text) {
+  auto n = make_node<CostModelNode>();
+  n->Load(text);
+  return CostModel(n);
+});
+}  // namespace akg
@@ -0,0 +1,84 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef COMMON_COST_MODEL_H_
+#define COMMON_COST_MODEL_H_
+#include <string>
+#include <vector>
+#include "tvm.h"
+
+namespace akg {
+// Length of the feature vector of one store.
+constexpr int kStoreFeatureLen = 16;
+
+/*
+ * Features of each store of a lowered stmt, one row per store in log2(1 + x) scale: the trip count of its loops, the
+ * float and int operations, bytes loaded and stored, the innermost, vector, parallel and unrolled extents, the loop
+ * depth, the loads and how many of them are contiguous or invariant in the innermost loop, whether the store is
+ * contiguous, whether it reduces into its buffer and the buffers it touches.
+ */
+std::vector<std::vector<float>> ExtractStoreFeatures(const Stmt &stmt);
+
+/*
+ * Gradient boosted regression trees that predict the cost of a kernel from its features, to rank tiling candidates
+ * without running them. Trees are grown level by level on presorted features, by least squares on the residuals.
+ */
+class CostModelNode : public Node {
+ public:
+  int num_trees{100};
+  int max_depth{6};
+  int min_leaf{2};
+  double learning_rate{0.1};
+
+  // Fits x (one row per kernel) to y, from scratch.
+  void Train(const std::vector<std::vector<float>> &x, const std::vector<float> &y);
+  // x has the length of the rows the model was trained on.
+  float Predict(const std::vector<float> &x) const;
+  std::string Save() const;
+  void Load(const std::string &text);
+
+  void VisitAttrs(AttrVisitor *v) {
+    v->Visit("num_trees", &num_trees);
+    v->Visit("max_depth", &max_depth);
+    v->Visit("min_leaf", &min_leaf);
+    v->Visit("learning_rate", &learning_rate);
+  }
+
+  static constexpr const char *_type_key = "CostModel";
+  TVM_DECLARE_NODE_TYPE_INFO(CostModelNode, Node);
+
+ private:
+  struct TreeNode {
+    int feature{-1};  // -1 for a leaf
+    float threshold{0};
+    float value{0};
+    int left{-1};
+    int right{-1};
+  };
+  using Tree = std::vector<TreeNode>;
+
+  Tree GrowTree(const std::vector<std::vector<float>> &x, const std::vector<std::vector<int>> &order,
+                const std::vector<float> &residual) const;
+  static float PredictTree(const Tree &tree, const std::vector<float> &x);
+
+  float base_{0};
+  // Length of the rows the model was trained on, the trees split on features below it.
+  size_t num_features_{0};
+  std::vector<Tree> trees_;
+};
+
+TVM_DEFINE_NODE_REF(CostModel, CostModelNode);
+}  // namespace akg
+#endif  // COMMON_COST_MODEL_H_
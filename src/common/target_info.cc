@@ -17,8 +17,23 @@
 
 #include "target_info.h"
 
+#include <sched.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+
 #include <tvm/runtime/registry.h>
 #include <tvm/packed_func_ext.h>
+#ifdef TVM_LLVM_VERSION
+#include "runtime/thread_pool.h"
+#endif
 
 namespace air {
 
@@ -41,4 +56,291 @@ GpuMemoryInfo GetGpuMemoryInfo(const std::string& scope) {
   }
 }
 
+namespace {
+constexpr int kGenericL1Bytes = 32 * 1024;
+constexpr int kGenericL2Bytes = 256 * 1024;
+constexpr int kGenericL3Bytes = 8 * 1024 * 1024;
+constexpr int kGenericCacheLineBytes = 64;
+constexpr int kGenericCoreNum = 8;
+constexpr int kGenericSimdBytes = 16;
+
+// Sizes are given as "48K", "2M" or in bytes.
+int ParseSize(const std::string& str) {
+  std::istringstream is(str);
+  int64_t value = 0;
+  std::string unit;
+  if (!(is >> value)) {
+    return 0;
+  }
+  is >> unit;
+  if (!unit.empty() && (unit[0] == 'K' || unit[0] == 'k')) {
+    value <<= 10;
+  } else if (!unit.empty() && (unit[0] == 'M' || unit[0] == 'm')) {
+    value <<= 20;
+  }
+  return static_cast<int>(value);
+}
+
+std::string ReadFirstLine(const std::string& path) {
+  std::ifstream ifs(path);
+  std::string line;
+  std::getline(ifs, line);
+  return line;
+}
+
+void DetectCaches(CpuInfoNode* info) {
+  for (int i = 0;; ++i) {
+    std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(i) + "/";
+    auto level = ReadFirstLine(dir + "level");
+    if (level.empty()) {
+      break;
+    }
+    int size = ParseSize(ReadFirstLine(dir + "size"));
+    if (ReadFirstLine(dir + "type") == "Instruction" || size <= 0) {
+      continue;
+    }
+    if (level == "1") {
+      info->l1_bytes = size;
+      int line = ParseSize(ReadFirstLine(dir + "coherency_line_size"));
+      info->cache_line_bytes = line > 0 ? line : info->cache_line_bytes;
+    } else if (level == "2") {
+      info->l2_bytes = size;
+    } else if (level == "3") {
+      info->l3_bytes = size;
+    }
+  }
+}
+
+bool HasIsa(const std::string& isa, const std::string& ext) {
+  std::istringstream is(isa);
+  std::string item;
+  while (std::getline(is, item, ',')) {
+    if (item == ext) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// A newer extension implies the older ones of its width, e.g. "isa=avx2" alone is a 32 bytes target.
+int SimdBytes(const std::string& isa) {
+  if (HasIsa(isa, "avx512") || HasIsa(isa, "avx512_vnni")) {
+    return 64;
+  }
+  return HasIsa(isa, "avx") || HasIsa(isa, "avx2") ? 32 : kGenericSimdBytes;
+}
+
+// The extensions every cpu of the host arch has, which llvm uses without -mcpu.
+std::string GenericIsa() {
+#if defined(__x86_64__)
+  return "sse";
+#elif defined(__aarch64__)
+  return "neon";
+#else
+  return "";
+#endif
+}
+
+std::string IsaOfSimd(int simd_bytes) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (simd_bytes >= 64) {
+    return "sse,avx,avx2,avx512";
+  }
+  return simd_bytes >= 32 ? "sse,avx,avx2" : "sse";
+#else
+  return GenericIsa();
+#endif
+}
+
+std::string DetectIsa() {
+  std::vector<std::string> exts;
+#if defined(__x86_64__) || defined(__i386__)
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    if (edx & bit_SSE2) {
+      exts.push_back("sse");
+    }
+    bool fma = (ecx & bit_FMA) != 0;
+    // The os has to save the wide registers on context switches too.
+    unsigned int xcr0_lo = 0, xcr0_hi = 0;
+    if ((ecx & bit_AVX) && (ecx & bit_OSXSAVE)) {
+      __asm__ volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    }
+    constexpr unsigned int kYmmState = 0x6;
+    constexpr unsigned int kZmmState = 0xe6;
+    if ((xcr0_lo & kYmmState) == kYmmState) {
+      exts.push_back("avx");
+      if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        // The avx gemm kernels need fma3 too.
+        if ((ebx & bit_AVX2) && fma) {
+          exts.push_back("avx2");
+        }
+        if ((ebx & bit_AVX512F) && (xcr0_lo & kZmmState) == kZmmState) {
+          exts.push_back("avx512");
+          if (ecx & bit_AVX512VNNI) {
+            exts.push_back("avx512_vnni");
+          }
+        }
+      }
+    }
+  }
+#elif defined(__aarch64__)
+  exts.push_back("neon");
+#endif
+  std::string isa;
+  for (const auto& ext : exts) {
+    isa += (isa.empty() ? "" : ",") + ext;
+  }
+  return isa;
+}
+
+int DetectCoreNum() {
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  if (sched_getaffinity(0, sizeof(cpuset), &cpuset) == 0 && CPU_COUNT(&cpuset) > 0) {
+    return CPU_COUNT(&cpuset);
+  }
+  return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
+CpuInfo MakeGenericCpuInfo() {
+  auto n = make_node<CpuInfoNode>();
+  n->l1_bytes = kGenericL1Bytes;
+  n->l2_bytes = kGenericL2Bytes;
+  n->l3_bytes = kGenericL3Bytes;
+  n->cache_line_bytes = kGenericCacheLineBytes;
+  n->core_num = kGenericCoreNum;
+  n->simd_bytes = kGenericSimdBytes;
+  n->isa = "";
+  return CpuInfo(n);
+}
+}  // namespace
+
+TVM_STATIC_IR_FUNCTOR(IRPrinter, vtable)
+.set_dispatch<CpuInfoNode>([](const ObjectRef& node, IRPrinter *p) {
+    auto* op = static_cast<const CpuInfoNode*>(node.get());
+    p->stream << "cpu-info("
+              << "l1_bytes=" << op->l1_bytes << ", l2_bytes=" << op->l2_bytes << ", l3_bytes=" << op->l3_bytes
+              << ", cache_line_bytes=" << op->cache_line_bytes << ", core_num=" << op->core_num
+              << ", simd_bytes=" << op->simd_bytes << ", isa=" << op->isa << ")";
+});
+
+TVM_REGISTER_NODE_TYPE(CpuInfoNode);
+
+CpuInfo GetHostCpuInfo() {
+  static const CpuInfo host = []() {
+    auto info = MakeGenericCpuInfo();
+    auto n = const_cast<CpuInfoNode*>(info.as<CpuInfoNode>());
+    DetectCaches(n);
+    n->core_num = DetectCoreNum();
+    n->isa = DetectIsa();
+    n->simd_bytes = SimdBytes(n->isa);
+    return info;
+  }();
+  return host;
+}
+
+namespace {
+// The build host as a target of generic code, whose kernels run on any cpu of its arch.
+CpuInfo GetGenericHostCpuInfo() {
+  static const CpuInfo generic = []() {
+    auto host = GetHostCpuInfo();
+    auto n = make_node<CpuInfoNode>(*host.as<CpuInfoNode>());
+    n->isa = GenericIsa();
+    n->simd_bytes = SimdBytes(n->isa);
+    return CpuInfo(n);
+  }();
+  return generic;
+}
+}  // namespace
+
+CpuInfo GetCpuInfo(const std::string& desc) {
+  if (desc.empty()) {
+    return GetGenericHostCpuInfo();
+  }
+  if (desc == "native") {
+    return GetHostCpuInfo();
+  }
+  auto info = MakeGenericCpuInfo();
+  auto n = const_cast<CpuInfoNode*>(info.as<CpuInfoNode>());
+  std::istringstream is(desc);
+  std::string item;
+  bool simd_given = false;
+  bool isa_given = false;
+  while (std::getline(is, item, ',')) {
+    auto pos = item.find('=');
+    CHECK(pos != std::string::npos) << "Invalid cpu info item " << item << " in " << desc;
+    auto key = item.substr(0, pos);
+    if (key == "isa") {
+      n->isa = item.substr(pos + 1);
+      std::replace(n->isa.begin(), n->isa.end(), '+', ',');
+      isa_given = true;
+      if (!simd_given) {
+        n->simd_bytes = SimdBytes(n->isa);
+      }
+      continue;
+    }
+    int value = ParseSize(item.substr(pos + 1));
+    CHECK_GT(value, 0) << "Invalid cpu info item " << item << " in " << desc;
+    if (key == "l1") {
+      n->l1_bytes = value;
+    } else if (key == "l2") {
+      n->l2_bytes = value;
+    } else if (key == "l3") {
+      n->l3_bytes = value;
+    } else if (key == "line") {
+      n->cache_line_bytes = value;
+    } else if (key == "cores") {
+      n->core_num = value;
+    } else if (key == "simd") {
+      n->simd_bytes = value;
+      simd_given = true;
+    } else {
+      LOG(FATAL) << "Unknown cpu info key " << key << " in " << desc;
+    }
+  }
+  if (!isa_given) {
+    n->isa = simd_given ? IsaOfSimd(n->simd_bytes) : GenericIsa();
+  }
+  return info;
+}
+
+std::string GetLLVMTarget(const std::string& target, const CpuInfo& info) {
+  if (target.find("-mcpu") != std::string::npos || target.find("-mattr") != std::string::npos) {
+    return target;
+  }
+  if (info.same_as(GetHostCpuInfo())) {
+    return target + " -mcpu=native";
+  }
+  std::string mattr;
+#if defined(__x86_64__) || defined(__i386__)
+  // avx2 stands for avx2 with fma3 in the isa, as the gemm kernels need both.
+  static const std::vector<std::pair<std::string, std::string>> attrs = {
+    {"avx", "+avx"}, {"avx2", "+avx2,+fma"}, {"avx512", "+avx512f"}, {"avx512_vnni", "+avx512vnni"}};
+  for (const auto& attr : attrs) {
+    if (HasIsa(info->isa, attr.first)) {
+      mattr += (mattr.empty() ? "" : ",") + attr.second;
+    }
+  }
+#endif
+  return mattr.empty() ? target : target + " -mattr=" + mattr;
+}
+
+int GetCpuThreadNum(const CpuInfo& info) {
+  const runtime::PackedFunc* f = runtime::Registry::Get("cpu.info.thread_num");
+  if (f == nullptr || !(info.same_as(GetHostCpuInfo()) || info.same_as(GetGenericHostCpuInfo()))) {
+    return info->core_num;
+  }
+  return (*f)();
+}
+
+TVM_REGISTER_GLOBAL("akg.GetCpuInfo").set_body_typed(GetCpuInfo);
+
+#ifdef TVM_LLVM_VERSION
+// The cpu runtime pool is built with llvm only, it sizes the parallel loops of the cpu tiling.
+TVM_REGISTER_GLOBAL("cpu.info.thread_num").set_body_typed<int()>([]() {
+  return static_cast<int>(mindspore::common::MaxThreadNumber());
+});
+#endif
+
 }  // namespace air
@@ -51,5 +51,74 @@ TVM_DEFINE_NODE_REF(GpuMemoryInfo, GpuMemoryInfoNode);
  */
 TVM_DLL GpuMemoryInfo GetGpuMemoryInfo(const std::string& scope);
 
+/*!
+ * \brief Cache hierarchy, core number and vector width of a cpu target.
+ *  Use CpuInfoNode as its container type
+ */
+struct CpuInfoNode : public Node {
+  /*! \brief Data cache size of each level in bytes, L1 and L2 are per core, L3 is shared */
+  int l1_bytes;
+  int l2_bytes;
+  int l3_bytes;
+  /*! \brief Cache line size in bytes */
+  int cache_line_bytes;
+  /*! \brief Number of logical cores that run kernel threads */
+  int core_num;
+  /*! \brief Width of the widest vector register in bytes */
+  int simd_bytes;
+  /*!
+   * \brief Instruction set extensions in the format of the cpu feature attr, e.g. "sse,avx,avx2,avx512,avx512_vnni"
+   *  or "neon", empty when unknown
+   */
+  std::string isa;
+
+  void VisitAttrs(AttrVisitor* v) {
+    v->Visit("l1_bytes", &l1_bytes);
+    v->Visit("l2_bytes", &l2_bytes);
+    v->Visit("l3_bytes", &l3_bytes);
+    v->Visit("cache_line_bytes", &cache_line_bytes);
+    v->Visit("core_num", &core_num);
+    v->Visit("simd_bytes", &simd_bytes);
+    v->Visit("isa", &isa);
+  }
+
+  static constexpr const char* _type_key = "CpuInfo";
+  TVM_DECLARE_NODE_TYPE_INFO(CpuInfoNode, Node);
+};
+
+/*! \brief Defines cpu info */
+TVM_DEFINE_NODE_REF(CpuInfo, CpuInfoNode);
+
+/*!
+ * \brief get cpu info of the build host, detected once per process from sysfs and cpuid.
+ * \return info The cpu info.
+ */
+TVM_DLL CpuInfo GetHostCpuInfo();
+
+/*!
+ * \brief get cpu info of a target, the one description both the cpu tiling and the llvm target machine follow.
+ * \param desc Empty for the build host with the vector extensions of generic llvm code, "native" for the build host
+ *  with all its extensions. Otherwise a cross target description such as
+ *  "l1=32K,l2=1M,l3=32M,line=64,cores=16,simd=64,isa=avx2+avx512", keys not given take generic values and a simd
+ *  width without isa takes the x86 extensions of that width.
+ * \return info The cpu info.
+ */
+TVM_DLL CpuInfo GetCpuInfo(const std::string& desc);
+
+/*!
+ * \brief get the llvm target that emits code for a cpu target.
+ * \param target The llvm target, an explicit -mcpu or -mattr in it is kept as given.
+ * \param info The cpu info.
+ * \return The target with -mcpu=native for the build host, or -mattr of the instruction sets of info.
+ */
+TVM_DLL std::string GetLLVMTarget(const std::string& target, const CpuInfo& info);
+
+/*!
+ * \brief get the number of threads parallel loops of a cpu target run with.
+ * \param info The cpu info.
+ * \return The thread number of the cpu runtime for the build host, otherwise the core number of info.
+ */
+TVM_DLL int GetCpuThreadNum(const CpuInfo& info);
+
 }  // namespace air
 #endif  // AKG_TARGET_INFO_H_
@@ -19,11 +19,13 @@
 #include <vector>
 #include <pass/utils.h>
 #include "build_module.h"
+#include "codegen/compile_profiler.h"
 #include "codegen/lower.h"
 #include "codegen/pass_mgr.h"
 #include "codegen/stage_lower.h"
 #include "composite/utils/dimension_peeling.h"
 #include "composite/utils/dump.h"
+#include "composite/utils/kernel_cache.h"
 #include "composite/utils/util.h"
 #include "composite/lower_tree/base_node.h"
 #include "composite/lower_tree/json_leaf.h"
@@ -119,15 +121,37 @@ BaseLowerNodePtr ConstructLowerTree(const std::string &target, bool poly, const
 
 Module LowerCompositeToModule(const std::string &target, bool poly, const std::string &segment_tree_str,
                               const Map<std::string, NodeRef> &segment_infos) {
+  auto &cache = KernelCache::Instance();
+  std::string cache_key;
+  if (cache.Enabled()) {
+    cache_key = cache.Key(target, poly, segment_tree_str, segment_infos);
+    Module module;
+    std::string kernel_name;
+    if (cache.Load(cache_key, &module, &kernel_name)) {
+      if (!kernel_name.empty()) {
+        DumpModuleCode(module, kernel_name, GetRealTarget(target));
+      }
+      return module;
+    }
+  }
+
+  CompileScope compile_scope;
+  ProfileScope profile("composite", "LowerCompositeToModule");
   auto build_str = std::string(kModule) + "0[" + segment_tree_str + "]";
   auto build_root = std::dynamic_pointer_cast<ModuleLowerNode>(
     ConstructLowerTree(GetRealTarget(target), poly, build_str, segment_infos));
   build_root->Process();
-  return build_root->GetModule();
+  auto module = build_root->GetModule();
+  // The stage lowers keep kPolyFallback in their own attrs, a fallback is seen through the compile context.
+  if (!cache_key.empty() && !PolyFellBack()) {
+    cache.Store(cache_key, module, build_root->GetKernelName());
+  }
+  return module;
 }
 
 NodeRef TuneComposite(const std::string &target, bool poly, const std::string &segment_tree_str,
                       const Map<std::string, NodeRef> &segment_infos) {
+  CompileScope compile_scope;
   auto build_str = std::string(kTune) + "0[" + segment_tree_str + "]";
   auto lower_root = ConstructLowerTree(GetRealTarget(target), poly, build_str, segment_infos);
   lower_root->Run();
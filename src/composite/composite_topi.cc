@@ -742,7 +742,9 @@ TVM_REGISTER_GLOBAL("BroadcastTo").set_body([](TVMArgs args, TVMRetValue *rv) {
   }
 });
 
-void BatchMatMul(const TVMArgs &args, TVMRetValue *rv) {
+// widen_int: int8 operands of an int32 dst_type are cast to int32 before the product, as the cpu int8 gemm kernel
+// accumulates them.
+void BatchMatMul(const TVMArgs &args, TVMRetValue *rv, bool widen_int = false) {
   CHECK_GE(args.size(), 2);
   auto inputs = args[0].operator Array<NodeRef>();
   auto attrs = args[1].operator OpAttr();
@@ -785,8 +787,8 @@ void BatchMatMul(const TVMArgs &args, TVMRetValue *rv) {
 
   size_t batch_dim = 0;
   IterVar reduce_k;
-  auto fcompute = [&left_matrix, &right_matrix, &transpose_a, &transpose_b, &reduce_k, &batch_dim,
-                   &dst_type](const Array<Var> &indices) {
+  auto fcompute = [&left_matrix, &right_matrix, &transpose_a, &transpose_b, &reduce_k, &batch_dim, &dst_type,
+                   widen_int](const Array<Var> &indices) {
     Array<Expr> left_indice;
     Array<Expr> right_indice;
     for (size_t i = 0; i < batch_dim; ++i) {
@@ -818,6 +820,10 @@ void BatchMatMul(const TVMArgs &args, TVMRetValue *rv) {
     if (dst_type == "float32") {
       left_buffer = Cast::make(Float(32), left_buffer);
       right_buffer = Cast::make(Float(32), right_buffer);
+    } else if (dst_type == "int32" && widen_int) {
+      // int8 products would overflow before the sum.
+      left_buffer = Cast::make(Int(32), left_buffer);
+      right_buffer = Cast::make(Int(32), right_buffer);
     }
 
     auto matrix_mul = Mul::make(left_buffer, right_buffer);
@@ -834,7 +840,7 @@ void BatchMatMul(const TVMArgs &args, TVMRetValue *rv) {
   *rv = compute(output_shape, fcompute, name, "matmul");
 }
 
-TVM_REGISTER_GLOBAL("CpuBatchMatMul").set_body([](TVMArgs args, TVMRetValue *rv) { BatchMatMul(args, rv); });
+TVM_REGISTER_GLOBAL("CpuBatchMatMul").set_body([](TVMArgs args, TVMRetValue *rv) { BatchMatMul(args, rv, true); });
 
 TVM_REGISTER_GLOBAL("CudaBatchMatMul").set_body([](TVMArgs args, TVMRetValue *rv) {
   CHECK_GE(args.size(), 2);
@@ -19,6 +19,7 @@
 #include <set>
 #include <vector>
 #include <utility>
+#include "codegen/compile_profiler.h"
 
 namespace akg {
 namespace lower {
@@ -43,9 +44,12 @@ Map<std::string, NodeRef> AddNamePosfix(const std::string &name, const Map<std::
 }
 
 void BaseLowerNode::Excute(BaseLowerNodePtr child, const Map<std::string, NodeRef> &forward_infos, bool is_clean,
-                           bool pass_out_backward_info) {
+                           bool pass_out_backward_info, StageType entrance) {
+  if (entrance == StageType::Unknown) {
+    entrance = entrance_stage_;
+  }
   if (child->current_stage_ == StageType::Unknown ||
-      (data_ && StageTypeLT(target_, child->current_stage_, entrance_stage_))) {
+      (data_ && StageTypeLT(target_, child->current_stage_, entrance))) {
     auto pass_forward_info = is_clean ? Map<std::string, NodeRef>{} : forward_infos_;
     for (auto iter : forward_infos) {
       pass_forward_info.Set(iter.first, iter.second);
@@ -53,7 +57,14 @@ void BaseLowerNode::Excute(BaseLowerNodePtr child, const Map<std::string, NodeRe
 
     child->ReceiveForwardInfos(pass_forward_info);
     child->CleanBackwardInfos();
-    child->Run(entrance_stage_);
+    {
+      ProfileScope profile("lower", child->name_);
+      child->Run(entrance);
+    }
+    // The rest of a single child node lowers the kernel of its child.
+    if (children_.size() == 1 && child->data_.defined()) {
+      CompileProfiler::SetKernel(child->data_->name);
+    }
 
     if (pass_out_backward_info) {
       UpdateBackwardInfos(child->BackwardInfos());
@@ -68,8 +68,10 @@ class BaseLowerNode {
   explicit BaseLowerNode(const std::string &target) : target_(target) { name_ = __FUNCTION__; }
   virtual ~BaseLowerNode() = default;
 
+  // Runs child up to `entrance`, which defaults to entrance_stage_. Does not write this node unless
+  // pass_out_backward_info is set, so sibling children may be run concurrently.
   void Excute(BaseLowerNodePtr child, const Map<std::string, NodeRef> &forward_infos = {}, bool is_clean = false,
-              bool pass_out_backward_info = true);
+              bool pass_out_backward_info = true, StageType entrance = StageType::Unknown);
   virtual void ExcuteImpl(StageType s) {}
   void Run(StageType s = StageType::Unknown) {
     if (IsSkipped()) {
@@ -308,6 +308,58 @@ class BlockIndexRewrite final : public IRMutator {
   int offset_;
 };
 
+bool IsCpuTaskPrologue(const Stmt &s) {
+  if (s.as<Allocate>() || s.as<LetStmt>() || s.as<ProducerConsumer>()) {
+    return true;
+  }
+  auto attr = s.as<AttrStmt>();
+  return attr != nullptr && !air::ir::attr::IsPragmaKey(attr->attr_key);
+}
+
+Stmt GetPrologueBody(const Stmt &s) {
+  if (auto op = s.as<Allocate>()) return op->body;
+  if (auto op = s.as<LetStmt>()) return op->body;
+  if (auto op = s.as<ProducerConsumer>()) return op->body;
+  auto op = s.as<AttrStmt>();
+  CHECK(op);
+  return op->body;
+}
+
+CpuTaskLoop GetCpuTaskLoop(const Stmt &stmt) {
+  CpuTaskLoop res;
+  Stmt s = stmt;
+  while (IsCpuTaskPrologue(s)) {
+    res.prologue.push_back(s);
+    s = GetPrologueBody(s);
+  }
+  auto loop = s.as<For>();
+  if (loop != nullptr && loop->for_type == ForType::Parallel && loop->extent.as<IntImm>() &&
+      loop->extent.as<IntImm>()->value > 0) {
+    res.loop = loop;
+  } else {
+    res.prologue.clear();
+  }
+  return res;
+}
+
+Stmt WrapCpuTaskPrologue(const std::vector<Stmt> &prologue, Stmt body) {
+  for (auto it = prologue.rbegin(); it != prologue.rend(); ++it) {
+    if (auto op = it->as<Allocate>()) {
+      body = Allocate::make(op->buffer_var, op->type, op->extents, op->condition, body, op->new_expr,
+                            op->free_function);
+    } else if (auto op = it->as<LetStmt>()) {
+      body = LetStmt::make(op->var, op->value, body);
+    } else if (auto op = it->as<ProducerConsumer>()) {
+      body = ProducerConsumer::make(op->func, op->is_producer, body);
+    } else {
+      auto attr = it->as<AttrStmt>();
+      CHECK(attr);
+      body = AttrStmt::make(attr->node, attr->attr_key, attr->value, body);
+    }
+  }
+  return body;
+}
+
 void RemoveDimInfo(std::vector<FuncInfo> &funcs) {
   for (auto &func : funcs) {
     func.stmt = RemoveDimAttr().Mutate(func.stmt);
@@ -879,6 +931,93 @@ class LowerBlockFusionAscend : public LowerStmtsFusion {
   size_t max_block_num_;
 };
 
+class LowerBlockFusionCpu : public LowerStmtsFusion {
+ public:
+  LowerBlockFusionCpu() {
+    func_transforms_ = {
+      // 1. Hoist the prologue of each outermost parallel loop and turn its iterations into tasks.
+      std::bind(&LowerBlockFusionCpu::ProcessTask, this, std::placeholders::_1),
+      // 2. Merge ir with IfThenElse on the task index.
+      std::bind(&LowerBlockFusionCpu::MergeIr, this, std::placeholders::_1),
+    };
+    stmt_transforms_ = {
+      // Add the parallel task loop, which the thread pool partitions.
+      std::bind(&LowerBlockFusionCpu::AddTaskLoop, this, std::placeholders::_1),
+    };
+  }
+  ~LowerBlockFusionCpu() = default;
+
+ private:
+  void VariableReset() override {
+    task_var_ = Var("task_idx", Int(32));
+    prologue_.clear();
+    unfused_.clear();
+    max_task_info_.clear();
+    max_task_num_ = 0;
+  }
+
+  void ProcessTask(std::vector<FuncInfo> &funcs) {
+    /*
+     * A stmt starting with a parallel loop gives one task per iteration:
+     * ========================================
+     * // attr [...] storage_scope = "global"
+     * allocate T0[...]
+     * parallel (i, 0, 64) { S0(i) }
+     * ========================================
+     * becomes the prologue "allocate T0", which is hoisted out of the task loop, and 64 tasks S0(task_idx - offset).
+     * Any other stmt is left out of the task loop with its own parallel loops, the thread pool does not run nested
+     * ones.
+     */
+    std::vector<FuncInfo> task_funcs;
+    for (auto &func : funcs) {
+      auto task_loop = GetCpuTaskLoop(func.stmt);
+      if (task_loop.loop == nullptr) {
+        unfused_.push_back(func.stmt);
+        continue;
+      }
+      auto loop = task_loop.loop;
+      int offset = static_cast<int>(max_task_num_);
+      prologue_.insert(prologue_.end(), task_loop.prologue.begin(), task_loop.prologue.end());
+      Expr task = air::cast(loop->loop_var.type(), offset == 0 ? Expr(task_var_) : task_var_ - offset);
+      std::unordered_map<const Variable *, Expr> vmap = {{loop->loop_var.get(), loop->min + task}};
+      func.stmt = Substitute(loop->body, vmap);
+      max_task_num_ += static_cast<size_t>(loop->extent.as<IntImm>()->value);
+      max_task_info_.emplace_back(max_task_num_);
+      task_funcs.push_back(func);
+    }
+    funcs = task_funcs;
+  }
+
+  void MergeIr(std::vector<FuncInfo> &funcs) {
+    if (funcs.empty()) {
+      res_stmt_ = Stmt();
+      return;
+    }
+    Stmt res_stmt = funcs.back().stmt;
+    for (size_t i = funcs.size() - 1; i > 0; --i) {
+      auto &func = funcs[i - 1];
+      res_stmt = IfThenElse::make(task_var_ < static_cast<int>(max_task_info_[i - 1]), func.stmt, res_stmt);
+    }
+    res_stmt_ = res_stmt;
+  }
+
+  void AddTaskLoop(Stmt &stmt) {
+    std::vector<Stmt> stmts;
+    if (stmt.defined()) {
+      stmt = For::make(task_var_, 0, static_cast<int>(max_task_num_), ForType::Parallel, DeviceAPI::None, stmt);
+      stmts.push_back(WrapCpuTaskPrologue(prologue_, stmt));
+    }
+    stmts.insert(stmts.end(), unfused_.begin(), unfused_.end());
+    stmt = Block::make(stmts);
+  }
+
+  Var task_var_;
+  std::vector<Stmt> prologue_;
+  std::vector<Stmt> unfused_;
+  std::vector<size_t> max_task_info_;
+  size_t max_task_num_;
+};
+
 using PipelineFusionPtr = std::shared_ptr<LowerPipelineFusion>;
 using BlockFusionPtr = std::shared_ptr<LowerStmtsFusion>;
 
@@ -903,6 +1042,8 @@ inline BlockFusionPtr GetBlockFusionByPlatform(const std::string &target) {
     return std::make_shared<LowerBlockFusionAscend>();
   } else if (target == "cuda") {
     return std::make_shared<LowerBlockFusionGpu>();
+  } else if (target == "llvm") {
+    return std::make_shared<LowerBlockFusionCpu>();
   }
 
   LOG(FATAL) << "Unsupport target: " << target;
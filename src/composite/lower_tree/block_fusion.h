@@ -21,6 +21,15 @@
 
 namespace akg {
 namespace ir {
+// Outermost parallel loop of a cpu stmt and the allocations, attrs and lets wrapping it. loop is nullptr when the stmt
+// does not start with a parallel loop of constant extent.
+struct CpuTaskLoop {
+  std::vector<Stmt> prologue;
+  const For *loop{nullptr};
+};
+CpuTaskLoop GetCpuTaskLoop(const Stmt &stmt);
+Stmt WrapCpuTaskPrologue(const std::vector<Stmt> &prologue, Stmt body);
+
 std::vector<Stmt> PipelineFusion(const std::vector<Stmt> &stmts, const Array<Array<NodeRef>> &pipeline_groups,
                                  const std::string &target);
 Stmt BlockFusion(const std::vector<Stmt> &stmts, const std::string &target);
@@ -29,7 +29,7 @@ constexpr auto kKernelName = "kernel_name";
 }  // namespace
 void JsonLowerLeaf::ExcuteImpl(StageType s) {
   if (forward_infos_.find(kCatch) != forward_infos_.end()) {
-    backward_infos_.Set(kBlockJsons, Expr(json_str_));
+    backward_infos_.Set(kBlockJsons, desc_->JsonStr());
     backward_infos_.Set(kBlockAttrs, attrs_);
     return;
   }
@@ -38,7 +38,7 @@ void JsonLowerLeaf::ExcuteImpl(StageType s) {
   ModifyAttrs(forward_infos_, info, &attrs_);
   ModifyBackwardInfos(forward_infos_, attrs_, info, &backward_infos_);
   data_ = LowerDataNode::make(GetScheduleWithBuildInfo(info), info.args, info.in_binds, attrs_,
-                              GetProcess(String2Json(json_str_)), info.kernel_name, GetConfig(), polyhedral_);
+                              desc_->Process(), info.kernel_name, GetConfig(), polyhedral_);
   ModifyData(forward_infos_, data_);
   current_stage_ = StageType::Begin;
 }
@@ -67,7 +67,7 @@ BuildInfo JsonLowerLeaf::GenBuildInfo(Map<std::string, NodeRef> &attrs) {
 
   ModifyInfoBeforeExtract(attrs, forward_infos_, &info);
 
-  ExtractBuildInfo(String2Json(json_str_), info);
+  ExtractBuildInfo(desc_->Json(), info);
 
   if (attrs.find(kKernelName) != attrs.end()) {
     CHECK(attrs[kKernelName]->IsInstance<StringImm>());
@@ -190,7 +190,7 @@ ProcDataFuncList JsonProc::GetProcDataFuncs(const std::string &target, JsonStage
 
 BaseLowerNodePtr CreateJsonLowerLeaf(const std::string &target, bool poly,
                                      const Map<std::string, NodeRef> &construct_infos) {
-  auto json_str = construct_infos[kJsonStr].as<StringImm>()->value;
+  auto json_str = Downcast<Expr>(construct_infos[kJsonStr]);
   auto attrs = Downcast<Map<std::string, NodeRef>>(construct_infos[kAttrs]);
   return std::make_shared<JsonLowerLeaf>(target, json_str, attrs, poly);
 }
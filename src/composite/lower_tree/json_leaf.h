@@ -27,6 +27,7 @@
 #include "codegen/pass_mgr.h"
 #include "codegen/stage_lower.h"
 #include "composite/utils/dump.h"
+#include "composite/utils/kernel_desc.h"
 #include "composite/utils/util.h"
 #include "composite/lower_tree/base_node.h"
 
@@ -36,9 +37,9 @@ constexpr auto kP = "P";
 
 class JsonLowerLeaf : public BaseLowerNode {
  public:
-  JsonLowerLeaf(const std::string &target, const std::string &json_str, const Map<std::string, NodeRef> &attrs,
+  JsonLowerLeaf(const std::string &target, const Expr &json_str, const Map<std::string, NodeRef> &attrs,
                 bool poly = true)
-      : BaseLowerNode(target), json_str_(json_str), attrs_(attrs), polyhedral_(poly) {
+      : BaseLowerNode(target), desc_(KernelDesc::Get(json_str)), attrs_(attrs), polyhedral_(poly) {
     name_ = __FUNCTION__;
   }
   ~JsonLowerLeaf() = default;
@@ -56,7 +57,7 @@ class JsonLowerLeaf : public BaseLowerNode {
   void ModifyInfoAfterExtract(Map<std::string, NodeRef> &attrs, Map<std::string, NodeRef> &forward_infos,
                               BuildInfo *info);
 
-  std::string json_str_;
+  KernelDescPtr desc_;
   Map<std::string, NodeRef> attrs_;
   bool polyhedral_{true};
   std::string origin_kernel_name_;
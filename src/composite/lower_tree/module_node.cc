@@ -24,7 +24,11 @@ namespace lower {
 void ModuleLowerNode::Process() {
   CHECK(children_.size() == 1);
   Excute(children_[0]);
-  auto build_rst = BuildRstNode::make(children_[0]->Node(), children_[0]->Data()->name);
+  kernel_name_ = children_[0]->Data()->name;
+  AttrMap attrs;
+  attrs = children_[0]->Data()->attrs;
+  auto build_rst = BuildRstNode::make(children_[0]->Node(), kernel_name_, attrs.GetStr("cpu_info", ""),
+                                     attrs.GetBool("kernel_cost", false));
   CHECK(build_rst.defined());
   module_ = BuildToModule(build_rst, children_[0]->Data()->target);
 }
@@ -32,9 +32,11 @@ class ModuleLowerNode : public BaseLowerNode {
 
   void Process();
   Module GetModule() { return module_; }
+  std::string GetKernelName() { return kernel_name_; }
 
  private:
   Module module_;
+  std::string kernel_name_;
 };
 }  // namespace lower
 }  // namespace akg
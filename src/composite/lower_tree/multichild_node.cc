@@ -15,6 +15,7 @@
  */
 
 #include "composite/lower_tree/multichild_node.h"
+#include <chrono>
 #include "composite/lower_tree/json_leaf.h"
 #include "composite/lower_tree/stitch_fusion.h"
 #include "composite/lower_tree/sync_process.h"
@@ -148,9 +149,8 @@ Array<Expr> AddInnerForAndBlockInfo::FixArgs(const Array<Expr> &args, const std:
   return new_args;
 }
 
-std::unordered_map<std::string, Peeling> GetOriginPeelInfo(const std::string &stitch_origin_json,
+std::unordered_map<std::string, Peeling> GetOriginPeelInfo(const picojson::value &stitch_origin_json,
                                                            const Map<std::string, NodeRef> &attrs, bool fold_dim) {
-  picojson::value v = String2Json(stitch_origin_json);
   BuildInfo info;
   info.opt.fold_dim = fold_dim;
   if (attrs.find(kPeeling) != attrs.end()) {
@@ -158,7 +158,7 @@ std::unordered_map<std::string, Peeling> GetOriginPeelInfo(const std::string &st
     CHECK(peeling != nullptr);
     info.opt.peel_info.peeling = peeling->value;
   }
-  ExtractBuildInfo(v, info);
+  ExtractBuildInfo(stitch_origin_json, info);
   return info.opt.peel_info.GetPeelTensors();
 }
 
@@ -441,6 +441,56 @@ Map<std::string, NodeRef> MultiChildLowerNode::GetCommonForwardInfo() {
   return forward_infos;
 }
 
+void MultiChildLowerNode::ExcuteChildren(const std::function<void(size_t)> &excute_child) {
+  using Clock = std::chrono::steady_clock;
+  std::vector<double> child_ms(children_.size(), 0);
+  auto start = Clock::now();
+  ParallelCompile(children_.size(), [&excute_child, &child_ms](size_t idx) {
+    auto child_start = Clock::now();
+    excute_child(idx);
+    child_ms[idx] = std::chrono::duration<double, std::milli>(Clock::now() - child_start).count();
+  });
+  if (getenv(GetDumpIRFlag().c_str()) != nullptr) {
+    double wall_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::stringstream ss;
+    ss << name_ << " lowered " << children_.size() << " children in " << wall_ms << " ms, per child (ms):";
+    for (auto ms : child_ms) {
+      ss << " " << ms;
+    }
+    LOG(INFO) << ss.str();
+  }
+}
+
+void MultiChildLowerNode::ExcuteAndMerge(StageType to, const std::string &kind) {
+  CHECK(children_.size() > 1);
+  std::vector<LowerData> datas;
+  std::vector<Stmt> irs;
+  // 1. Run children concurrently.
+  ExcuteChildren([this, &kind](size_t i) {
+    auto forward_infos = GetCommonForwardInfo();
+    forward_infos = AddNamePosfix(kind, forward_infos_, i, true, forward_infos);
+    Excute(children_[i], forward_infos, false, false);
+  });
+
+  // 2. Collect child results in order.
+  for (auto &child : children_) {
+    UpdateBackwardInfos(child->BackwardInfos());
+    auto data = child->Data();
+    CollectOutputMap(data, backward_infos_, outputs2args_);
+    for (const auto &x : data->arg_list_0) {
+      all_args_.push_back(x);
+    }
+    datas.push_back(data);
+    irs.push_back(Downcast<Stmt>(child->Node()));
+  }
+
+  // 3. Merge datas and irs.
+  Merge(datas, irs);
+
+  // 4. Run with merge infos.
+  Postprocess(to);
+}
+
 REG_INFO_FUNC_BEFORE(kCce, "MultiChildLowerNode", ModifyInfoPeeling);
 REG_BACKWARD_FUNC(kCuda, "MultiChildLowerNode", ModifyBackwardNames);
 REG_BACKWARD_FUNC(kCce, "MultiChildLowerNode", ModifyBackwardNames);
@@ -34,7 +34,7 @@ constexpr auto kInputNames = "input_names";
 constexpr auto kOutputNames = "output_names";
 constexpr auto kPeeledTensors = "peeled_tensors";
 constexpr auto kPeeling = "peeling";
-std::unordered_map<std::string, Peeling> GetOriginPeelInfo(const std::string &stitch_origin_json,
+std::unordered_map<std::string, Peeling> GetOriginPeelInfo(const picojson::value &stitch_origin_json,
                                                            const Map<std::string, NodeRef> &attrs, bool fold_dim);
 Map<std::string, Array<NodeRef>> PeelingToNodeRef(const std::unordered_map<std::string, Peeling> &peeled_tensors);
 std::unordered_map<std::string, Peeling> NodeRefToPeeling(const Map<std::string, Array<NodeRef>> &peeled_noderef);
@@ -115,6 +115,13 @@ class MultiChildLowerNode : public BaseLowerNode {
 
   Map<std::string, NodeRef> GetCommonForwardInfo();
 
+  // Runs excute_child(i) for every child on compile threads. Children must not pass their backward infos out here;
+  // callers collect them in child order afterwards, so the merged result is the same as a serial run.
+  void ExcuteChildren(const std::function<void(size_t)> &excute_child);
+  // Runs the children concurrently with the name posfix of kind, collects their results in order, merges them and runs
+  // the merged kernel to `to`.
+  void ExcuteAndMerge(StageType to, const std::string &kind);
+
   void Postprocess(StageType to);
   void CollectOutputMap(const LowerData &data, const Map<std::string, NodeRef> &backward_info,
                         std::unordered_map<std::string, NodeRef> &outputs2args);
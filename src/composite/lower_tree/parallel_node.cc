@@ -26,32 +26,7 @@
 namespace akg {
 namespace lower {
 constexpr auto kBlockPlan = "block_plan";
-void CudaParallelLowerNode::ExcuteImpl(StageType to) {
-  CHECK(children_.size() > 1);
-  std::vector<LowerData> datas;
-  std::vector<Stmt> block_irs;
-  // 1. Run child.
-  for (size_t i = 0; i < children_.size(); ++i) {
-    auto &child = children_[i];
-    auto forward_infos = GetCommonForwardInfo();
-    forward_infos = AddNamePosfix(kParallel, forward_infos_, i, true, forward_infos);
-
-    Excute(child, forward_infos);
-    auto data = child->Data();
-    CollectOutputMap(data, backward_infos_, outputs2args_);
-    for (const auto &x : data->arg_list_0) {
-      all_args_.push_back(x);
-    }
-    datas.push_back(data);
-    block_irs.push_back(Downcast<Stmt>(child->Node()));
-  }
-
-  // 2. Merge datas and block irs.
-  Merge(datas, block_irs);
-
-  // 3. Run with merge infos.
-  Postprocess(to);
-}
+void CudaParallelLowerNode::ExcuteImpl(StageType to) { ExcuteAndMerge(to, kParallel); }
 
 void CudaParallelLowerNode::PostUpdateDataAndNodeRef(LowerData &data, NodeRef &) {
   data->arg_list_0 = ReorderArgs(inputs_, outputs_, all_args_, outputs2args_);
@@ -70,30 +45,56 @@ Stmt CudaParallelLowerNode::MergeStmts(const LowerData &data, std::vector<Stmt>
   return merged_ir;
 }
 
+void CpuParallelLowerNode::ExcuteImpl(StageType to) { ExcuteAndMerge(to, kParallel); }
+
+void CpuParallelLowerNode::PostUpdateDataAndNodeRef(LowerData &data, NodeRef &) {
+  data->arg_list_0 = ReorderArgs(inputs_, outputs_, all_args_, outputs2args_);
+}
+
+Stmt CpuParallelLowerNode::MergeStmts(const LowerData &data, std::vector<Stmt> &block_irs) {
+  auto dump_mng = DumpManager(data->name + "_merge", data->config->dump_pass_ir);
+  DUMP_ORIGIN_IR(dump_mng, block_irs);
+
+  // The parallel loops of the children become tasks of one parallel loop, so the kernel enters the thread pool once.
+  // Children without a single parallel loop of constant extent keep their own loops.
+  Stmt merged_ir;
+  TRANSFORM_AND_TRY_DUMP(dump_mng, merged_ir, ir::BlockFusion, block_irs, target_);
+  auto ElimDupInputs = [](Stmt stmt, const Array<NodeRef> &inputs) { return ElimDuplicateInputs(inputs).Run(stmt); };
+  TRANSFORM_AND_TRY_DUMP(dump_mng, merged_ir, ElimDupInputs, merged_ir, inputs_);
+  return merged_ir;
+}
+
 void AscendParallelLowerNode::ExcuteImpl(StageType to) {
   CHECK(children_.size() > 1);
   std::vector<LowerData> datas;
   std::vector<Stmt> block_irs;
-  // 1. Run child.
-  for (size_t i = 0; i < children_.size(); ++i) {
+  // 1. Run children concurrently, the ones with block plan stop before flattern.
+  std::vector<Map<std::string, NodeRef>> children_attrs(children_.size());
+  ExcuteChildren([this, &children_attrs](size_t i) {
     auto &child = children_[i];
 
     // Catch child's attrs.
     Map<std::string, NodeRef> catch_forward_info;
     catch_forward_info.Set(kCatch, Expr("JsonLowerLeaf"));
     Excute(child, catch_forward_info, true, false);
-    auto child_attrs = Downcast<Map<std::string, NodeRef>>(child->BackwardInfos()[kBlockAttrs]);
+    children_attrs[i] = Downcast<Map<std::string, NodeRef>>(child->BackwardInfos()[kBlockAttrs]);
 
-    LowerData block_data;
-    NodeRef block_ir;
-    Map<std::string, NodeRef> backward_infos;
     auto forward_infos = GetCommonForwardInfo();
     forward_infos = AddNamePosfix(kParallel, forward_infos_, i, true, forward_infos);
-    if (child_attrs.find(kBlockPlan) != child_attrs.end()) {
-      auto old_entrance_stage = entrance_stage_;
-      entrance_stage_ = StageType::BeforeFlattern;
+    auto entrance = children_attrs[i].find(kBlockPlan) != children_attrs[i].end() ? StageType::BeforeFlattern
+                                                                                  : entrance_stage_;
+    Excute(child, forward_infos, false, false, entrance);
+  });
+
+  // 2. Collect child results in order, peeling touches all args collected so far.
+  for (size_t i = 0; i < children_.size(); ++i) {
+    auto &child = children_[i];
+    auto &child_attrs = children_attrs[i];
+    UpdateBackwardInfos(child->BackwardInfos());
 
-      Excute(child, forward_infos);
+    LowerData block_data;
+    NodeRef block_ir;
+    if (child_attrs.find(kBlockPlan) != child_attrs.end()) {
       auto data = child->Data();
 
       std::unordered_map<std::string, NodeRef> tmp_outputs2args;
@@ -105,20 +106,18 @@ void AscendParallelLowerNode::ExcuteImpl(StageType to) {
       PeelInfo peel_info = GetPeelInfoFromAttrs(child_attrs);
 
       StageLower stage_lower(data, child->Node(),
-                             StageManager::Instance().NextStageType(data_->target, entrance_stage_));
+                             StageManager::Instance().NextStageType(data_->target, StageType::BeforeFlattern));
       stage_lower.ApplyMutator(
         [this, &peel_info, &tmp_outputs2args, &block](NodeRef &node_ref, LowerData &data) -> NodeRef {
           auto stmt = Downcast<Stmt>(node_ref);
           stmt = AddPeelInfoAndBlockAttr(stmt, data, peel_info, tmp_outputs2args, block);
           return NEXT_PASS(CanonicalSimplify, stmt);
         });
-      stage_lower.RunTo(old_entrance_stage);
+      stage_lower.RunTo(entrance_stage_);
 
       block_ir = stage_lower.Node();
       block_data = stage_lower.Data();
-      entrance_stage_ = old_entrance_stage;
     } else {
-      Excute(child, forward_infos);
       block_ir = child->Node();
       block_data = child->Data();
     }
@@ -131,10 +130,10 @@ void AscendParallelLowerNode::ExcuteImpl(StageType to) {
     block_irs.push_back(Downcast<Stmt>(block_ir));
   }
 
-  // 2. Merge datas and block irs.
+  // 3. Merge datas and block irs.
   Merge(datas, block_irs);
 
-  // 3. Run with merge infos.
+  // 4. Run with merge infos.
   Postprocess(to);
 }
 
@@ -169,6 +168,14 @@ BaseLowerNodePtr CreateCudaParallelLowerNode(const std::string &target, bool,
                                                  Downcast<Array<NodeRef>>(construct_infos[kKernelOutputs]));
 }
 
+BaseLowerNodePtr CreateCpuParallelLowerNode(const std::string &target, bool,
+                                            const Map<std::string, NodeRef> &construct_infos) {
+  CHECK(construct_infos.find(kKernelInputs) != construct_infos.end());
+  CHECK(construct_infos.find(kKernelOutputs) != construct_infos.end());
+  return std::make_shared<CpuParallelLowerNode>(target, Downcast<Array<NodeRef>>(construct_infos[kKernelInputs]),
+                                                Downcast<Array<NodeRef>>(construct_infos[kKernelOutputs]));
+}
+
 BaseLowerNodePtr CreateAscendParallelLowerNode(const std::string &target, bool,
                                                const Map<std::string, NodeRef> &construct_infos) {
   CHECK(construct_infos.find(kKernelInputs) != construct_infos.end());
@@ -179,5 +186,6 @@ BaseLowerNodePtr CreateAscendParallelLowerNode(const std::string &target, bool,
 
 REG_NODE_CREATOR(kCuda, kParallel, CreateCudaParallelLowerNode);
 REG_NODE_CREATOR(kCce, kParallel, CreateAscendParallelLowerNode);
+REG_NODE_CREATOR(kLlvm, kParallel, CreateCpuParallelLowerNode);
 }  // namespace lower
 }  // namespace akg
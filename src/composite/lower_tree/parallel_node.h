@@ -51,6 +51,23 @@ class CudaParallelLowerNode : public MultiChildLowerNode {
   Stmt MergeStmts(const LowerData &data, std::vector<Stmt> &block_irs) override;
 };
 
+class CpuParallelLowerNode : public MultiChildLowerNode {
+ public:
+  CpuParallelLowerNode(const std::string &target, const Array<NodeRef> &kernel_inputs,
+                       const Array<NodeRef> &kernel_outputs)
+      : MultiChildLowerNode(target, kernel_inputs, kernel_outputs) {
+    CHECK(target_ == kLlvm);
+    entrance_stage_ = StageType::Flattern;
+    name_ = __FUNCTION__;
+  }
+  ~CpuParallelLowerNode() override = default;
+  void ExcuteImpl(StageType to) override;
+
+ private:
+  void PostUpdateDataAndNodeRef(LowerData &data, NodeRef &) override;
+  Stmt MergeStmts(const LowerData &data, std::vector<Stmt> &block_irs) override;
+};
+
 class AscendParallelLowerNode : public MultiChildLowerNode {
  public:
   AscendParallelLowerNode(const std::string &target, const Array<NodeRef> &kernel_inputs,
@@ -14,11 +14,16 @@
  * limitations under the License.
  */
 #include "composite/lower_tree/stitch_fusion.h"
+#include "composite/lower_tree/block_fusion.h"
 #include "composite/utils/util.h"
 #include "composite/utils/dump.h"
 #include "dmlc/logging.h"
 #include <ir_pass.h>
+#include <tvm/arithmetic.h>
+#include <algorithm>
 #include <fstream>
+#include <numeric>
+#include <set>
 
 namespace akg {
 struct WorkspaceInfo {
@@ -651,4 +656,241 @@ Stmt StitchFusionAscend(std::vector<Stmt> &stitch_irs, const std::string &kernel
   DumpStmt2File("stitch_info/" + kernel_name + "_after_stitch.cc", stmt);
   return stmt;
 }
+struct CpuStitchBuffer {
+  Buffer arg;
+  bool is_output{false};
+  int64_t size{-1};  // elements, -1 when not constant
+  Var var;
+  std::set<size_t> irs;
+  bool sliced{true};  // every access of task b is in [b * size / tasks, (b + 1) * size / tasks)
+};
+
+/*
+ * Checks that the stitched buffers are accessed slice by slice in a task body, so the slice a task reads has been
+ * written by the same task before.
+ */
+class CpuStitchSliceChecker : public IRVisitor {
+ public:
+  CpuStitchSliceChecker(std::unordered_map<std::string, CpuStitchBuffer> &buffers,
+                        const std::unordered_map<const Variable *, std::string> &names, const Var &task,
+                        int64_t task_num, size_t ir_idx)
+      : buffers_(buffers), names_(names), task_(task), task_num_(task_num), ir_idx_(ir_idx) {
+    analyzer_.Bind(task_, Range::make_by_min_extent(0, static_cast<int>(task_num_)));
+  }
+  ~CpuStitchSliceChecker() override = default;
+
+  void Bind(const Var &var, int64_t extent) {
+    analyzer_.Bind(var, Range::make_by_min_extent(0, static_cast<int>(extent)));
+  }
+
+ private:
+  void Visit_(const For *op) final {
+    analyzer_.Bind(op->loop_var, Range::make_by_min_extent(op->min, op->extent));
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const LetStmt *op) final {
+    analyzer_.Bind(op->var, op->value);
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Load *op) final {
+    Check(op->buffer_var, op->index);
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Store *op) final {
+    Check(op->buffer_var, op->index);
+    IRVisitor::Visit_(op);
+  }
+
+  // Any other use, such as an address passed to a call, can not be sliced.
+  void Visit_(const Variable *op) final {
+    auto it = names_.find(op);
+    if (it != names_.end()) {
+      buffers_[it->second].sliced = false;
+    }
+  }
+
+  void Check(const Var &var, const Expr &index) {
+    auto it = names_.find(var.get());
+    if (it == names_.end()) {
+      return;
+    }
+    auto &buffer = buffers_[it->second];
+    buffer.irs.insert(ir_idx_);
+    if (!buffer.sliced) {
+      return;
+    }
+    if (buffer.size <= 0 || buffer.size % task_num_ != 0 || index.type().lanes() != 1) {
+      buffer.sliced = false;
+      return;
+    }
+    int64_t slice = buffer.size / task_num_;
+    Expr offset = analyzer_.Simplify(index - air::cast(index.type(), task_) * make_const(index.type(), slice));
+    auto bound = analyzer_.const_int_bound(offset);
+    if (air::ir::ExprUseVar(offset, task_) || bound->min_value < 0 || bound->max_value >= slice) {
+      buffer.sliced = false;
+    }
+  }
+
+  std::unordered_map<std::string, CpuStitchBuffer> &buffers_;
+  const std::unordered_map<const Variable *, std::string> &names_;
+  Var task_;
+  int64_t task_num_;
+  size_t ir_idx_;
+  air::arith::Analyzer analyzer_;
+};
+
+// Redirects the accesses of stitched buffers to the kernel outputs or to the buffers allocated in the kernel.
+class CpuStitchMutate : public IRMutator {
+ public:
+  CpuStitchMutate(std::unordered_map<std::string, CpuStitchBuffer> &buffers,
+                  const std::unordered_map<const Variable *, std::string> &names, const Var &task, int64_t task_num)
+      : buffers_(buffers), names_(names), task_(task), task_num_(task_num) {}
+  ~CpuStitchMutate() override = default;
+
+ private:
+  Expr Mutate_(const Load *op, const Expr &e) final {
+    auto it = names_.find(op->buffer_var.get());
+    if (it == names_.end()) {
+      return IRMutator::Mutate_(op, e);
+    }
+    auto &buffer = buffers_[it->second];
+    return Load::make(op->type, buffer.var, FixIndex(buffer, this->Mutate(op->index)), this->Mutate(op->predicate));
+  }
+
+  Stmt Mutate_(const Store *op, const Stmt &s) final {
+    auto it = names_.find(op->buffer_var.get());
+    if (it == names_.end()) {
+      return IRMutator::Mutate_(op, s);
+    }
+    auto &buffer = buffers_[it->second];
+    return Store::make(buffer.var, this->Mutate(op->value), FixIndex(buffer, this->Mutate(op->index)),
+                       this->Mutate(op->predicate));
+  }
+
+  Expr FixIndex(const CpuStitchBuffer &buffer, const Expr &index) {
+    if (buffer.is_output || task_num_ <= 1) {
+      return index;
+    }
+    return index - air::cast(index.type(), task_) * make_const(index.type(), buffer.size / task_num_);
+  }
+
+  std::unordered_map<std::string, CpuStitchBuffer> &buffers_;
+  const std::unordered_map<const Variable *, std::string> &names_;
+  Var task_;
+  int64_t task_num_;
+};
+
+Stmt AllocateCpuStitchBuffers(Stmt stmt, const std::unordered_map<std::string, CpuStitchBuffer> &buffers,
+                              int64_t task_num) {
+  for (const auto &kv : buffers) {
+    auto &buffer = kv.second;
+    if (buffer.is_output) {
+      continue;
+    }
+    if (task_num > 1) {
+      stmt = Allocate::make(buffer.var, buffer.arg->dtype, {make_const(Int(32), buffer.size / task_num)},
+                            const_true(), stmt);
+      stmt = AttrStmt::make(buffer.var, air::ir::attr::storage_scope, StringImm::make("local"), stmt);
+    } else {
+      stmt = Allocate::make(buffer.var, buffer.arg->dtype, buffer.arg->shape, const_true(), stmt);
+      stmt = AttrStmt::make(buffer.var, air::ir::attr::storage_scope, StringImm::make("global"), stmt);
+    }
+  }
+  return stmt;
+}
+
+Stmt StitchFusionCpu(std::vector<Stmt> &stitch_irs, const std::string &kernel_name,
+                     const std::unordered_map<std::string, NodeRef> &outputs2args,
+                     const std::unordered_map<std::string, NodeRef> &real_outputs, const Array<NodeRef> &args,
+                     int thread_num) {
+  CHECK(stitch_irs.size() > 1);
+  // 1. Stitched buffers by tensor name. The producer writes the data of its output arg, a consumer reads the data of
+  //    its input arg of the tensor name.
+  std::unordered_map<std::string, CpuStitchBuffer> buffers;
+  std::unordered_map<const Variable *, std::string> names;
+  for (const auto &kv : outputs2args) {
+    auto arg = Downcast<Buffer>(kv.second);
+    CpuStitchBuffer buffer;
+    buffer.arg = arg;
+    buffer.is_output = real_outputs.count(kv.first) > 0;
+    buffer.var = buffer.is_output ? arg->data : Var(arg->name + "_stitch", Handle());
+    if (std::all_of(arg->shape.begin(), arg->shape.end(), [](const Expr &e) { return e.as<IntImm>() != nullptr; })) {
+      buffer.size = GetTotalSize(arg->shape);
+    }
+    buffers[kv.first] = buffer;
+    names[arg->data.get()] = kv.first;
+  }
+  for (const auto &x : args) {
+    auto arg = Downcast<Buffer>(x);
+    if (buffers.count(arg->name) > 0 && names.count(arg->data.get()) == 0) {
+      names[arg->data.get()] = arg->name;
+    }
+  }
+
+  // 2. Every ir starts with a parallel loop, the loops are split to a common number of tasks.
+  std::vector<ir::CpuTaskLoop> task_loops;
+  int64_t task_num = 0;
+  for (const auto &ir : stitch_irs) {
+    task_loops.push_back(ir::GetCpuTaskLoop(ir));
+    if (task_loops.back().loop == nullptr) {
+      task_num = 0;
+      break;
+    }
+    task_num = std::gcd(task_num, task_loops.back().loop->extent.as<IntImm>()->value);
+  }
+
+  // 3. The tasks of all irs are fused when each one reads only what it has written, with enough tasks for the pool.
+  Var task("stitch_idx", Int(32));
+  std::vector<Stmt> task_bodies;
+  bool fuse = task_num >= thread_num && task_num > 1;
+  for (size_t i = 0; fuse && i < stitch_irs.size(); ++i) {
+    auto loop = task_loops[i].loop;
+    int64_t inner = loop->extent.as<IntImm>()->value / task_num;
+    Var sub(loop->loop_var->name_hint + "_inner", loop->loop_var.type());
+    Expr iter = air::cast(loop->loop_var.type(), task);
+    if (inner > 1) {
+      iter = iter * make_const(loop->loop_var.type(), inner) + sub;
+    }
+    Stmt body = Substitute(loop->body, {{loop->loop_var.get(), loop->min + iter}});
+    CpuStitchSliceChecker checker(buffers, names, task, task_num, i);
+    checker.Bind(sub, inner);
+    checker.Visit(body);
+    if (inner > 1) {
+      body = For::make(sub, 0, static_cast<int>(inner), ForType::Serial, DeviceAPI::None, body);
+    }
+    task_bodies.push_back(body);
+  }
+  for (const auto &kv : buffers) {
+    auto &buffer = kv.second;
+    if ((!buffer.is_output || buffer.irs.size() > 1) && !buffer.sliced) {
+      fuse = false;
+    }
+    if (!buffer.is_output && (buffer.size <= 0 || (task_num > 0 && buffer.size % task_num != 0))) {
+      fuse = false;
+    }
+  }
+
+  Stmt stmt;
+  if (fuse) {
+    stmt = CpuStitchMutate(buffers, names, task, task_num).Mutate(Block::make(task_bodies));
+    stmt = AllocateCpuStitchBuffers(stmt, buffers, task_num);
+    stmt = For::make(task, 0, static_cast<int>(task_num), ForType::Parallel, DeviceAPI::None, stmt);
+    std::vector<Stmt> prologue;
+    for (const auto &task_loop : task_loops) {
+      prologue.insert(prologue.end(), task_loop.prologue.begin(), task_loop.prologue.end());
+    }
+    stmt = ir::WrapCpuTaskPrologue(prologue, stmt);
+  } else {
+    // The irs run one after another in the kernel, the buffers between them are allocated whole.
+    LOG(INFO) << kernel_name << " is stitched without fusing the tasks of its parts";
+    stmt = CpuStitchMutate(buffers, names, task, 1).Mutate(Block::make(stitch_irs));
+    stmt = AllocateCpuStitchBuffers(stmt, buffers, 1);
+  }
+  stmt = Simplify(stmt);
+  stmt = RemoveNoOp(stmt);
+  return stmt;
+}
 }  // namespace akg
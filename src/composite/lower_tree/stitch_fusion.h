@@ -379,6 +379,10 @@ Stmt StitchFusionAscend(std::vector<Stmt> &stitch_irs, const std::string &kernel
                         std::unordered_map<std::string, NodeRef> &stitch_buffer,
                         const std::unordered_map<std::string, NodeRef> &real_outputs, Array<NodeRef> &workspace_args,
                         Map<Tensor, Buffer> &workspace_binds);
+Stmt StitchFusionCpu(std::vector<Stmt> &stitch_irs, const std::string &kernel_name,
+                     const std::unordered_map<std::string, NodeRef> &outputs2args,
+                     const std::unordered_map<std::string, NodeRef> &real_outputs, const Array<NodeRef> &args,
+                     int thread_num);
 }  // namespace akg
 
 #endif  // STITCH_FUSION_H_
@@ -20,6 +20,7 @@
 #include "composite/lower_tree/sync_process.h"
 #include "composite/parser.h"
 #include "composite/extract_build_info.h"
+#include "common/target_info.h"
 
 namespace akg {
 namespace lower {
@@ -28,16 +29,17 @@ constexpr auto kIdx = "part_idx";
 constexpr auto kEnableStitch = "enable_stitch_fusion";
 constexpr auto kSharedMemTensors = "shared_memory_tensors";
 constexpr auto kStitchOriginJson = "stitch_origin_json";
+constexpr auto kCpuInfo = "cpu_info";
 
 Stmt String2LowerStmtSimple(const StringImm *json_str, const Map<std::string, NodeRef> &attrs, bool poly,
                             bool buffer_stitch, bool fold_dim, std::vector<size_t> &split_index) {
   CHECK(json_str);
-  picojson::value v = String2Json(json_str->value);
+  auto desc = KernelDesc::Get(GetRef<Expr>(json_str));
   BuildInfo info;
   info.opt.stitch = buffer_stitch;
   info.opt.fold_dim = fold_dim;
   info.opt.enable_dump = false;
-  ExtractBuildInfo(v, info);
+  ExtractBuildInfo(desc->Json(), info);
 
   LowerData data = LowerDataNode::make(GetScheduleWithBuildInfo(info), info.args, info.in_binds, attrs, kCuda,
                                        info.kernel_name + "_check", GetConfig(), poly);
@@ -98,9 +100,8 @@ bool CheckFoldDim(const NodeRef &block_json) {
   std::vector<int> fold_index;
   for (auto &stitch_json : Downcast<Array<Expr>>(block_json)) {
     CHECK(stitch_json.as<StringImm>());
-    picojson::value v = String2Json(stitch_json.as<StringImm>()->value);
     BuildInfo info;
-    ExtractBuildInfo(v, info);
+    ExtractBuildInfo(KernelDesc::Get(stitch_json)->Json(), info);
     if (info.opt.fold_dims_.empty()) {
       return false;
     }
@@ -172,8 +173,9 @@ Map<std::string, NodeRef> CudaStitchLowerNode::GetStitchForwardInfo(
   forward_infos = AddNamePosfix(kStitch, forward_infos_, i, true, forward_infos);
 
   // New attrs.
-  std::vector<OpDesc> op_v = ParseOpDesc(child_json.as<StringImm>()->value);
-  auto kernel_name = ParseKernelName(child_json.as<StringImm>()->value);
+  auto desc = KernelDesc::Get(child_json);
+  std::vector<OpDesc> op_v = ParseOpDesc(desc->OpDescs());
+  const auto &kernel_name = desc->KernelName();
   const std::function<Stmt(const StringImm *, const Map<std::string, NodeRef> &, bool, bool, bool,
                            std::vector<size_t> &)>
     f = std::bind(&String2LowerStmtSimple, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
@@ -224,6 +226,36 @@ void CudaStitchLowerNode::PostUpdateDataAndNodeRef(LowerData &data, NodeRef &) {
   data->arg_list_0 = ReorderArgs(inputs_, outputs_, all_args_, outputs2args_, workspace_args_);
 }
 
+void CpuStitchLowerNode::ExcuteImpl(StageType to) { ExcuteAndMerge(to, kStitch); }
+
+Stmt CpuStitchLowerNode::MergeStmts(const LowerData &data, std::vector<Stmt> &stitch_irs) {
+  auto dump_mng = DumpManager(data->name + "_merge", data->config->dump_pass_ir);
+  DUMP_ORIGIN_IR(dump_mng, stitch_irs);
+
+  GetRealOutputs();
+
+  // Tasks are fused only when there are enough for the threads of the kernel's cpu.
+  std::string cpu_info;
+  if (data->attrs.find(kCpuInfo) != data->attrs.end()) {
+    auto info = data->attrs[kCpuInfo].as<StringImm>();
+    CHECK(info);
+    cpu_info = info->value;
+  }
+  int thread_num = air::GetCpuThreadNum(air::GetCpuInfo(cpu_info));
+
+  Stmt stitched_ir;
+  TRANSFORM_AND_TRY_DUMP(dump_mng, stitched_ir, StitchFusionCpu, stitch_irs, data->name, outputs2args_,
+                         real_outputs_, data->arg_list_0, thread_num);
+  auto ElimDupInputs = [](Stmt stmt, const Array<NodeRef> &inputs) { return ElimDuplicateInputs(inputs).Run(stmt); };
+  TRANSFORM_AND_TRY_DUMP(dump_mng, stitched_ir, ElimDupInputs, stitched_ir, inputs_);
+  return stitched_ir;
+}
+
+void CpuStitchLowerNode::PostUpdateDataAndNodeRef(LowerData &data, NodeRef &) {
+  // Stitched buffers that are not outputs are allocated in the kernel.
+  data->arg_list_0 = ReorderArgs(inputs_, outputs_, all_args_, outputs2args_);
+}
+
 void AscendStitchLowerNode::ExcuteImpl(StageType to) {
   CHECK(children_.size() > 1);
 
@@ -279,7 +311,7 @@ Map<std::string, NodeRef> AscendStitchLowerNode::GetStitchForwardInfo(const Map<
   forward_infos.Set(kIdx, Expr(i));
   forward_infos.Set(kFoldDim, Expr(fold_dim));
 
-  auto peeled_tensors = GetOriginPeelInfo(stitch_origin_json_, child_attrs, fold_dim);
+  auto peeled_tensors = GetOriginPeelInfo(stitch_origin_desc_->Json(), child_attrs, fold_dim);
   forward_infos.Set(kPeeledTensors, PeelingToNodeRef(peeled_tensors));
   forward_infos = AddNamePosfix(kStitch, forward_infos_, i, true, forward_infos);
 
@@ -385,6 +417,14 @@ BaseLowerNodePtr CreateCudaStitchLowerNode(const std::string &target, bool,
     Downcast<Map<std::string, Array<NodeRef>>>(construct_infos[kCleanOpMap]));
 }
 
+BaseLowerNodePtr CreateCpuStitchLowerNode(const std::string &target, bool,
+                                          const Map<std::string, NodeRef> &construct_infos) {
+  CHECK(construct_infos.find(kKernelInputs) != construct_infos.end());
+  CHECK(construct_infos.find(kKernelOutputs) != construct_infos.end());
+  return std::make_shared<CpuStitchLowerNode>(target, Downcast<Array<NodeRef>>(construct_infos[kKernelInputs]),
+                                              Downcast<Array<NodeRef>>(construct_infos[kKernelOutputs]));
+}
+
 BaseLowerNodePtr CreateAscendStitchLowerNode(const std::string &target, bool,
                                              const Map<std::string, NodeRef> &construct_infos) {
   CHECK(construct_infos.find(kStitchOriginJson) != construct_infos.end());
@@ -394,7 +434,7 @@ BaseLowerNodePtr CreateAscendStitchLowerNode(const std::string &target, bool,
   return std::make_shared<AscendStitchLowerNode>(
     target, Downcast<Array<NodeRef>>(construct_infos[kKernelInputs]),
     Downcast<Array<NodeRef>>(construct_infos[kKernelOutputs]),
-    construct_infos[kStitchOriginJson].as<StringImm>()->value,
+    Downcast<Expr>(construct_infos[kStitchOriginJson]),
     Downcast<Map<std::string, Array<NodeRef>>>(construct_infos[kAllocMap]));
 }
 
@@ -404,6 +444,7 @@ REG_ATTR_FUNC(kCuda, "CudaStitchLowerNode", ModifyStitchAttrs);
 
 REG_NODE_CREATOR(kCuda, kStitch, CreateCudaStitchLowerNode);
 REG_NODE_CREATOR(kCce, kStitch, CreateAscendStitchLowerNode);
+REG_NODE_CREATOR(kLlvm, kStitch, CreateCpuStitchLowerNode);
 }  // namespace lower
 
 TVM_REGISTER_GLOBAL("check_fold_dim").set_body_typed(lower::CheckFoldDim);
@@ -25,6 +25,7 @@
 #include "codegen/stage_lower.h"
 #include "composite/utils/dimension_peeling.h"
 #include "composite/utils/dump.h"
+#include "composite/utils/kernel_desc.h"
 #include "composite/utils/util.h"
 #include "composite/lower_tree/base_node.h"
 #include "composite/lower_tree/multichild_node.h"
@@ -67,13 +68,30 @@ class CudaStitchLowerNode : public MultiChildLowerNode {
   std::vector<StitchOpType> ir_type_array_;
 };
 
+class CpuStitchLowerNode : public MultiChildLowerNode {
+ public:
+  CpuStitchLowerNode(const std::string &target, const Array<NodeRef> &kernel_inputs,
+                     const Array<NodeRef> &kernel_outputs)
+      : MultiChildLowerNode(target, kernel_inputs, kernel_outputs) {
+    CHECK(target_ == kLlvm);
+    entrance_stage_ = StageType::Flattern;
+    name_ = __FUNCTION__;
+  }
+  ~CpuStitchLowerNode() override = default;
+  void ExcuteImpl(StageType to) override;
+
+ private:
+  Stmt MergeStmts(const LowerData &data, std::vector<Stmt> &stitch_irs) override;
+  void PostUpdateDataAndNodeRef(LowerData &data, NodeRef &) override;
+};
+
 class AscendStitchLowerNode : public MultiChildLowerNode {
  public:
   AscendStitchLowerNode(const std::string &target, const Array<NodeRef> &kernel_inputs,
-                        const Array<NodeRef> &kernel_outputs, const std::string &stitch_origin_json,
+                        const Array<NodeRef> &kernel_outputs, const Expr &stitch_origin_json,
                         Map<std::string, Array<NodeRef>> alloc_map)
       : MultiChildLowerNode(target, kernel_inputs, kernel_outputs),
-        stitch_origin_json_(stitch_origin_json),
+        stitch_origin_desc_(KernelDesc::Get(stitch_origin_json)),
         alloc_map_(alloc_map) {
     CHECK(target_ == kCce);
     entrance_stage_ = StageType::BeforeFlattern;
@@ -90,7 +108,7 @@ class AscendStitchLowerNode : public MultiChildLowerNode {
   Stmt MergeStmts(const LowerData &data, std::vector<Stmt> &stitch_irs) override;
   void PostUpdateDataAndNodeRef(LowerData &data, NodeRef &node_ref) override;
 
-  std::string stitch_origin_json_;
+  KernelDescPtr stitch_origin_desc_;
   Map<std::string, Array<NodeRef>> alloc_map_;
   Map<Tensor, Buffer> workspace_binds_;
 };
@@ -118,12 +118,27 @@ void TotLowerNode::ExcuteImpl(StageType stage) {
   current_stage_ = stage;
 }
 
+void CpuTotLowerNode::ExcuteImpl(StageType stage) {
+  CHECK(children_.size() == 1);
+  Excute(children_[0]);
+  StageLower stage_lower(children_[0]->Data());
+  stage_lower.RunTo(stage);
+  node_ref_ = stage_lower.Node();
+  data_ = stage_lower.Data();
+  current_stage_ = stage;
+}
+
 REG_BACKWARD_FUNC(kCuda, "Tot", ModifyBackwardTot);
 
 BaseLowerNodePtr CreateTotLowerNode(const std::string &target, bool, const Map<std::string, NodeRef> &) {
   return std::make_shared<TotLowerNode>(target);
 }
 
+BaseLowerNodePtr CreateCpuTotLowerNode(const std::string &target, bool, const Map<std::string, NodeRef> &) {
+  return std::make_shared<CpuTotLowerNode>(target);
+}
+
 REG_NODE_CREATOR(kCuda, kTot, CreateTotLowerNode);
+REG_NODE_CREATOR(kLlvm, kTot, CreateCpuTotLowerNode);
 }  // namespace lower
 }  // namespace akg
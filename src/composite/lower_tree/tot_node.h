@@ -43,6 +43,15 @@ class TotLowerNode : public BaseLowerNode {
 
   void ExcuteImpl(StageType stage) override;
 };
+
+// On cpu the gather and scatter ops are ir builder loops, which ScheduleTotLoop schedules in the llvm pipeline.
+class CpuTotLowerNode : public BaseLowerNode {
+ public:
+  explicit CpuTotLowerNode(const std::string &target) : BaseLowerNode(target) { name_ = __FUNCTION__; }
+  ~CpuTotLowerNode() override {}
+
+  void ExcuteImpl(StageType stage) override;
+};
 }  // namespace lower
 }  // namespace akg
 #endif  // AKG_SRC_COMPOSITE_LOWER_TREE_TOT_NODE_H_
@@ -77,33 +77,10 @@ void ParseOutputTensors(const picojson::array &output_descs, std::vector<std::st
   }
 }
 
-std::string ParseKernelName(const std::string &json_str) {
-  std::string kernel_name;
-  picojson::value v = String2Json(json_str);
-  picojson::array op_desc;
-  const picojson::value::object &input_obj = v.get<picojson::object>();
-  for (const auto &item : input_obj) {
-    if (item.first == "op") {
-      CHECK(item.second.is<std::string>());
-      kernel_name = item.second.get<std::string>();
-    }
-  }
-  return kernel_name;
-}
-
-std::vector<OpDesc> ParseOpDesc(const std::string &json_str) {
-  picojson::value v = String2Json(json_str);
-  picojson::array op_desc;
-  const picojson::value::object &input_obj = v.get<picojson::object>();
-  for (const auto &item : input_obj) {
-    if (item.first == "op_desc") {
-      CHECK(item.second.is<picojson::array>());
-      op_desc = item.second.get<picojson::array>();
-    }
-  }
+std::vector<OpDesc> ParseOpDesc(const picojson::array &op_descs) {
   std::vector<std::string> input_tensors;
   std::vector<std::string> output_tensors;
-  auto parser = OpDescsParser(op_desc, input_tensors, output_tensors);
+  auto parser = OpDescsParser(op_descs, input_tensors, output_tensors);
   parser.Parse();
   return parser.op_descs_;
 }
@@ -184,7 +161,7 @@ Stmt Parse(const picojson::value &input_json, BuildInfo &info) {
   ParseInputTensors(input_desc, info.input_names);
   ParseOutputTensors(output_desc, info.output_names);
   // 2. parse op descs
-  auto parser = OpDescsParser(op_descs, info.input_names, info.output_names);
+  auto parser = OpDescsParser(std::move(op_descs), info.input_names, info.output_names);
   parser.Parse();
   info.opt.input_funcs = parser.input_funcs_;
   info.opt.output_funcs = parser.output_funcs_;
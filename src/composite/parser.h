@@ -27,8 +27,7 @@ std::tuple<std::string, std::string, picojson::array, picojson::array, picojson:
   const picojson::value &input_json);
 void ParseInputTensors(const picojson::array &input_descs, std::vector<std::string> &input_tensors);
 void ParseOutputTensors(const picojson::array &output_descs, std::vector<std::string> &output_tensors);
-std::vector<OpDesc> ParseOpDesc(const std::string &json_str);
-std::string ParseKernelName(const std::string &json_str);
+std::vector<OpDesc> ParseOpDesc(const picojson::array &op_descs);
 Stmt MakeStmt(const std::vector<OpDesc> &op_descs);
 Stmt Parse(const picojson::value &input_json, BuildInfo &info);
 
@@ -0,0 +1,353 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "composite/utils/kernel_cache.h"
+#include <dirent.h>
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <tvm/node/serialization.h>
+#include "codegen/util.h"
+#include "common/target_info.h"
+#include "composite/utils/util.h"
+
+#ifndef AKG_VERSION
+#define AKG_VERSION "unknown"
+#endif
+
+namespace akg {
+namespace {
+constexpr auto kAkgVersion = AKG_VERSION;
+constexpr size_t kDefaultCacheSizeMB = 1024;
+constexpr auto kTmpSuffix = ".tmp";
+constexpr time_t kStaleTmpSeconds = 3600;
+constexpr auto kNameSuffix = ".name";
+// Environment read while lowering that changes the code of a kernel.
+const std::vector<std::string> kKeyEnvs = {"AKG_REPLACE_POLY_SCHEDULE",
+                                           "MS_AKG_MIND_TRICKS",
+                                           "MS_AKG_MIND_TRICKS_DIR",
+                                           "MS_AKG_MIND_TRICKS_TEMPLATES",
+                                           "MS_AKG_MIND_TRICKS_OPERATOR_BLACKLIST",
+                                           "MS_AKG_MIND_TRICKS_AUTOGEN",
+                                           "MS_AKG_MIND_TRICKS_AUTOGEN_SWIZZLE",
+                                           "MS_AKG_DISABLE_SWIZZLE",
+                                           "MS_AKG_FORCE_SWIZZLE"};
+
+// Module type key -> file format understood by both SaveToFile and module.loadfile_<format>. The stackvm host used
+// by cuda and cce serializes its device imports into the same file.
+const std::vector<std::pair<std::string, std::string>> kCacheFormats = {{"llvm", "ll"}, {"stackvm", "stackvm"}};
+
+std::string CacheFormat(const air::runtime::Module &module) {
+  std::string type_key = module->type_key();
+  for (const auto &it : kCacheFormats) {
+    if (it.first == type_key) {
+      // An llvm module can not carry its imports through an ll file.
+      return type_key == "llvm" && !module->imports().empty() ? "" : it.second;
+    }
+  }
+  return "";
+}
+
+std::string CacheDir() {
+  const char *dir = getenv(kKernelCacheDirEnv);
+  return dir == nullptr ? "" : std::string(dir);
+}
+
+size_t CacheSizeLimit() {
+  size_t size_mb = kDefaultCacheSizeMB;
+  const char *env = getenv(kKernelCacheSizeEnv);
+  if (env != nullptr) {
+    size_mb = static_cast<size_t>(std::max(atol(env), 0L));
+  }
+  return size_mb << 20;
+}
+
+bool EndsWith(const std::string &str, const std::string &suffix) {
+  return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+}  // namespace
+
+// Identifies the akg library that builds the kernels, so entries of a rebuilt library are never reused.
+std::string LibraryIdentity() {
+  static const std::string identity = []() {
+    std::stringstream ss;
+    ss << kAkgVersion;
+    Dl_info info;
+    struct stat lib_stat;
+    if (dladdr(reinterpret_cast<void *>(&CacheDir), &info) != 0 && info.dli_fname != nullptr &&
+        stat(info.dli_fname, &lib_stat) == 0) {
+      ss << ":" << info.dli_fname << ":" << lib_stat.st_size << ":" << lib_stat.st_mtime;
+    }
+    return ss.str();
+  }();
+  return identity;
+}
+
+// Canonical text of a build request: map keys are sorted and json strings are re-serialized with sorted keys,
+// so requests that only differ in dict order share one entry.
+void Canonicalize(const NodeRef &node, std::ostream &os) {
+  if (!node.defined()) {
+    os << "null";
+  } else if (auto str = node.as<StringImm>()) {
+    std::string value = str->value;
+    if (!value.empty() && value[0] == '{') {
+      picojson::value json;
+      if (picojson::parse(json, value).empty()) {
+        value = json.serialize();
+      }
+    }
+    os << "s" << value.size() << ":" << value;
+  } else if (auto imm = node.as<IntImm>()) {
+    os << "i" << imm->type << ":" << imm->value;
+  } else if (auto imm = node.as<UIntImm>()) {
+    os << "u" << imm->type << ":" << imm->value;
+  } else if (auto imm = node.as<FloatImm>()) {
+    os << "f" << imm->type << ":" << std::setprecision(17) << imm->value;
+  } else if (node->IsInstance<air::StrMapNode>()) {
+    auto map = Downcast<Map<std::string, NodeRef>>(node);
+    std::vector<std::string> keys;
+    for (const auto &kv : map) {
+      keys.push_back(kv.first);
+    }
+    std::sort(keys.begin(), keys.end());
+    os << "{";
+    for (const auto &key : keys) {
+      os << key.size() << ":" << key << "=";
+      Canonicalize(map[key], os);
+      os << ";";
+    }
+    os << "}";
+  } else if (node->IsInstance<air::ArrayNode>()) {
+    os << "[";
+    for (const auto &item : Downcast<Array<NodeRef>>(node)) {
+      Canonicalize(item, os);
+      os << ",";
+    }
+    os << "]";
+  } else {
+    os << "n" << air::SaveJSON(node);
+  }
+}
+
+// 128 bit FNV-1a, two 64 bit lanes with different offset bases.
+std::string HashHex(const std::string &str) {
+  constexpr uint64_t kPrime = 1099511628211ULL;
+  std::stringstream ss;
+  for (uint64_t lane : {14695981039346656037ULL, 0x6c62272e07bb0142ULL}) {
+    for (unsigned char c : str) {
+      lane = (lane ^ c) * kPrime;
+    }
+    ss << std::hex << std::setw(16) << std::setfill('0') << lane;
+  }
+  return ss.str();
+}
+
+KernelCache &KernelCache::Instance() {
+  static KernelCache instance;
+  return instance;
+}
+
+bool KernelCache::Enabled() const {
+  // IR dumps are side effects of a real build, and custom lower passes are opaque to the key.
+  return !CacheDir().empty() && getenv(GetDumpIRFlag().c_str()) == nullptr && getenv("DUMP_C_PASS") == nullptr &&
+         BuildConfig::Current()->add_lower_pass.empty();
+}
+
+std::string KernelCache::Key(const std::string &target, bool poly, const std::string &segment_tree,
+                             const Map<std::string, NodeRef> &segment_infos) const {
+  std::stringstream ss;
+  // Llvm kernels are built for the host cpu and their parallel loops are sized for its threads.
+  auto cpu_info = air::GetHostCpuInfo();
+  ss << LibraryIdentity() << "|" << cpu_info << "|" << air::GetCpuThreadNum(cpu_info) << "|" << target << "|" << poly
+     << "|" << segment_tree << "|";
+  // The attrs of the kernels, as the poly, cpu storage plan and tot schedule switches, are in the segment infos.
+  Canonicalize(segment_infos, ss);
+  // The dump flag of the config follows the dump env, which turns the cache off.
+  auto config = air::make_node<air::BuildConfigNode>(*BuildConfig::Current().operator->());
+  config->dump_pass_ir = false;
+  ss << "|" << air::SaveJSON(BuildConfig(config));
+  for (const auto &env : kKeyEnvs) {
+    const char *value = getenv(env.c_str());
+    ss << "|" << env << "=" << (value == nullptr ? "<unset>" : value);
+  }
+  return HashHex(ss.str());
+}
+
+bool KernelCache::Load(const std::string &key, air::runtime::Module *module, std::string *kernel_name) {
+  auto dir = CacheDir();
+  for (const auto &it : kCacheFormats) {
+    auto path = dir + "/" + key + "." + it.second;
+    if (access(path.c_str(), R_OK) != 0) {
+      continue;
+    }
+    try {
+      *module = air::runtime::Module::LoadFromFile(path, it.second);
+    } catch (const std::exception &e) {
+      // The entry may be evicted or replaced by another process meanwhile, rebuild it.
+      LOG(WARNING) << "Failed to load cached kernel " << path << ": " << e.what();
+      continue;
+    }
+    static_cast<void>(utime(path.c_str(), nullptr));
+    std::ifstream name_file(dir + "/" + key + kNameSuffix);
+    kernel_name->clear();
+    std::getline(name_file, *kernel_name);
+    ++hits_;
+    return true;
+  }
+  ++misses_;
+  return false;
+}
+
+void KernelCache::Store(const std::string &key, air::runtime::Module module, const std::string &kernel_name) {
+  if (!module.defined()) {
+    return;
+  }
+  auto format = CacheFormat(module);
+  if (format.empty()) {
+    return;
+  }
+  auto dir = CacheDir();
+  CreateDir(dir);
+  auto path = dir + "/" + key + "." + format;
+  std::stringstream tmp;
+  tmp << path << "." << getpid() << "_" << std::hash<std::thread::id>()(std::this_thread::get_id()) << kTmpSuffix;
+  try {
+    module->SaveToFile(tmp.str(), format);
+  } catch (const std::exception &e) {
+    LOG(WARNING) << "Failed to save kernel to cache " << path << ": " << e.what();
+    static_cast<void>(remove(tmp.str().c_str()));
+    return;
+  }
+  struct stat file_stat;
+  size_t size = stat(tmp.str().c_str(), &file_stat) == 0 ? static_cast<size_t>(file_stat.st_size) : 0;
+  // The name goes first, a module found by Load has its name unless it was evicted meanwhile.
+  auto name_tmp = tmp.str() + kNameSuffix;
+  {
+    std::ofstream name_file(name_tmp);
+    name_file << kernel_name;
+  }
+  if (rename(name_tmp.c_str(), (dir + "/" + key + kNameSuffix).c_str()) != 0) {
+    static_cast<void>(remove(name_tmp.c_str()));
+  }
+  if (rename(tmp.str().c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Failed to move kernel into cache " << path;
+    static_cast<void>(remove(tmp.str().c_str()));
+    return;
+  }
+  ++stores_;
+  Track(dir, size);
+}
+
+void KernelCache::Track(const std::string &dir, size_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (dir == tracked_dir_ && tracked_size_ + size <= CacheSizeLimit()) {
+    tracked_size_ += size;
+    return;
+  }
+  // Other processes may share the directory, so it is rescanned only when the tracked size passes the limit.
+  tracked_dir_ = dir;
+  tracked_size_ = Evict(dir);
+}
+
+size_t KernelCache::Evict(const std::string &dir) {
+  auto limit = CacheSizeLimit();
+  DIR *dp = opendir(dir.c_str());
+  if (dp == nullptr) {
+    return 0;
+  }
+  // (last use, size, path)
+  std::vector<std::tuple<time_t, size_t, std::string>> entries;
+  size_t total = 0;
+  struct dirent *ent = nullptr;
+  while ((ent = readdir(dp)) != nullptr) {
+    std::string name = ent->d_name;
+    if (name == "." || name == "..") {
+      continue;
+    }
+    auto path = dir + "/" + name;
+    struct stat file_stat;
+    if (stat(path.c_str(), &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+      continue;
+    }
+    if (EndsWith(name, kTmpSuffix)) {
+      // Left behind by a writer that died before renaming it.
+      if (time(nullptr) - file_stat.st_mtime > kStaleTmpSeconds) {
+        static_cast<void>(remove(path.c_str()));
+      }
+      continue;
+    }
+    if (EndsWith(name, kNameSuffix)) {
+      // Removed with its module.
+      continue;
+    }
+    entries.emplace_back(file_stat.st_mtime, static_cast<size_t>(file_stat.st_size), path);
+    total += static_cast<size_t>(file_stat.st_size);
+  }
+  closedir(dp);
+  if (total <= limit) {
+    return total;
+  }
+  std::sort(entries.begin(), entries.end());
+  for (const auto &entry : entries) {
+    if (total <= limit) {
+      break;
+    }
+    // Another process may have evicted it already.
+    const auto &path = std::get<2>(entry);
+    if (remove(path.c_str()) == 0) {
+      ++evictions_;
+    }
+    static_cast<void>(remove((path.substr(0, path.rfind('.')) + kNameSuffix).c_str()));
+    total -= std::get<1>(entry);
+  }
+  return total;
+}
+
+Map<std::string, NodeRef> KernelCache::Stats() const {
+  Map<std::string, NodeRef> stats;
+  stats.Set("hits", air::make_const(Int(64), hits_.load()));
+  stats.Set("misses", air::make_const(Int(64), misses_.load()));
+  stats.Set("stores", air::make_const(Int(64), stores_.load()));
+  stats.Set("evictions", air::make_const(Int(64), evictions_.load()));
+  return stats;
+}
+
+void KernelCache::ResetStats() {
+  hits_ = 0;
+  misses_ = 0;
+  stores_ = 0;
+  evictions_ = 0;
+}
+
+TVM_REGISTER_GLOBAL("akg_kernel_cache_stats").set_body_typed<Map<std::string, NodeRef>()>([]() {
+  return KernelCache::Instance().Stats();
+});
+TVM_REGISTER_GLOBAL("akg_kernel_cache_reset_stats").set_body_typed<void()>([]() {
+  KernelCache::Instance().ResetStats();
+});
+}  // namespace akg
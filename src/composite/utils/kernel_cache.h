@@ -0,0 +1,72 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef COMPOSITE_UTILS_KERNEL_CACHE_H_
+#define COMPOSITE_UTILS_KERNEL_CACHE_H_
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include "tvm.h"
+
+namespace akg {
+constexpr auto kKernelCacheDirEnv = "AKG_KERNEL_CACHE_DIR";
+constexpr auto kKernelCacheSizeEnv = "AKG_KERNEL_CACHE_SIZE_MB";
+
+// Helpers shared with the other compile caches.
+std::string LibraryIdentity();
+void Canonicalize(const NodeRef &node, std::ostream &os);
+std::string HashHex(const std::string &str);
+
+/*
+ * On-disk cache of built composite modules, keyed by a hash of the canonical build request and the akg library.
+ * It is enabled by AKG_KERNEL_CACHE_DIR and may be shared by concurrent processes: entries are written to a temporary
+ * file and renamed into place, and least recently used entries are evicted once the directory grows over
+ * AKG_KERNEL_CACHE_SIZE_MB (1024 by default). The size is tracked from the stores of this process and recounted from
+ * the directory when it passes the limit. The kernel name is kept next to the module, so the code of a loaded kernel
+ * is dumped like the one of a built kernel.
+ */
+class KernelCache {
+ public:
+  static KernelCache &Instance();
+
+  bool Enabled() const;
+  std::string Key(const std::string &target, bool poly, const std::string &segment_tree,
+                  const Map<std::string, NodeRef> &segment_infos) const;
+  bool Load(const std::string &key, air::runtime::Module *module, std::string *kernel_name);
+  void Store(const std::string &key, air::runtime::Module module, const std::string &kernel_name);
+  Map<std::string, NodeRef> Stats() const;
+  void ResetStats();
+
+ private:
+  KernelCache() = default;
+  ~KernelCache() = default;
+  KernelCache(const KernelCache &) = delete;
+  KernelCache &operator=(const KernelCache &) = delete;
+
+  void Track(const std::string &dir, size_t size);
+  // Returns the size left in dir.
+  size_t Evict(const std::string &dir);
+
+  std::atomic<int64_t> hits_{0};
+  std::atomic<int64_t> misses_{0};
+  std::atomic<int64_t> stores_{0};
+  std::atomic<int64_t> evictions_{0};
+  std::mutex mutex_;
+  std::string tracked_dir_;
+  size_t tracked_size_{0};
+};
+}  // namespace akg
+#endif  // COMPOSITE_UTILS_KERNEL_CACHE_H_
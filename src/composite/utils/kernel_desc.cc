@@ -0,0 +1,74 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "composite/utils/kernel_desc.h"
+#include <mutex>
+#include <unordered_map>
+#include "codegen/compile_profiler.h"
+#include "composite/utils/util.h"
+
+namespace akg {
+namespace {
+std::mutex g_descs_mutex;
+std::unordered_map<const void *, std::weak_ptr<const KernelDesc>> g_descs;
+const picojson::array g_empty_array;
+}  // namespace
+
+KernelDesc::KernelDesc(const Expr &json_str) : json_str_(json_str) {
+  auto str = json_str.as<StringImm>();
+  CHECK(str != nullptr) << "composite json should be a StringImm.";
+  {
+    ProfileScope profile("composite", "ParseJson");
+    std::string err = picojson::parse(json_, str->value);
+    CHECK(err.empty()) << "json parse error, error message: " << err;
+  }
+  CHECK(json_.is<picojson::object>());
+  const auto &json_obj = json_.get<picojson::object>();
+  auto iter = json_obj.find("op");
+  if (iter != json_obj.end()) {
+    CHECK(iter->second.is<std::string>());
+    kernel_name_ = iter->second.get<std::string>();
+  }
+  op_descs_ = &g_empty_array;
+  iter = json_obj.find("op_desc");
+  if (iter != json_obj.end()) {
+    CHECK(iter->second.is<picojson::array>());
+    op_descs_ = &iter->second.get<picojson::array>();
+  }
+  process_ = GetProcess(json_);
+}
+
+KernelDescPtr KernelDesc::Get(const Expr &json_str) {
+  CHECK(json_str.defined());
+  const void *key = json_str.get();
+  {
+    std::lock_guard<std::mutex> lock(g_descs_mutex);
+    auto iter = g_descs.find(key);
+    if (iter != g_descs.end()) {
+      if (auto desc = iter->second.lock()) {
+        return desc;
+      }
+    }
+  }
+
+  KernelDescPtr desc(new KernelDesc(json_str));
+  std::lock_guard<std::mutex> lock(g_descs_mutex);
+  for (auto iter = g_descs.begin(); iter != g_descs.end();) {
+    iter = iter->second.expired() ? g_descs.erase(iter) : std::next(iter);
+  }
+  g_descs[key] = desc;
+  return desc;
+}
+}  // namespace akg
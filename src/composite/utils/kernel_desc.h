@@ -0,0 +1,54 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef COMPOSITE_UTILS_KERNEL_DESC_H_
+#define COMPOSITE_UTILS_KERNEL_DESC_H_
+#include <memory>
+#include <string>
+#include "tvm.h"
+#include "picojson.h"
+
+namespace akg {
+/*
+ * Composite json parsed once and shared read only by the lower tree nodes that hold the same json StringImm. A
+ * descriptor is looked up by the StringImm node, so the json string, which may be several MB, is neither hashed nor
+ * copied again. The descriptor keeps the StringImm alive, so the node address cannot be reused while it is cached.
+ */
+class KernelDesc {
+ public:
+  static std::shared_ptr<const KernelDesc> Get(const Expr &json_str);
+
+  const Expr &JsonStr() const { return json_str_; }
+  const picojson::value &Json() const { return json_; }
+  const std::string &KernelName() const { return kernel_name_; }
+  // Process after GetRealTarget, e.g. "llvm" for "cpu".
+  const std::string &Process() const { return process_; }
+  const picojson::array &OpDescs() const { return *op_descs_; }
+
+ private:
+  explicit KernelDesc(const Expr &json_str);
+  KernelDesc(const KernelDesc &) = delete;
+  KernelDesc &operator=(const KernelDesc &) = delete;
+
+  Expr json_str_;
+  picojson::value json_;
+  std::string kernel_name_;
+  std::string process_;
+  const picojson::array *op_descs_{nullptr};  // points into json_
+};
+
+using KernelDescPtr = std::shared_ptr<const KernelDesc>;
+}  // namespace akg
+#endif  // COMPOSITE_UTILS_KERNEL_DESC_H_
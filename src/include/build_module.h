@@ -17,15 +17,89 @@
 #ifndef INCLUDE_AKG_BUILD_MODULE_H_
 #define INCLUDE_AKG_BUILD_MODULE_H_
 
+#include <atomic>
 #include <string>
 #include <exception>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "codegen/util.h"
 
 namespace akg {
-extern AttrMap g_attrs;
-extern Array<NodeRef> g_external_call_name;
-extern CsrMap g_csr;
+// Compilation state is thread local, so that several kernels can be lowered at once in one process.
+extern thread_local AttrMap g_attrs;
+extern thread_local Array<NodeRef> g_external_call_name;
+extern thread_local CsrMap g_csr;
+
+/*
+ * Debug hooks configured by environment variables. They are resolved once per compilation, so that passes do not
+ * probe the environment or the file system when no hook is set.
+ */
+struct DebugHooks {
+  // DUMP_C_PASS: comma separated names or id prefixes of the Halide passes whose result is dumped as C code.
+  std::unordered_set<std::string> dump_c_pass_names;
+  std::vector<std::string> dump_c_pass_ids;
+  // Poly passes of kernels with a dump_poly_dir attr, which dump_pass_ir sets, load their input schedule from
+  // <dump_poly_dir>/<pass name>.txt when it exists. The dump dir is listed once per schedule run, kernels without one
+  // touch no file. AKG_REPLACE_POLY_SCHEDULE=0 turns it off.
+  bool replace_poly_schedule{true};
+
+  static DebugHooks FromEnv();
+  // Hooks of the compilation on the current thread.
+  static const DebugHooks &Current();
+};
+
+/*
+ * Per-compilation context: the attrs, csr extents, external calls, name counters and debug hooks of the kernel being
+ * lowered on the current thread.
+ */
+struct CompileContext {
+  AttrMap attrs;
+  CsrMap csr;
+  Array<NodeRef> external_call_name;
+  std::unordered_map<std::string, size_t> counters;
+  DebugHooks debug_hooks{DebugHooks::FromEnv()};
+  // Set once a poly run of the compilation falls back, shared with its parallel tasks.
+  std::shared_ptr<std::atomic<bool>> poly_fallback{std::make_shared<std::atomic<bool>>(false)};
+
+  // Copy of the context installed on the current thread, used to hand it over to a worker thread.
+  static CompileContext Current();
+};
+
+/*
+ * Installs a compilation context on the current thread and restores the enclosing one on exit, so nested or
+ * consecutive compilations never observe each other's state.
+ */
+class CompileScope {
+ public:
+  explicit CompileScope(const CompileContext &context = CompileContext());
+  ~CompileScope();
+  CompileScope(const CompileScope &) = delete;
+  CompileScope &operator=(const CompileScope &) = delete;
+
+ private:
+  CompileContext saved_;
+};
+
+// Next value of a per-compilation counter, so generated names do not depend on previously compiled kernels.
+size_t NextCompileId(const std::string &key);
+
+// Marks and queries a poly fallback of the current compilation, its result is not worth caching.
+void SetPolyFallback();
+bool PolyFellBack();
+
+/*
+ * Runs task(0) ... task(task_num - 1) on compile threads. Every task starts from a copy of the caller's compile context
+ * and build config, so a kernel gets the same names as when it is lowered alone, whatever the thread it runs on or the
+ * order tasks are scheduled. Compile ids only name things inside one kernel, so sibling kernels may share them. The
+ * caller continues after the largest id drawn by a task. The thread number is read from AKG_COMPILE_THREADS (hardware
+ * concurrency by default), nested calls run serially. Once all tasks are finished, the failure of the lowest task
+ * index is rethrown on the caller.
+ */
+void ParallelCompile(size_t task_num, const std::function<void(size_t)> &task);
 
 /*
  * Custom exception used when memory allocation fails and triggers micro-tuning to try to recover from failure.
@@ -67,16 +141,36 @@ BuildRst BuildToFunc(const Schedule &inputs, const Array<NodeRef> &in_args, cons
 
 air::runtime::Module BuildToModule(const NodeRef &ref, const std::string &target_name = "cce");
 
+// Writes the code of the device module, or of the host module without one, to the kernel meta directory when
+// MS_DEV_DUMP_CODE is set.
+void DumpModuleCode(const air::runtime::Module &module, const std::string &kernel_name, const std::string &target_name);
+
+/*
+ * Builds variants, the BuildRsts of a kernel specialized to each of keys followed by the generic one, into one llvm
+ * module. Its entry func name calls the variant whose key equals the sizes of the shape dims, [arg, dim] each, of the
+ * tensor arguments, the generic one otherwise.
+ */
+air::runtime::Module BuildMultiVersionModule(const Array<NodeRef> &variants, const Array<Array<Integer>> &dims,
+                                             const Array<Array<Integer>> &keys, const std::string &name,
+                                             const std::string &target_name);
+
 class BuildRstNode : public Node {
  public:
   NodeRef rst;
   std::string kernel_name;
+  // The cpu_info attr the kernel was lowered for, the llvm target of its code follows it.
+  std::string cpu_info;
+  // The kernel_cost attr, the llvm module records the float operations and bytes of the kernel for kernel_bench.
+  bool kernel_cost{false};
 
-  TVM_DLL static BuildRst make(const NodeRef &rst, const std::string &kernel_name);
+  TVM_DLL static BuildRst make(const NodeRef &rst, const std::string &kernel_name, const std::string &cpu_info = "",
+                               bool kernel_cost = false);
 
   void VisitAttrs(AttrVisitor *v) {
     v->Visit("rst", &rst);
     v->Visit("kernel_name", &kernel_name);
+    v->Visit("cpu_info", &cpu_info);
+    v->Visit("kernel_cost", &kernel_cost);
   }
 
   static constexpr const char *_type_key = "BuildRst";
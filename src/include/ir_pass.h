@@ -96,6 +96,14 @@ Stmt GemmFactor(const Stmt &stmt);
 
 Stmt ReductionFactor(const Stmt &stmt, const Map<Tensor, Buffer> &extern_buffer);
 
+/*!
+ * \brief Pack the buffers of the flattened llvm ir whose lifetimes do not overlap into shared arenas.
+ * \param stmt The flattened stmt.
+ * \param name The kernel name, used in the log of the memory saved.
+ * \return Transformed stmt.
+ */
+Stmt CpuStoragePlan(const Stmt &stmt, const std::string &name);
+
 Stmt ElementwiseFlatten(Stmt stmt, const Map<Tensor, Buffer> &extern_buffer,
                         const Map<Tensor, Buffer> &new_extern_buffer);
 
@@ -249,6 +257,23 @@ Stmt RealizeCompress(Stmt stmt);
 
 Stmt RestoreCsrLoop(Stmt stmt, Map<Tensor, Buffer> extern_buffer);
 
+/*!
+ * \brief Split the row loops of csr kernels into parallel tasks of the same number of nonzeros and vectorize their
+ *  loops over the nonzeros of a row, for the cpu given by the attr cpu_info.
+ * \param stmt The flattened stmt.
+ * \return Transformed stmt.
+ */
+Stmt ScheduleCsrLoop(const Stmt &stmt);
+
+/*!
+ * \brief Run the gather and scatter loop nests indexed by loaded values in parallel for the cpu given by the attr
+ *  cpu_info, scatters through per-task partial outputs or buckets of output rows.
+ * \param stmt The flattened stmt.
+ * \param binds The buffers of the arguments, whose sizes choose the schedule of scatters.
+ * \return Transformed stmt.
+ */
+Stmt ScheduleTotLoop(const Stmt &stmt, const Map<Tensor, Buffer> &binds);
+
 Stmt ReduceFusionOpt(Stmt stmt, const Map<Tensor, Buffer> &extern_buffer);
 
 Stmt SinkAllocate(const Stmt &stmt);
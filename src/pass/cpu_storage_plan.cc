@@ -0,0 +1,343 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tvm/ir.h>
+#include <tvm/ir_mutator.h>
+#include <tvm/ir_pass.h>
+#include <tvm/ir_visitor.h>
+#include <tvm/runtime/device_api.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ir_pass.h"
+
+namespace akg {
+namespace ir {
+/*
+ * Storage planning of the flattened llvm ir. The buffers allocated in a scope, the kernel or the body of a parallel
+ * loop, are packed into one arena per element type, where buffers whose lifetimes do not overlap share offsets.
+ * Lifetimes are intervals over the statements of the scope, a loop or an if counting as one statement, so a buffer
+ * used across iterations stays live over the whole loop. Buffers under kMaxStackAlloca bytes stay on the stack, and
+ * buffers whose address is used other than by a load or a store are left alone.
+ */
+namespace {
+struct PlanBuffer {
+  const Allocate *alloc{nullptr};
+  int64_t bytes{0};
+  int first{-1};
+  int last{-1};
+  int64_t offset{0};  // in bytes from the arena
+  bool escaped{false};
+};
+
+struct Arena {
+  Var var;
+  Type type;
+  int64_t bytes;
+};
+
+// The allocations of a scope and the statements that use them.
+class ScopeLiveness : public IRVisitor {
+ public:
+  void Plan(const Stmt &body) {
+    Visit(body);
+    for (auto &kv : buffers_) {
+      if (!kv.second.escaped && kv.second.first >= 0) {
+        candidates_.push_back(&kv.second);
+      }
+    }
+    std::sort(candidates_.begin(), candidates_.end(),
+              [](const PlanBuffer *a, const PlanBuffer *b) { return a->first < b->first; });
+  }
+
+  std::unordered_map<const Variable *, PlanBuffer> buffers_;
+  std::vector<PlanBuffer *> candidates_;
+
+ private:
+  void Visit(const NodeRef &node) override {
+    auto s = node.as<StmtNode>();
+    if (s == nullptr || IsTransparent(node)) {
+      IRVisitor::Visit(node);
+      return;
+    }
+    // Statements of the scope are numbered, everything below one is used at its number.
+    if (depth_++ == 0) {
+      ++index_;
+    }
+    IRVisitor::Visit(node);
+    --depth_;
+  }
+
+  bool IsTransparent(const NodeRef &node) const {
+    return depth_ == 0 && (node->IsInstance<Block>() || node->IsInstance<AttrStmt>() || node->IsInstance<Allocate>() ||
+                           node->IsInstance<LetStmt>() || node->IsInstance<ProducerConsumer>());
+  }
+
+  void Visit_(const Allocate *op) final {
+    // Allocations in a parallel loop belong to the scope of its body.
+    if (parallel_depth_ == 0 && !op->new_expr.defined() && op->type.lanes() == 1 &&
+        op->constant_allocation_size() > 0 && IsPlanScope(op->buffer_var.get())) {
+      int64_t bytes = op->constant_allocation_size() * op->type.bytes();
+      if (bytes >= air::runtime::kMaxStackAlloca) {
+        buffers_[op->buffer_var.get()].alloc = op;
+        buffers_[op->buffer_var.get()].bytes = bytes;
+      }
+    }
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const AttrStmt *op) final {
+    if (op->attr_key == air::ir::attr::storage_scope) {
+      if (auto str = op->value.as<StringImm>()) {
+        scopes_[op->node.as<Variable>()] = str->value;
+      }
+    }
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const For *op) final {
+    bool parallel = op->for_type == ForType::Parallel;
+    parallel_depth_ += parallel ? 1 : 0;
+    IRVisitor::Visit_(op);
+    parallel_depth_ -= parallel ? 1 : 0;
+  }
+
+  void Visit_(const Load *op) final {
+    Touch(op->buffer_var.get());
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Store *op) final {
+    Touch(op->buffer_var.get());
+    IRVisitor::Visit_(op);
+  }
+
+  // An address taken may be used after the statement, so the buffer can not share its storage.
+  void Visit_(const Call *op) final {
+    if (op->is_intrinsic(air::ir::intrinsic::tvm_address_of) && !op->args.empty()) {
+      if (auto load = op->args[0].as<Load>()) {
+        Visit_(load->buffer_var.get());
+      }
+    }
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Variable *op) final {
+    auto it = buffers_.find(op);
+    if (it != buffers_.end()) {
+      it->second.escaped = true;
+    }
+  }
+
+  void Touch(const Variable *var) {
+    auto it = buffers_.find(var);
+    if (it == buffers_.end()) {
+      return;
+    }
+    if (it->second.first < 0) {
+      it->second.first = index_;
+    }
+    it->second.last = index_;
+  }
+
+  bool IsPlanScope(const Variable *var) const {
+    auto it = scopes_.find(var);
+    return it == scopes_.end() || it->second.empty() || it->second == "global" || it->second == "local";
+  }
+
+  std::unordered_map<const Variable *, std::string> scopes_;
+  int index_{0};
+  int depth_{0};
+  int parallel_depth_{0};
+};
+
+// Redirects the planned buffers to their arena and drops their allocations.
+class ArenaRewriter : public IRMutator {
+ public:
+  struct Slot {
+    Var arena;
+    int64_t offset;  // in elements
+  };
+
+  explicit ArenaRewriter(const std::unordered_map<const Variable *, Slot> &slots) : slots_(slots) {}
+  ~ArenaRewriter() override = default;
+
+  Stmt Mutate_(const Allocate *op, const Stmt &s) final {
+    if (slots_.count(op->buffer_var.get())) {
+      return Mutate(op->body);
+    }
+    return IRMutator::Mutate_(op, s);
+  }
+
+  Stmt Mutate_(const AttrStmt *op, const Stmt &s) final {
+    auto var = op->node.as<Variable>();
+    if (var != nullptr && slots_.count(var) && op->attr_key == air::ir::attr::storage_scope) {
+      return Mutate(op->body);
+    }
+    return IRMutator::Mutate_(op, s);
+  }
+
+  Expr Mutate_(const Load *op, const Expr &e) final {
+    auto it = slots_.find(op->buffer_var.get());
+    if (it == slots_.end()) {
+      return IRMutator::Mutate_(op, e);
+    }
+    return Load::make(op->type, it->second.arena, Offset(Mutate(op->index), it->second.offset), Mutate(op->predicate));
+  }
+
+  Stmt Mutate_(const Store *op, const Stmt &s) final {
+    auto it = slots_.find(op->buffer_var.get());
+    if (it == slots_.end()) {
+      return IRMutator::Mutate_(op, s);
+    }
+    return Store::make(it->second.arena, Mutate(op->value), Offset(Mutate(op->index), it->second.offset),
+                       Mutate(op->predicate));
+  }
+
+ private:
+  static Expr Offset(const Expr &index, int64_t offset) {
+    if (offset == 0) {
+      return index;
+    }
+    auto scalar = make_const(index.type().element_of(), offset);
+    if (auto ramp = index.as<Ramp>()) {
+      return Ramp::make(ramp->base + scalar, ramp->stride, ramp->lanes);
+    }
+    if (index.type().lanes() > 1) {
+      return index + Broadcast::make(scalar, index.type().lanes());
+    }
+    return index + scalar;
+  }
+
+  const std::unordered_map<const Variable *, Slot> &slots_;
+};
+
+class CpuStoragePlanner : public IRMutator {
+ public:
+  Stmt Run(const Stmt &stmt) { return PlanScope(stmt); }
+
+  int64_t before_{0};
+  int64_t after_{0};
+  int planned_{0};
+
+ private:
+  Stmt Mutate_(const For *op, const Stmt &s) final {
+    if (op->for_type != ForType::Parallel) {
+      return IRMutator::Mutate_(op, s);
+    }
+    return For::make(op->loop_var, op->min, op->extent, op->for_type, op->device_api, PlanScope(op->body));
+  }
+
+  Stmt PlanScope(const Stmt &body) {
+    // Inner scopes first, their arenas are allocated in their parallel loops.
+    Stmt stmt = Mutate(body);
+    ScopeLiveness liveness;
+    liveness.Plan(stmt);
+
+    std::vector<std::vector<PlanBuffer *>> groups;
+    for (auto buffer : liveness.candidates_) {
+      auto it = std::find_if(groups.begin(), groups.end(), [buffer](const std::vector<PlanBuffer *> &g) {
+        return g[0]->alloc->type == buffer->alloc->type;
+      });
+      if (it == groups.end()) {
+        groups.push_back({buffer});
+      } else {
+        it->push_back(buffer);
+      }
+    }
+
+    std::unordered_map<const Variable *, ArenaRewriter::Slot> slots;
+    std::vector<Arena> arenas;
+    for (auto &group : groups) {
+      int64_t total = 0;
+      int64_t size = Pack(group, &total);
+      if (group.size() < 2 || size >= total) {
+        continue;
+      }
+      Type type = group[0]->alloc->type;
+      std::ostringstream name;
+      name << "arena_" << type;
+      Var arena(name.str(), Handle());
+      for (auto buffer : group) {
+        slots[buffer->alloc->buffer_var.get()] = {arena, buffer->offset / type.bytes()};
+      }
+      arenas.push_back({arena, type, size});
+      before_ += total;
+      after_ += size;
+      planned_ += static_cast<int>(group.size());
+    }
+    if (slots.empty()) {
+      return stmt;
+    }
+    stmt = ArenaRewriter(slots).Mutate(stmt);
+    for (const auto &arena : arenas) {
+      stmt = Allocate::make(arena.var, arena.type, {make_const(Int(32), arena.bytes / arena.type.bytes())}, const_true(),
+                            stmt);
+      stmt = AttrStmt::make(arena.var, air::ir::attr::storage_scope, StringImm::make("global"), stmt);
+    }
+    return stmt;
+  }
+
+  // First fit of the buffers, largest first, at aligned offsets clear of every buffer live at the same time.
+  static int64_t Pack(const std::vector<PlanBuffer *> &group, int64_t *total) {
+    constexpr int64_t align = air::runtime::kTempAllocaAlignment;
+    auto aligned = [](int64_t bytes) { return (bytes + align - 1) / align * align; };
+    std::vector<PlanBuffer *> order = group;
+    std::stable_sort(order.begin(), order.end(), [](const PlanBuffer *a, const PlanBuffer *b) {
+      return a->bytes > b->bytes;
+    });
+    std::vector<PlanBuffer *> placed;
+    int64_t size = 0;
+    for (auto buffer : order) {
+      *total += aligned(buffer->bytes);
+      std::vector<std::pair<int64_t, int64_t>> busy;
+      for (auto other : placed) {
+        if (other->first <= buffer->last && buffer->first <= other->last) {
+          busy.emplace_back(other->offset, other->offset + aligned(other->bytes));
+        }
+      }
+      std::sort(busy.begin(), busy.end());
+      int64_t offset = 0;
+      for (const auto &range : busy) {
+        if (offset + buffer->bytes <= range.first) {
+          break;
+        }
+        offset = std::max(offset, range.second);
+      }
+      buffer->offset = offset;
+      size = std::max(size, offset + aligned(buffer->bytes));
+      placed.push_back(buffer);
+    }
+    return size;
+  }
+};
+}  // namespace
+
+Stmt CpuStoragePlan(const Stmt &stmt, const std::string &name) {
+  CpuStoragePlanner planner;
+  Stmt res = planner.Run(stmt);
+  if (planner.planned_ > 0) {
+    LOG(INFO) << name << ": storage plan packs " << planner.planned_ << " buffers of " << planner.before_
+              << " bytes into " << planner.after_ << " bytes, " << (planner.before_ - planner.after_) << " bytes saved";
+  }
+  return res;
+}
+}  // namespace ir
+}  // namespace akg
@@ -24,6 +24,7 @@
 #include <pass/utils.h>
 #include <algorithm>
 #include <stack>
+#include "build_module.h"
 
 namespace akg {
 namespace ir {
@@ -307,10 +308,15 @@ class TaylorExpan : public IRMutator {
     return tensors[0];
   }
 
+  // Temporary of the expansion, named apart from the other kernels of the compilation.
+  Tensor TaylorTensor(const Tensor &like) {
+    return PlaceholderOpNode::make("taylor_" + std::to_string(NextCompileId("taylor")), like->shape, like->dtype)
+      .output(0);
+  }
+
   Stmt TaylorExpansionHyperbolic(const Provide *op, const TRIGONOTYPE &type) {
     Tensor to_expand = GetFirstTensor(op->value);
-    Tensor minus =
-      PlaceholderOpNode::make("taylor_" + std::to_string(ct_++), to_expand->shape, to_expand->dtype).output(0);
+    Tensor minus = TaylorTensor(to_expand);
 
     std::vector<Tensor> allocate_tensors = {minus};
     std::vector<Stmt> stmt_vec;
@@ -319,8 +325,7 @@ class TaylorExpan : public IRMutator {
     Stmt first = StmtCreater<Mul>(make_call_(to_expand, op), FloatImm::make(to_expand->dtype, -1.000), minus->op,
                                   minus->value_index, op);
 
-    Tensor exp =
-      PlaceholderOpNode::make("taylor_" + std::to_string(ct_++), to_expand->shape, to_expand->dtype).output(0);
+    Tensor exp = TaylorTensor(to_expand);
     allocate_tensors.push_back(exp);
 
     // t_exp = exp(x)
@@ -328,8 +333,7 @@ class TaylorExpan : public IRMutator {
       Provide::make(exp->op, exp->value_index,
                     Call::make(to_expand->dtype, "exp", {make_call_(to_expand, op)}, Call::PureIntrinsic), op->args));
 
-    Tensor exp_minus =
-      PlaceholderOpNode::make("taylor_" + std::to_string(ct_++), to_expand->shape, to_expand->dtype).output(0);
+    Tensor exp_minus = TaylorTensor(to_expand);
     allocate_tensors.push_back(exp_minus);
 
     // t_exp_ = exp(-x)
@@ -338,8 +342,7 @@ class TaylorExpan : public IRMutator {
                                      op->args));
 
     // t_minus = t_exp - t_exp_
-    Tensor binary =
-      PlaceholderOpNode::make("taylor_" + std::to_string(ct_++), to_expand->shape, to_expand->dtype).output(0);
+    Tensor binary = TaylorTensor(to_expand);
     allocate_tensors.push_back(binary);
     if (type == TRIGONOTYPE::SINH) {
       stmt_vec.push_back(
@@ -350,8 +353,7 @@ class TaylorExpan : public IRMutator {
     }
 
     // t_muls = t_minus * 0.5
-    Tensor muls =
-      PlaceholderOpNode::make("taylor_" + std::to_string(ct_++), to_expand->shape, to_expand->dtype).output(0);
+    Tensor muls = TaylorTensor(to_expand);
     allocate_tensors.push_back(muls);
     stmt_vec.push_back(StmtCreater<Mul>(make_call_(binary, op), FloatImm::make(to_expand->dtype, 0.5000), op->func,
                                         op->value_index, op));
@@ -366,8 +368,7 @@ class TaylorExpan : public IRMutator {
     series_ = series;
 
     Tensor to_expand = GetFirstTensor(op->value);
-    Tensor pow_tensor =
-      PlaceholderOpNode::make("taylor_" + std::to_string(ct_++), to_expand->shape, to_expand->dtype).output(0);
+    Tensor pow_tensor = TaylorTensor(to_expand);
     Expr call_pow = make_call_(pow_tensor, op);
     std::vector<Tensor> allocate_tensors = {pow_tensor};
     std::vector<Stmt> stmt_vec;
@@ -379,15 +380,13 @@ class TaylorExpan : public IRMutator {
     items.push(FloatImm::make(to_expand->dtype, TAYLOR_COS_PRE[0]));
     for (size_t i = 1; i < series_; ++i) {
       CHECK(i < TAYLOR_COS_PRE.size());
-      Tensor t_mul =
-        PlaceholderOpNode::make("taylor_" + std::to_string(ct_++), to_expand->shape, to_expand->dtype).output(0);
+      Tensor t_mul = TaylorTensor(to_expand);
       allocate_tensors.push_back(t_mul);
 
       // t_mul = t_pow * prefix
       stmt_vec.push_back(StmtCreater<Mul>(items.top(), call_pow, t_mul->op, t_mul->value_index, op));
 
-      Tensor t_muls =
-        PlaceholderOpNode::make("taylor_" + std::to_string(ct_++), to_expand->shape, to_expand->dtype).output(0);
+      Tensor t_muls = TaylorTensor(to_expand);
       allocate_tensors.push_back(t_muls);
 
       // t_mul = -1.000 * t_mul
@@ -398,8 +397,7 @@ class TaylorExpan : public IRMutator {
       int value_index;
       FunctionRef func;
       if (i < series_ - 1) {
-        Tensor t_add =
-          PlaceholderOpNode::make("taylor_" + std::to_string(ct_++), to_expand->shape, to_expand->dtype).output(0);
+        Tensor t_add = TaylorTensor(to_expand);
         allocate_tensors.push_back(t_add);
         items.push(make_call_(t_add, op));
         func = t_add->op;
@@ -422,8 +420,7 @@ class TaylorExpan : public IRMutator {
     series_ = series;
 
     Tensor to_expand = GetFirstTensor(op->value);
-    Tensor pow_tensor =
-      PlaceholderOpNode::make("taylor_" + std::to_string(ct_++), to_expand->shape, to_expand->dtype).output(0);
+    Tensor pow_tensor = TaylorTensor(to_expand);
 
     Expr call_pow = make_call_(pow_tensor, op);
     std::vector<Tensor> allocate_tensors = {pow_tensor};
@@ -438,10 +435,8 @@ class TaylorExpan : public IRMutator {
     items.push(to_expand);
     for (size_t i = 0; i < series_; ++i) {
       CHECK(i < TAYLOR_SIN_PRE.size());
-      Tensor t_pown =
-        PlaceholderOpNode::make("taylor_" + std::to_string(ct_++), to_expand->shape, to_expand->dtype).output(0);
-      Tensor t_mul =
-        PlaceholderOpNode::make("taylor_" + std::to_string(ct_++), to_expand->shape, to_expand->dtype).output(0);
+      Tensor t_pown = TaylorTensor(to_expand);
+      Tensor t_mul = TaylorTensor(to_expand);
       allocate_tensors.push_back(t_pown);
       allocate_tensors.push_back(t_mul);
 
@@ -456,8 +451,7 @@ class TaylorExpan : public IRMutator {
       FunctionRef func;
       Expr base_expr = make_call_(bases.top(), op);
       if (i < series_ - 1) {
-        Tensor t_add =
-          PlaceholderOpNode::make("taylor_" + std::to_string(ct_++), to_expand->shape, to_expand->dtype).output(0);
+        Tensor t_add = TaylorTensor(to_expand);
         bases.push(t_add);
         allocate_tensors.push_back(t_add);
         func = t_add->op;
@@ -500,7 +494,6 @@ class TaylorExpan : public IRMutator {
   std::unordered_map<FunctionRef, int, air::NodeHash, air::NodeEqual> index_node_;
   std::function<Expr(const Tensor &, const Provide *)> make_call_;
   size_t series_{4};
-  static int ct_;
 };
 
 Stmt HybridMixSubstitue(const Stmt &s, const SubTensorTable &table) {
@@ -512,8 +505,6 @@ Stmt HybridMixSubstitue(const Stmt &s, const SubTensorTable &table) {
   return res;
 }
 
-int TaylorExpan::ct_ = 0;
-
 class FloorDivOpt : public IRMutator {
  public:
   Stmt Run(const Stmt &s) {
@@ -549,7 +540,7 @@ class FloorDivOpt : public IRMutator {
   Expr Mutate_(const FloorDiv *op, const Expr &e) final {
     Expr second = FloorDiv::make(op->a, op->b);
     if (InVarMap(second)) {
-      Var tmp("_div_" + std::to_string(ct_++), op->type);
+      Var tmp("_div_" + std::to_string(NextCompileId("floor_div")), op->type);
       new_let_stmts_.push_back(std::make_pair(tmp, second));
       return tmp;
     }
@@ -558,11 +549,8 @@ class FloorDivOpt : public IRMutator {
   }
 
   std::vector<std::pair<Var, Expr>> new_let_stmts_;
-  static int ct_;
 };
 
-int FloorDivOpt::ct_ = 0;
-
 Stmt FeatureLibTransform(const Stmt stmt) {
   LibAllocator allocator;
 
@@ -159,7 +159,12 @@ class GemmCompute : public IRMutator {
       sync_compute_flag_ = true;
       Stmt body = IRMutator::Mutate(op->body);
       sync_compute_flag_ = false;
-      Stmt stmt = Evaluate::make(Call::make(Handle(), air::ir::intrinsic::sgemm_kernel_avx,
+      const char *kernel = KernelName();
+      if (kernel == nullptr) {
+        // No kernel for the operand types (e.g. a custom bfloat16), the loops on the packed operands stay.
+        return s;
+      }
+      Stmt stmt = Evaluate::make(Call::make(Handle(), kernel,
                                             {input_2_, input_1_, compute_, mnk_size_[GemmMNK::M], mnk_size_[GemmMNK::N],
                                              mnk_size_[GemmMNK::K], ldc_, Cast::make(Float(32), 1)},
                                             Call::Intrinsic));
@@ -199,10 +204,27 @@ class GemmCompute : public IRMutator {
     }
   }
 
+  // float16 and int8 operands are cast to the type of C.
+  Expr SplitCast(const Expr &e) { return e.as<Cast>() ? e.as<Cast>()->value : e; }
+
+  // float32 or float16 A and B with float32 C, int8 A and B with int32 C, see CpuIslEmitter::HasGemmKernel.
+  const char *KernelName() {
+    if (input_type_ == Float(32) && output_type_ == Float(32)) {
+      return air::ir::intrinsic::sgemm_kernel_avx;
+    } else if (input_type_ == Float(16) && output_type_ == Float(32)) {
+      return air::ir::intrinsic::hgemm_kernel_avx512;
+    } else if (input_type_ == Int(8) && output_type_ == Int(32)) {
+      return air::ir::intrinsic::igemm_kernel_vnni;
+    }
+    return nullptr;
+  }
+
   void AnalyzeComputeInfo(const Provide *op) {
     Expr c_expr = op->value.as<Add>()->a;
-    Expr a_expr = op->value.as<Add>()->b.as<Mul>()->a;
-    Expr b_expr = op->value.as<Add>()->b.as<Mul>()->b;
+    Expr a_expr = SplitCast(op->value.as<Add>()->b.as<Mul>()->a);
+    Expr b_expr = SplitCast(op->value.as<Add>()->b.as<Mul>()->b);
+    input_type_ = a_expr.type() == b_expr.type() ? a_expr.type() : Type();
+    output_type_ = c_expr.type();
 
     compute_ = Call::make(Handle(), air::ir::intrinsic::tvm_address_of, {c_expr}, Call::PureIntrinsic);
     input_1_ = Call::make(Handle(), air::ir::intrinsic::tvm_address_of, {a_expr}, Call::PureIntrinsic);
@@ -242,6 +264,8 @@ class GemmCompute : public IRMutator {
 
   bool sync_compute_flag_{false};
   int64_t ldc_{0};
+  Type input_type_{Float(32)};
+  Type output_type_{Float(32)};
   Expr compute_;
   Expr input_1_;
   Expr input_2_;
@@ -401,7 +401,7 @@ class PackedReconstruction : public IRMutator {
       auto c = op->args[1];
       int block_size = b_block_size_;
       Expr new_ld = a_col_major_ ? a_m_len_ : a_k_len_;
-      Expr new_idx = get_new_idx(a_col_major_, block_size, r, c, a_k_len_, a_m_len_);
+      Expr new_idx = get_new_idx(a_col_major_, block_size, r, c, a_k_len_, a_m_len_, a_dtype_ == Int(8));
       return Provide::make(op->func, op->value_index, op->value,
         {floordiv(new_idx, new_ld), indexmod(new_idx, new_ld)});
     }
@@ -410,7 +410,7 @@ class PackedReconstruction : public IRMutator {
       auto c = op->args[1];
       int block_size = a_block_size_;
       Expr new_ld = b_col_major_ ? b_k_len_ : b_n_len_;
-      Expr new_idx = get_new_idx(!b_col_major_, block_size, r, c, b_k_len_, b_n_len_);
+      Expr new_idx = get_new_idx(!b_col_major_, block_size, r, c, b_k_len_, b_n_len_, b_dtype_ == Int(8));
       return Provide::make(op->func, op->value_index, op->value,
         {floordiv(new_idx, new_ld), indexmod(new_idx, new_ld)});
     }
@@ -418,7 +418,9 @@ class PackedReconstruction : public IRMutator {
   }
 
  private:
-  Expr get_new_idx(bool km, int block_size, Expr r, Expr c, Expr k_len, Expr m_len) {
+  // Panels of block_size rows stored k-major, the last rows in panels of block_size / 2, block_size / 4 ... 1. With
+  // group_k (int8 for the VNNI kernel), k is packed in groups of 4 inside a panel, the last k_len % 4 stay k-major.
+  Expr get_new_idx(bool km, int block_size, Expr r, Expr c, Expr k_len, Expr m_len, bool group_k) {
     auto block_num = ceil(div(m_len, block_size * 1.0));
     auto m_rest = indexmod(m_len, block_size);
     Expr k = km ? r : c;
@@ -437,6 +439,12 @@ class PackedReconstruction : public IRMutator {
       small_block /= 2;
     }
     auto new_idx = (block_idx * block_size + a) * k_len + mm - a + b * k;
+    if (group_k) {
+      constexpr int group = 4;
+      auto grouped_idx =
+        (block_idx * block_size + a) * k_len + floordiv(k, group) * b * group + (mm - a) * group + indexmod(k, group);
+      new_idx = Select::make(k < k_len - indexmod(k_len, group), grouped_idx, new_idx);
+    }
     return new_idx;
   }
 
@@ -31,6 +31,7 @@
 
 #include "common/common_util.h"
 #include "pass/utils.h"
+#include "build_module.h"
 #include "ir_pass.h"
 
 namespace akg {
@@ -38,6 +39,7 @@ namespace ir {
 constexpr auto REDUCE_AREA_FLAG = "reduce_area";
 constexpr auto VECTOR_LENGTH = "VECTOR_LENGTH";
 constexpr auto REDUCE_PROVIDE = "REDUCE_PROVIDE";
+constexpr int DEFAULT_REDUCE_ACCUMULATORS = 4;
 
 struct ReductionData {
   Stmt body;
@@ -401,8 +403,8 @@ class MutateReduceBody : public IRMutator {
 
 class ReduceVectorizeEnable : public IRMutator {
  public:
-  explicit ReduceVectorizeEnable(std::map<int, std::shared_ptr<ReductionData>> &reduce_data)
-      : reduce_datas_(reduce_data) {}
+  ReduceVectorizeEnable(std::map<int, std::shared_ptr<ReductionData>> &reduce_data, int max_accumulators)
+      : reduce_datas_(reduce_data), max_accumulators_(max_accumulators) {}
 
   Stmt Mutate_(const AttrStmt *op, const Stmt &s) {
     if (op->attr_key == REDUCE_AREA_FLAG) {
@@ -456,9 +458,9 @@ class ReduceVectorizeEnable : public IRMutator {
     return IRMutator::Mutate_(op, s);
   }
 
-  void SetTensorBuffer(std::shared_ptr<ReductionData> &reduce_data, const std::string &tensor_name) {
+  void SetTensorBuffer(std::shared_ptr<ReductionData> &reduce_data, const std::string &tensor_name, int accumulators) {
     Array<Expr> shapes;
-    shapes.push_back(reduce_data->vector_parallel_for->extent);
+    shapes.push_back(reduce_data->vector_parallel_for->extent * accumulators);
     Type type = reduce_data->reduce_data_type_info;
 
     Tensor tensor = placeholder(shapes, type, tensor_name);
@@ -490,32 +492,39 @@ class ReduceVectorizeEnable : public IRMutator {
     auto name = reduce_provide->func->func_name();
     name += "_temp";
     name += std::to_string(tensor_name_count_++);
-    SetTensorBuffer(cur_reduce_data_, name);
+    int accumulators = NumAccumulators();
+    SetTensorBuffer(cur_reduce_data_, name, accumulators);
+    Expr index = vector_parallel_for->loop_var;
+    if (accumulators > 1) {
+      // Consecutive unrolled iterations fold into different vectors, so they are not one dependent chain.
+      index = Mod::make(cur_reduce_data_->unroll_for->loop_var, accumulators) * vector_parallel_for->extent + index;
+    }
     Array<Expr> args;
-    args.push_back(vector_parallel_for->loop_var);
+    args.push_back(index);
     cur_reduce_data_->reduce_temp = MakeCallFromTempTensor(args);
+    Expr combine_temp = MakeCallFromTempTensor({vector_parallel_for->loop_var});
 
     // step 2: final reduce area
     auto value = reduce_provide->value;
     auto dst_func = reduce_provide->func;
     if (auto min = value.as<Min>()) {
       SetTheDstAndInputExpr(min->a, min->b, dst_func);
-      value = Min::make(cur_reduce_data_->reduce_dst, cur_reduce_data_->reduce_temp);
+      value = Min::make(cur_reduce_data_->reduce_dst, combine_temp);
     } else if (auto max = value.as<Max>()) {
       SetTheDstAndInputExpr(max->a, max->b, dst_func);
-      value = Max::make(cur_reduce_data_->reduce_dst, cur_reduce_data_->reduce_temp);
+      value = Max::make(cur_reduce_data_->reduce_dst, combine_temp);
     } else if (auto and_op = value.as<And>()) {
       SetTheDstAndInputExpr(and_op->a, and_op->b, dst_func);
-      value = And::make(cur_reduce_data_->reduce_dst, cur_reduce_data_->reduce_temp);
+      value = And::make(cur_reduce_data_->reduce_dst, combine_temp);
     } else if (auto or_op = value.as<Or>()) {
       SetTheDstAndInputExpr(or_op->a, or_op->b, dst_func);
-      value = Or::make(cur_reduce_data_->reduce_dst, cur_reduce_data_->reduce_temp);
+      value = Or::make(cur_reduce_data_->reduce_dst, combine_temp);
     } else if (auto add = value.as<Add>()) {
       SetTheDstAndInputExpr(add->a, add->b, dst_func);
-      value = Add::make(cur_reduce_data_->reduce_dst, cur_reduce_data_->reduce_temp);
+      value = Add::make(cur_reduce_data_->reduce_dst, combine_temp);
     } else if (auto mul = value.as<Mul>()) {
       SetTheDstAndInputExpr(mul->a, mul->b, dst_func);
-      value = Mul::make(cur_reduce_data_->reduce_dst, cur_reduce_data_->reduce_temp);
+      value = Mul::make(cur_reduce_data_->reduce_dst, combine_temp);
     } else {
       CHECK(false) << "reduce type is invalid";
     }
@@ -525,7 +534,12 @@ class ReduceVectorizeEnable : public IRMutator {
     auto reduce_provide_new =
       Provide::make(reduce_provide->func, reduce_provide->value_index, value, reduce_provide->args);
     Map<Var, Expr> finial_replace_var;
-    finial_replace_var.Set(vector_parallel_for->loop_var, loop_var);
+    Expr temp_extent = cur_reduce_data_->temp_tensor->shape[0];
+    int shift = 0;
+    bool tree_combine = max_accumulators_ > 1 && is_zero(vector_parallel_for->min) &&
+                        is_const_power_of_two_integer(temp_extent, &shift) && shift > 0 &&
+                        !air::ir::ExprUseVar(cur_reduce_data_->reduce_dst, vector_parallel_for->loop_var);
+    finial_replace_var.Set(vector_parallel_for->loop_var, tree_combine ? make_zero(loop_var.type()) : loop_var);
     reduce_provide_new = air::ir::Substitute(reduce_provide_new, finial_replace_var);
     if (cur_reduce_data_->outter_reduction_data.get() != nullptr) {
       auto op = reduce_provide_new.as<Provide>();
@@ -537,8 +551,10 @@ class ReduceVectorizeEnable : public IRMutator {
       }
       cur_reduce_data_->outter_reduction_data->parallel_internal_reduce_provides.insert(op);
     }
-    Stmt final_reduce = For::make(loop_var, vector_parallel_for->min, vector_parallel_for->extent,
-                                  air::ir::ForType::Serial, vector_parallel_for->device_api, reduce_provide_new);
+    Stmt final_reduce = tree_combine ? Block::make(MakeTreeCombine(value, 1 << shift), reduce_provide_new)
+                                     : For::make(loop_var, vector_parallel_for->min, temp_extent,
+                                                 air::ir::ForType::Serial, vector_parallel_for->device_api,
+                                                 reduce_provide_new);
 
     // step 3: vectorize or parallel area
     auto reduce_body = MutateReduceBody(cur_reduce_data_).Mutate(cur_reduce_data_->body);
@@ -549,10 +565,10 @@ class ReduceVectorizeEnable : public IRMutator {
     Map<Var, Expr> init_replace_var;
     init_replace_var.Set(vector_parallel_for->loop_var, loop_var);
     auto init_provide = Provide::make(cur_reduce_data_->temp_tensor->op, cur_reduce_data_->temp_tensor->value_index,
-                                      cur_reduce_data_->init_value, cur_reduce_data_->reduce_temp.as<Call>()->args);
+                                      cur_reduce_data_->init_value, combine_temp.as<Call>()->args);
     init_provide = air::ir::Substitute(init_provide, init_replace_var);
-    Stmt init_stmt = For::make(loop_var, vector_parallel_for->min, vector_parallel_for->extent,
-                               air::ir::ForType::Vectorized, vector_parallel_for->device_api, init_provide);
+    Stmt init_stmt = For::make(loop_var, vector_parallel_for->min, temp_extent, air::ir::ForType::Vectorized,
+                               vector_parallel_for->device_api, init_provide);
 
     // 4 make block and insert realize
     Stmt stmt = Block::make({init_stmt, reduce_body, final_reduce});
@@ -561,6 +577,61 @@ class ReduceVectorizeEnable : public IRMutator {
     return stmt;
   }
 
+  // Independent accumulators of a vectorized reduce nested in an unrolled loop, 1 keeps a single vector.
+  int NumAccumulators() {
+    auto vector_for = cur_reduce_data_->vector_parallel_for;
+    auto unroll_for = cur_reduce_data_->unroll_for;
+    if (unroll_for == nullptr || vector_for->for_type != air::ir::ForType::Vectorized || !is_zero(vector_for->min)) {
+      return 1;
+    }
+    auto extent = unroll_for->extent.as<IntImm>();
+    bool nested = false;
+    air::ir::PostOrderVisit(unroll_for->body, [&nested, vector_for](const NodeRef &node) {
+      nested = nested || node.get() == vector_for;
+    });
+    if (extent == nullptr || !nested) {
+      return 1;
+    }
+    int accumulators = std::max(max_accumulators_, 1);
+    while (extent->value % accumulators != 0) {
+      --accumulators;
+    }
+    return accumulators;
+  }
+
+  // Folds the upper half of the temp tensor into the lower half until temp[0] holds the result. The order is fixed, so
+  // the result does not depend on the thread count at run time.
+  Stmt MakeTreeCombine(const Expr &final_value, int size) {
+    auto temp = cur_reduce_data_->temp_tensor;
+    auto loop_type = cur_reduce_data_->vector_parallel_for->loop_var.type();
+    std::vector<Stmt> stmts;
+    for (int half = size / 2; half >= 1; half /= 2) {
+      auto loop_var = Variable::make(loop_type, "tree" + std::to_string(var_name_count_++));
+      Expr lower = MakeCallFromTempTensor({loop_var});
+      Expr upper = MakeCallFromTempTensor({loop_var + make_const(loop_type, half)});
+      Expr value;
+      if (final_value.as<Min>()) {
+        value = Min::make(lower, upper);
+      } else if (final_value.as<Max>()) {
+        value = Max::make(lower, upper);
+      } else if (final_value.as<And>()) {
+        value = And::make(lower, upper);
+      } else if (final_value.as<Or>()) {
+        value = Or::make(lower, upper);
+      } else if (final_value.as<Add>()) {
+        value = Add::make(lower, upper);
+      } else {
+        CHECK(final_value.as<Mul>()) << "reduce type is invalid";
+        value = Mul::make(lower, upper);
+      }
+      Stmt provide = Provide::make(temp->op, temp->value_index, value, {loop_var});
+      auto for_type = half > 1 ? air::ir::ForType::Vectorized : air::ir::ForType::Serial;
+      stmts.push_back(For::make(loop_var, make_zero(loop_type), make_const(loop_type, half), for_type,
+                                DeviceAPI::None, provide));
+    }
+    return Block::make(stmts);
+  }
+
   Expr MakeCallFromTempTensor(const Array<Expr> &args) {
     std::string name = cur_reduce_data_->temp_tensor->op->name;
     Type type = cur_reduce_data_->temp_buffer->dtype;
@@ -588,13 +659,15 @@ class ReduceVectorizeEnable : public IRMutator {
   std::shared_ptr<ReductionData> cur_reduce_data_;
   int var_name_count_{0};
   int tensor_name_count_{0};
+  int max_accumulators_{DEFAULT_REDUCE_ACCUMULATORS};
 };
 
 Stmt ReductionFactor(const Stmt &stmt, const Map<Tensor, Buffer> &extern_buffer) {
   IdentifyReduceChance identify_reduce(extern_buffer);
   identify_reduce.Visit(stmt);
 
-  return ReduceVectorizeEnable(identify_reduce.reduce_datas_).Mutate(stmt);
+  int max_accumulators = g_attrs.GetInt(kReduceAccumulators, DEFAULT_REDUCE_ACCUMULATORS);
+  return ReduceVectorizeEnable(identify_reduce.reduce_datas_, max_accumulators).Mutate(stmt);
 }
 
 }  // namespace ir
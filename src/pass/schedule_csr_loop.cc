@@ -0,0 +1,350 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tvm/ir.h>
+#include <tvm/ir_mutator.h>
+#include <tvm/ir_pass.h>
+#include <tvm/ir_visitor.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "build_module.h"
+#include "common/target_info.h"
+#include "ir_pass.h"
+
+namespace akg {
+namespace ir {
+/*
+ * Cpu schedule of the loop nests of csr kernels, after flattening:
+ *
+ *   for (row, 0, rows) {
+ *     out[row] = 0
+ *     for (idx, 0, (indptr[row + 1] - indptr[row])) {
+ *       out[row] = select(indptr[row] + idx < indptr[row + 1], data[indptr[row] + idx] * ..., 0) + out[row]
+ *     }
+ *   }
+ *
+ * The rows are split into tasks of the same number of nonzeros, each task finds its rows by a binary search of
+ * indptr, so that skewed row lengths do not leave threads idle:
+ *
+ *   parallel (task, 0, tasks) {
+ *     csr_rows[0] = lower bound of indptr[0] + nnz * task / tasks in indptr, csr_rows[1] the same for task + 1
+ *     for (row, csr_rows[0], (csr_rows[1] - csr_rows[0])) { ... }
+ *   }
+ *
+ * Only rows that write disjoint elements are split, a scatter by column index stays serial. The loop over the
+ * nonzeros of a row is vectorized when it writes the nonzeros element-wise or accumulates into one element, through
+ * vector accumulators in the latter case, with a scalar loop for the remainder.
+ */
+namespace {
+constexpr int kTasksPerCore = 4;
+constexpr auto kCsrReduceUpdate = "reduce_update";
+
+// Returns the indptr buffer if extent is the number of nonzeros of row, indptr[row + 1] - indptr[row].
+const Variable *MatchNonzeros(const Expr &extent, const Var &row) {
+  auto sub = extent.as<Sub>();
+  if (sub == nullptr) {
+    return nullptr;
+  }
+  auto end = sub->a.as<Load>();
+  auto begin = sub->b.as<Load>();
+  if (end == nullptr || begin == nullptr || end->buffer_var.get() != begin->buffer_var.get() ||
+      !Equal(begin->index, row) || !is_zero(Simplify(end->index - row - 1))) {
+    return nullptr;
+  }
+  return end->buffer_var.get();
+}
+
+// The loop over the nonzeros of a row in the body of the row loop, not under another loop.
+class NonzerosLoopFinder : public IRVisitor {
+ public:
+  explicit NonzerosLoopFinder(const Var &row) : row_(row) {}
+
+  void Visit_(const For *op) final {
+    if (loop_ == nullptr && is_zero(op->min)) {
+      indptr_ = MatchNonzeros(op->extent, row_);
+      loop_ = indptr_ != nullptr ? op : nullptr;
+    }
+  }
+
+  const For *loop_{nullptr};
+  const Variable *indptr_{nullptr};
+
+ private:
+  const Var &row_;
+};
+
+// Whether the rows can run in any order: every store of a row writes elements that only this row writes and reads.
+class RowIndependence : public IRVisitor {
+ public:
+  RowIndependence(const Var &row, const Variable *indptr) : row_(row), indptr_(indptr) {}
+
+  bool Check(const Stmt &body) {
+    Visit(body);
+    for (auto load : loads_) {
+      auto it = stores_.find(load->buffer_var.get());
+      if (it != stores_.end() &&
+          std::none_of(it->second.begin(), it->second.end(), [load](const Expr &e) { return Equal(e, load->index); })) {
+        return false;
+      }
+    }
+    return independent_;
+  }
+
+ private:
+  void Visit_(const Store *op) final {
+    // The elements of a row are given by the row or by its range in indptr, not by a loaded column index.
+    bool loads_other = false;
+    PostOrderVisit(op->index, [this, &loads_other](const NodeRef &node) {
+      auto load = node.as<Load>();
+      loads_other = loads_other || (load != nullptr && load->buffer_var.get() != indptr_);
+    });
+    if (loads_other || !air::ir::ExprUseVar(op->index, row_)) {
+      independent_ = false;
+    }
+    stores_[op->buffer_var.get()].push_back(op->index);
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Load *op) final {
+    loads_.push_back(op);
+    IRVisitor::Visit_(op);
+  }
+
+  const Var &row_;
+  const Variable *indptr_;
+  bool independent_{true};
+  std::unordered_map<const Variable *, std::vector<Expr>> stores_;
+  std::vector<const Load *> loads_;
+};
+
+// Drops the bound checks of the nonzeros of a row, idx < nnz holds in the loop.
+class RemoveNonzerosGuard : public IRMutator {
+ public:
+  RemoveNonzerosGuard(const Var &idx, const Expr &nnz) : idx_(idx), nnz_(nnz) {}
+
+  Expr Mutate_(const LT *op, const Expr &e) final {
+    if (is_zero(Simplify((op->a - op->b) - (idx_ - nnz_)))) {
+      return const_true();
+    }
+    return IRMutator::Mutate_(op, e);
+  }
+
+  Stmt Mutate_(const AttrStmt *op, const Stmt &s) final {
+    if (op->attr_key == kCsrReduceUpdate) {
+      return Mutate(op->body);
+    }
+    return IRMutator::Mutate_(op, s);
+  }
+
+ private:
+  const Var &idx_;
+  const Expr &nnz_;
+};
+
+// Replaces one loop of a stmt.
+class LoopReplacer : public IRMutator {
+ public:
+  LoopReplacer(const For *loop, const Stmt &replaced) : loop_(loop), replaced_(replaced) {}
+
+  Stmt Mutate_(const For *op, const Stmt &s) final { return op == loop_ ? replaced_ : IRMutator::Mutate_(op, s); }
+
+ private:
+  const For *loop_;
+  const Stmt &replaced_;
+};
+
+class CsrLoopScheduler : public IRMutator {
+ public:
+  CsrLoopScheduler(int tasks, int simd_bytes) : tasks_(tasks), simd_bytes_(simd_bytes) {}
+
+  Stmt Mutate_(const For *op, const Stmt &s) final {
+    if (op->for_type != ForType::Serial || !is_zero(op->min)) {
+      return IRMutator::Mutate_(op, s);
+    }
+    NonzerosLoopFinder finder(op->loop_var);
+    finder.Visit(op->body);
+    if (finder.loop_ == nullptr) {
+      return IRMutator::Mutate_(op, s);
+    }
+    const For *nonzeros = finder.loop_;
+    Stmt body = LoopReplacer(nonzeros, VectorizeNonzeros(nonzeros)).Mutate(op->body);
+    if (!RowIndependence(op->loop_var, finder.indptr_).Check(op->body)) {
+      return For::make(op->loop_var, op->min, op->extent, op->for_type, op->device_api, body);
+    }
+    return BalanceRows(op, body, nonzeros->extent.as<Sub>()->a.as<Load>());
+  }
+
+ private:
+  Stmt VectorizeNonzeros(const For *op) {
+    Stmt loop = GetRef<Stmt>(op);
+    Var nnz("row_nnz", op->extent.type());
+    Stmt body = Simplify(RemoveNonzerosGuard(op->loop_var, op->extent).Mutate(op->body));
+    auto store = body.as<Store>();
+    if (store == nullptr) {
+      return loop;
+    }
+    int lanes = simd_bytes_ / std::max(store->value.type().bytes(), 1);
+    if (lanes < 2) {
+      return loop;
+    }
+
+    Var outer(op->loop_var->name_hint + ".outer", op->loop_var.type());
+    Var inner(op->loop_var->name_hint + ".inner", op->loop_var.type());
+    Var tail(op->loop_var->name_hint + ".tail", op->loop_var.type());
+    Expr vector_nnz = floordiv(nnz, lanes) * lanes;
+    Map<Var, Expr> vector_idx = {{op->loop_var, outer * lanes + inner}};
+    auto Vectorized = [&outer, &inner, &nnz, lanes](const Stmt &s) {
+      Stmt loop = For::make(inner, 0, lanes, ForType::Vectorized, DeviceAPI::None, s);
+      return For::make(outer, 0, floordiv(nnz, lanes), ForType::Serial, DeviceAPI::None, loop);
+    };
+    Stmt remainder = For::make(tail, vector_nnz, nnz - vector_nnz, ForType::Serial, DeviceAPI::None,
+                               Substitute(body, {{op->loop_var, tail}}));
+
+    Stmt res;
+    Expr value;
+    if (IsElementwise(body, op->loop_var)) {
+      res = Block::make(Vectorized(Substitute(body, vector_idx)), remainder);
+    } else if (MatchAccumulate(store, op->loop_var, &value)) {
+      // One accumulator per lane, added to the element after the vector loop.
+      Type type = store->value.type();
+      Var acc("csr_acc", Handle());
+      auto Acc = [&acc, type](const Expr &index) { return Load::make(type, acc, index, const_true()); };
+      Var lane("csr_lane", Int(32));
+      Stmt init = For::make(lane, 0, lanes, ForType::Vectorized, DeviceAPI::None,
+                            Store::make(acc, make_zero(type), lane, const_true()));
+      Stmt update = Vectorized(Store::make(acc, Acc(inner) + Substitute(value, vector_idx), inner, const_true()));
+      std::vector<Expr> parts;
+      for (int i = 0; i < lanes; ++i) {
+        parts.push_back(Acc(i));
+      }
+      for (size_t n = parts.size(); n > 1; n = (n + 1) / 2) {
+        for (size_t i = 0; i + 1 < n; i += 2) {
+          parts[i / 2] = parts[i] + parts[i + 1];
+        }
+        if (n % 2 == 1) {
+          parts[n / 2] = parts[n - 1];
+        }
+      }
+      Expr dst = Load::make(type, store->buffer_var, store->index, store->predicate);
+      Stmt combine = Store::make(store->buffer_var, dst + parts[0], store->index, store->predicate);
+      res = Block::make({init, update, combine, remainder});
+      res = Allocate::make(acc, type, {make_const(Int(32), lanes)}, const_true(), res);
+      res = AttrStmt::make(acc, air::ir::attr::storage_scope, StringImm::make("local"), res);
+    } else {
+      return loop;
+    }
+    return LetStmt::make(nnz, op->extent, res);
+  }
+
+  // Every store writes the element of the nonzero, and no iteration reads what another one writes.
+  static bool IsElementwise(const Stmt &body, const Var &idx) {
+    bool elementwise = true;
+    std::vector<const Variable *> written;
+    PostOrderVisit(body, [&elementwise, &written, &idx](const NodeRef &node) {
+      if (auto store = node.as<Store>()) {
+        elementwise = elementwise && air::ir::ExprUseVar(store->index, idx);
+        written.push_back(store->buffer_var.get());
+      }
+    });
+    PostOrderVisit(body, [&elementwise, &written](const NodeRef &node) {
+      auto load = node.as<Load>();
+      if (load != nullptr && std::count(written.begin(), written.end(), load->buffer_var.get())) {
+        elementwise = false;
+      }
+    });
+    return elementwise;
+  }
+
+  // dst[i] = dst[i] + value or value + dst[i], with i the same in all iterations and value not reading dst.
+  static bool MatchAccumulate(const Store *store, const Var &idx, Expr *value) {
+    auto add = store->value.as<Add>();
+    if (add == nullptr || store->value.type().lanes() != 1 || air::ir::ExprUseVar(store->index, idx)) {
+      return false;
+    }
+    auto IsDst = [store](const Expr &e) {
+      auto load = e.as<Load>();
+      return load != nullptr && load->buffer_var.same_as(store->buffer_var) && Equal(load->index, store->index);
+    };
+    *value = IsDst(add->a) ? add->b : (IsDst(add->b) ? add->a : Expr());
+    if (!value->defined()) {
+      return false;
+    }
+    bool reads_dst = false;
+    PostOrderVisit(*value, [&reads_dst, store](const NodeRef &node) {
+      auto load = node.as<Load>();
+      reads_dst = reads_dst || (load != nullptr && load->buffer_var.same_as(store->buffer_var));
+    });
+    return !reads_dst;
+  }
+
+  Stmt BalanceRows(const For *op, const Stmt &body, const Load *end) {
+    Expr rows = op->extent;
+    auto const_rows = as_const_int(rows);
+    int tasks = const_rows != nullptr ? static_cast<int>(std::min<int64_t>(tasks_, *const_rows)) : tasks_;
+    if (tasks < 2) {
+      return For::make(op->loop_var, op->min, op->extent, op->for_type, op->device_api, body);
+    }
+    Type type = end->type;
+    Var indptr = Downcast<Var>(end->buffer_var);
+    auto Indptr = [&indptr, type](const Expr &index) { return Load::make(type, indptr, index, const_true()); };
+    Var bound("csr_rows", Handle());
+    auto Bound = [&bound, type](int slot) { return Load::make(type, bound, slot, const_true()); };
+    auto SetBound = [&bound](int slot, const Expr &value) { return Store::make(bound, value, slot, const_true()); };
+
+    // The first row whose nonzeros start at or after target, by a binary search over [0, rows] in bound[slot] and
+    // bound[2].
+    int steps = 32;
+    if (const_rows != nullptr) {
+      for (steps = 1; (int64_t{1} << steps) <= *const_rows; ++steps) {
+      }
+    }
+    auto LowerBound = [&](int slot, const Expr &target) {
+      Var step("csr_step", Int(32));
+      Var mid("csr_mid", type);
+      Stmt bisect = IfThenElse::make(Indptr(mid) < target, SetBound(slot, mid + 1), SetBound(2, mid));
+      bisect = LetStmt::make(mid, floordiv(Bound(slot) + Bound(2), 2), bisect);
+      bisect = IfThenElse::make(Bound(slot) < Bound(2), bisect);
+      return Block::make({SetBound(slot, make_zero(type)), SetBound(2, cast(type, rows)),
+                          For::make(step, 0, steps, ForType::Serial, DeviceAPI::None, bisect)});
+    };
+
+    Var task("csr_task", Int(32));
+    Expr nnz = cast(Int(64), Indptr(rows) - Indptr(0));
+    auto Target = [&](const Expr &t) { return Indptr(0) + cast(type, floordiv(nnz * cast(Int(64), t), tasks)); };
+    Stmt last_end = SetBound(1, cast(type, rows));
+    Stmt task_body = Block::make(
+      {LowerBound(0, Target(task)), IfThenElse::make(task == tasks - 1, last_end, LowerBound(1, Target(task + 1))),
+       For::make(op->loop_var, Bound(0), Bound(1) - Bound(0), ForType::Serial, op->device_api, body)});
+    task_body = Allocate::make(bound, type, {make_const(Int(32), 3)}, const_true(), task_body);
+    task_body = AttrStmt::make(bound, air::ir::attr::storage_scope, StringImm::make("local"), task_body);
+    return For::make(task, 0, tasks, ForType::Parallel, DeviceAPI::None, task_body);
+  }
+
+  int tasks_;
+  int simd_bytes_;
+};
+}  // namespace
+
+Stmt ScheduleCsrLoop(const Stmt &stmt) {
+  auto cpu_info = air::GetCpuInfo(g_attrs.GetStr("cpu_info", ""));
+  return CsrLoopScheduler(cpu_info->core_num * kTasksPerCore, cpu_info->simd_bytes).Mutate(stmt);
+}
+}  // namespace ir
+}  // namespace akg
@@ -0,0 +1,545 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tvm/arithmetic.h>
+#include <tvm/ir.h>
+#include <tvm/ir_mutator.h>
+#include <tvm/ir_pass.h>
+#include <tvm/ir_visitor.h>
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "build_module.h"
+#include "common/target_info.h"
+#include "ir_pass.h"
+
+namespace akg {
+namespace ir {
+/*
+ * Cpu schedule of the index-driven loop nests of Gather, GatherNd, TensorScatterAdd and UnsortedSegmentSum, after
+ * flattening. A nest is the outermost serial loop of a stmt whose loads or stores are indexed by loaded values.
+ *
+ * A gather nest, whose stores write a disjoint row of elements in each iteration of its outer loop, runs the outer
+ * loop in parallel when there are several cores and at least kMinParallelUpdates stores. In a loop over a gathered row, the bounds check of the loaded index is hoisted and the row is
+ * vectorized. When the gathered buffer does not fit in l2, the loop over the indices prefetches the row of the index
+ * kPrefetchDistance iterations ahead, its loads stay scalar.
+ *
+ * A scatter nest, which accumulates into the elements given by loaded indices, is split into tasks that do not write
+ * the same elements:
+ *   partial  each task accumulates its range of iterations into its own copy of the output, zeroed first, and the
+ *            copies are added to the output afterwards. Used when the copies cost no more than the updates and fit in
+ *            l3.
+ *   bucket   the iterations are sorted by their output row, modulo the number of tasks, with a counting sort, and
+ *            each task runs the iterations of its bucket in order. Used when the rows written by the iterations are
+ *            proven to be either the same or disjoint.
+ * Otherwise the nest stays serial.
+ */
+namespace {
+constexpr int kTasksPerCore = 4;
+constexpr int kPrefetchDistance = 8;
+constexpr int kMaxPrefetchLines = 8;
+// Below this many stores, a gather takes less time than waking the threads of the pool.
+constexpr int64_t kMinParallelUpdates = 16384;
+
+bool LoadsIndex(const Expr &index) {
+  bool loads = false;
+  PostOrderVisit(index, [&loads](const NodeRef &node) { loads = loads || node.as<Load>() != nullptr; });
+  return loads;
+}
+
+// The loops, stores and loads of a loop nest.
+class NestInfo : public IRVisitor {
+ public:
+  explicit NestInfo(const Stmt &nest) { Visit(nest); }
+
+  std::vector<const For *> loops_;
+  std::vector<const Store *> stores_;
+  std::vector<const Load *> loads_;
+  std::vector<Var> lets_;
+  bool indirect_load_{false};
+  bool indirect_store_{false};
+  // Loops already scheduled, allocations or calls with side effects.
+  bool opaque_{false};
+
+ private:
+  void Visit_(const For *op) final {
+    opaque_ = opaque_ || op->for_type != ForType::Serial;
+    loops_.push_back(op);
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Store *op) final {
+    indirect_store_ = indirect_store_ || LoadsIndex(op->index);
+    stores_.push_back(op);
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Load *op) final {
+    indirect_load_ = indirect_load_ || LoadsIndex(op->index);
+    loads_.push_back(op);
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const LetStmt *op) final {
+    lets_.push_back(op->var);
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Allocate *op) final {
+    opaque_ = true;
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Evaluate *op) final {
+    opaque_ = true;
+    IRVisitor::Visit_(op);
+  }
+};
+
+// The number of iterations of the innermost statements of a nest, the loops of unknown extent counted once.
+int64_t NestUpdates(const NestInfo &nest) {
+  int64_t updates = 1;
+  for (auto loop : nest.loops_) {
+    auto loop_extent = as_const_int(loop->extent);
+    updates *= loop_extent != nullptr ? *loop_extent : 1;
+  }
+  return updates;
+}
+
+/*
+ * The elements a store writes in an iteration of the outer loop of a nest are [start, start + span), start being the
+ * index with the inner loops at their first iteration and a multiple of span. Two iterations then write either the
+ * same row of elements or disjoint ones.
+ */
+bool RowOfStore(const Store *store, const NestInfo &nest, Expr *start, int64_t *span) {
+  air::arith::Analyzer analyzer;
+  Map<Var, Expr> first;
+  for (size_t i = 1; i < nest.loops_.size(); ++i) {
+    auto loop = nest.loops_[i];
+    analyzer.Bind(loop->loop_var, Range::make_by_min_extent(loop->min, loop->extent));
+    first.Set(loop->loop_var, loop->min);
+  }
+  *start = Simplify(Substitute(store->index, first));
+  for (const auto &let : nest.lets_) {
+    if (air::ir::ExprUseVar(*start, let)) {
+      return false;
+    }
+  }
+  auto bound = analyzer.const_int_bound(Simplify(store->index - *start));
+  if (bound->min_value < 0 || bound->max_value >= std::numeric_limits<int32_t>::max()) {
+    return false;
+  }
+  *span = bound->max_value + 1;
+  return *span == 1 || analyzer.CanProve(floormod(*start, make_const(start->type(), *span)) == 0);
+}
+
+// dst[i] = dst[i] + value or value + dst[i], with value not reading dst.
+Expr AccumulatedValue(const Store *store) {
+  auto add = store->value.as<Add>();
+  if (add == nullptr || store->value.type().lanes() != 1) {
+    return Expr();
+  }
+  auto IsDst = [store](const Expr &e) {
+    auto load = e.as<Load>();
+    return load != nullptr && load->buffer_var.same_as(store->buffer_var) && Equal(load->index, store->index);
+  };
+  Expr value = IsDst(add->a) ? add->b : (IsDst(add->b) ? add->a : Expr());
+  bool reads_dst = false;
+  if (value.defined()) {
+    PostOrderVisit(value, [&reads_dst, store](const NodeRef &node) {
+      auto load = node.as<Load>();
+      reads_dst = reads_dst || (load != nullptr && load->buffer_var.same_as(store->buffer_var));
+    });
+  }
+  return reads_dst ? Expr() : value;
+}
+
+// Moves the accesses of a buffer to a slice of another one.
+class BufferRedirect : public IRMutator {
+ public:
+  BufferRedirect(const Variable *from, const Var &to, const Expr &offset) : from_(from), to_(to), offset_(offset) {}
+
+  Expr Mutate_(const Load *op, const Expr &e) final {
+    if (op->buffer_var.get() != from_) {
+      return IRMutator::Mutate_(op, e);
+    }
+    return Load::make(op->type, to_, Mutate(op->index) + offset_, Mutate(op->predicate));
+  }
+
+  Stmt Mutate_(const Store *op, const Stmt &s) final {
+    if (op->buffer_var.get() != from_) {
+      return IRMutator::Mutate_(op, s);
+    }
+    return Store::make(to_, Mutate(op->value), Mutate(op->index) + offset_, Mutate(op->predicate));
+  }
+
+ private:
+  const Variable *from_;
+  const Var &to_;
+  const Expr &offset_;
+};
+
+Stmt AllocateBuffer(const Var &buffer, Type type, const Expr &size, const Stmt &body) {
+  Stmt stmt = Allocate::make(buffer, type, {size}, const_true(), body);
+  return AttrStmt::make(buffer, air::ir::attr::storage_scope, StringImm::make("global"), stmt);
+}
+
+// Hoists bounds checks, vectorizes and prefetches the rows of a gather nest.
+class GatherRowScheduler : public IRMutator {
+ public:
+  GatherRowScheduler(const air::CpuInfo &cpu, const std::unordered_map<const Variable *, int64_t> &sizes)
+      : cpu_(cpu), sizes_(sizes) {}
+
+  Stmt Mutate_(const For *op, const Stmt &s) final {
+    Stmt stmt = IRMutator::Mutate_(op, s);
+    op = stmt.as<For>();
+    Stmt body = Prefetch(op, op->body);
+    if (!body.same_as(op->body)) {
+      return For::make(op->loop_var, op->min, op->extent, op->for_type, op->device_api, body);
+    }
+    // for (k) { if (c) A else B } with c not depending on k becomes if (c) { for (k) A } else { for (k) B }.
+    auto guard = op->body.as<IfThenElse>();
+    auto extent = as_const_int(op->extent);
+    if (guard != nullptr && extent != nullptr && *extent > 0 && !air::ir::ExprUseVar(guard->condition, op->loop_var)) {
+      auto Loop = [op](const Stmt &s) {
+        return s.defined() ? For::make(op->loop_var, op->min, op->extent, op->for_type, op->device_api, s) : s;
+      };
+      Stmt then_case = Loop(guard->then_case);
+      Stmt else_case = Loop(guard->else_case);
+      then_case = Vectorize(then_case.as<For>());
+      else_case = else_case.defined() ? Vectorize(else_case.as<For>()) : else_case;
+      return IfThenElse::make(guard->condition, then_case, else_case);
+    }
+    return Vectorize(op);
+  }
+
+  // Prefetches the rows gathered in the iteration kPrefetchDistance ahead of loop.
+  Stmt Prefetch(const For *op, const Stmt &body) {
+    NestInfo inner(body);
+    std::vector<Var> inner_vars = inner.lets_;
+    for (auto loop : inner.loops_) {
+      inner_vars.push_back(loop->loop_var);
+    }
+    auto UsesInnerVar = [&inner_vars](const Expr &e) {
+      return std::any_of(inner_vars.begin(), inner_vars.end(),
+                         [&e](const Var &v) { return air::ir::ExprUseVar(e, v); });
+    };
+
+    std::vector<const Variable *> prefetched;
+    std::vector<Stmt> prefetches;
+    for (auto load : inner.loads_) {
+      if (!LoadsIndex(load->index) ||
+          std::count(prefetched.begin(), prefetched.end(), load->buffer_var.get()) || !IsLarge(load)) {
+        continue;
+      }
+      // A row of the load is given by indices loaded with loop, not with the loops inside it.
+      bool row_load = false;
+      bool fixed_row = true;
+      PostOrderVisit(load->index, [&](const NodeRef &node) {
+        if (auto index = node.as<Load>()) {
+          row_load = row_load || air::ir::ExprUseVar(index->index, op->loop_var);
+          fixed_row = fixed_row && !UsesInnerVar(index->index);
+        }
+      });
+      if (!row_load || !fixed_row) {
+        continue;
+      }
+      air::arith::Analyzer analyzer;
+      Map<Var, Expr> first;
+      for (auto loop : inner.loops_) {
+        analyzer.Bind(loop->loop_var, Range::make_by_min_extent(loop->min, loop->extent));
+        first.Set(loop->loop_var, loop->min);
+      }
+      Expr start = Simplify(Substitute(load->index, first));
+      if (UsesInnerVar(start)) {
+        continue;
+      }
+      auto bound = analyzer.const_int_bound(Simplify(load->index - start));
+      int64_t row_bytes = load->type.bytes();
+      if (bound->min_value >= 0 && bound->max_value < std::numeric_limits<int32_t>::max()) {
+        row_bytes *= bound->max_value + 1;
+      }
+      int line = std::max(cpu_->cache_line_bytes, load->type.bytes());
+      int64_t lines = std::min<int64_t>((row_bytes + line - 1) / line, kMaxPrefetchLines);
+      Expr ahead = Substitute(start, {{op->loop_var, op->loop_var + kPrefetchDistance}});
+      Var l("prefetch_line", Int(32));
+      Expr address = Load::make(load->type, load->buffer_var, ahead + l * (line / load->type.bytes()), const_true());
+      address = Call::make(Handle(), air::ir::intrinsic::tvm_address_of, {address}, Call::PureIntrinsic);
+      Stmt prefetch = Evaluate::make(Call::make(load->type, Call::prefetch, {address, 0, 3, 1}, Call::Intrinsic));
+      prefetch = lines > 1 ? For::make(l, 0, static_cast<int>(lines), ForType::Serial, DeviceAPI::None, prefetch)
+                           : Substitute(prefetch, {{l, make_zero(Int(32))}});
+      // The indices past the end of the loop are not loaded.
+      prefetches.push_back(IfThenElse::make(op->loop_var + kPrefetchDistance < op->min + op->extent, prefetch));
+      prefetched.push_back(load->buffer_var.get());
+    }
+    if (prefetches.empty()) {
+      return body;
+    }
+    prefetches.push_back(body);
+    return Block::make(prefetches);
+  }
+
+ private:
+  bool IsLarge(const Load *load) const {
+    auto it = sizes_.find(load->buffer_var.get());
+    return it == sizes_.end() || it->second * load->type.bytes() > cpu_->l2_bytes;
+  }
+
+  // A row loop writing contiguous elements is split into vectors of the simd width.
+  Stmt Vectorize(const For *op) const {
+    Stmt loop = GetRef<Stmt>(op);
+    auto store = op->body.as<Store>();
+    auto extent = as_const_int(op->extent);
+    if (store == nullptr || extent == nullptr || store->value.type().lanes() != 1) {
+      return loop;
+    }
+    int lanes = cpu_->simd_bytes / std::max(store->value.type().bytes(), 1);
+    Expr next = Substitute(store->index, {{op->loop_var, op->loop_var + 1}});
+    if (lanes < 2 || *extent < lanes || *extent % lanes != 0 || !is_one(Simplify(next - store->index))) {
+      return loop;
+    }
+    if (*extent == lanes) {
+      return For::make(op->loop_var, op->min, op->extent, ForType::Vectorized, op->device_api, op->body);
+    }
+    Var outer(op->loop_var->name_hint + ".outer", op->loop_var.type());
+    Var inner(op->loop_var->name_hint + ".inner", op->loop_var.type());
+    Stmt body = Substitute(op->body, {{op->loop_var, op->min + outer * lanes + inner}});
+    body = For::make(inner, 0, lanes, ForType::Vectorized, op->device_api, body);
+    return For::make(outer, 0, static_cast<int>(*extent / lanes), ForType::Serial, op->device_api, body);
+  }
+
+  const air::CpuInfo &cpu_;
+  const std::unordered_map<const Variable *, int64_t> &sizes_;
+};
+
+class TotLoopScheduler : public IRMutator {
+ public:
+  TotLoopScheduler(const air::CpuInfo &cpu, const std::unordered_map<const Variable *, int64_t> &sizes)
+      : cpu_(cpu), sizes_(sizes) {}
+
+  Stmt Mutate_(const For *op, const Stmt &s) final {
+    if (op->for_type != ForType::Serial) {
+      return s;
+    }
+    NestInfo nest(s);
+    if (nest.opaque_ || !(nest.indirect_load_ || nest.indirect_store_)) {
+      return s;
+    }
+    if (nest.indirect_store_) {
+      return ScheduleScatter(op, nest);
+    }
+    auto extent = as_const_int(op->extent);
+    if (extent != nullptr && *extent <= 1) {
+      return IRMutator::Mutate_(op, s);
+    }
+    return ScheduleGather(op, nest);
+  }
+
+ private:
+  Stmt ScheduleGather(const For *op, const NestInfo &nest) {
+    Stmt s = GetRef<Stmt>(op);
+    // The rows written in different iterations are disjoint, and an iteration reads only its own row of them.
+    air::arith::Analyzer analyzer;
+    std::unordered_map<const Variable *, std::vector<Expr>> written;
+    for (auto store : nest.stores_) {
+      Expr start;
+      int64_t span = 0;
+      if (!RowOfStore(store, nest, &start, &span) || !air::ir::ExprUseVar(start, op->loop_var)) {
+        return s;
+      }
+      Expr next = Substitute(start, {{op->loop_var, op->loop_var + 1}});
+      if (!analyzer.CanProve(next - start >= make_const(start.type(), span))) {
+        return s;
+      }
+      written[store->buffer_var.get()].push_back(store->index);
+    }
+    for (auto load : nest.loads_) {
+      auto it = written.find(load->buffer_var.get());
+      if (it != written.end() && std::none_of(it->second.begin(), it->second.end(),
+                                              [load](const Expr &e) { return Equal(e, load->index); })) {
+        return s;
+      }
+    }
+    GatherRowScheduler rows(cpu_, sizes_);
+    Stmt body = rows.Prefetch(op, rows.Mutate(op->body));
+    // Small gathers keep their vectorized and prefetched rows, but run them on the calling thread.
+    bool parallel =
+      cpu_->core_num >= 2 && (as_const_int(op->extent) == nullptr || NestUpdates(nest) >= kMinParallelUpdates);
+    return For::make(op->loop_var, op->min, op->extent, parallel ? ForType::Parallel : ForType::Serial,
+                     op->device_api, body);
+  }
+
+  Stmt ScheduleScatter(const For *op, const NestInfo &nest) {
+    Stmt s = GetRef<Stmt>(op);
+    // Partials and buckets only pay off across threads.
+    if (cpu_->core_num < 2) {
+      return s;
+    }
+    auto out = nest.stores_[0]->buffer_var;
+    for (auto store : nest.stores_) {
+      if (!store->buffer_var.same_as(out) || !AccumulatedValue(store).defined()) {
+        return s;
+      }
+    }
+    auto out_loads = std::count_if(nest.loads_.begin(), nest.loads_.end(),
+                                   [&out](const Load *load) { return load->buffer_var.same_as(out); });
+    if (out_loads != static_cast<int64_t>(nest.stores_.size())) {
+      return s;
+    }
+
+    auto extent = as_const_int(op->extent);
+    int64_t updates = NestUpdates(nest);
+    int tasks = cpu_->core_num;
+    if (extent != nullptr) {
+      tasks = static_cast<int>(std::min<int64_t>(tasks, *extent));
+    }
+    auto size = sizes_.find(out.get());
+    int64_t bytes = nest.stores_[0]->value.type().bytes();
+    if (size != sizes_.end() && tasks >= 2 && tasks * size->second <= updates &&
+        tasks * size->second * bytes <= cpu_->l3_bytes && tasks * size->second < std::numeric_limits<int32_t>::max()) {
+      return PartialScatter(op, out, nest.stores_[0]->value.type(), size->second, tasks);
+    }
+    Stmt bucketed = BucketScatter(op, nest);
+    return bucketed.defined() ? bucketed : s;
+  }
+
+  Stmt PartialScatter(const For *op, const Var &out, Type type, int64_t size, int tasks) {
+    Var partial("tot_partial", Handle());
+    Var task("tot_task", Int(32));
+    Var elem("tot_elem", Int(32));
+    Expr offset = task * static_cast<int>(size);
+    Stmt zero = For::make(elem, 0, static_cast<int>(size), ForType::Serial, DeviceAPI::None,
+                          Store::make(partial, make_zero(type), offset + elem, const_true()));
+    Expr chunk = floordiv(op->extent + (tasks - 1), tasks);
+    Expr begin = Min::make(task * chunk, op->extent);
+    Stmt rows = For::make(op->loop_var, op->min + begin, Min::make(chunk, op->extent - begin), ForType::Serial,
+                          op->device_api, BufferRedirect(out.get(), partial, offset).Mutate(op->body));
+    Stmt accumulate = For::make(task, 0, tasks, ForType::Parallel, DeviceAPI::None, Block::make(zero, rows));
+
+    // Each task adds the copies of its range of the output.
+    Var part_task("tot_task", Int(32));
+    Var part("tot_part", Int(32));
+    Var sum_elem("tot_elem", Int(32));
+    int elems = static_cast<int>((size + tasks - 1) / tasks);
+    Expr lo = Min::make(part_task * elems, static_cast<int>(size));
+    Expr sum = Load::make(type, out, sum_elem, const_true()) +
+               Load::make(type, partial, part * static_cast<int>(size) + sum_elem, const_true());
+    Stmt reduce = For::make(sum_elem, lo, Min::make(elems, static_cast<int>(size) - lo), ForType::Serial,
+                            DeviceAPI::None, Store::make(out, sum, sum_elem, const_true()));
+    reduce = For::make(part, 0, tasks, ForType::Serial, DeviceAPI::None, reduce);
+    reduce = For::make(part_task, 0, tasks, ForType::Parallel, DeviceAPI::None, reduce);
+    return AllocateBuffer(partial, type, make_const(Int(32), tasks * size), Block::make(accumulate, reduce));
+  }
+
+  Stmt BucketScatter(const For *op, const NestInfo &nest) {
+    Expr start;
+    int64_t span = 0;
+    for (auto store : nest.stores_) {
+      Expr store_start;
+      int64_t store_span = 0;
+      if (!RowOfStore(store, nest, &store_start, &store_span) ||
+          (start.defined() && (!Equal(store_start, start) || store_span != span))) {
+        return Stmt();
+      }
+      start = store_start;
+      span = store_span;
+    }
+    auto extent = as_const_int(op->extent);
+    int tasks = cpu_->core_num * kTasksPerCore;
+    if (extent != nullptr) {
+      tasks = static_cast<int>(std::min<int64_t>(tasks, *extent));
+    }
+    if (tasks < 2) {
+      return Stmt();
+    }
+
+    Type type = op->loop_var.type();
+    Var count("tot_count", Handle());
+    Var cursor("tot_cursor", Handle());
+    Var order("tot_order", Handle());
+    auto Count = [&count, type](const Expr &b) { return Load::make(type, count, b, const_true()); };
+    auto Cursor = [&cursor, type](const Expr &b) { return Load::make(type, cursor, b, const_true()); };
+    auto Key = [&](const Var &iter) {
+      Expr row = Substitute(start, {{op->loop_var, iter}});
+      row = span > 1 ? floordiv(row, make_const(row.type(), span)) : row;
+      return cast(type, floormod(row, make_const(row.type(), tasks)));
+    };
+    auto Loop = [](const Var &v, const Expr &min, const Expr &extent, const Stmt &body) {
+      return For::make(v, min, extent, ForType::Serial, DeviceAPI::None, body);
+    };
+
+    // count[b + 1] is the size of bucket b, then its start after the prefix sum.
+    Var clear_b("tot_bucket", Int(32));
+    Var sum_b("tot_bucket", Int(32));
+    Var copy_b("tot_bucket", Int(32));
+    Var count_iter(op->loop_var->name_hint + ".count", type);
+    Var fill_iter(op->loop_var->name_hint + ".fill", type);
+    Var count_key("tot_key", type);
+    Var fill_key("tot_key", type);
+    Stmt clear = Loop(clear_b, 0, tasks + 1, Store::make(count, make_zero(type), clear_b, const_true()));
+    Stmt histogram = Loop(count_iter, op->min, op->extent,
+                          LetStmt::make(count_key, Key(count_iter),
+                                        Store::make(count, Count(count_key + 1) + 1, count_key + 1, const_true())));
+    Stmt prefix = Loop(sum_b, 1, tasks, Store::make(count, Count(sum_b) + Count(sum_b - 1), sum_b, const_true()));
+    Stmt cursors = Loop(copy_b, 0, tasks, Store::make(cursor, Count(copy_b), copy_b, const_true()));
+    Stmt fill = Block::make(Store::make(order, fill_iter, Cursor(fill_key), const_true()),
+                            Store::make(cursor, Cursor(fill_key) + 1, fill_key, const_true()));
+    fill = Loop(fill_iter, op->min, op->extent, LetStmt::make(fill_key, Key(fill_iter), fill));
+
+    // The iterations of a bucket keep their order, so every element is accumulated in the serial order.
+    Var task("tot_task", Int(32));
+    Var pos("tot_pos", type);
+    Stmt rows = LetStmt::make(op->loop_var, Load::make(type, order, pos, const_true()), op->body);
+    rows = Loop(pos, Count(task), Count(task + 1) - Count(task), rows);
+    Stmt run = For::make(task, 0, tasks, ForType::Parallel, DeviceAPI::None, rows);
+
+    Stmt res = Block::make({clear, histogram, prefix, cursors, fill, run});
+    res = AllocateBuffer(order, type, op->extent, res);
+    res = AllocateBuffer(cursor, type, make_const(Int(32), tasks), res);
+    return AllocateBuffer(count, type, make_const(Int(32), tasks + 1), res);
+  }
+
+  const air::CpuInfo &cpu_;
+  const std::unordered_map<const Variable *, int64_t> &sizes_;
+};
+}  // namespace
+
+Stmt ScheduleTotLoop(const Stmt &stmt, const Map<Tensor, Buffer> &binds) {
+  std::unordered_map<const Variable *, int64_t> sizes;
+  for (const auto &kv : binds) {
+    int64_t size = 1;
+    for (const auto &dim : kv.second->shape) {
+      auto extent = as_const_int(dim);
+      size = (extent != nullptr && size > 0) ? size * *extent : -1;
+    }
+    if (size > 0) {
+      sizes[kv.second->data.get()] = size;
+    }
+  }
+  PostOrderVisit(stmt, [&sizes](const NodeRef &node) {
+    auto op = node.as<Allocate>();
+    if (op != nullptr && op->constant_allocation_size() > 0) {
+      sizes[op->buffer_var.get()] = op->constant_allocation_size();
+    }
+  });
+  auto cpu_info = air::GetCpuInfo(g_attrs.GetStr("cpu_info", ""));
+  return TotLoopScheduler(cpu_info, sizes).Mutate(stmt);
+}
+}  // namespace ir
+}  // namespace akg
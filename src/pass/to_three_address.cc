@@ -27,6 +27,7 @@
 #include <algorithm>
 #include "pass/utils.h"
 #include "pass/rewrite_simplify_cce.h"
+#include "build_module.h"
 
 namespace akg {
 namespace ir {
@@ -286,7 +287,7 @@ class ThreeAddressExprMutator : public IRMutator {
     if (args.empty()) {
       args = args_;
     }
-    std::string name = output_->op->name + "_" + std::to_string(ct_++);
+    std::string name = output_->op->name + "_" + std::to_string(NextCompileId("three_address"));
     imm = PlaceholderOpNode::make(name, GetShape(args), value.type()).output(0);
     imm_tensors.push_back(imm);
     imm_ops.insert(imm->op);
@@ -625,7 +626,6 @@ class ThreeAddressExprMutator : public IRMutator {
 
   std::unordered_set<const Call *> broadcast_;
 
-  static int ct_;
   bool disable_selection_{false};
   std::vector<bool> expand_floatimm_;
   bool IsReductionOp_{false};
@@ -643,8 +643,6 @@ Expr ThreeAddressExprMutator::Mutate(Expr expr) {
   return ret;
 }
 
-int ThreeAddressExprMutator::ct_ = 0;
-
 class InstructionMutator : IRMutator {
  public:
   explicit InstructionMutator(ThreeAddressExprMutator &mutator, Array<Expr> &args) : mutator_(mutator), args_(args) {}
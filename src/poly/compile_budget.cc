@@ -0,0 +1,118 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "poly/compile_budget.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+#include "build_module.h"
+#include "codegen/compile_profiler.h"
+
+namespace akg {
+namespace ir {
+namespace poly {
+namespace {
+constexpr double kDefaultMaxSeconds = 0;
+constexpr double kDefaultMaxMemoryMB = 0;
+constexpr auto kWatchInterval = std::chrono::milliseconds(50);
+
+// The attr, else AKG_<ATTR>, else the default.
+double Limit(const std::string &attr, double default_value) {
+  std::string env = "AKG_" + attr;
+  std::transform(env.begin(), env.end(), env.begin(), [](unsigned char c) { return std::toupper(c); });
+  const char *value = getenv(env.c_str());
+  return g_attrs.GetFloat(attr, value == nullptr ? default_value : atof(value));
+}
+}  // namespace
+
+CompileBudget::CompileBudget(isl_ctx *ctx)
+    : ctx_(ctx),
+      max_operations_(static_cast<int64_t>(std::max(Limit(kPolyMaxOperations, 0), 0.0))),
+      max_seconds_(std::max(Limit(kPolyMaxSeconds, kDefaultMaxSeconds), 0.0)),
+      max_memory_bytes_(static_cast<int64_t>(std::max(Limit(kPolyMaxMemoryMB, kDefaultMaxMemoryMB), 0.0) * (1 << 20))),
+      start_(std::chrono::steady_clock::now()) {
+  if (max_operations_ > 0) {
+    isl_ctx_set_max_operations(ctx_, static_cast<unsigned long>(max_operations_));
+  }
+  if (max_memory_bytes_ > 0) {
+    heap_base_ = CompileProfiler::HeapInUse();
+    // Malloc can not tell the heap here.
+    if (heap_base_ == 0) {
+      max_memory_bytes_ = 0;
+    }
+  }
+  if (max_seconds_ > 0 || max_memory_bytes_ > 0) {
+    watchdog_ = std::thread(&CompileBudget::Watch, this);
+  }
+}
+
+CompileBudget::~CompileBudget() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+  }
+  done_cv_.notify_all();
+  if (watchdog_.joinable()) {
+    watchdog_.join();
+  }
+}
+
+std::string CompileBudget::Measure() const {
+  std::stringstream reason;
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+  if (max_seconds_ > 0 && seconds > max_seconds_) {
+    reason << "wall time over " << max_seconds_ << " s";
+  } else if (max_memory_bytes_ > 0 && CompileProfiler::HeapInUse() - heap_base_ > max_memory_bytes_) {
+    reason << "heap growth over " << (max_memory_bytes_ >> 20) << " MB";
+  }
+  return reason.str();
+}
+
+void CompileBudget::Watch() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!done_cv_.wait_for(lock, kWatchInterval, [this]() { return done_; })) {
+    auto reason = Measure();
+    if (!reason.empty()) {
+      reason_ = reason;
+      isl_ctx_abort(ctx_);
+      return;
+    }
+  }
+}
+
+void CompileBudget::Check() {
+  std::string reason;
+  if (Exceeded(&reason)) {
+    throw BudgetExceeded(reason);
+  }
+}
+
+bool CompileBudget::Exceeded(std::string *reason, bool quota_error) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (reason_.empty()) {
+    reason_ = Measure();
+  }
+  if (reason_.empty() && max_operations_ > 0 && (quota_error || isl_ctx_last_error(ctx_) == isl_error_quota)) {
+    std::stringstream operations;
+    operations << "isl operations over " << max_operations_;
+    reason_ = operations.str();
+  }
+  *reason = reason_;
+  return !reason_.empty();
+}
+}  // namespace poly
+}  // namespace ir
+}  // namespace akg
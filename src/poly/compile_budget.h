@@ -0,0 +1,82 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef POLY_COMPILE_BUDGET_H_
+#define POLY_COMPILE_BUDGET_H_
+#include <isl/ctx.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace akg {
+namespace ir {
+namespace poly {
+// Attrs of the per kernel limits, each overrides the environment variable of the same name in upper case with an AKG_
+// prefix. 0 is no limit.
+constexpr auto kPolyMaxOperations = "poly_max_operations";
+constexpr auto kPolyMaxSeconds = "poly_max_seconds";
+constexpr auto kPolyMaxMemoryMB = "poly_max_memory_mb";
+
+struct BudgetExceeded : public std::runtime_error {
+  explicit BudgetExceeded(const std::string &reason) : std::runtime_error(reason) {}
+};
+
+/*
+ * Limits the isl operations, the wall time and the heap growth of one poly run on its isl_ctx. Operations are counted
+ * by isl itself through isl_ctx_set_max_operations. Time and memory are polled by a watchdog thread that aborts the
+ * isl_ctx, so the next isl operation fails, and are checked again between the poly phases. All limits are off unless
+ * they are set: the wall time depends on the load of the machine and the heap is the one of the whole process, so
+ * either would make the schedule of a kernel depend on what else runs.
+ */
+class CompileBudget {
+ public:
+  explicit CompileBudget(isl_ctx *ctx);
+  ~CompileBudget();
+
+  // Throws BudgetExceeded once a limit is reached.
+  void Check();
+  // Whether an error of the poly run comes from a limit, with the limit in reason. The isl bindings clear the quota
+  // error of the isl_ctx when they throw it as isl::exception_quota.
+  bool Exceeded(std::string *reason, bool quota_error = false);
+
+ private:
+  CompileBudget(const CompileBudget &) = delete;
+  CompileBudget &operator=(const CompileBudget &) = delete;
+
+  std::string Measure() const;
+  void Watch();
+
+  isl_ctx *ctx_;
+  int64_t max_operations_{0};
+  double max_seconds_{0};
+  int64_t max_memory_bytes_{0};
+  std::chrono::steady_clock::time_point start_;
+  int64_t heap_base_{0};
+
+  std::mutex mutex_;
+  std::condition_variable done_cv_;
+  bool done_{false};
+  std::string reason_;
+  std::thread watchdog_;
+};
+}  // namespace poly
+}  // namespace ir
+}  // namespace akg
+#endif  // POLY_COMPILE_BUDGET_H_
@@ -1,5 +1,8 @@
 #include "poly/cpu_isl_emitter.h"
+#include <algorithm>
 #include <regex>
+#include <sstream>
+#include "poly/schedule_tree_util.h"
 
 namespace akg {
 namespace ir {
@@ -12,8 +15,8 @@ static std::unordered_map<std::string, std::function<Expr(Expr, Expr)>> maker_ma
   {"SumOp", Add::make}, {"AddOp", Add::make}, {"SubOp", Sub::make}, {"MulOp", Mul::make}, {"DivOp", Div::make},
   {"MinOp", Min::make}, {"MaxOp", Max::make}, {"AndOp", And::make}, {"OrOp", Or::make}};
 
-static std::unordered_set<std::string> arm_instruction_set = {"avx", "sse", "avx512"};
-static constexpr auto X86_INSTRUCTION_SET = "neon";
+// Instruction sets of the x86 gemm micro-kernels, sse alone has no kernel. GemmFactor has no arm kernel either.
+static std::unordered_set<std::string> x86_gemm_instruction_set = {"avx", "avx2", "avx512", "avx512_vnni"};
 
 Stmt CpuIslEmitter::Emit(const isl::ast_node &node) {
   Stmt stmt = EmitAst(node);
@@ -29,20 +32,75 @@ Stmt CpuIslEmitter::EmitInfo(const Stmt &stmt) {
     result = AttrStmt::make(Expr("INFO"), "VECTOR_LENGTH", Expr(len), result);
   }
 
+  // Without a feature attr, matmuls use the instruction sets of the target cpu, which the llvm target also follows.
   std::string feature = info_.user_config_.GetFeature();
+  if (feature.empty() && info_.user_config_.GetEnableMatmul()) {
+    feature = info_.user_config_.GetCpuInfo()->isa;
+  }
   if (feature.empty()) {
     return result;
   }
 
-  if (arm_instruction_set.find(feature) != arm_instruction_set.end()) {
-    result = AttrStmt::make(Expr("INFO"), "PACKA", Expr(8), result);
-  } else if (feature == X86_INSTRUCTION_SET) {
-    result = AttrStmt::make(Expr("INFO"), "PACKA", Expr(16), result);
+  // feature may list several instruction sets, e.g. "avx512,avx512_vnni".
+  auto split = [](const std::string &isa) {
+    std::unordered_set<std::string> items;
+    std::stringstream ss(isa);
+    for (std::string item; std::getline(ss, item, ',');) {
+      items.insert(item);
+    }
+    return items;
+  };
+  auto features = split(feature);
+  bool x86_kernel = std::any_of(features.begin(), features.end(),
+                                [](const std::string &f) { return x86_gemm_instruction_set.count(f) > 0; });
+  if (!x86_kernel || !HasGemmKernel(features, split(info_.user_config_.GetCpuInfo()->isa))) {
+    return result;
   }
+
+  // The kernels compute panels of 8 rows of A by 4 columns of B.
+  result = AttrStmt::make(Expr("INFO"), "PACKA", Expr(8), result);
   result = AttrStmt::make(Expr("INFO"), "PACKB", Expr(4), result);
   return result;
 }
 
+// GemmFactor has kernels for float32, float16 (avx512) and int8 (avx512_vnni) A and B, other matmuls are not packed
+// and stay loop nests. Only float16 takes the reduced precision kernel, a 16 bit custom type such as bfloat16 has
+// none. Tensors that are not bound, e.g. a C fused with an elementwise op, are not checked. The avx512 kernels also
+// need their extensions in the target cpu the llvm code is emitted for, otherwise the matmul computes in the type of
+// C by the loop nest.
+bool CpuIslEmitter::HasGemmKernel(const std::unordered_set<std::string> &features,
+                                  const std::unordered_set<std::string> &target) {
+  auto tensors = GetMatmulTensorsName(info_);
+  auto binds = info_.user_config_.GetBind();
+  auto dtype = [&tensors, &binds](const std::string &matrix, Type *type) {
+    for (const auto &bind : binds) {
+      if (tensors.count(matrix) > 0 && bind.first->op->name == tensors[matrix]) {
+        *type = bind.first->dtype;
+        return true;
+      }
+    }
+    return false;
+  };
+  Type a_type = Float(32);
+  Type b_type = Float(32);
+  Type c_type;
+  static_cast<void>(dtype(MATRIX_A, &a_type));
+  static_cast<void>(dtype(MATRIX_B, &b_type));
+  bool has_c = dtype(MATRIX_C, &c_type);
+  auto has = [&features, &target](const std::string &isa) { return features.count(isa) > 0 && target.count(isa) > 0; };
+  bool avx512 = has("avx512") || has("avx512_vnni");
+  if (a_type != b_type) {
+    return false;
+  } else if (a_type == Float(32)) {
+    return !has_c || c_type == Float(32);
+  } else if (a_type == Float(16)) {
+    return avx512 && (!has_c || c_type == Float(32));
+  } else if (a_type == Int(8)) {
+    return has("avx512_vnni") && (!has_c || c_type == Int(32));
+  }
+  return false;
+}
+
 Stmt CpuIslEmitter::EmitBlock(const isl::ast_node_block &block_node) {
   std::vector<Stmt> stmts;
 
@@ -132,18 +190,17 @@ Stmt CpuIslEmitter::EmitUserStmt(const isl::ast_node_user &node) {
 
 Stmt CpuIslEmitter::EmitRealizeForGlobalTensor(const Stmt &from) {
   auto binds = info_.user_config_.GetBind();
-  auto origin_binds = info_.user_config_.GetOriginBind();
   Stmt stmt = from;
   for (auto bind : binds) {
     if (!bind.first.defined()) {
       continue;
     }
-    // input and output tensor, no need to emit realize
-    if (origin_binds.find(bind.first) != origin_binds.end()) {
+    // input and output tensor, no need to emit realize; matched by name as dynamic shapes rebuild the bound tensors
+    std::string name = bind.first->op->name;
+    if (info_.IsInBinds(name)) {
       continue;
     }
     // promoted tensor, the realize info already emitted before
-    std::string name = bind.first->op->name;
     if (IsEndsWith(name, LOCAL_MEMORY)) {
       continue;
     }
@@ -37,6 +37,7 @@ class CpuIslEmitter : public IslEmitter {
   Stmt EmitReduce(const std::vector<std::string> &args);
   Stmt EmitMatrixTranspose(const std::vector<std::string> &names);
   Stmt EmitInfo(const Stmt &stmt);
+  bool HasGemmKernel(const std::unordered_set<std::string> &features, const std::unordered_set<std::string> &target);
 };
 
 }  // namespace poly
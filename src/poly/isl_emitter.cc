@@ -195,6 +195,11 @@ Stmt IslEmitter::EmitFor(const isl::ast_node_for &node) {
     cond_expr = Simplify_cce(cond_expr + 1);
   }
 
+  // The vector tail in a tile of a symbolic extent has a symbolic extent, which is left serial.
+  if (for_type == ForType::Vectorized && !is_const(Simplify_cce(cond_expr))) {
+    for_type = ForType::Serial;
+  }
+
   int64_t inc = static_cast<int64_t>(WrappedStrtol(node.get_inc().to_C_str()));
   CHECK_EQ(inc, 1) << "We guarantee stride=1 by making scale=false in poly.";
 
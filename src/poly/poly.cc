@@ -14,6 +14,10 @@
  * limitations under the License.
  */
 
+#include "build_module.h"
+#include "codegen/compile_profiler.h"
+#include "poly/compile_budget.h"
+#include "poly/schedule_cache.h"
 #include "poly/scop.h"
 #include "poly/tune_info_adapter.h"
 
@@ -24,9 +28,14 @@ namespace ir {
  */
 class Poly {
  public:
-  Poly() : isl_ctx_(isl::ctx(isl_ctx_alloc())) {}
+  explicit Poly(bool budgeted = false) : isl_ctx_(isl::ctx(isl_ctx_alloc())) {
+    if (budgeted) {
+      budget_.reset(new poly::CompileBudget(isl_ctx_.get()));
+    }
+  }
 
   ~Poly() noexcept {
+    budget_.reset();
     scop_->info_.user_config_.FreeReplaceConfig();
     scop_.reset();
     // scop must be deconstructed before isl_ctx is deconstructed
@@ -36,6 +45,22 @@ class Poly {
   void Run(const Stmt &stmt, const Map<Tensor, Buffer> &extern_buffer, std::string target,
            const Map<std::string, NodeRef> &spec_gemm_attrs, bool is_tuning, bool is_dynamic,
            const Schedule &origin_sch) {
+    // Heap the scop and the isl objects hold at the end of each phase, when profiling.
+    auto &profiler = CompileProfiler::Instance();
+    int64_t heap_base = profiler.Enabled() ? CompileProfiler::HeapInUse() : 0;
+    int64_t heap_peak = 0;
+    auto sample_heap = [&profiler, &heap_base, &heap_peak]() {
+      if (profiler.Enabled()) {
+        heap_peak = std::max(heap_peak, CompileProfiler::HeapInUse() - heap_base);
+      }
+    };
+    // The budget is checked before each phase, isl checks it within.
+    auto check_budget = [this]() {
+      if (budget_ != nullptr) {
+        budget_->Check();
+      }
+    };
+
     stmt_ = stmt;
     scop_.reset(new poly::Scop(Simplify_cce(stmt_), isl_ctx_));
     CHECK(scop_ != nullptr);
@@ -44,21 +69,45 @@ class Poly {
 
     std::chrono::high_resolution_clock::time_point timer_start;
     // generate isl schedule from Halide
-    TIMER_START;
-    isl::schedule sch = scop_->GenIsl();
-    TIMER_SHOW("GenIsl", std::string(is_spec_gemm ? "_specgemm" : ""));
+    isl::schedule sch;
+    {
+      ProfileScope profile("poly", "GenIsl");
+      TIMER_START;
+      sch = scop_->GenIsl();
+      TIMER_SHOW("GenIsl", std::string(is_spec_gemm ? "_specgemm" : ""));
+    }
+    sample_heap();
+    check_budget();
 
     // isl schedule transform
-    TIMER_START;
-    isl::schedule sched = scop_->Transform(sch);
-    TIMER_SHOW("Transform", std::string(is_spec_gemm ? "_specgemm" : ""));
+    isl::schedule sched;
+    {
+      ProfileScope profile("poly", "Transform");
+      TIMER_START;
+      sched = scop_->Transform(sch);
+      TIMER_SHOW("Transform", std::string(is_spec_gemm ? "_specgemm" : ""));
+    }
+    sample_heap();
+    check_budget();
 
     // generate Halide from isl schedule
-    TIMER_START;
-    stmt_ = scop_->GenHalide(sched);
-    TIMER_SHOW("GenHalide", std::string(is_spec_gemm ? "_specgemm" : ""));
+    {
+      ProfileScope profile("poly", "GenHalide");
+      TIMER_START;
+      stmt_ = scop_->GenHalide(sched);
+      TIMER_SHOW("GenHalide", std::string(is_spec_gemm ? "_specgemm" : ""));
+    }
+    sample_heap();
+    if (profiler.Enabled()) {
+      profiler.RecordCounter("poly.heap_bytes", heap_peak);
+    }
 
-    if (is_dynamic) stmt_ = RestoreCombinedParams(stmt_, scop_->info_);
+    if (is_dynamic) {
+      stmt_ = RestoreCombinedParams(stmt_, scop_->info_);
+    } else if (scop_->info_.user_config_.GetTarget() == TARGET_CPU) {
+      // Symbolic shapes of cpu kernels are tiled by constants, only the shape params are mapped back.
+      stmt_ = RestoreShapeParams(stmt_, scop_->info_);
+    }
 
     if (is_tuning) {
       if (scop_->info_.user_config_.GetUseNewSpace()) {
@@ -79,6 +128,11 @@ class Poly {
 
   Stmt GetStmt() { return stmt_; }
 
+  // Whether Run failed because it exceeded the budget.
+  bool BudgetExceeded(std::string *reason, bool quota_error) {
+    return budget_ != nullptr && budget_->Exceeded(reason, quota_error);
+  }
+
   NodeRef GetSpaces() { return spaces_; }
 
   Array<Var> GetTilingParams() {
@@ -104,6 +158,7 @@ class Poly {
 
  private:
   std::unique_ptr<poly::Scop> scop_{nullptr};
+  std::unique_ptr<poly::CompileBudget> budget_{nullptr};
   // define isl_ctx outside scop because there are a lot of isl objects in the members of scop class,
   // and we need to ensure that they are deconstructed before the isl_ctx is freed.
   isl::ctx isl_ctx_;
@@ -112,12 +167,97 @@ class Poly {
   bool gen_empty_tiling{false};
 };
 
+namespace {
+// Runs poly, false when it exceeded the budget.
+bool RunPoly(const Stmt &stmt, const Map<Tensor, Buffer> &extern_buffer, const std::string &target, bool is_dynamic,
+             const Map<std::string, NodeRef> &spec_gemm_attrs, const Schedule &sch, bool budgeted, Stmt *result,
+             Array<Var> *tiling_params, std::string *reason) {
+  Poly poly(budgeted);
+  try {
+    poly.Run(stmt, extern_buffer, target, spec_gemm_attrs, false, is_dynamic, sch);
+  } catch (const isl::exception_quota &) {
+    if (!poly.BudgetExceeded(reason, true)) {
+      throw;
+    }
+    return false;
+  } catch (const std::exception &) {
+    if (!poly.BudgetExceeded(reason, false)) {
+      throw;
+    }
+    return false;
+  }
+  *result = poly.GetStmt();
+  *tiling_params = poly.GetTilingParams();
+  return true;
+}
+
+void RecordFallback(const std::string &fallback, int level, const std::string &reason) {
+  LOG(WARNING) << "Poly of " << g_attrs.GetStr(kKernelName, "kernel") << " exceeded its compile budget (" << reason
+               << "), falling back to " << fallback;
+  g_attrs.Set(kPolyFallback, StringImm::make(fallback));
+  SetPolyFallback();
+  auto &profiler = CompileProfiler::Instance();
+  if (profiler.Enabled()) {
+    profiler.RecordCounter("poly.fallback", level);
+  }
+}
+
+// Neither whole component scheduling nor fusion of strongly connected components.
+void UseCheapSchedule() {
+  g_attrs.Set("pragma_disable_whole_component", air::make_const(Int(32), true));
+  g_attrs.Set("pragma_disable_loop_fusion", air::make_const(Int(32), true));
+}
+}  // namespace
+
 /// Interface for lower pass
 Array<NodeRef> AutoPoly(const Stmt &stmt, const Map<Tensor, Buffer> &extern_buffer, std::string target,
                         const bool is_dynamic, const Map<std::string, NodeRef> &spec_gemm_attrs, Schedule sch) {
-  Poly poly;
-  poly.Run(stmt, extern_buffer, target, spec_gemm_attrs, false, is_dynamic, sch);
-  return Array<NodeRef>({poly.GetStmt(), poly.GetTilingParams()});
+  auto &cache = poly::ScheduleCache::Instance();
+  poly::ScheduleCache::Kernel kernel;
+  bool cached = false;
+  if (cache.Enabled(target, is_dynamic, spec_gemm_attrs)) {
+    ProfileScope profile("poly", "ScheduleCache");
+    Stmt result;
+    cached = cache.MakeKernel(stmt, extern_buffer, target, &kernel);
+    if (cached && cache.Load(kernel, &result)) {
+      return Array<NodeRef>({result, Array<Var>()});
+    }
+  }
+  Map<std::string, NodeRef> attrs = g_attrs;
+  // Spec gemm runs inside the poly of its kernel, which is budgeted already.
+  bool budgeted = spec_gemm_attrs.empty();
+  Stmt result;
+  Array<Var> tiling_params;
+  std::string reason;
+  bool done = RunPoly(stmt, extern_buffer, target, is_dynamic, spec_gemm_attrs, sch, budgeted, &result, &tiling_params,
+                      &reason);
+  // A schedule of a fallback is not stored, the next build of the kernel may fit its budget.
+  bool fell_back = !done;
+  if (!done) {
+    g_attrs = attrs;
+    RecordFallback("the cheap schedule", 1, reason);
+    UseCheapSchedule();
+    done = RunPoly(stmt, extern_buffer, target, is_dynamic, spec_gemm_attrs, sch, true, &result, &tiling_params,
+                   &reason);
+  }
+  if (!done && target.compare(0, 4, "llvm") == 0) {
+    // Cpu kernels lower without poly too, lower.h takes over.
+    g_attrs = attrs;
+    RecordFallback("lowering without poly", 2, reason);
+    g_attrs.Set(kPolySkipped, air::make_const(Int(32), true));
+    return Array<NodeRef>({stmt, Array<Var>()});
+  }
+  if (!done) {
+    // Other targets need poly, finish it without limits.
+    g_attrs = attrs;
+    RecordFallback("the cheap schedule without limits", 3, reason);
+    UseCheapSchedule();
+    RunPoly(stmt, extern_buffer, target, is_dynamic, spec_gemm_attrs, sch, false, &result, &tiling_params, &reason);
+  }
+  if (cached && !fell_back && tiling_params.empty()) {
+    cache.Store(kernel, result, attrs);
+  }
+  return Array<NodeRef>({result, tiling_params});
 }
 
 NodeRef GenTuningSpace(const Stmt &stmt, std::string target, const Map<Tensor, Buffer> &extern_buffer,
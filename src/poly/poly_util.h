@@ -443,6 +443,7 @@ constexpr auto PROMOTE_GLOBAL_TO_REGISTER_C = "promote_global_to_register_c";
 constexpr auto PROMOTE_GLOBAL_TO_REGISTER_AB = "promote_global_to_register_ab";
 constexpr auto PROMOTE_GLOBAL_TO_REGISTER_A = "promote_global_to_register_a";
 constexpr auto PROMOTE_GLOBAL_TO_REGISTER_B = "promote_global_to_register_b";
+constexpr auto PROMOTE_GLOBAL_TO_LOCAL = "promote_global_to_local";
 
 // promote marker for thread group
 constexpr auto PROMOTE_GLOBAL_TO_SHARED = "promote_global_to_shared";
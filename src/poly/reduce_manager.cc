@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include "build_module.h"
 #include "poly/schedule_pass/reschedule.h"
 #include "poly/schedule_tree_util.h"
 #include "poly/schedule_pass.h"
@@ -201,10 +202,7 @@ isl::schedule_node ReduceManager::RescheduleForReduce(const isl::schedule_node &
   return node;
 }
 
-size_t ReduceManager::GetReduceId() const {
-  static size_t reduce_count = 0;
-  return reduce_count++;
-}
+size_t ReduceManager::GetReduceId() const { return NextCompileId("reduce"); }
 
 isl::union_set ReduceManager::GetCurrentNodeReduceStatements(const isl::schedule_node node,
                                                              ReduceTensorInfoMap &all_reduce_map,
@@ -0,0 +1,757 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "poly/schedule_cache.h"
+#include <unistd.h>
+#include <tvm/node/serialization.h>
+#include <tvm/runtime/registry.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include "build_module.h"
+#include "codegen/util.h"
+#include "common/target_info.h"
+#include "composite/utils/kernel_cache.h"
+#include "poly/schedule_pass/scheduling_mind_trick.h"
+
+namespace akg {
+namespace ir {
+namespace poly {
+namespace {
+constexpr size_t kDefaultCacheSize = 256;
+
+std::string CacheDir() {
+  const char *dir = getenv(kScheduleCacheDirEnv);
+  return dir == nullptr ? "" : std::string(dir);
+}
+
+size_t CacheCapacity() {
+  const char *env = getenv(kScheduleCacheSizeEnv);
+  return env == nullptr ? kDefaultCacheSize : static_cast<size_t>(std::max(atol(env), 0L));
+}
+
+// Mind tricks are matched against the kernel name.
+bool KernelNameMatters() {
+  return g_attrs.GetBool("enable_mind_trick", true) &&
+         (!g_attrs.GetStr("mind_trick", "").empty() || getenv(env_string_mind_tricks_dir_) != nullptr ||
+          getenv(env_string_mind_tricks_operator_blacklist_) != nullptr);
+}
+
+std::string WithoutDigits(const std::string &name) {
+  std::string result;
+  for (char c : name) {
+    if (!isdigit(static_cast<unsigned char>(c))) {
+      result.push_back(c);
+    }
+  }
+  return result;
+}
+
+/*
+ * Canonical text of a poly input. Every node prints its type key, data type and fields, tensors print as t<index>
+ * and variables as v<index> in the order they are first met.
+ */
+class CanonicalForm : public IRVisitor {
+ public:
+  CanonicalForm(std::ostream &os, ScheduleCache::Kernel *kernel) : os_(os), kernel_(kernel) {}
+
+  bool Run(const Stmt &stmt, const Map<Tensor, Buffer> &extern_buffer) {
+    PostOrderVisit(stmt, [this](const NodeRef &node) {
+      if (auto op = node.as<Provide>()) {
+        names_.emplace(op->func->func_name(), op->func);
+      } else if (auto op = node.as<Realize>()) {
+        names_.emplace(op->func->func_name(), op->func);
+      } else if (auto op = node.as<Call>()) {
+        if (op->func.defined()) {
+          names_.emplace(op->func->func_name(), op->func);
+        }
+      }
+    });
+    std::map<std::pair<const Node *, int>, Buffer> binds;
+    for (const auto &kv : extern_buffer) {
+      names_.emplace(kv.first->op->name, kv.first->op);
+      binds.emplace(std::make_pair(kv.first->op.get(), kv.first->value_index), kv.second);
+    }
+    Visit(stmt);
+    // Tensors found in the buffers are appended to the list meanwhile.
+    for (size_t i = 0; i < kernel_->tensors.size(); ++i) {
+      auto op = kernel_->tensors[i].as<OperationNode>();
+      for (int j = 0; op != nullptr && j < op->num_outputs(); ++j) {
+        auto it = binds.find(std::make_pair(static_cast<const Node *>(op), j));
+        if (it == binds.end()) {
+          continue;
+        }
+        os_ << "b" << i << "." << j;
+        BufferText(it->second);
+        kernel_->buffers.push_back(it->second);
+        binds.erase(it);
+      }
+    }
+    // The substitution could not map a buffer whose tensor is not in the stmt.
+    return supported_ && binds.empty();
+  }
+
+  void Visit(const NodeRef &node) final {
+    if (!node.defined()) {
+      os_ << "_";
+      return;
+    }
+    os_ << node->GetTypeKey();
+    if (auto expr = node.as<ExprNode>()) {
+      os_ << ":" << expr->type;
+    }
+    os_ << "(";
+    if (node->IsInstance<ExprNode>() || node->IsInstance<StmtNode>()) {
+      IRVisitor::Visit(node);
+    } else {
+      NodeText(node);
+    }
+    os_ << ")";
+  }
+
+  void Visit_(const Variable *op) final { os_ << "v" << VarIndex(air::GetRef<Var>(op)); }
+  void Visit_(const IntImm *op) final { os_ << op->value; }
+  void Visit_(const UIntImm *op) final { os_ << op->value; }
+  void Visit_(const FloatImm *op) final { os_ << std::hexfloat << op->value << std::defaultfloat; }
+
+  void Visit_(const StringImm *op) final {
+    // Pragmas name tensors by strings.
+    auto it = names_.find(op->value);
+    if (it != names_.end()) {
+      FuncText(it->second);
+    } else {
+      os_ << op->value.size() << ":" << op->value;
+    }
+  }
+
+  void Visit_(const Call *op) final {
+    os_ << op->call_type << "," << op->value_index << ",";
+    if (op->func.defined()) {
+      FuncText(op->func);
+    } else {
+      os_ << op->name;
+    }
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Provide *op) final {
+    FuncText(op->func);
+    os_ << "," << op->value_index;
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Realize *op) final {
+    FuncText(op->func);
+    os_ << "," << op->value_index << "," << op->type;
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const ProducerConsumer *op) final {
+    FuncText(op->func);
+    os_ << "," << op->is_producer;
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Prefetch *op) final {
+    FuncText(op->func);
+    os_ << "," << op->value_index << "," << op->type;
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const For *op) final {
+    os_ << "v" << VarIndex(op->loop_var) << "," << op->for_type << "," << static_cast<int>(op->device_api);
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const LetStmt *op) final {
+    os_ << "v" << VarIndex(op->var);
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Let *op) final {
+    os_ << "v" << VarIndex(op->var);
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Allocate *op) final {
+    os_ << "v" << VarIndex(op->buffer_var) << "," << op->type << "," << op->free_function;
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Load *op) final {
+    os_ << "v" << VarIndex(op->buffer_var);
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Store *op) final {
+    os_ << "v" << VarIndex(op->buffer_var);
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const AttrStmt *op) final {
+    os_ << op->attr_key << ",";
+    Visit(op->node);
+    IRVisitor::Visit_(op);
+  }
+
+  void Visit_(const Reduce *op) final {
+    os_ << op->value_index << ",";
+    for (size_t i = 0; i < op->combiner->lhs.size(); ++i) {
+      os_ << "v" << VarIndex(op->combiner->lhs[i]) << "v" << VarIndex(op->combiner->rhs[i]);
+      Visit(op->combiner->result[i]);
+      Visit(op->combiner->identity_element[i]);
+    }
+    for (const auto &iv : op->axis) {
+      Visit(iv);
+    }
+    IRVisitor::Visit_(op);
+  }
+
+ private:
+  size_t VarIndex(const Var &var) {
+    auto it = vars_.find(var.get());
+    if (it != vars_.end()) {
+      return it->second;
+    }
+    size_t index = vars_.size();
+    vars_.emplace(var.get(), index);
+    kernel_->vars.push_back(var);
+    return index;
+  }
+
+  void FuncText(const FunctionRef &func) {
+    auto it = funcs_.find(func.get());
+    if (it != funcs_.end()) {
+      os_ << "t" << it->second;
+      return;
+    }
+    size_t index = funcs_.size();
+    funcs_.emplace(func.get(), index);
+    kernel_->tensors.push_back(func);
+    os_ << "t" << index << "<" << WithoutDigits(func->func_name()) << ">";
+    auto op = func.as<OperationNode>();
+    if (op == nullptr) {
+      supported_ = false;
+      return;
+    }
+    os_ << op->GetTypeKey() << "," << op->tag << "[";
+    for (int i = 0; i < op->num_outputs(); ++i) {
+      os_ << op->output_dtype(i);
+      for (const auto &dim : op->output_shape(i)) {
+        Visit(dim);
+      }
+      os_ << ";";
+    }
+    os_ << "]";
+    if (auto compute = func.as<ComputeOpNode>()) {
+      for (const auto &iv : compute->axis) {
+        Visit(iv);
+      }
+      for (const auto &iv : compute->reduce_axis) {
+        Visit(iv);
+      }
+      for (const auto &expr : compute->body) {
+        Visit(expr);
+      }
+    }
+  }
+
+  void BufferText(const Buffer &buffer) {
+    os_ << "(" << buffer->dtype << ",v" << VarIndex(buffer->data) << "," << buffer->scope << ","
+        << buffer->data_alignment << "," << buffer->offset_factor << "," << static_cast<int>(buffer->buffer_type);
+    for (const auto &dim : buffer->shape) {
+      Visit(dim);
+    }
+    os_ << ";";
+    for (const auto &stride : buffer->strides) {
+      Visit(stride);
+    }
+    os_ << ";";
+    Visit(buffer->elem_offset);
+    os_ << ")";
+  }
+
+  // The nodes of attrs other than expressions.
+  void NodeText(const NodeRef &node) {
+    if (node->IsInstance<OperationNode>()) {
+      FuncText(Downcast<FunctionRef>(node));
+    } else if (auto tensor = node.as<TensorNode>()) {
+      FuncText(tensor->op);
+      os_ << "," << tensor->value_index;
+    } else if (auto iv = node.as<IterVarNode>()) {
+      os_ << "v" << VarIndex(iv->var) << "," << iv->iter_type << "," << iv->thread_tag;
+      if (iv->dom.defined()) {
+        Visit(iv->dom->min);
+        Visit(iv->dom->extent);
+      }
+    } else if (node->IsInstance<air::ArrayNode>()) {
+      for (const auto &item : Downcast<Array<NodeRef>>(node)) {
+        Visit(item);
+      }
+    } else {
+      // Buffers of the stmt and other nodes are not substituted back.
+      supported_ = false;
+    }
+  }
+
+  std::ostream &os_;
+  ScheduleCache::Kernel *kernel_;
+  std::unordered_map<std::string, FunctionRef> names_;
+  std::unordered_map<const Node *, size_t> funcs_;
+  std::unordered_map<const Node *, size_t> vars_;
+  bool supported_{true};
+};
+
+// Replaces the tensors, variables and buffers of the cached kernel by those of the new one. The ones poly created, like
+// loop variables and local copies of tensors, are copied so that no two hits share them, the copies of tensors derived
+// from a cached tensor are renamed after the new tensor.
+class KernelSubstitute : public IRMutator {
+ public:
+  KernelSubstitute(const ScheduleCache::Kernel &from, const ScheduleCache::Kernel &to) {
+    CHECK_EQ(from.tensors.size(), to.tensors.size());
+    CHECK_EQ(from.vars.size(), to.vars.size());
+    CHECK_EQ(from.buffers.size(), to.buffers.size());
+    for (size_t i = 0; i < from.tensors.size(); ++i) {
+      funcs_[from.tensors[i].get()] = to.tensors[i];
+      names_.emplace(from.tensors[i]->func_name(), to.tensors[i]->func_name());
+    }
+    for (size_t i = 0; i < from.vars.size(); ++i) {
+      vars_[from.vars[i].get()] = to.vars[i];
+    }
+    for (size_t i = 0; i < from.buffers.size(); ++i) {
+      buffers_[from.buffers[i].get()] = to.buffers[i];
+    }
+  }
+
+  Expr Mutate_(const Variable *op, const Expr &e) final { return MapVar(air::GetRef<Var>(op)); }
+
+  Expr Mutate_(const StringImm *op, const Expr &e) final {
+    auto name = Rename(op->value);
+    return name == op->value ? e : StringImm::make(name);
+  }
+
+  Expr Mutate_(const Call *op, const Expr &e) final {
+    Expr expr = IRMutator::Mutate_(op, e);
+    op = expr.as<Call>();
+    if (!op->func.defined()) {
+      return expr;
+    }
+    auto func = Func(op->func);
+    if (func.same_as(op->func)) {
+      return expr;
+    }
+    return Call::make(op->type, func->func_name(), op->args, op->call_type, func, op->value_index);
+  }
+
+  Expr Mutate_(const Reduce *op, const Expr &e) final {
+    Array<IterVar> axis;
+    for (const auto &iv : op->axis) {
+      axis.push_back(MapIterVar(iv));
+    }
+    return Reduce::make(op->combiner, MutateArray(op->source), axis, Mutate(op->condition), op->value_index);
+  }
+
+  Expr Mutate_(const Load *op, const Expr &e) final {
+    Expr expr = IRMutator::Mutate_(op, e);
+    op = expr.as<Load>();
+    auto var = MapVar(op->buffer_var);
+    return var.same_as(op->buffer_var) ? expr : Load::make(op->type, var, op->index, op->predicate);
+  }
+
+  Expr Mutate_(const Let *op, const Expr &e) final {
+    Expr expr = IRMutator::Mutate_(op, e);
+    op = expr.as<Let>();
+    auto var = MapVar(op->var);
+    return var.same_as(op->var) ? expr : Let::make(var, op->value, op->body);
+  }
+
+  Stmt Mutate_(const Store *op, const Stmt &s) final {
+    Stmt stmt = IRMutator::Mutate_(op, s);
+    op = stmt.as<Store>();
+    auto var = MapVar(op->buffer_var);
+    return var.same_as(op->buffer_var) ? stmt : Store::make(var, op->value, op->index, op->predicate);
+  }
+
+  Stmt Mutate_(const Allocate *op, const Stmt &s) final {
+    Stmt stmt = IRMutator::Mutate_(op, s);
+    op = stmt.as<Allocate>();
+    auto var = MapVar(op->buffer_var);
+    return var.same_as(op->buffer_var)
+             ? stmt
+             : Allocate::make(var, op->type, op->extents, op->condition, op->body, op->new_expr, op->free_function);
+  }
+
+  Stmt Mutate_(const For *op, const Stmt &s) final {
+    Stmt stmt = IRMutator::Mutate_(op, s);
+    op = stmt.as<For>();
+    auto var = MapVar(op->loop_var);
+    return var.same_as(op->loop_var) ? stmt
+                                     : For::make(var, op->min, op->extent, op->for_type, op->device_api, op->body);
+  }
+
+  Stmt Mutate_(const LetStmt *op, const Stmt &s) final {
+    Stmt stmt = IRMutator::Mutate_(op, s);
+    op = stmt.as<LetStmt>();
+    auto var = MapVar(op->var);
+    return var.same_as(op->var) ? stmt : LetStmt::make(var, op->value, op->body);
+  }
+
+  Stmt Mutate_(const Provide *op, const Stmt &s) final {
+    Stmt stmt = IRMutator::Mutate_(op, s);
+    op = stmt.as<Provide>();
+    auto func = Func(op->func);
+    return func.same_as(op->func) ? stmt : Provide::make(func, op->value_index, op->value, op->args);
+  }
+
+  Stmt Mutate_(const Realize *op, const Stmt &s) final {
+    Stmt stmt = IRMutator::Mutate_(op, s);
+    op = stmt.as<Realize>();
+    auto func = Func(op->func);
+    return func.same_as(op->func)
+             ? stmt
+             : Realize::make(func, op->value_index, op->type, op->bounds, op->condition, op->body);
+  }
+
+  Stmt Mutate_(const ProducerConsumer *op, const Stmt &s) final {
+    Stmt stmt = IRMutator::Mutate_(op, s);
+    op = stmt.as<ProducerConsumer>();
+    auto func = Func(op->func);
+    return func.same_as(op->func) ? stmt : ProducerConsumer::make(func, op->is_producer, op->body);
+  }
+
+  Stmt Mutate_(const AttrStmt *op, const Stmt &s) final {
+    Stmt stmt = IRMutator::Mutate_(op, s);
+    op = stmt.as<AttrStmt>();
+    auto node = MapNode(op->node);
+    return node.same_as(op->node) ? stmt : AttrStmt::make(node, op->attr_key, op->value, op->body);
+  }
+
+ private:
+  Var MapVar(const Var &var) {
+    auto it = vars_.find(var.get());
+    if (it != vars_.end()) {
+      return it->second;
+    }
+    Var copy(var->name_hint, var->type);
+    vars_[var.get()] = copy;
+    return copy;
+  }
+
+  Array<Expr> MutateArray(const Array<Expr> &exprs) {
+    Array<Expr> result;
+    for (const auto &e : exprs) {
+      result.push_back(Mutate(e));
+    }
+    return result;
+  }
+
+  Expr MutateOrUndefined(const Expr &e) { return e.defined() ? Mutate(e) : e; }
+
+  IterVar MapIterVar(const IterVar &iv) {
+    Range dom =
+      iv->dom.defined() ? Range::make_by_min_extent(Mutate(iv->dom->min), Mutate(iv->dom->extent)) : iv->dom;
+    return IterVarNode::make(dom, MapVar(iv->var), iv->iter_type, iv->thread_tag);
+  }
+
+  // The longest cached tensor name that is a whole word at the start of name.
+  std::string Rename(const std::string &name) const {
+    const std::pair<const std::string, std::string> *best = nullptr;
+    for (const auto &kv : names_) {
+      const auto &from = kv.first;
+      if (name.compare(0, from.size(), from) == 0 &&
+          (name.size() == from.size() || !isalnum(static_cast<unsigned char>(name[from.size()]))) &&
+          (best == nullptr || from.size() > best->first.size())) {
+        best = &kv;
+      }
+    }
+    return best == nullptr ? name : best->second + name.substr(best->first.size());
+  }
+
+  FunctionRef Func(const FunctionRef &func) {
+    auto it = funcs_.find(func.get());
+    if (it != funcs_.end()) {
+      return it->second;
+    }
+    FunctionRef result = func;
+    if (auto op = func.as<PlaceholderOpNode>()) {
+      result = air::PlaceholderOpNode::make(Rename(op->name), MutateArray(op->shape), op->dtype);
+    } else if (auto op = func.as<air::ComputeOpNode>()) {
+      Array<IterVar> axis;
+      for (const auto &iv : op->axis) {
+        axis.push_back(MapIterVar(iv));
+      }
+      result = air::ComputeOpNode::make(Rename(op->name), op->tag, op->attrs, axis, MutateArray(op->body));
+    }
+    funcs_[func.get()] = result;
+    return result;
+  }
+
+  NodeRef MapNode(const NodeRef &node) {
+    if (!node.defined()) {
+      return node;
+    }
+    if (node->IsInstance<OperationNode>()) {
+      return Func(Downcast<FunctionRef>(node));
+    }
+    if (auto tensor = node.as<TensorNode>()) {
+      auto func = Func(tensor->op);
+      return func.same_as(tensor->op) ? node : Downcast<Operation>(func).output(tensor->value_index);
+    }
+    if (auto buffer = node.as<BufferNode>()) {
+      auto it = buffers_.find(buffer);
+      if (it != buffers_.end()) {
+        return it->second;
+      }
+      Buffer copy = BufferNode::make(MapVar(buffer->data), buffer->dtype, MutateArray(buffer->shape),
+                                     MutateArray(buffer->strides), MutateOrUndefined(buffer->elem_offset), buffer->name,
+                                     buffer->scope, buffer->data_alignment, buffer->offset_factor,
+                                     buffer->buffer_type);
+      buffers_[buffer] = copy;
+      return copy;
+    }
+    if (auto iv = node.as<IterVarNode>()) {
+      return MapIterVar(air::GetRef<IterVar>(iv));
+    }
+    if (node->IsInstance<air::ArrayNode>()) {
+      Array<NodeRef> items;
+      for (const auto &item : Downcast<Array<NodeRef>>(node)) {
+        items.push_back(MapNode(item));
+      }
+      return items;
+    }
+    if (node->IsInstance<ExprNode>()) {
+      return Mutate(Downcast<Expr>(node));
+    }
+    return node;
+  }
+
+  std::unordered_map<const Node *, FunctionRef> funcs_;
+  std::unordered_map<const Node *, Var> vars_;
+  std::unordered_map<const Node *, Buffer> buffers_;
+  std::map<std::string, std::string> names_;
+};
+
+Map<std::string, NodeRef> EntryToMap(const ScheduleCache::Kernel &kernel, const Stmt &stmt,
+                                     const Map<std::string, NodeRef> &attrs) {
+  Map<std::string, NodeRef> map;
+  map.Set("key", StringImm::make(kernel.text));
+  map.Set("tensors", kernel.tensors);
+  map.Set("vars", kernel.vars);
+  map.Set("buffers", kernel.buffers);
+  map.Set("stmt", stmt);
+  map.Set("attrs", attrs);
+  return map;
+}
+}  // namespace
+
+ScheduleCache::ScheduleCache() : capacity_(CacheCapacity()) {}
+
+ScheduleCache &ScheduleCache::Instance() {
+  static ScheduleCache instance;
+  return instance;
+}
+
+bool ScheduleCache::Enabled(const std::string &target, bool is_dynamic,
+                            const Map<std::string, NodeRef> &spec_gemm_attrs) const {
+  if (!g_attrs.GetBool(kEnablePolyCache, false) || (capacity_ == 0 && CacheDir().empty())) {
+    return false;
+  }
+  // Poly leaves state besides the stmt and the attrs for the cce passes, csr kernels and the spec gemm
+  // builder, and dumps its ir and mind trick templates. Schedules replaced from files of the dump dir are not in
+  // the key.
+  bool supported_target = target == "cuda" || target.compare(0, 4, "llvm") == 0;
+  bool replace_schedule = DebugHooks::Current().replace_poly_schedule && !g_attrs.GetStr(kDumpPolyDir, "").empty();
+  return supported_target && !is_dynamic && spec_gemm_attrs.empty() && !g_attrs.GetBool("is_csr", false) &&
+         g_csr.empty() && !g_attrs.GetBool(kDumpPassIr, false) && !replace_schedule &&
+         getenv(env_string_mind_tricks_templates_) == nullptr;
+}
+
+bool ScheduleCache::MakeKernel(const Stmt &stmt, const Map<Tensor, Buffer> &extern_buffer, const std::string &target,
+                               Kernel *kernel) const {
+  std::stringstream ss;
+  ss << target << "|";
+  if (target.compare(0, 4, "llvm") == 0) {
+    // Cpu tiling depends on the target cpu and the threads that run the kernel.
+    auto cpu_info = air::GetCpuInfo(g_attrs.GetStr("cpu_info", ""));
+    ss << cpu_info << "," << air::GetCpuThreadNum(cpu_info) << "|";
+  }
+  Map<std::string, NodeRef> attrs;
+  for (const auto &kv : g_attrs) {
+    if (kv.first != kDumpPolyDir && kv.first != kDumpIrDir && (kv.first != kKernelName || KernelNameMatters())) {
+      attrs.Set(kv.first, kv.second);
+    }
+  }
+  Canonicalize(attrs, ss);
+  ss << "|";
+  if (!CanonicalForm(ss, kernel).Run(stmt, extern_buffer)) {
+    return false;
+  }
+  kernel->text = ss.str();
+  return true;
+}
+
+bool ScheduleCache::Find(const Kernel &kernel, Entry *entry) {
+  auto hash = HashHex(kernel.text);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(hash);
+    if (it != index_.end() && it->second->second.kernel.text == kernel.text) {
+      entries_.splice(entries_.begin(), entries_, it->second);
+      *entry = it->second->second;
+      return true;
+    }
+  }
+  if (!LoadFile(kernel, entry)) {
+    return false;
+  }
+  Insert(hash, Entry(*entry));
+  return true;
+}
+
+void ScheduleCache::Insert(const std::string &hash, Entry &&entry) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (capacity_ == 0) {
+    return;
+  }
+  auto it = index_.find(hash);
+  if (it != index_.end()) {
+    entries_.erase(it->second);
+  }
+  entries_.emplace_front(hash, std::move(entry));
+  index_[hash] = entries_.begin();
+  while (entries_.size() > capacity_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+    ++evictions_;
+  }
+}
+
+bool ScheduleCache::Load(const Kernel &kernel, Stmt *stmt) {
+  Entry entry;
+  if (!Find(kernel, &entry)) {
+    ++misses_;
+    return false;
+  }
+  *stmt = KernelSubstitute(entry.kernel, kernel).Mutate(entry.stmt);
+  for (const auto &kv : entry.attrs) {
+    g_attrs.Set(kv.first, kv.second);
+  }
+  ++hits_;
+  return true;
+}
+
+void ScheduleCache::Store(const Kernel &kernel, const Stmt &stmt, const Map<std::string, NodeRef> &attrs) {
+  Entry entry{kernel, stmt, {}};
+  for (const auto &kv : g_attrs) {
+    auto it = attrs.find(kv.first);
+    if (it == attrs.end() || !(*it).second.same_as(kv.second)) {
+      entry.attrs.Set(kv.first, kv.second);
+    }
+  }
+  SaveFile(entry);
+  Insert(HashHex(kernel.text), std::move(entry));
+  ++stores_;
+}
+
+bool ScheduleCache::LoadFile(const Kernel &kernel, Entry *entry) const {
+  auto dir = CacheDir();
+  if (dir.empty()) {
+    return false;
+  }
+  auto path = dir + "/" + HashHex(LibraryIdentity() + "|" + kernel.text) + ".json";
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    return false;
+  }
+  std::stringstream json;
+  json << file.rdbuf();
+  try {
+    auto map = Downcast<Map<std::string, NodeRef>>(air::LoadJSON(json.str()));
+    if (Downcast<Expr>(map["key"]).as<StringImm>()->value != kernel.text) {
+      return false;
+    }
+    entry->kernel.text = kernel.text;
+    entry->kernel.tensors = Downcast<Array<FunctionRef>>(map["tensors"]);
+    entry->kernel.vars = Downcast<Array<Var>>(map["vars"]);
+    entry->kernel.buffers = Downcast<Array<Buffer>>(map["buffers"]);
+    entry->stmt = Downcast<Stmt>(map["stmt"]);
+    entry->attrs = Downcast<Map<std::string, NodeRef>>(map["attrs"]);
+  } catch (const std::exception &e) {
+    LOG(WARNING) << "Failed to load cached poly schedule " << path << ": " << e.what();
+    return false;
+  }
+  return true;
+}
+
+void ScheduleCache::SaveFile(const Entry &entry) const {
+  auto dir = CacheDir();
+  if (dir.empty()) {
+    return;
+  }
+  CreateDir(dir);
+  auto path = dir + "/" + HashHex(LibraryIdentity() + "|" + entry.kernel.text) + ".json";
+  std::stringstream tmp;
+  tmp << path << "." << getpid() << "_" << std::hash<std::thread::id>()(std::this_thread::get_id()) << ".tmp";
+  {
+    std::ofstream file(tmp.str());
+    if (file.is_open()) {
+      file << air::SaveJSON(EntryToMap(entry.kernel, entry.stmt, entry.attrs));
+    }
+    if (!file.good()) {
+      LOG(WARNING) << "Failed to save poly schedule to cache " << path;
+      static_cast<void>(remove(tmp.str().c_str()));
+      return;
+    }
+  }
+  // Concurrent writers of one kernel write the same entry.
+  if (rename(tmp.str().c_str(), path.c_str()) != 0) {
+    static_cast<void>(remove(tmp.str().c_str()));
+  }
+}
+
+Map<std::string, NodeRef> ScheduleCache::Stats() const {
+  Map<std::string, NodeRef> stats;
+  stats.Set("hits", air::make_const(Int(64), hits_.load()));
+  stats.Set("misses", air::make_const(Int(64), misses_.load()));
+  stats.Set("stores", air::make_const(Int(64), stores_.load()));
+  stats.Set("evictions", air::make_const(Int(64), evictions_.load()));
+  return stats;
+}
+
+void ScheduleCache::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  index_.clear();
+  capacity_ = CacheCapacity();
+  hits_ = 0;
+  misses_ = 0;
+  stores_ = 0;
+  evictions_ = 0;
+}
+
+TVM_REGISTER_GLOBAL("akg_poly_cache_stats").set_body_typed<Map<std::string, NodeRef>()>([]() {
+  return ScheduleCache::Instance().Stats();
+});
+TVM_REGISTER_GLOBAL("akg_poly_cache_reset").set_body_typed<void()>([]() { ScheduleCache::Instance().Reset(); });
+}  // namespace poly
+}  // namespace ir
+}  // namespace akg
@@ -0,0 +1,95 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef POLY_SCHEDULE_CACHE_H_
+#define POLY_SCHEDULE_CACHE_H_
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "tvm.h"
+
+namespace akg {
+namespace ir {
+namespace poly {
+constexpr auto kScheduleCacheDirEnv = "AKG_POLY_CACHE_DIR";
+constexpr auto kScheduleCacheSizeEnv = "AKG_POLY_CACHE_SIZE";
+constexpr auto kEnablePolyCache = "enable_poly_cache";
+
+/*
+ * Cache of the poly results of structurally identical kernels, as the fused kernels of a network often are. A kernel
+ * is keyed by the canonical text of its input: tensors and variables are numbered in the order they appear, tensor
+ * names lose their digits and shapes, types, buffers, target and attrs are kept, llvm kernels add the target cpu and
+ * thread count. A hit substitutes the tensors, variables and buffers of the kernel back into the cached stmt, copies
+ * the ones poly created and replays the attrs poly set. The cache is used when the enable_poly_cache attr is set and
+ * no schedule can be replaced from the dump dir.
+ * Entries live in a least recently used list of AKG_POLY_CACHE_SIZE kernels (256 by default) and, when
+ * AKG_POLY_CACHE_DIR is set, are also saved there as json for later processes.
+ */
+class ScheduleCache {
+ public:
+  // The canonical form of a poly input, with its tensors, variables and buffers in the order of the text.
+  struct Kernel {
+    std::string text;
+    Array<FunctionRef> tensors;
+    Array<Var> vars;
+    Array<Buffer> buffers;
+  };
+
+  static ScheduleCache &Instance();
+
+  bool Enabled(const std::string &target, bool is_dynamic, const Map<std::string, NodeRef> &spec_gemm_attrs) const;
+  // False when the input holds nodes the substitution can not map.
+  bool MakeKernel(const Stmt &stmt, const Map<Tensor, Buffer> &extern_buffer, const std::string &target,
+                  Kernel *kernel) const;
+  bool Load(const Kernel &kernel, Stmt *stmt);
+  // attrs are the global attrs before poly ran, the ones it changed are replayed on a hit.
+  void Store(const Kernel &kernel, const Stmt &stmt, const Map<std::string, NodeRef> &attrs);
+  Map<std::string, NodeRef> Stats() const;
+  void Reset();
+
+ private:
+  struct Entry {
+    Kernel kernel;
+    Stmt stmt;
+    Map<std::string, NodeRef> attrs;
+  };
+
+  ScheduleCache();
+  ~ScheduleCache() = default;
+  ScheduleCache(const ScheduleCache &) = delete;
+  ScheduleCache &operator=(const ScheduleCache &) = delete;
+
+  bool Find(const Kernel &kernel, Entry *entry);
+  void Insert(const std::string &hash, Entry &&entry);
+  bool LoadFile(const Kernel &kernel, Entry *entry) const;
+  void SaveFile(const Entry &entry) const;
+
+  std::mutex mutex_;
+  size_t capacity_;
+  // Most recently used first.
+  std::list<std::pair<std::string, Entry>> entries_;
+  std::unordered_map<std::string, std::list<std::pair<std::string, Entry>>::iterator> index_;
+
+  std::atomic<int64_t> hits_{0};
+  std::atomic<int64_t> misses_{0};
+  std::atomic<int64_t> stores_{0};
+  std::atomic<int64_t> evictions_{0};
+};
+}  // namespace poly
+}  // namespace ir
+}  // namespace akg
+#endif  // POLY_SCHEDULE_CACHE_H_
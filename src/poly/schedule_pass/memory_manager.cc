@@ -253,10 +253,10 @@ PartitionSingle::PartitionSingle(int times, int tile_start, int cut_m,
   m_fractal_int_info_ = fractal_int_info;
 }
 
-PartitionSingle *PartitionSingle::single_ = nullptr;
-int PartitionSingle::m_times_ = 0;
-int PartitionSingle::m_cut_m_ = 0;
-std::map<std::string, Expr> PartitionSingle::m_fractal_int_info_;
+thread_local PartitionSingle *PartitionSingle::single_ = nullptr;
+thread_local int PartitionSingle::m_times_ = 0;
+thread_local int PartitionSingle::m_cut_m_ = 0;
+thread_local std::map<std::string, Expr> PartitionSingle::m_fractal_int_info_;
 
 void MemoryManager::GatherBufferFootprintDefInfo(const isl::schedule_node &tree, BufferDefInfo &tensor_info) {
   auto fp_cluster = tensor_info.GetFootPrintCluster(tree);
@@ -1356,7 +1356,59 @@ isl::schedule_node TileOuterBand::TileElementWiseForCpu(const isl::schedule_node
   // last tiling: vectorized
   node = IsolateTilesCpu(node);
   node = InsertAllMarker(node, is_all_reduce);
-  return node.ancestor(node.get_tree_depth() - start_depth);
+  node = node.ancestor(node.get_tree_depth() - start_depth);
+
+  // Mark the tile of a parallel task, the memory manager packs the strided tensors it reads there.
+  if (!is_all_reduce && scop_info_.user_config_.GetUseSharedMemory() && !scop_info_.user_config_.GetEnableMatmul() &&
+      HasStridedVectorizedRead(node)) {
+    auto tile_node = node.isa<isl::schedule_node_mark>() ? node.child(0) : node;
+    if (tile_node.isa<isl::schedule_node_band>()) {
+      node = tile_node.child(0).insert_mark(PROMOTE_GLOBAL_TO_LOCAL);
+      node = node.ancestor(node.get_tree_depth() - start_depth);
+    }
+  }
+  return node;
+}
+
+/*
+ * Whether a tensor is read with a non-unit stride along the vectorized loop below node. Only such reads are packed by
+ * the memory manager, other tiles are not marked so that it does not analyse them.
+ */
+bool TileOuterBand::HasStridedVectorizedRead(const isl::schedule_node &node) {
+  auto vectorized_marks = CollectMarkNode(node, FOR_VECTORIZED);
+  if (vectorized_marks.empty() || !vectorized_marks[0].child(0).isa<isl::schedule_node_band>()) {
+    return false;
+  }
+
+  auto vectorized_band = vectorized_marks[0].child(0);
+  size_t inner_depth =
+    vectorized_band.schedule_depth() + vectorized_band.as<isl::schedule_node_band>().n_member() - 1;
+  auto reads = scop_info_.analysis_result_.GetReads().domain_factor_domain().intersect_domain(
+    CollectDomain(vectorized_band));
+  auto schedule_reads = reads.apply_domain(LocalSchedule(vectorized_band));
+  for (auto map : schedule_reads.get_map_list()) {
+    int tensor_dim = static_cast<int>(map.range().n_dim());
+    if (inner_depth >= map.domain().n_dim() || tensor_dim == 0) {
+      continue;
+    }
+    auto schedule_next = CreateMapIncreaseDim(map.get_space().domain(), inner_depth);
+    auto deltas = schedule_next.apply_domain(map).apply_range(map).deltas().project_out_all_params();
+    if (deltas.is_empty()) {
+      continue;
+    }
+    // A change that is not constant is left to the cost model of the memory manager.
+    if (!deltas.is_singleton()) {
+      return true;
+    }
+    auto point = deltas.sample_point();
+    for (int i = 0; i < tensor_dim; ++i) {
+      auto delta = std::abs(isl::manage(isl_point_get_coordinate_val(point.get(), isl_dim_set, i)).get_num_si());
+      if ((i < tensor_dim - 1 && delta != 0) || delta > 1) {
+        return true;
+      }
+    }
+  }
+  return false;
 }
 
 isl::schedule_node TileOuterBand::TileReduceXForCpu(const isl::schedule_node &orig_node) {
@@ -1477,8 +1529,9 @@ isl::schedule_node TileOuterBand::InsertMarkerForLoop(const isl::schedule_node &
   auto band_node = orig_node.as<isl::schedule_node_band>();
   auto partial_schedule = band_node.get_partial_schedule().intersect_domain(orig_node.get_domain());
   auto upa_list = partial_schedule.get_union_pw_aff_list();
-  auto extent = upa_list.get_at(insert_pos).floor().max_val().get_num_si();
-  if (extent < 1) {
+  // The loop over the tiles of a symbolic extent is unbounded, it is always marked.
+  auto max_val = upa_list.get_at(insert_pos).floor().max_val();
+  if (max_val.is_int() && max_val.get_num_si() < 1) {
     return orig_node;
   }
 
@@ -1508,14 +1561,15 @@ isl::multi_val TileOuterBand::GetVectorizationTileSize(const isl::schedule_node
   int vectorized_length = scop_info_.user_config_.GetVectorLength();
 
   if (vectorized_length == 0) {
+    // One full vector register of the target for the narrowest type.
+    int simd_bytes = scop_info_.user_config_.GetCpuInfo()->simd_bytes;
     for (auto a : original_access.get_map_list()) {
       auto id = a.get_tuple_id(isl_dim_out).to_str();
-      Tensor tensor = scop_info_.FindTensor(id);
       Type type = scop_info_.GetDtypeOf(id);
-      int bytes = type.bytes();
-      auto tmp_bytes = (4 / bytes) * 4;  // Default vectorization mode fp32 = 4Bytes
-      vectorized_length = std::max(tmp_bytes, vectorized_length);
+      int bytes = std::max(type.bytes(), 1);
+      vectorized_length = std::max(simd_bytes / bytes, vectorized_length);
     }
+    vectorized_length = std::max(vectorized_length, 1);
   }
 
   int tile_size = static_cast<int>(orig_node.as<isl::schedule_node_band>().n_member());
@@ -113,6 +113,7 @@ class TileOuterBand : public SchedulePass {
   isl::schedule_node TileGemmOperatorForCpu(const isl::schedule_node &orig_node);
   isl::schedule_node TileGemmBandNodeForCpu(const isl::schedule_node &orig_node);
   isl::schedule_node TileElementWiseForCpu(const isl::schedule_node &orig_node, const bool is_all_reduce = false);
+  bool HasStridedVectorizedRead(const isl::schedule_node &node);
 
   bool IsContainReduceStatement(const isl::schedule_node &orig_node);
   isl::multi_val GetVectorizationTileSize(const isl::schedule_node &orig_node);
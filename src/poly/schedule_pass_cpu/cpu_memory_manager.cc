@@ -19,6 +19,9 @@
 #include "poly/scop.h"
 #include "poly/dma_inject.h"
 #include "poly/poly_util.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
 #include <vector>
 #include <numeric>
 
@@ -31,11 +34,25 @@ isl::schedule CpuMemoryManager::Run(isl::schedule sch) {
     return sch;
   }
 
-  if (!scop_info_.user_config_.GetEnableMatmul()) {
+  schedule_ = sch;
+  if (scop_info_.user_config_.GetEnableMatmul()) {
+    mark_names_ = {PROMOTE_GLOBAL_TO_REGISTER_A, PROMOTE_GLOBAL_TO_REGISTER_B};
+    return HoistCpuMemory();
+  }
+
+  // Beyond matmul, the tiles marked by the tiling pack the strided tensors they read into local buffers.
+  if (CollectMarkNode(sch.root(), PROMOTE_GLOBAL_TO_LOCAL).empty()) {
     return sch;
   }
-  schedule_ = sch;
-  return HoistCpuMemory();
+  mark_names_ = {PROMOTE_GLOBAL_TO_LOCAL};
+  auto DeleteTileMark = [](isl::schedule_node node) -> isl::schedule_node {
+    if (node.isa<isl::schedule_node_mark>() &&
+        node.as<isl::schedule_node_mark>().get_id().get_name() == PROMOTE_GLOBAL_TO_LOCAL) {
+      return node.del();
+    }
+    return node;
+  };
+  return HoistCpuMemory().get_root().map_descendant_bottom_up(DeleteTileMark).get_schedule();
 }
 
 isl::schedule CpuMemoryManager::HoistCpuMemory() {
@@ -67,7 +84,6 @@ isl::schedule CpuMemoryManager::HoistCpuMemory() {
       return orig_node;
     }
 
-    mark_names_ = {PROMOTE_GLOBAL_TO_REGISTER_A, PROMOTE_GLOBAL_TO_REGISTER_B};
     CpuMemoryStrategy other_op(scop_info_, mark_names_, band_index_);
     other_op.CreateClusterList(orig_node);
     auto node = orig_node;
@@ -131,23 +147,31 @@ isl::schedule_node CpuMemoryManager::HoistClusters(const isl::schedule_node &nod
       continue;
     }
 
-    if (GetTensorMark(buffer_info.dst_tensor_id.get_name(), scop_info_) == TENSOR_C) {
+    bool is_matmul = scop_info_.user_config_.GetEnableMatmul();
+    if (is_matmul && GetTensorMark(buffer_info.dst_tensor_id.get_name(), scop_info_) == TENSOR_C) {
       continue;
     }
     auto id = buffer_info.tensor_id;
 
     auto box_sizes = fp_cluster->GetFixedBoxSizes();
     if (box_sizes.size() == 0) {
+      if (!is_matmul) {
+        continue;
+      }
       LOG(FATAL) << "Can not manage a scalar tensor";
     }
 
-    bool use_reuse_filter = true;
-    if (current_outer_bn_->template_type == Template::TRANSPOSE_OP) {
-      use_reuse_filter = false;
+    bool need_shared_memory = false;
+    if (is_matmul) {
+      bool use_reuse_filter = true;
+      if (current_outer_bn_->template_type == Template::TRANSPOSE_OP) {
+        use_reuse_filter = false;
+      }
+      bool is_injective = !ReuseTensorCluster(*fp_cluster, partial_sched_mupa);
+      need_shared_memory = !use_reuse_filter || !is_injective || CoalescingAccessWay(res_node, *fp_cluster);
+    } else {
+      need_shared_memory = IsTilePromotionProfitable(node, *fp_cluster, id, partial_sched_mupa);
     }
-    bool is_injective = !ReuseTensorCluster(*fp_cluster, partial_sched_mupa);
-
-    bool need_shared_memory = !use_reuse_filter || !is_injective || CoalescingAccessWay(res_node, *fp_cluster);
     if (!need_shared_memory) {
       continue;
     }
@@ -180,6 +204,12 @@ void CpuMemoryManager::GatherBufferFootprintDefInfo(const isl::schedule_node &no
   isl::id tensor_id = tensor_info.tensor_id;
   Type type = scop_info_.GetDtypeOf(tensor_id);
 
+  if (!scop_info_.user_config_.GetEnableMatmul()) {
+    // Rows of a packed tile start on a vector boundary.
+    int lanes = std::max(scop_info_.user_config_.GetCpuInfo()->simd_bytes / std::max(type.bytes(), 1), 1);
+    sizes.back() = (sizes.back() + lanes - 1) / lanes * lanes;
+  }
+
   isl::id cluster_id = tensor_info.dst_tensor_id;
 
   // build a Halide Node for cluster_id
@@ -249,6 +279,106 @@ bool CpuMemoryManager::CoalescingAccessWay(const isl::schedule_node &node, const
   return false;
 }
 
+/*
+ * The cost model of the tile promotion beyond matmul. A tensor read with a non-unit stride along the vectorized loop
+ * is gathered lane by lane from global memory, the packed copy is read from a tile that stays in cache instead.
+ */
+bool CpuMemoryManager::IsTilePromotionProfitable(const isl::schedule_node &node, const TensorFootprintCluster &cluster,
+                                                 const isl::id &tensor_id,
+                                                 const isl::multi_union_pw_aff &outer_pw_aff) {
+  auto cpu_info = scop_info_.user_config_.GetCpuInfo();
+  int64_t bytes = std::max(scop_info_.GetDtypeOf(tensor_id).bytes(), 1);
+  auto box_sizes = cluster.GetFixedBoxSizes();
+  int64_t box_bytes = std::accumulate(box_sizes.begin(), box_sizes.end(), bytes, std::multiplies<int64_t>());
+  // The tiling keeps the working set of a task within half of L2, the copy must fit in the other half.
+  if (box_bytes > cpu_info->l2_bytes / 2) {
+    return false;
+  }
+
+  Tensor tensor = scop_info_.FindTensor(tensor_id);
+  auto delta = VectorizedAccessDelta(node, cluster);
+  if (!tensor.defined() || delta.empty() || delta.size() != tensor->shape.size() || delta.size() != box_sizes.size()) {
+    return false;
+  }
+  std::vector<int64_t> shape;
+  for (const auto &dim : tensor->shape) {
+    auto extent = as_const_int(dim);
+    if (extent == nullptr) {
+      return false;
+    }
+    shape.push_back(*extent);
+  }
+  // The packed tile keeps the layout of the tensor with the rows padded as in GatherBufferFootprintDefInfo.
+  std::vector<int64_t> packed(box_sizes.begin(), box_sizes.end());
+  int64_t lanes = std::max(cpu_info->simd_bytes / bytes, static_cast<int64_t>(1));
+  packed.back() = (packed.back() + lanes - 1) / lanes * lanes;
+
+  // Broadcasts and unit strides vectorize as they are, and a tile as wide as the tensor reads with the same stride.
+  int64_t stride = FlattenDelta(delta, shape);
+  if (stride <= 1 || FlattenDelta(delta, packed) >= stride) {
+    return false;
+  }
+
+  // Every lane loads its own cache line, and with large strides its own page.
+  if (stride * bytes >= cpu_info->cache_line_bytes) {
+    return true;
+  }
+
+  // The lanes share cache lines, the copy pays off only if the tile is read more than once.
+  return ReuseTensorCluster(cluster, outer_pw_aff);
+}
+
+/*
+ * The absolute change of the tensor indexes between two adjacent iterations of the vectorized loop below node, empty
+ * when there is no such loop or the change is not constant. Of several accesses, the largest change is taken.
+ */
+std::vector<int64_t> CpuMemoryManager::VectorizedAccessDelta(const isl::schedule_node &node,
+                                                             const TensorFootprintCluster &cluster) {
+  auto vectorized_marks = CollectMarkNode(node, FOR_VECTORIZED);
+  if (vectorized_marks.empty() || !vectorized_marks[0].child(0).isa<isl::schedule_node_band>()) {
+    return {};
+  }
+
+  auto vectorized_band = vectorized_marks[0].child(0);
+  size_t inner_depth =
+    vectorized_band.schedule_depth() + vectorized_band.as<isl::schedule_node_band>().n_member() - 1;
+  auto access = cluster.OrigianlAccessRelations().intersect_domain(CollectDomain(vectorized_band));
+  auto schedule_access = access.apply_domain(LocalSchedule(vectorized_band));
+
+  std::vector<int64_t> res;
+  for (auto map : schedule_access.get_map_list()) {
+    if (inner_depth >= map.domain().n_dim()) {
+      continue;
+    }
+    auto schedule_next = CreateMapIncreaseDim(map.get_space().domain(), inner_depth);
+    auto deltas = schedule_next.apply_domain(map).apply_range(map).deltas().project_out_all_params();
+    if (deltas.is_empty() || !deltas.is_singleton()) {
+      continue;
+    }
+    auto point = deltas.sample_point();
+    // Compared outer dimension first, a change in an outer dimension is the larger stride.
+    std::vector<int64_t> delta;
+    for (int i = 0; i < static_cast<int>(map.range().n_dim()); ++i) {
+      delta.push_back(std::abs(isl::manage(isl_point_get_coordinate_val(point.get(), isl_dim_set, i)).get_num_si()));
+    }
+    if (res.empty() || (delta.size() == res.size() && delta > res)) {
+      res = delta;
+    }
+  }
+  return res;
+}
+
+// Offset in elements of an index change in a row-major layout of the given extents.
+int64_t CpuMemoryManager::FlattenDelta(const std::vector<int64_t> &delta, const std::vector<int64_t> &extents) {
+  int64_t flat = 0;
+  int64_t extent = 1;
+  for (int i = static_cast<int>(delta.size()) - 1; i >= 0; --i) {
+    flat += delta[i] * extent;
+    extent *= extents[i];
+  }
+  return flat;
+}
+
 isl::schedule CpuMemoryManager::InsertVectorizedMarker(const isl::schedule &sch) {
   auto GetPromotedWriteFilter = [this](isl::schedule_node node) -> isl::schedule_node {
     if (!node.isa<isl::schedule_node_band>() || !node.has_parent() || !node.parent().isa<isl::schedule_node_filter>()) {
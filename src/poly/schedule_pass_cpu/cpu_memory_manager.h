@@ -45,6 +45,12 @@ class CpuMemoryManager : public SchedulePass {
 
   bool CoalescingAccessWay(const isl::schedule_node &node, const TensorFootprintCluster &cluster);
 
+  bool IsTilePromotionProfitable(const isl::schedule_node &node, const TensorFootprintCluster &cluster,
+                                 const isl::id &tensor_id, const isl::multi_union_pw_aff &outer_pw_aff);
+
+  std::vector<int64_t> VectorizedAccessDelta(const isl::schedule_node &node, const TensorFootprintCluster &cluster);
+  static int64_t FlattenDelta(const std::vector<int64_t> &delta, const std::vector<int64_t> &extents);
+
   isl::schedule InsertVectorizedMarker(const isl::schedule &sch);
 
   isl::schedule HoistCpuMemory();
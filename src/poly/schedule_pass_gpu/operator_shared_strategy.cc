@@ -268,6 +268,10 @@ std::set<std::string> CpuMemoryStrategy::GetInitPromotedTensor() {
 }
 
 void CpuMemoryStrategy::CreateClusterList(const isl::schedule_node &node) {
+  if (!scop_info_.user_config_.GetEnableMatmul()) {
+    CreateTileClusterList(node);
+    return;
+  }
   std::set<std::string> id_sets = GetInitPromotedTensor();
   RecordCustomPromotedTensors(id_sets);
   DeleteNotPromotedTensors(id_sets);
@@ -308,6 +312,19 @@ void CpuMemoryStrategy::CreateClusterList(const isl::schedule_node &node) {
   }
 }
 
+void CpuMemoryStrategy::CreateTileClusterList(const isl::schedule_node &node) {
+  // Every tensor that is only read is a candidate, the memory manager decides which ones are worth packing.
+  if (scop_info_.analysis_result_.GetTensorOfTensor()) {
+    return;
+  }
+  std::set<std::string> id_sets = OperatorSharedStrategy::GetInitPromotedTensor();
+  RecordCustomPromotedTensors(id_sets);
+  DeleteNotPromotedTensors(id_sets);
+  for (auto mark_name : mark_names_) {
+    RecordPromotedTensorInfo(node, id_sets, mark_name);
+  }
+}
+
 }  // namespace poly
 }  // namespace ir
 }  // namespace akg
@@ -71,6 +71,7 @@ class CpuMemoryStrategy : public OperatorSharedStrategy {
   ~CpuMemoryStrategy() {}
   std::set<std::string> GetInitPromotedTensor();
   void CreateClusterList(const isl::schedule_node &node);
+  void CreateTileClusterList(const isl::schedule_node &node);
 };
 }  // namespace poly
 }  // namespace ir
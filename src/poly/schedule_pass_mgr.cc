@@ -15,10 +15,29 @@
  */
 
 #include "poly/schedule_pass_mgr.h"
+#include <dirent.h>
+#include <unordered_set>
+#include "build_module.h"
+#include "codegen/compile_profiler.h"
 
 namespace akg {
 namespace ir {
 namespace poly {
+namespace {
+// Names of the entries of dir, empty when it does not exist.
+std::unordered_set<std::string> ListDir(const std::string &dir) {
+  std::unordered_set<std::string> names;
+  DIR *dp = opendir(dir.empty() ? "." : dir.c_str());
+  if (dp == nullptr) {
+    return names;
+  }
+  for (struct dirent *ent = readdir(dp); ent != nullptr; ent = readdir(dp)) {
+    names.insert(ent->d_name);
+  }
+  closedir(dp);
+  return names;
+}
+}  // namespace
 
 const std::vector<std::shared_ptr<SchedulePass>> &SchedulePassMgr::GetSchedulePasses() const {
   return schedule_passes_;
@@ -43,6 +62,12 @@ isl::schedule SchedulePassMgr::Run(const isl::schedule &sch, const std::vector<s
   auto final_sch = sch;
   auto replace_sch = sch;
   need_restart_ = false;
+  // Replacement schedules are looked up in one listing of the dump dir instead of a file probe per pass, kernels
+  // without a dump_poly_dir attr touch no file.
+  std::unordered_set<std::string> schedule_files;
+  if (DebugHooks::Current().replace_poly_schedule && !scop_info_.user_config_.GetDumpPolyDir().empty()) {
+    schedule_files = ListDir(scop_info_.AddDumpDir(""));
+  }
 
   std::set<std::string> disabled;
   for (auto &pass : passes) {
@@ -55,7 +80,8 @@ isl::schedule SchedulePassMgr::Run(const isl::schedule &sch, const std::vector<s
       LOG(INFO) << "Running poly pass " << name;
     }
 
-    if (LoadScheduleTreeFromFile(scop_info_.AddDumpDir(pass->GetPassName() + ".txt"), replace_sch)) {
+    if (schedule_files.count(pass->GetPassName() + ".txt") > 0 &&
+        LoadScheduleTreeFromFile(scop_info_.AddDumpDir(pass->GetPassName() + ".txt"), replace_sch)) {
       if (!replace_sch.plain_is_equal(final_sch)) {
         final_sch = replace_sch;
         LOG(WARNING) << (pass->GetPassName() + " input schedule had been replaced  !!!");
@@ -64,7 +90,10 @@ isl::schedule SchedulePassMgr::Run(const isl::schedule &sch, const std::vector<s
 
     std::stringstream time_log;
     TIMER_START;
-    final_sch = pass->Run(final_sch);
+    {
+      ProfileScope profile("poly", pass->GetPassName());
+      final_sch = pass->Run(final_sch);
+    }
     time_log << "[ Polyhedral exec time" << (scop_info_.mmu_info_.IsSpecGemm() ? "_specgemm" : "") << " ], "
              << pass->GetPassName() << " spent " << TIMER_DURATION << " ms";
 
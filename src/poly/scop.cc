@@ -204,10 +204,6 @@ isl::id_list CreateIteratorList(const isl::schedule &schedule_iter, const std::s
   return res;
 }
 
-size_t &AstNodeNum() {
-  static thread_local size_t n = 0;
-  return n;
-}
 constexpr auto AST_NODE_ID_PREFIX = "__node_";
 Stmt GenHalide(ScopInfo &info, const isl::schedule &sch, bool used_for_tile_out_band) {
   if (sch.get()) info.analysis_result_.SetTransformedSchedule(sch);
@@ -221,7 +217,7 @@ Stmt GenHalide(ScopInfo &info, const isl::schedule &sch, bool used_for_tile_out_
   auto gather = [&node_info_repo](const isl::ast_node &node, const isl::ast_build &build) -> isl::ast_node {
     auto schedule_map = isl::map::from(build.get_schedule());
 
-    auto node_id = isl::id(node.ctx(), std::string(AST_NODE_ID_PREFIX) + std::to_string(AstNodeNum()++));
+    auto node_id = isl::id(node.ctx(), std::string(AST_NODE_ID_PREFIX) + std::to_string(NextCompileId("ast_node")));
     CHECK_EQ(0u, node_info_repo.count(node_id)) << "node already exists: " << node_id;
 
     auto &node_info = node_info_repo[node_id];
@@ -45,6 +45,7 @@ class Scop {
 Stmt GenHalide(ScopInfo &info, const isl::schedule &, bool used_for_tile_out_band = false);
 Stmt DsaHalideOptimizer(const Stmt &s, bool dynamic_shape = false);
 Stmt RestoreCombinedParams(Stmt stmt, ScopInfo &info);
+Stmt RestoreShapeParams(Stmt stmt, ScopInfo &info);
 std::pair<TileSizes, std::deque<ParamInfo>> GenerateTiling(const isl::schedule &sch, ScopInfo &scop_info, Stmt body);
 NodeRef GenerateTilingSpace(const isl::schedule &sch, ScopInfo &scop_info, Stmt body, int dump_level);
 NodeRef GenerateTuningSpace(TuneInfo *tune_info, int dump_level);
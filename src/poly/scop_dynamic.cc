@@ -464,6 +464,13 @@ Stmt ReplacePrimesWithParameters(Stmt stmt, ScopInfo &scop_info) {
   return stmt;
 }
 
+Stmt RestoreShapeParams(Stmt stmt, ScopInfo &scop_info) {
+  stmt = air::ir::MergeNest(scop_info.user_config_.GetOuterLetStmts(), stmt);
+  auto params_rev_map = scop_info.user_config_.GetParamsRevMap();
+  stmt = RestoreCombinedParamsMutator(params_rev_map).Mutate(stmt);
+  return stmt;
+}
+
 Stmt RestoreCombinedParams(Stmt stmt, ScopInfo &scop_info) {
   if (scop_info.mmu_info_.IsConv() && !scop_info.mmu_info_.IsSpecGemm()) {
     stmt = RestoreConstToMinMutator().Mutate(stmt);
@@ -489,10 +496,7 @@ Stmt RestoreCombinedParams(Stmt stmt, ScopInfo &scop_info) {
     }
   }
   stmt = AddTilingStrategyApplet(scop_info, stmt);
-  stmt = air::ir::MergeNest(scop_info.user_config_.GetOuterLetStmts(), stmt);
-  auto params_rev_map = scop_info.user_config_.GetParamsRevMap();
-  stmt = RestoreCombinedParamsMutator(params_rev_map).Mutate(stmt);
-  return stmt;
+  return RestoreShapeParams(stmt, scop_info);
 }
 
 }  // namespace poly
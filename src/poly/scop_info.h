@@ -21,6 +21,7 @@
 #include "build_module.h"
 #include "pass/utils.h"
 #include "common/common_util.h"
+#include "common/target_info.h"
 #include "pass/convolution_model.h"
 #include "poly/poly_util.h"
 #include "poly/dynamic_shape.h"
@@ -316,7 +317,9 @@ class UserConfig {
     } else if (GetTarget() == TARGET_CPU) {
       ParseVectorLengthAttr(attrs, "vector_length", &vector_length_, false);
       ParseBoolAttr(attrs, "pragma_enable_matmul", &enable_matmul_);
+      ParseBoolAttr(attrs, "use_shared_memory", &use_shared_memory_);
       ParseStringAttr(attrs, "feature", &feature_);
+      ParseStringAttr(attrs, "cpu_info", &cpu_info_);
     }
 
     if (force_remove_self_dependence_) {
@@ -558,6 +561,8 @@ class UserConfig {
   // cpu type
   std::string GetFeature() { return feature_; }
   void SetFeature(std::string feature) { feature_ = feature; }
+  // Cache hierarchy and vector extensions of the target cpu, the build host of generic code when empty.
+  air::CpuInfo GetCpuInfo() { return air::GetCpuInfo(cpu_info_); }
 
  private:
   // tools for parsing user config
@@ -795,6 +800,7 @@ class UserConfig {
 
   // cpu type
   std::string feature_;
+  std::string cpu_info_;
 
   // csr config
   int csr_thread_num_{128};
@@ -1431,10 +1437,11 @@ class ScopInfo {
 
 class PartitionSingle {
  private:
-  static PartitionSingle *single_;
-  static int m_times_;
-  static int m_cut_m_;
-  static std::map<std::string, Expr> m_fractal_int_info_;
+  // One instance per compiling thread.
+  thread_local static PartitionSingle *single_;
+  thread_local static int m_times_;
+  thread_local static int m_cut_m_;
+  thread_local static std::map<std::string, Expr> m_fractal_int_info_;
   PartitionSingle(int times, int tile_start, int cut_m, const std::map<std::string, Expr> &fractal_int_info);
   ~PartitionSingle() = default;
 
@@ -15,6 +15,7 @@
  */
 
 #include "sync_manager.h"
+#include "build_module.h"
 #include "poly_util.h"
 #include "scop_info.h"
 #include "poly/schedule_tree_util.h"
@@ -34,14 +35,12 @@ isl::id SyncManager::MakeUniqueId(SyncLevel level) {
 }
 
 isl::id SyncManager::GetSyncId() const {
-  static size_t count = 0;
-  auto sync_id = std::string(SYNC_PREFIX) + std::to_string(count++);
+  auto sync_id = std::string(SYNC_PREFIX) + std::to_string(NextCompileId("sync"));
   return isl::id(ctx_, sync_id);
 }
 
 isl::id SyncManager::GetWarpSyncId() const {
-  static size_t count = 0;
-  auto sync_id = std::string(WARP_SYNC_PREFIX) + std::to_string(count++);
+  auto sync_id = std::string(WARP_SYNC_PREFIX) + std::to_string(NextCompileId("warp_sync"));
   return isl::id(ctx_, sync_id);
 }
 
@@ -49,10 +49,8 @@ constexpr auto VECTORIZE_BYTE = 256;
 constexpr auto MAX_REPEAT = 255;
 constexpr auto MIN_CORE_GRANULARITY = 256;
 constexpr auto DESIRE_CORE_GRANULARITY = 8192;
-constexpr auto MIN_EXEC_NUM_PER_THREAD = 4096;
-constexpr auto BEST_PARALLEL_NUM = 192;
-constexpr auto PARALLEL_DECREASE_VALUE = 8;
-constexpr auto BEST_UNROLL_NUM = 256;
+constexpr auto PARALLEL_TASKS_PER_CORE = 4;
+constexpr auto MAX_UNROLL_VECTORS = 64;
 constexpr auto MIN_UNROLL_NUM = 8;
 constexpr auto MATMUL_BEST_FACTOR = 128;
 constexpr auto MATMUL_AXIS_M = 0;
@@ -461,6 +461,7 @@ class CpuStrategy : public TilingStrategy {
   void AddCpuConstraint();
 
  private:
+  void InitCacheParams();
   void BuildAxesQueue();
   void RecordTileValue();
   void SetMatMulTileValue(int index);
@@ -470,10 +471,14 @@ class CpuStrategy : public TilingStrategy {
                             bool is_unroll_axis = false, int64_t tile_left = 1);
 
   std::vector<std::vector<std::pair<TileAxis *, int64_t>>> pending_axes_;
-  int min_exec_num_per_thread_{MIN_EXEC_NUM_PER_THREAD};
-  int best_parallel_num_{BEST_PARALLEL_NUM};
-  int parallel_decrease_value_{PARALLEL_DECREASE_VALUE};
-  int best_unroll_num_{BEST_UNROLL_NUM};
+  air::CpuInfo cpu_info_;
+  // Bytes touched by one point of the iteration domain, summed over all accessed tensors.
+  int64_t point_bytes_{1};
+  int64_t min_elem_bytes_{1};
+  int64_t max_elem_bytes_{1};
+  int best_parallel_num_{1};
+  int parallel_decrease_value_{1};
+  int best_unroll_num_{MIN_UNROLL_NUM};
   int min_unroll_num_{MIN_UNROLL_NUM};
   int best_factor_for_matmul_{MATMUL_BEST_FACTOR};
   int axis_m_{MATMUL_AXIS_M};
@@ -20,12 +20,71 @@ namespace akg {
 namespace ir {
 namespace poly {
 
+namespace {
+int64_t FloorPowerOfTwo(int64_t value) {
+  int64_t result = 1;
+  while (result * 2 <= value) {
+    result *= 2;
+  }
+  return result;
+}
+}  // namespace
+
 void CpuStrategy::AddCpuConstraint() {
+  InitCacheParams();
   BuildAxesQueue();
   SetMultiLevelTileValue();
   RecordTileValue();
 }
 
+void CpuStrategy::InitCacheParams() {
+  auto &scop_info = analyzer_->scop_info_;
+  cpu_info_ = scop_info.user_config_.GetCpuInfo();
+  CHECK(cpu_info_.defined());
+
+  auto accesses = scop_info.analysis_result_.GetReads().domain_factor_domain().unite(
+    scop_info.analysis_result_.GetWrites().domain_factor_domain());
+  std::unordered_map<std::string, int64_t> tensor_bytes;
+  for (auto access : accesses.get_map_list()) {
+    auto id = access.get_tuple_id(isl_dim_out).to_str();
+    tensor_bytes[id] = std::max(scop_info.GetDtypeOf(id).bytes(), 1);
+  }
+  point_bytes_ = 0;
+  min_elem_bytes_ = tensor_bytes.empty() ? 4 : INT64_MAX;
+  max_elem_bytes_ = tensor_bytes.empty() ? 4 : 1;
+  for (const auto &it : tensor_bytes) {
+    point_bytes_ += it.second;
+    min_elem_bytes_ = std::min(min_elem_bytes_, it.second);
+    max_elem_bytes_ = std::max(max_elem_bytes_, it.second);
+  }
+  point_bytes_ = std::max(point_bytes_, max_elem_bytes_);
+
+  // Several tasks per thread balance uneven tails, stepping by the thread number keeps the tasks evenly spread.
+  int thread_num = air::GetCpuThreadNum(cpu_info_);
+  best_parallel_num_ = thread_num * PARALLEL_TASKS_PER_CORE;
+  parallel_decrease_value_ = thread_num;
+
+  // The innermost tile is unrolled into at most MAX_UNROLL_VECTORS vector registers and, with every tensor it
+  // touches, fills at most half of L1.
+  int64_t lanes = std::max(cpu_info_->simd_bytes / min_elem_bytes_, static_cast<int64_t>(1));
+  int64_t l1_fit = cpu_info_->l1_bytes / 2 / point_bytes_;
+  best_unroll_num_ = static_cast<int>(
+    std::max(FloorPowerOfTwo(std::min(lanes * MAX_UNROLL_VECTORS, l1_fit)), static_cast<int64_t>(min_unroll_num_)));
+
+  // A square tile of the matmul right-hand side has to stay in half of L2.
+  int64_t l2_fit = cpu_info_->l2_bytes / 2 / max_elem_bytes_;
+  int64_t square = 1;
+  while ((square * 2) * (square * 2) <= l2_fit) {
+    square *= 2;
+  }
+  best_factor_for_matmul_ = static_cast<int>(std::min(square, static_cast<int64_t>(MATMUL_BEST_FACTOR)));
+
+  std::stringstream ss;
+  ss << "Cpu info: " << cpu_info_ << ", point bytes = " << point_bytes_ << ", threads = " << thread_num << ", best parallel num = " << best_parallel_num_
+     << ", best unroll num = " << best_unroll_num_ << ", matmul factor = " << best_factor_for_matmul_ << ".";
+  analyzer_->GetTileLogger().AppendLog(CPU_TILING, ss);
+}
+
 void CpuStrategy::BuildAxesQueue() {
   int band_size = analyzer_->scop_info_.analysis_result_.GetOuterBandNumber();
   pending_axes_.resize(band_size);
@@ -33,12 +92,15 @@ void CpuStrategy::BuildAxesQueue() {
     if (axis == this->analyzer_->RootAxis()) {
       return;
     }
+    // A symbolic extent is taken as one task of the fewest unrolled rows per parallel slot, so that a dynamic kernel
+    // is still parallelized and vectorized by constant tiles.
     const auto r = axis->range_extent.as<IntImm>();
-    if (r && r->value > 0 && !axis->is_inner) {
+    int64_t extent = r ? r->value : static_cast<int64_t>(this->best_parallel_num_) * this->min_unroll_num_;
+    if (extent > 0 && !axis->is_inner) {
       if (this->analyzer_->scop_info_.analysis_result_.GetOuterBandNode(axis->index)->template_type == Template::MATMUL) {
         axis->MarkWithAttr(AttrInfo{"axis_token", this->axes_name_[axis->dim_axis]});
       }
-      this->pending_axes_[axis->index].emplace_back(std::make_pair(axis, r->value));
+      this->pending_axes_[axis->index].emplace_back(std::make_pair(axis, extent));
     }
   });
 }
@@ -87,7 +149,9 @@ void CpuStrategy::SetParallelTileValue(TileAxis *axis, const int64_t axis_size,
     c0_tile_value = axis->c0_constraints.tile_extent_.as<IntImm>()->value;
     tile_size = tile_left;
   }
-  int64_t evaluate_num = data_size / min_exec_num_per_thread_;
+  // Each thread should at least stream one L1 worth of data.
+  int64_t data_bytes = data_size * point_bytes_;
+  int64_t evaluate_num = data_bytes / cpu_info_->l1_bytes;
   if (evaluate_num >= best_parallel_num_) {
     parallel_num = std::min(axis_size, static_cast<int64_t>(best_parallel_num_));
   } else if (evaluate_num > 1) {
@@ -104,6 +168,14 @@ void CpuStrategy::SetParallelTileValue(TileAxis *axis, const int64_t axis_size,
     parallel_num = evaluate_num;
   }
   int64_t tile_value = axis_size / parallel_num;
+
+  // The working set of one task should fit in half of L2.
+  int64_t row_bytes = std::max(data_bytes / axis_size, static_cast<int64_t>(1));
+  int64_t l2_fit = cpu_info_->l2_bytes / 2 / row_bytes;
+  if (tile_value > l2_fit && l2_fit >= c0_tile_value) {
+    tile_value = l2_fit / c0_tile_value * c0_tile_value;
+  }
+
   if (tile_value < min_unroll_num_) {
     tile_value = std::min(axis_size, static_cast<int64_t>(min_unroll_num_));
     c0_tile_value = tile_value;
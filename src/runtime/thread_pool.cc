@@ -15,7 +15,14 @@
  */
 
 #include <algorithm>
+#include <cctype>
 #include <exception>
+#include <fstream>
+#include <sstream>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 #if AKG_USE_OPENMP
 #include <omp.h>
 #endif
@@ -50,64 +57,328 @@ size_t MaxThreadNumber() {
   return thread_num;
 }
 
+namespace {
+constexpr int kSpinCount = 20000;
+constexpr const char *kNumaNodePath = "/sys/devices/system/node/node";
+
+inline void CpuRelax() {
+#if defined(_M_X64) || defined(__x86_64__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+// Parse a sysfs cpulist such as "0-15,32-47".
+std::vector<int> ParseCpuList(const std::string &cpu_list) {
+  std::vector<int> cpus;
+  std::stringstream ss(cpu_list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty() || !isdigit(range[0])) {
+      continue;
+    }
+    auto pos = range.find('-');
+    int first = atoi(range.substr(0, pos).c_str());
+    int last = pos == std::string::npos ? first : atoi(range.substr(pos + 1).c_str());
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+// Cpus of each NUMA node that this process is allowed to run on; empty nodes are dropped.
+std::vector<std::vector<int>> GetNumaNodeCpus() {
+  std::vector<std::vector<int>> nodes;
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    return nodes;
+  }
+  for (int node = 0;; ++node) {
+    std::ifstream ifs(kNumaNodePath + std::to_string(node) + "/cpulist");
+    if (!ifs.is_open()) {
+      break;
+    }
+    std::string cpu_list;
+    std::getline(ifs, cpu_list);
+    std::vector<int> cpus;
+    for (auto cpu : ParseCpuList(cpu_list)) {
+      if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) {
+        cpus.push_back(cpu);
+      }
+    }
+    if (!cpus.empty()) {
+      nodes.push_back(cpus);
+    }
+  }
+#endif
+  return nodes;
+}
+
+void BindThreadToCpus(std::thread *thread, const std::vector<int> &cpus) {
+#ifdef __linux__
+  if (cpus.empty()) {
+    return;
+  }
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (auto cpu : cpus) {
+    CPU_SET(cpu, &cpuset);
+  }
+  if (pthread_setaffinity_np(thread->native_handle(), sizeof(cpu_set_t), &cpuset) != 0) {
+    LOG(WARNING) << "Bind akg runtime thread to numa node failed.";
+  }
+#endif
+}
+}  // namespace
+
+void WorkQueue::Push(const WorkItem &item) {
+  Lock();
+  items_.push_back(item);
+  size_.store(items_.size(), std::memory_order_relaxed);
+  Unlock();
+}
+
+bool WorkQueue::Pop(WorkItem *item) {
+  if (Empty()) {
+    return false;
+  }
+  Lock();
+  bool found = !items_.empty();
+  if (found) {
+    *item = items_.front();
+    items_.pop_front();
+    size_.store(items_.size(), std::memory_order_relaxed);
+  }
+  Unlock();
+  return found;
+}
+
+bool WorkQueue::Steal(WorkItem *item, const ParallelJob *only) {
+  if (Empty()) {
+    return false;
+  }
+  Lock();
+  bool found = !items_.empty() && (only == nullptr || items_.back().job == only);
+  if (found) {
+    *item = items_.back();
+    items_.pop_back();
+    size_.store(items_.size(), std::memory_order_relaxed);
+  }
+  Unlock();
+  return found;
+}
+
 ThreadPool::ThreadPool() {
   max_thread_num_ = MaxThreadNumber();
 }
 
-void ThreadPool::SyncRunLoop() {
-  while (true) {
-    Task task;
-    {
-      std::unique_lock<std::mutex> lock(task_mutex_);
-      task_cond_var_.wait(lock, [this] { return !task_queue_.empty() || exit_run_; });
-      if (exit_run_) {
-        return;
-      }
-      task = task_queue_.front();
-      task_queue_.pop();
+void ThreadPool::InitAffinity(size_t worker_num) {
+  steal_order_.assign(worker_num, {});
+  worker_cpus_.assign(worker_num, {});
+  std::vector<size_t> worker_node(worker_num, 0);
+  const char *affinity = getenv("AKG_THREAD_AFFINITY");
+  auto nodes = GetNumaNodeCpus();
+  if (nodes.size() > 1 && (affinity == nullptr || std::string(affinity) != "0")) {
+    // Blocked distribution, so that neighbouring task ids share a node.
+    for (size_t i = 0; i < worker_num; ++i) {
+      worker_node[i] = i * nodes.size() / worker_num;
+      worker_cpus_[i] = nodes[worker_node[i]];
     }
-    try {
-      task();
-    } catch (std::exception &e) {
-      LOG(ERROR) << "Have exception in run loop of thread";
+  }
+  for (size_t i = 0; i < worker_num; ++i) {
+    for (size_t k = 1; k < worker_num; ++k) {
+      auto victim = (i + k) % worker_num;
+      if (worker_node[victim] == worker_node[i]) {
+        steal_order_[i].push_back(victim);
+      }
     }
-    {
-      std::unique_lock<std::mutex> task_lock(task_mutex_);
-      task_finished_count_ = task_finished_count_ + 1;
+    for (size_t k = 1; k < worker_num; ++k) {
+      auto victim = (i + k) % worker_num;
+      if (worker_node[victim] != worker_node[i]) {
+        steal_order_[i].push_back(victim);
+      }
     }
-    finished_cond_var_.notify_one();
   }
 }
 
-bool ThreadPool::SyncRun(const std::vector<Task> &tasks) {
-  if (tasks.size() == 1) {
-    auto ret = tasks[0]();
-    return ret;
+void ThreadPool::EnsureWorkers() {
+  if (workers_ready_.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(pool_mtx_);
+  if (workers_ready_.load(std::memory_order_relaxed)) {
+    return;
   }
-  std::unique_lock<std::mutex> lock(pool_mtx_);
   exit_run_ = false;
-  size_t task_num = tasks.size();
-  size_t thread_num = sync_run_threads_.size();
-  if (thread_num < max_thread_num_ && thread_num < task_num) {
-    auto new_thread_num = max_thread_num_;
-    if (task_num < max_thread_num_) {
-      new_thread_num = task_num;
+  // The launching thread always runs a share of the job itself.
+  size_t worker_num = max_thread_num_ - 1;
+  queues_.clear();
+  for (size_t i = 0; i < worker_num; ++i) {
+    queues_.emplace_back(std::make_unique<WorkQueue>());
+  }
+  InitAffinity(worker_num);
+  for (size_t i = 0; i < worker_num; ++i) {
+    sync_run_threads_.emplace_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+    BindThreadToCpus(&sync_run_threads_.back(), worker_cpus_[i]);
+  }
+  workers_ready_.store(true, std::memory_order_release);
+}
+
+void ThreadPool::RunItem(const WorkItem &item) {
+  auto job = item.job;
+  try {
+    if (job->tasks != nullptr) {
+      (*job->tasks)[item.task_id]();
+    } else {
+      job->flambda(item.task_id, job->num_task, job->cdata);
     }
-    for (size_t i = thread_num; i < new_thread_num; ++i) {
-      sync_run_threads_.emplace_back(std::thread(&ThreadPool::SyncRunLoop, this));
+  } catch (std::exception &e) {
+    LOG(ERROR) << "Have exception in run loop of thread";
+  }
+  // The job may be destroyed by its owner as soon as remaining reaches zero.
+  if (job->remaining.fetch_sub(1) == 1 && waiting_num_.load() > 0) {
+    { std::lock_guard<std::mutex> lock(done_mtx_); }
+    done_cond_var_.notify_all();
+  }
+}
+
+bool ThreadPool::FindWork(size_t worker_id, WorkItem *item, const ParallelJob *only) {
+  auto queue_num = queues_.size();
+  if (worker_id < queue_num) {
+    if (queues_[worker_id]->Pop(item)) {
+      return true;
+    }
+    for (auto victim : steal_order_[worker_id]) {
+      if (queues_[victim]->Steal(item, only)) {
+        return true;
+      }
     }
+    return false;
   }
+  for (size_t i = 0; i < queue_num; ++i) {
+    if (queues_[i]->Steal(item, only)) {
+      return true;
+    }
+  }
+  return false;
+}
 
-  for (auto &task : tasks) {
-    std::lock_guard<std::mutex> task_lock(task_mutex_);
-    task_queue_.push(task);
-    task_cond_var_.notify_one();
+void ThreadPool::WorkerLoop(size_t worker_id) {
+  WorkItem item;
+  while (!exit_run_) {
+    auto seen_epoch = epoch_.load();
+    if (FindWork(worker_id, &item, nullptr)) {
+      RunItem(item);
+      continue;
+    }
+    bool found = false;
+    for (int i = 0; i < kSpinCount && !exit_run_; ++i) {
+      if (epoch_.load(std::memory_order_relaxed) != seen_epoch) {
+        found = true;
+        break;
+      }
+      CpuRelax();
+    }
+    if (found) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(park_mtx_);
+    parked_num_.fetch_add(1);
+    park_cond_var_.wait(lock, [this, seen_epoch] { return epoch_.load() != seen_epoch || exit_run_; });
+    parked_num_.fetch_sub(1);
+  }
+}
+
+void ThreadPool::Dispatch(ParallelJob *job) {
+  auto queue_num = queues_.size();
+  if (queue_num == 0 || job->num_task == 1) {
+    return;
+  }
+  // Task 0 stays with the launching thread, the others are spread over the worker deques starting at a rotating
+  // offset so that concurrent launches do not pile onto the same workers.
+  auto start = next_queue_.fetch_add(job->num_task - 1, std::memory_order_relaxed);
+  for (int i = 1; i < job->num_task; ++i) {
+    queues_[(start + i - 1) % queue_num]->Push({job, i});
+  }
+  epoch_.fetch_add(1);
+  int parked = parked_num_.load();
+  if (parked > 0) {
+    { std::lock_guard<std::mutex> lock(park_mtx_); }
+    if (parked >= job->num_task - 1) {
+      for (int i = 1; i < job->num_task; ++i) {
+        park_cond_var_.notify_one();
+      }
+    } else {
+      park_cond_var_.notify_all();
+    }
   }
+}
+
+void ThreadPool::WaitJob(ParallelJob *job) {
+  WorkItem item;
+  if (queues_.empty() || job->num_task == 1) {
+    for (int i = 0; i < job->num_task; ++i) {
+      RunItem({job, i});
+    }
+    return;
+  }
+  RunItem({job, 0});
+  // Help with our own job only, so that an unrelated long kernel cannot delay this launch.
+  while (job->remaining.load(std::memory_order_acquire) > 0 && FindWork(queues_.size(), &item, job)) {
+    RunItem(item);
+  }
+  for (int i = 0; i < kSpinCount; ++i) {
+    if (job->remaining.load(std::memory_order_acquire) == 0) {
+      return;
+    }
+    CpuRelax();
+  }
+  waiting_num_.fetch_add(1);
   {
-    std::unique_lock<std::mutex> task_lock(task_mutex_);
-    finished_cond_var_.wait(task_lock, [this, task_num] { return task_num == task_finished_count_; });
-    task_finished_count_ = 0;
+    std::unique_lock<std::mutex> lock(done_mtx_);
+    done_cond_var_.wait(lock, [job] { return job->remaining.load() == 0; });
+  }
+  waiting_num_.fetch_sub(1);
+}
+
+bool ThreadPool::SyncRun(const std::vector<Task> &tasks) {
+  if (tasks.empty()) {
+    return SUCCESS;
   }
+  if (tasks.size() == 1) {
+    auto ret = tasks[0]();
+    return ret;
+  }
+  EnsureWorkers();
+  ParallelJob job;
+  job.tasks = &tasks;
+  job.num_task = static_cast<int>(tasks.size());
+  job.remaining = job.num_task;
+  Dispatch(&job);
+  WaitJob(&job);
+  return SUCCESS;
+}
+
+bool ThreadPool::ParallelLaunch(ParallelLambda flambda, void *cdata, int num_task) {
+  if (num_task <= 0) {
+    return SUCCESS;
+  }
+  if (num_task == 1) {
+    flambda(0, 1, cdata);
+    return SUCCESS;
+  }
+  EnsureWorkers();
+  ParallelJob job;
+  job.flambda = flambda;
+  job.cdata = cdata;
+  job.num_task = num_task;
+  job.remaining = num_task;
+  Dispatch(&job);
+  WaitJob(&job);
   return SUCCESS;
 }
 
@@ -118,17 +389,22 @@ ThreadPool &ThreadPool::GetInstance() {
 
 void ThreadPool::ClearThreadPool() {
   std::lock_guard<std::mutex> sync_run_lock(pool_mtx_);
-  if (exit_run_) {
+  if (!workers_ready_) {
     return;
   }
   exit_run_ = true;
-  task_cond_var_.notify_all();
+  {
+    std::lock_guard<std::mutex> lock(park_mtx_);
+    park_cond_var_.notify_all();
+  }
   for (auto &it : sync_run_threads_) {
     if (it.joinable()) {
       it.join();
     }
   }
   sync_run_threads_.clear();
+  queues_.clear();
+  workers_ready_ = false;
 }
 
 ThreadPool::~ThreadPool() {
@@ -159,21 +435,19 @@ int AKGBackendParallelLaunch(
     FAKGParallelLambda flambda,
     void* cdata,
     int num_task) {
+  // The loops of a symbolic extent launch 0 tasks, which take all the threads as in TVMBackendParallelLaunch.
 #if !AKG_USE_OPENMP
   auto& thread_pool = mindspore::common::ThreadPool::GetInstance();
-  std::vector<std::function<int()>> tasks;
   int max_task_num = static_cast<int>(thread_pool.GetSyncRunThreadNum());
-  max_task_num = std::min(num_task, max_task_num);
-  for (int i = 0; i < max_task_num; ++i) {
-    auto block = [&, i]() {
-        flambda(i, max_task_num, cdata);
-        return 0;
-    };
-    tasks.emplace_back(block);
-  }
-  thread_pool.SyncRun(tasks);
+  max_task_num = num_task > 0 ? std::min(num_task, max_task_num) : max_task_num;
+  thread_pool.ParallelLaunch(flambda, cdata, max_task_num);
 #else
-  int num_workers = std::min(static_cast<int>(mindspore::common::MaxThreadNumber()), num_task);
+  // Counting the cores reads sysfs, which would cost more than a small kernel.
+  static const int max_workers = static_cast<int>(mindspore::common::MaxThreadNumber());
+  int num_workers = num_task > 0 ? std::min(max_workers, num_task) : max_workers;
+  if (num_workers == 1) {
+    return flambda(0, 1, cdata);
+  }
   omp_set_num_threads(num_workers);
   #pragma omp parallel num_threads(num_workers)
   {
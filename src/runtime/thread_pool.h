@@ -19,7 +19,7 @@
 #include <condition_variable>
 #include <thread>
 #include <vector>
-#include <queue>
+#include <deque>
 #include <string>
 #include <atomic>
 #include <memory>
@@ -32,7 +32,57 @@ namespace common {
 enum Status { FAIL = -1, SUCCESS = 0 };
 using Task = std::function<int()>;
 using CTask = std::function<void(size_t, size_t)>;
+using ParallelLambda = int (*)(int task_id, int num_task, void *cdata);
 
+size_t MaxThreadNumber();
+
+/*!
+ * \brief One parallel launch in flight. A job lives on the launching thread's stack, so workers must not touch
+ *        it after the decrement that brings remaining to zero.
+ */
+struct ParallelJob {
+  ParallelLambda flambda{nullptr};
+  void *cdata{nullptr};
+  const std::vector<Task> *tasks{nullptr};
+  int num_task{0};
+  std::atomic<int> remaining{0};
+};
+
+struct WorkItem {
+  ParallelJob *job{nullptr};
+  int task_id{0};
+};
+
+/*!
+ * \brief Per-worker task deque. The owner pops from the front, thieves take from the back. Critical sections
+ *        are a handful of instructions, so a spin lock is cheaper than a mutex here.
+ */
+class WorkQueue {
+ public:
+  void Push(const WorkItem &item);
+  bool Pop(WorkItem *item);
+  bool Steal(WorkItem *item, const ParallelJob *only = nullptr);
+  bool Empty() const { return size_.load(std::memory_order_relaxed) == 0; }
+
+ private:
+  void Lock() {
+    while (lock_.test_and_set(std::memory_order_acquire)) {
+    }
+  }
+  void Unlock() { lock_.clear(std::memory_order_release); }
+
+  std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+  std::atomic<size_t> size_{0};
+  std::deque<WorkItem> items_;
+};
+
+/*!
+ * \brief Work-stealing pool backing AKGBackendParallelLaunch.
+ *
+ * Every worker owns a deque; a launch distributes its task ids statically over the deques and the launching
+ * thread runs task 0 itself. Idle workers steal from their NUMA neighbours first, spin for a while and then park.
+ * Launches do not serialize on a pool lock, so several kernels may be in flight at once.
+ */
 class ThreadPool {
  public:
   ~ThreadPool();
@@ -40,22 +90,38 @@ class ThreadPool {
   ThreadPool &operator=(const ThreadPool &) = delete;
   static ThreadPool &GetInstance();
   bool SyncRun(const std::vector<Task> &tasks);
+  // Static partition fast path: run flambda(i, num_task, cdata) for every i in [0, num_task).
+  bool ParallelLaunch(ParallelLambda flambda, void *cdata, int num_task);
   size_t GetSyncRunThreadNum() { return max_thread_num_; }
   void ClearThreadPool();
 
  private:
   ThreadPool();
-  void SyncRunLoop();
+  void EnsureWorkers();
+  void InitAffinity(size_t worker_num);
+  void Dispatch(ParallelJob *job);
+  void WaitJob(ParallelJob *job);
+  bool FindWork(size_t worker_id, WorkItem *item, const ParallelJob *only);
+  void WorkerLoop(size_t worker_id);
+  void RunItem(const WorkItem &item);
 
   size_t max_thread_num_{1};
   std::mutex pool_mtx_;
   std::atomic_bool exit_run_ = {false};
-  std::queue<Task> task_queue_;
-  std::mutex task_mutex_;
-  std::condition_variable task_cond_var_;
-  size_t task_finished_count_{0};
-  std::condition_variable finished_cond_var_;
+  std::atomic_bool workers_ready_ = {false};
+  std::atomic<size_t> next_queue_{0};
+  std::vector<std::unique_ptr<WorkQueue>> queues_;
+  // steal_order_[i] lists the victims of worker i, same NUMA node first.
+  std::vector<std::vector<size_t>> steal_order_;
+  std::vector<std::vector<int>> worker_cpus_;
+  std::mutex park_mtx_;
+  std::condition_variable park_cond_var_;
+  std::atomic<uint64_t> epoch_{0};
+  std::atomic<int> parked_num_{0};
+  std::mutex done_mtx_;
+  std::condition_variable done_cond_var_;
+  std::atomic<int> waiting_num_{0};
   std::vector<std::thread> sync_run_threads_{};
 };
 }  // namespace common
-}  // namespace mindspore
\ No newline at end of file
+}  // namespace mindspore
@@ -0,0 +1,127 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BENCHMARK_CODEGEN_BENCH_UTIL_H_
+#define BENCHMARK_CODEGEN_BENCH_UTIL_H_
+
+/*
+ * Helpers of the codegen benchmarks, which build flattened irs by hand, run them as llvm kernels and check them
+ * against a reference.
+ */
+#include <dmlc/logging.h>
+#include <tvm/buffer.h>
+#include <tvm/build_module.h>
+#include <tvm/ir.h>
+#include <tvm/ir_pass.h>
+#include <tvm/operation.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/packed_func.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace akg {
+namespace bench {
+// A flat kernel argument: its placeholder and buffer, and its data on the host.
+struct Tensor {
+  air::Tensor placeholder;
+  air::Buffer buffer;
+  air::runtime::NDArray array;
+};
+
+inline Tensor NewTensor(const std::string &name, air::DataType type, int64_t size) {
+  Tensor t;
+  t.placeholder = air::placeholder({air::Expr(static_cast<int>(size))}, type, name);
+  t.buffer = air::decl_buffer({air::Expr(static_cast<int>(size))}, type, name);
+  t.array = air::runtime::NDArray::Empty(
+    {size}, {static_cast<uint8_t>(type.code()), static_cast<uint8_t>(type.bits()), 1}, {kDLCPU, 0});
+  return t;
+}
+
+inline air::Expr Load(const Tensor &t, const air::Expr &index) {
+  return air::ir::Load::make(t.buffer->dtype, t.buffer->data, index, air::const_true());
+}
+
+inline air::Stmt Store(const Tensor &t, const air::Expr &value, const air::Expr &index) {
+  return air::ir::Store::make(t.buffer->data, value, index, air::const_true());
+}
+
+inline air::Expr Load(const Tensor *t, const air::Expr &index) { return Load(*t, index); }
+
+inline air::Stmt Store(const Tensor *t, const air::Expr &value, const air::Expr &index) {
+  return Store(*t, value, index);
+}
+
+inline air::Stmt Loop(const air::Var &var, int extent, const air::Stmt &body,
+                      air::ir::ForType type = air::ir::ForType::Serial) {
+  return air::ir::For::make(var, 0, extent, type, air::ir::DeviceAPI::None, body);
+}
+
+// An llvm kernel of a flattened body, taking the buffers of args.
+inline air::runtime::PackedFunc Build(air::Stmt body, const std::string &name,
+                                      const std::vector<const Tensor *> &args) {
+  body = air::ir::Simplify(body);
+  body = air::ir::VectorizeLoop(body);
+  body = air::ir::Simplify(body);
+  body = air::ir::RemoveNoOp(body);
+  air::Array<air::NodeRef> api_args;
+  for (auto t : args) {
+    api_args.push_back(t->buffer);
+  }
+  auto func = air::ir::MakeAPI(body, name, api_args, 0, true);
+  auto target = air::Target::Create("llvm");
+  auto module = air::build({func}, target, target, air::BuildConfig::Create());
+  return module.GetFunction(name, true);
+}
+
+inline void Call(const air::runtime::PackedFunc &kernel, const std::vector<const Tensor *> &args) {
+  std::vector<TVMValue> values(args.size());
+  std::vector<int> codes(args.size());
+  air::runtime::TVMArgsSetter setter(values.data(), codes.data());
+  for (size_t i = 0; i < args.size(); ++i) {
+    setter(i, args[i]->array);
+  }
+  air::runtime::TVMRetValue rv;
+  kernel.CallPacked(air::runtime::TVMArgs(values.data(), codes.data(), static_cast<int>(args.size())), &rv);
+}
+
+// Checks a float32 result against a double reference, within tolerance relative to the reference.
+inline void CheckClose(const Tensor &out, const std::vector<double> &reference, double tolerance,
+                       const std::string &what) {
+  auto result = static_cast<const float *>(out.array->data);
+  for (size_t i = 0; i < reference.size(); ++i) {
+    CHECK_LE(std::fabs(result[i] - reference[i]), tolerance * (1 + std::fabs(reference[i])))
+      << what << " at " << i << ": " << result[i] << " vs " << reference[i];
+  }
+}
+
+template <typename F>
+double BestSeconds(int repeats, F &&run) {
+  double best = 1e30;
+  for (int r = 0; r < repeats; ++r) {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    auto end = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double>(end - start).count());
+  }
+  return best;
+}
+}  // namespace bench
+}  // namespace akg
+
+#endif  // BENCHMARK_CODEGEN_BENCH_UTIL_H_
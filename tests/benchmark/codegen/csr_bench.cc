@@ -0,0 +1,228 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Run time of float32 csr kernels on matrices of rows x cols with nnz_per_row nonzeros per row on average, built as
+ * the flattened irs of the CSRMV and CSRMul ir builders:
+ *   spmv  out[row] = sum of data[k] * x[indices[k]] over the nonzeros k of the row
+ *   mul   out[k] = data[k] * dense[row, indices[k]]
+ * with the row lengths
+ *   uniform  all rows the same
+ *   zipf     the length of the i-th longest row proportional to 1 / (i + 1)
+ *   head     the first 1% of the rows hold half of the nonzeros
+ * compared as
+ *   rows     the row loop parallel, the rows split evenly over the threads
+ *   csr      ScheduleCsrLoop, tasks of the same number of nonzeros and vectorized rows
+ * Each result is checked against a double reference.
+ *
+ * Usage: csr_bench [rows] [cols] [nnz_per_row] [repeats]
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "build_module.h"
+#include "ir_pass.h"
+
+namespace {
+using air::Expr;
+using air::Stmt;
+using air::Var;
+using akg::bench::BestSeconds;
+using akg::bench::Build;
+using akg::bench::Call;
+using akg::bench::Load;
+using akg::bench::NewTensor;
+using akg::bench::Store;
+using akg::bench::Tensor;
+
+struct Csr {
+  int rows;
+  int cols;
+  Tensor indptr;
+  Tensor indices;
+  Tensor data;
+};
+
+// Row lengths of the distribution, nnz_per_row on average and at most cols.
+std::vector<int> RowLengths(const std::string &dist, int rows, int cols, int nnz_per_row) {
+  std::vector<double> weights(rows, 1.0);
+  if (dist == "zipf") {
+    for (int r = 0; r < rows; ++r) weights[r] = 1.0 / (r + 1);
+  } else if (dist == "head") {
+    int head = std::max(rows / 100, 1);
+    for (int r = 0; r < rows; ++r) weights[r] = r < head ? static_cast<double>(rows - head) / head : 1.0;
+  }
+  double total = 0;
+  for (double w : weights) total += w;
+  std::vector<int> lengths(rows);
+  for (int r = 0; r < rows; ++r) {
+    lengths[r] = std::min(cols, static_cast<int>(std::lround(weights[r] / total * rows * nnz_per_row)));
+  }
+  std::shuffle(lengths.begin(), lengths.end(), std::mt19937(2));
+  return lengths;
+}
+
+Csr NewCsr(const std::string &dist, int rows, int cols, int nnz_per_row) {
+  auto lengths = RowLengths(dist, rows, cols, nnz_per_row);
+  std::vector<int> indptr(rows + 1, 0);
+  for (int r = 0; r < rows; ++r) indptr[r + 1] = indptr[r] + lengths[r];
+  int nnz = indptr[rows];
+  Csr m{rows, cols, NewTensor("indptr", air::Int(32), rows + 1), NewTensor("indices", air::Int(32), nnz),
+        NewTensor("data", air::Float(32), nnz)};
+  std::copy(indptr.begin(), indptr.end(), static_cast<int *>(m.indptr.array->data));
+  std::mt19937 rng(0);
+  std::vector<int> all_cols(cols);
+  for (int c = 0; c < cols; ++c) all_cols[c] = c;
+  auto indices = static_cast<int *>(m.indices.array->data);
+  auto data = static_cast<float *>(m.data.array->data);
+  for (int r = 0; r < rows; ++r) {
+    // Sorted distinct columns of the row.
+    for (int k = 0; k < lengths[r]; ++k) {
+      std::swap(all_cols[k], all_cols[k + rng() % (cols - k)]);
+    }
+    std::sort(all_cols.begin(), all_cols.begin() + lengths[r]);
+    for (int k = 0; k < lengths[r]; ++k) {
+      indices[indptr[r] + k] = all_cols[k];
+      data[indptr[r] + k] = std::uniform_real_distribution<float>(-1.0f, 1.0f)(rng);
+    }
+  }
+  return m;
+}
+
+// The loop nest of the ir builders: for each row, a loop over its nonzeros with the bound check of the builder.
+Stmt RowLoop(const Csr &m, const std::function<Stmt(Expr, Expr, Stmt)> &row_body,
+             const std::function<Stmt(Expr, Expr)> &nonzero) {
+  Var row("row", air::Int(32));
+  Var idx("idx", air::Int(32));
+  Expr start = Load(m.indptr, row);
+  Expr end = Load(m.indptr, row + 1);
+  Stmt body = nonzero(row, start + idx);
+  body = air::ir::IfThenElse::make(start + idx < end, body);
+  Stmt nonzeros = air::ir::For::make(idx, 0, end - start, air::ir::ForType::Serial, air::ir::DeviceAPI::None, body);
+  return air::ir::For::make(row, 0, m.rows, air::ir::ForType::Serial, air::ir::DeviceAPI::None,
+                            row_body(row, start, nonzeros));
+}
+
+struct Kernel {
+  const char *name;
+  Stmt ir;
+  std::vector<const Tensor *> args;
+  const Tensor *out;
+  std::vector<double> reference;
+};
+
+Kernel Spmv(const Csr &m, const Tensor &x, const Tensor &out) {
+  Kernel k{"spmv", Stmt(), {&m.indptr, &m.indices, &m.data, &x, &out}, &out, {}};
+  k.ir = RowLoop(
+    m,
+    [&out](Expr row, Expr, Stmt nonzeros) {
+      return air::ir::Block::make(Store(out, air::make_zero(air::Float(32)), row), nonzeros);
+    },
+    [&](Expr row, Expr pos) {
+      Stmt update = Store(out, Load(out, row) + Load(m.data, pos) * Load(x, Load(m.indices, pos)), row);
+      return air::ir::AttrStmt::make(Expr("INFO"), "reduce_update", Expr(""), update);
+    });
+  auto indptr = static_cast<const int *>(m.indptr.array->data);
+  auto indices = static_cast<const int *>(m.indices.array->data);
+  auto data = static_cast<const float *>(m.data.array->data);
+  auto xs = static_cast<const float *>(x.array->data);
+  k.reference.assign(m.rows, 0);
+  for (int r = 0; r < m.rows; ++r) {
+    for (int p = indptr[r]; p < indptr[r + 1]; ++p) k.reference[r] += static_cast<double>(data[p]) * xs[indices[p]];
+  }
+  return k;
+}
+
+Kernel Mul(const Csr &m, const Tensor &dense, const Tensor &out) {
+  Kernel k{"mul", Stmt(), {&m.indptr, &m.indices, &m.data, &dense, &out}, &out, {}};
+  k.ir = RowLoop(
+    m, [](Expr, Expr, Stmt nonzeros) { return nonzeros; },
+    [&](Expr row, Expr pos) {
+      return Store(out, Load(m.data, pos) * Load(dense, row * m.cols + Load(m.indices, pos)), pos);
+    });
+  auto indptr = static_cast<const int *>(m.indptr.array->data);
+  auto indices = static_cast<const int *>(m.indices.array->data);
+  auto data = static_cast<const float *>(m.data.array->data);
+  auto ds = static_cast<const float *>(dense.array->data);
+  k.reference.assign(m.indices.array->shape[0], 0);
+  for (int r = 0; r < m.rows; ++r) {
+    for (int p = indptr[r]; p < indptr[r + 1]; ++p) {
+      k.reference[p] = static_cast<double>(data[p]) * ds[static_cast<int64_t>(r) * m.cols + indices[p]];
+    }
+  }
+  return k;
+}
+
+// The row loop parallel as it is.
+class ParallelRows : public air::ir::IRMutator {
+ public:
+  Stmt Mutate_(const air::ir::For *op, const Stmt &s) final {
+    if (op->loop_var->name_hint != "row") {
+      return IRMutator::Mutate_(op, s);
+    }
+    return air::ir::For::make(op->loop_var, op->min, op->extent, air::ir::ForType::Parallel, op->device_api,
+                              op->body);
+  }
+};
+
+double Run(const Kernel &k, const Stmt &ir, const std::string &mode, int repeats) {
+  auto kernel = Build(ir, std::string(k.name) + "_" + mode, k.args);
+  auto out = static_cast<float *>(k.out->array->data);
+  std::fill_n(out, k.out->array->shape[0], NAN);
+  Call(kernel, k.args);
+  akg::bench::CheckClose(*k.out, k.reference, 1e-4, std::string(k.name) + " " + mode);
+  return BestSeconds(repeats, [&]() { Call(kernel, k.args); });
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  int rows = argc > 1 ? atoi(argv[1]) : 65536;
+  int cols = argc > 2 ? atoi(argv[2]) : 4096;
+  int nnz_per_row = argc > 3 ? atoi(argv[3]) : 32;
+  int repeats = argc > 4 ? atoi(argv[4]) : 20;
+  CHECK_GT(rows, 0);
+  CHECK_GE(cols, nnz_per_row);
+
+  std::mt19937 rng(1);
+  auto x = NewTensor("x", air::Float(32), cols);
+  auto dense = NewTensor("dense", air::Float(32), static_cast<int64_t>(rows) * cols);
+  for (auto t : {&x, &dense}) {
+    auto values = static_cast<float *>(t->array->data);
+    for (int64_t i = 0; i < t->array->shape[0]; ++i) values[i] = std::uniform_real_distribution<float>(-1, 1)(rng);
+  }
+
+  printf("%-6s%-9s%10s%12s%12s%10s\n", "op", "rows", "nnz", "rows(ms)", "csr(ms)", "speedup");
+  for (const std::string dist : {"uniform", "zipf", "head"}) {
+    Csr m = NewCsr(dist, rows, cols, nnz_per_row);
+    int64_t nnz = m.indices.array->shape[0];
+    auto spmv_out = NewTensor("out", air::Float(32), rows);
+    auto mul_out = NewTensor("out", air::Float(32), nnz);
+    for (const auto &k : {Spmv(m, x, spmv_out), Mul(m, dense, mul_out)}) {
+      double parallel_rows = Run(k, ParallelRows().Mutate(k.ir), "rows", repeats);
+      double csr = Run(k, akg::ir::ScheduleCsrLoop(k.ir), "csr", repeats);
+      printf("%-6s%-9s%10lld%12.3f%12.3f%9.2fx\n", k.name, dist.c_str(), static_cast<long long>(nnz),
+             parallel_rows * 1e3, csr * 1e3, parallel_rows / csr);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,185 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * GB/s of float32 all-reduces of 2^log2_n elements, in the loop nest the CPU poly emitter produces for them: a parallel
+ * loop over blocks of kUnroll * kLanes elements, an unrolled loop and a vectorized loop, both in reduce areas, lowered
+ * by ReductionFactor with
+ *   single   reduce_accumulators = 1, one accumulator vector per block and serial combines
+ *   multi    reduce_accumulators = 4, the default: independent accumulator vectors and tree combines
+ * Each result is checked against a double reference and must be the same on every run.
+ *
+ * Usage: reduce_bench [log2_n] [repeats]
+ */
+#include <dmlc/logging.h>
+#include <tvm/buffer.h>
+#include <tvm/build_module.h>
+#include <tvm/ir.h>
+#include <tvm/ir_mutator.h>
+#include <tvm/ir_pass.h>
+#include <tvm/operation.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/packed_func.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "build_module.h"
+#include "ir_pass.h"
+
+namespace {
+using air::runtime::NDArray;
+using air::runtime::PackedFunc;
+
+constexpr int kLanes = 8;
+constexpr int kUnroll = 16;
+
+struct ReduceOp {
+  const char *name;
+  std::function<air::Expr(air::Expr, air::Expr)> make;
+  float init;
+  double (*reference)(double, double);
+  float (*sample)(std::mt19937 &);
+  double tolerance;  // relative to the reference
+};
+
+float Uniform(std::mt19937 &rng) { return std::uniform_real_distribution<float>(-1e3f, 1e3f)(rng); }
+
+// Products of +-1 are exact, other inputs overflow or lose all digits over 2^24 elements.
+float Sign(std::mt19937 &rng) { return rng() % 2 == 0 ? 1.0f : -1.0f; }
+
+const std::vector<ReduceOp> kOps = {
+  {"sum", air::ir::Add::make, 0.0f, [](double a, double b) { return a + b; },
+   [](std::mt19937 &rng) { return std::uniform_real_distribution<float>(0.0f, 1.0f)(rng); }, 1e-4},
+  {"max", air::ir::Max::make, -INFINITY, [](double a, double b) { return std::max(a, b); }, Uniform, 0},
+  {"min", air::ir::Min::make, INFINITY, [](double a, double b) { return std::min(a, b); }, Uniform, 0},
+  {"prod", air::ir::Mul::make, 1.0f, [](double a, double b) { return a * b; }, Sign, 0},
+};
+
+// The emitter marks the reduce statements for ReductionFactor only.
+class RemoveReduceProvide : public air::ir::IRMutator {
+ public:
+  air::Stmt Mutate_(const air::ir::AttrStmt *op, const air::Stmt &s) final {
+    return op->attr_key == "REDUCE_PROVIDE" ? Mutate(op->body) : IRMutator::Mutate_(op, s);
+  }
+};
+
+NDArray Empty(int64_t size) {
+  return NDArray::Empty({size}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+}
+
+PackedFunc BuildReduce(const ReduceOp &op, int64_t size, int accumulators) {
+  akg::g_attrs.Set(akg::kReduceAccumulators, air::Expr(accumulators));
+  auto in = air::placeholder({air::Expr(static_cast<int>(size))}, air::Float(32), "in");
+  auto out = air::placeholder({air::Expr(1)}, air::Float(32), "out");
+  air::Var p("p", air::Int(32));
+  air::Var u("u", air::Int(32));
+  air::Var v("v", air::Int(32));
+  auto reduce_area = [](const air::Stmt &body) {
+    return air::ir::AttrStmt::make(air::Expr("INFO"), "reduce_area", air::ir::StringImm::make("reduce_area"), body);
+  };
+  air::Stmt body = air::ir::Provide::make(out->op, 0, op.make(out(0), in((p * kUnroll + u) * kLanes + v)), {0});
+  body = air::ir::AttrStmt::make(air::Expr("INFO"), "REDUCE_PROVIDE", air::Expr("REDUCE_PROVIDE"), body);
+  body = air::ir::For::make(v, 0, kLanes, air::ir::ForType::Vectorized, air::ir::DeviceAPI::None, body);
+  body = reduce_area(air::ir::For::make(u, 0, kUnroll, air::ir::ForType::Unrolled, air::ir::DeviceAPI::None, body));
+  body = reduce_area(air::ir::For::make(p, 0, static_cast<int>(size / (kUnroll * kLanes)),
+                                        air::ir::ForType::Parallel, air::ir::DeviceAPI::None, body));
+  body = air::ir::Block::make(air::ir::Provide::make(out->op, 0, air::ir::FloatImm::make(air::Float(32), op.init), {0}),
+                              body);
+
+  auto in_buffer = air::decl_buffer(in->shape, in->dtype, "in");
+  auto out_buffer = air::decl_buffer(out->shape, out->dtype, "out");
+  air::Map<air::Tensor, air::Buffer> binds;
+  binds.Set(in, in_buffer);
+  binds.Set(out, out_buffer);
+  body = akg::ir::ReductionFactor(body, binds);
+  body = RemoveReduceProvide().Mutate(body);
+  body = air::ir::StorageFlatten(body, binds, 64, false);
+  body = air::ir::Simplify(body);
+  body = air::ir::VectorizeLoop(body);
+  body = air::ir::UnrollLoop(body, 0, 8, 0, true);
+  body = air::ir::Simplify(body);
+  body = air::ir::RemoveNoOp(body);
+
+  std::string name = std::string(op.name) + "_" + std::to_string(accumulators);
+  auto func = air::ir::MakeAPI(body, name, {in_buffer, out_buffer}, 0, true);
+  auto target = air::Target::Create("llvm");
+  auto module = air::build({func}, target, target, air::BuildConfig::Create());
+  return module.GetFunction(name, true);
+}
+
+template <typename F>
+double BestSeconds(int repeats, F &&run) {
+  double best = 1e30;
+  for (int r = 0; r < repeats; ++r) {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    auto end = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double>(end - start).count());
+  }
+  return best;
+}
+
+// GB/s of the kernel, after checking its result against the reference and across the repeats.
+double RunReduce(const ReduceOp &op, const NDArray &input, int accumulators, int repeats) {
+  int64_t size = input->shape[0];
+  auto kernel = BuildReduce(op, size, accumulators);
+  auto output = Empty(1);
+  auto data = static_cast<const float *>(input->data);
+  auto result = static_cast<float *>(output->data);
+  double reference = op.init;
+  for (int64_t k = 0; k < size; ++k) {
+    reference = op.reference(reference, data[k]);
+  }
+  kernel(input, output);
+  float first = result[0];
+  CHECK_LE(std::fabs(first - reference), op.tolerance * std::fabs(reference))
+    << op.name << " with " << accumulators << " accumulators: " << first << " vs " << reference;
+  double seconds = BestSeconds(repeats, [&]() {
+    kernel(input, output);
+    CHECK_EQ(std::memcmp(&first, result, sizeof(first)), 0) << op.name << " is not deterministic";
+  });
+  return static_cast<double>(size) * sizeof(float) / seconds * 1e-9;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  int log2_n = argc > 1 ? atoi(argv[1]) : 24;
+  int repeats = argc > 2 ? atoi(argv[2]) : 20;
+  CHECK_GE(log2_n, 10);
+  int64_t size = int64_t{1} << log2_n;
+
+  std::mt19937 rng(0);
+  printf("%-8s%14s%14s%10s\n", "op", "single(GB/s)", "multi(GB/s)", "speedup");
+  for (const auto &op : kOps) {
+    auto input = Empty(size);
+    auto data = static_cast<float *>(input->data);
+    for (int64_t k = 0; k < size; ++k) {
+      data[k] = op.sample(rng);
+    }
+    double single = RunReduce(op, input, 1, repeats);
+    double multi = RunReduce(op, input, 4, repeats);
+    printf("%-8s%14.2f%14.2f%9.2fx\n", op.name, single, multi, multi / single);
+  }
+  return 0;
+}
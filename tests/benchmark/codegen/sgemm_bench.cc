@@ -0,0 +1,230 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Single core GFLOP/s of the SgemmKernelAvx micro-kernels on packed operands of BERT-base and ResNet-50 GEMMs:
+ *   avx      llvm -mcpu=haswell, the ymm kernels
+ *   avx512   llvm -mcpu=skylake-avx512, the zmm kernels (skipped when the host has no avx512f)
+ *   fp16     HgemmKernelAvx512, float16 A and B (skipped without avx512f)
+ *   int8     IgemmKernelVnni, int8 A and B, GOP/s (skipped without avx512vnni)
+ * m is the contiguous dimension of C the kernels vectorize over, as after GemmFactor.
+ *
+ * Usage: sgemm_bench [repeats]
+ */
+#include <dmlc/logging.h>
+#include <tvm/buffer.h>
+#include <tvm/build_module.h>
+#include <tvm/ir.h>
+#include <tvm/ir_pass.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/packed_func.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+using air::runtime::NDArray;
+using air::runtime::PackedFunc;
+
+struct GemmShape {
+  const char *name;
+  int64_t m;
+  int64_t n;
+  int64_t k;
+};
+
+const std::vector<GemmShape> kShapes = {
+  {"bert_qkv", 768, 128, 768},         {"bert_ffn1", 3072, 128, 768},       {"bert_ffn2", 768, 128, 3072},
+  {"resnet_conv2_3x3", 64, 3136, 576}, {"resnet_conv3_3x3", 128, 784, 1152}, {"resnet_conv4_3x3", 256, 196, 2304},
+  {"resnet_conv5_3x3", 512, 49, 4608}, {"resnet_fc", 1000, 1, 2048},
+};
+
+constexpr int kPackA = 8;
+constexpr int kPackB = 4;
+
+struct Kernel {
+  const char *name;
+  const char *target;
+  const char *intrinsic;
+  air::Type input_type;
+  air::Type output_type;
+  const char *host_feature;
+};
+
+const std::vector<Kernel> kKernels = {
+  {"avx(GF/s)", "llvm -mcpu=haswell", air::ir::intrinsic::sgemm_kernel_avx, air::Float(32), air::Float(32), "avx2"},
+  {"avx512(GF/s)", "llvm -mcpu=skylake-avx512", air::ir::intrinsic::sgemm_kernel_avx, air::Float(32), air::Float(32),
+   "avx512f"},
+  {"fp16(GF/s)", "llvm -mcpu=skylake-avx512", air::ir::intrinsic::hgemm_kernel_avx512, air::Float(16), air::Float(32),
+   "avx512f"},
+  {"int8(GOP/s)", "llvm -mcpu=cascadelake", air::ir::intrinsic::igemm_kernel_vnni, air::Int(8), air::Int(32),
+   "avx512vnni"},
+};
+
+// __builtin_cpu_supports only takes literals.
+bool HostSupports(const std::string &feature) {
+  if (feature == "avx2") {
+    return __builtin_cpu_supports("avx2");
+  } else if (feature == "avx512f") {
+    return __builtin_cpu_supports("avx512f");
+  }
+  return __builtin_cpu_supports("avx512vnni");
+}
+
+// Same layout as PackedReconstruction: panels of block rows stored k-major, the last rows in panels of block / 2,
+// block / 4 ... 1. With group_k, k is packed in groups of 4 inside a panel and the last k_len % 4 stay k-major.
+template <typename T>
+std::vector<T> Pack(const std::vector<T> &src, int64_t rows, int64_t k_len, int64_t block, bool group_k) {
+  std::vector<T> dst(src.size());
+  int64_t grouped_k = group_k ? k_len - k_len % 4 : 0;
+  size_t base = 0;
+  for (int64_t row = 0; row < rows;) {
+    int64_t size = block;
+    while (size > rows - row) {
+      size /= 2;
+    }
+    for (int64_t k = 0; k < k_len; ++k) {
+      for (int64_t i = 0; i < size; ++i) {
+        int64_t pos = k < grouped_k ? (k / 4) * size * 4 + i * 4 + k % 4 : k * size + i;
+        dst[base + pos] = src[(row + i) * k_len + k];
+      }
+    }
+    base += size * k_len;
+    row += size;
+  }
+  return dst;
+}
+
+// Exact for the small integers of the benchmark.
+uint16_t ToHalf(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  if ((bits & 0x7fffffff) == 0) {
+    return static_cast<uint16_t>(bits >> 16);
+  }
+  uint32_t exponent = ((bits >> 23) & 0xff) - 127 + 15;
+  return static_cast<uint16_t>(((bits >> 16) & 0x8000) | (exponent << 10) | ((bits >> 13) & 0x3ff));
+}
+
+// Packed A or B of the kernel input type from the float values.
+NDArray PackInput(const std::vector<float> &src, int64_t rows, int64_t k_len, int64_t block, air::Type type) {
+  auto array = NDArray::Empty({static_cast<int64_t>(src.size())},
+                              DLDataType{static_cast<uint8_t>(type.code()), static_cast<uint8_t>(type.bits()), 1},
+                              DLContext{kDLCPU, 0});
+  if (type == air::Float(16)) {
+    std::vector<uint16_t> half(src.size());
+    std::transform(src.begin(), src.end(), half.begin(), ToHalf);
+    auto packed = Pack(half, rows, k_len, block, false);
+    std::copy(packed.begin(), packed.end(), static_cast<uint16_t *>(array->data));
+  } else if (type == air::Int(8)) {
+    std::vector<int8_t> bytes(src.begin(), src.end());
+    auto packed = Pack(bytes, rows, k_len, block, true);
+    std::copy(packed.begin(), packed.end(), static_cast<int8_t *>(array->data));
+  } else {
+    auto packed = Pack(src, rows, k_len, block, false);
+    std::copy(packed.begin(), packed.end(), static_cast<float *>(array->data));
+  }
+  return array;
+}
+
+PackedFunc BuildGemm(const Kernel &kernel, const GemmShape &shape) {
+  auto a = air::decl_buffer({air::Expr(shape.m * shape.k)}, kernel.input_type, "a");
+  auto b = air::decl_buffer({air::Expr(shape.n * shape.k)}, kernel.input_type, "b");
+  auto c = air::decl_buffer({air::Expr(shape.n * shape.m)}, kernel.output_type, "c");
+  auto body = air::ir::Evaluate::make(air::ir::Call::make(
+    air::Handle(), kernel.intrinsic,
+    {a->data, b->data, c->data, air::Expr(shape.m), air::Expr(shape.n), air::Expr(shape.k), air::Expr(shape.m),
+     air::ir::Cast::make(air::Float(32), 1)},
+    air::ir::Call::Intrinsic));
+  auto func = air::ir::MakeAPI(body, "gemm", {a, b, c}, 0, true);
+  auto target = air::Target::Create(kernel.target);
+  auto module = air::build({func}, target, target, air::BuildConfig::Create());
+  return module.GetFunction("gemm", true);
+}
+
+void RunShape(const GemmShape &shape, int repeats) {
+  // Small integers, exact in every input type: float16 and int8 results match the float32 reference exactly.
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dist(-8, 8);
+  std::vector<float> a(shape.m * shape.k);
+  std::vector<float> b(shape.n * shape.k);
+  for (auto &v : a) {
+    v = static_cast<float>(dist(gen));
+  }
+  for (auto &v : b) {
+    v = static_cast<float>(dist(gen));
+  }
+  std::vector<double> expect(shape.n * shape.m, 0.0);
+  for (int64_t j = 0; j < shape.n; ++j) {
+    for (int64_t i = 0; i < shape.m; ++i) {
+      double sum = 0.0;
+      for (int64_t k = 0; k < shape.k; ++k) {
+        sum += static_cast<double>(a[i * shape.k + k]) * b[j * shape.k + k];
+      }
+      expect[j * shape.m + i] = sum;
+    }
+  }
+  double flops = 2.0 * shape.m * shape.n * shape.k;
+
+  printf("%-18s %6ld %6ld %6ld", shape.name, shape.m, shape.n, shape.k);
+  for (const auto &kernel : kKernels) {
+    if (!HostSupports(kernel.host_feature)) {
+      printf(" %12s", "-");
+      continue;
+    }
+    auto gemm = BuildGemm(kernel, shape);
+    auto a_packed = PackInput(a, shape.m, shape.k, kPackA, kernel.input_type);
+    auto b_packed = PackInput(b, shape.n, shape.k, kPackB, kernel.input_type);
+    bool int_output = kernel.output_type == air::Int(32);
+    auto c_type = DLDataType{static_cast<uint8_t>(int_output ? kDLInt : kDLFloat), 32, 1};
+    auto c = NDArray::Empty({shape.n * shape.m}, c_type, DLContext{kDLCPU, 0});
+    memset(c->data, 0, shape.n * shape.m * sizeof(float));
+    gemm(a_packed, b_packed, c);
+    for (size_t i = 0; i < expect.size(); ++i) {
+      double out = int_output ? static_cast<int32_t *>(c->data)[i] : static_cast<float *>(c->data)[i];
+      CHECK_EQ(out, expect[i]) << shape.name << " " << kernel.name << " mismatch at " << i;
+    }
+    double best = 1e30;
+    for (int r = 0; r < repeats; ++r) {
+      auto start = std::chrono::steady_clock::now();
+      gemm(a_packed, b_packed, c);
+      auto end = std::chrono::steady_clock::now();
+      best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    printf(" %12.1f", flops / best * 1e-9);
+  }
+  printf("\n");
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  int repeats = argc > 1 ? atoi(argv[1]) : 20;
+  printf("%-18s %6s %6s %6s", "shape", "m", "n", "k");
+  for (const auto &kernel : kKernels) {
+    printf(" %12s", kernel.name);
+  }
+  printf("\n");
+  for (const auto &shape : kShapes) {
+    RunShape(shape, repeats);
+  }
+  return 0;
+}
@@ -0,0 +1,287 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Run time of the CPU lower tree nodes on reduce + elementwise graphs, built as the flattened irs the CPU emitter
+ * produces for their parts:
+ *   layernorm  rows mean and rstd, then (x - mean) * rstd
+ *   softmax    rows max, exp(x - max), rows sum, then exp / sum
+ * compared as
+ *   split      one kernel per part, the tensors between them in memory
+ *   stitch     StitchFusionCpu, one kernel whose tasks run all parts on their rows
+ *   parallel   both graphs stitched, then two launches against one BlockFusion kernel
+ * Each result is checked against a double reference.
+ *
+ * Usage: stitch_bench [rows] [cols] [repeats]
+ */
+#include <tvm/ir_visitor.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bench_util.h"
+#include "common/target_info.h"
+#include "composite/lower_tree/block_fusion.h"
+#include "composite/lower_tree/stitch_fusion.h"
+
+namespace {
+using air::Expr;
+using air::Stmt;
+using air::Var;
+using air::runtime::PackedFunc;
+using akg::bench::BestSeconds;
+using akg::bench::Build;
+using akg::bench::Call;
+using akg::bench::Load;
+using akg::bench::Loop;
+using akg::bench::Store;
+using akg::bench::Tensor;
+
+constexpr int kRowTile = 4;
+constexpr int kLanes = 8;
+
+struct Graph {
+  const char *name;
+  std::vector<const Tensor *> inputs;
+  std::vector<const Tensor *> outputs;
+  std::vector<const Tensor *> temps;
+  std::vector<Stmt> parts;
+  std::vector<std::vector<const Tensor *>> part_args;
+  std::vector<double> reference;
+};
+
+Tensor *NewTensor(std::vector<std::unique_ptr<Tensor>> &pool, const std::string &name, int64_t size) {
+  pool.emplace_back(new Tensor(akg::bench::NewTensor(name, air::Float(32), size)));
+  return pool.back().get();
+}
+
+Expr Float(double value) { return air::make_const(air::Float(32), value); }
+
+// Rows reduce: a parallel loop over tiles of kRowTile rows, out[row] = combine over cols of value(x[row, col]).
+Stmt RowReduce(const Tensor *out, int rows, int cols, float init,
+               const std::function<Expr(Expr, Expr, Expr)> &combine, const std::function<Expr(Expr)> &finish) {
+  Var p("p", air::Int(32));
+  Var r("r", air::Int(32));
+  Var c("c", air::Int(32));
+  Expr row = p * kRowTile + r;
+  Stmt body = Store(out, combine(Load(out, row), row, row * cols + c), row);
+  body = Loop(c, cols, body);
+  Stmt init_stmt = Store(out, Float(init), row);
+  Stmt finish_stmt = finish ? Store(out, finish(Load(out, row)), row) : air::ir::Evaluate::make(0);
+  body = Loop(r, kRowTile, air::ir::Block::make({init_stmt, body, finish_stmt}));
+  return Loop(p, rows / kRowTile, body, air::ir::ForType::Parallel);
+}
+
+// Flattened elementwise: a parallel loop over blocks of cols elements, out[i] = value(i, i / cols).
+Stmt Elementwise(const Tensor *out, int rows, int cols, const std::function<Expr(Expr, Expr)> &value) {
+  Var o("o", air::Int(32));
+  Var j("j", air::Int(32));
+  Var v("v", air::Int(32));
+  Expr index = o * cols + j * kLanes + v;
+  Stmt body = Store(out, value(index, air::floordiv(index, cols)), index);
+  body = Loop(v, kLanes, body, air::ir::ForType::Vectorized);
+  body = Loop(j, cols / kLanes, body);
+  return Loop(o, rows, body, air::ir::ForType::Parallel);
+}
+
+void BuildLayerNorm(Graph &g, std::vector<std::unique_ptr<Tensor>> &pool, int rows, int cols) {
+  auto x = NewTensor(pool, "ln_x", int64_t{rows} * cols);
+  auto mean = NewTensor(pool, "ln_mean", rows);
+  auto rstd = NewTensor(pool, "ln_rstd", rows);
+  auto out = NewTensor(pool, "ln_out", int64_t{rows} * cols);
+  g.name = "layernorm";
+  g.inputs = {x};
+  g.outputs = {out};
+  g.temps = {mean, rstd};
+  Stmt mean_ir = RowReduce(
+    mean, rows, cols, 0, [&](Expr acc, Expr, Expr i) { return acc + Load(x, i); },
+    [&](Expr acc) { return acc * Float(1.0 / cols); });
+  Stmt rstd_ir = RowReduce(
+    rstd, rows, cols, 0,
+    [&](Expr acc, Expr row, Expr i) {
+      Expr d = Load(x, i) - Load(mean, row);
+      return acc + d * d;
+    },
+    [&](Expr acc) { return Float(1) / air::sqrt(acc * Float(1.0 / cols) + Float(1e-5)); });
+  Stmt out_ir =
+    Elementwise(out, rows, cols, [&](Expr i, Expr row) { return (Load(x, i) - Load(mean, row)) * Load(rstd, row); });
+  g.parts = {mean_ir, rstd_ir, out_ir};
+  g.part_args = {{x, mean}, {x, mean, rstd}, {x, mean, rstd, out}};
+
+  std::mt19937 rng(0);
+  auto data = static_cast<float *>(x->array->data);
+  for (int64_t k = 0; k < int64_t{rows} * cols; ++k) {
+    data[k] = std::uniform_real_distribution<float>(-1.0f, 1.0f)(rng);
+  }
+  g.reference.assign(int64_t{rows} * cols, 0);
+  for (int r = 0; r < rows; ++r) {
+    const float *row = data + int64_t{r} * cols;
+    double m = 0;
+    double s = 0;
+    for (int c = 0; c < cols; ++c) m += row[c];
+    m /= cols;
+    for (int c = 0; c < cols; ++c) s += (row[c] - m) * (row[c] - m);
+    double rs = 1 / std::sqrt(s / cols + 1e-5);
+    for (int c = 0; c < cols; ++c) g.reference[int64_t{r} * cols + c] = (row[c] - m) * rs;
+  }
+}
+
+void BuildSoftmax(Graph &g, std::vector<std::unique_ptr<Tensor>> &pool, int rows, int cols) {
+  auto x = NewTensor(pool, "sm_x", int64_t{rows} * cols);
+  auto max = NewTensor(pool, "sm_max", rows);
+  auto e = NewTensor(pool, "sm_exp", int64_t{rows} * cols);
+  auto sum = NewTensor(pool, "sm_sum", rows);
+  auto out = NewTensor(pool, "sm_out", int64_t{rows} * cols);
+  g.name = "softmax";
+  g.inputs = {x};
+  g.outputs = {out};
+  g.temps = {max, e, sum};
+  Stmt max_ir = RowReduce(
+    max, rows, cols, -INFINITY, [&](Expr acc, Expr, Expr i) { return air::max(acc, Load(x, i)); }, nullptr);
+  Stmt exp_ir = Elementwise(e, rows, cols, [&](Expr i, Expr row) { return air::exp(Load(x, i) - Load(max, row)); });
+  Stmt sum_ir = RowReduce(
+    sum, rows, cols, 0, [&](Expr acc, Expr, Expr i) { return acc + Load(e, i); }, nullptr);
+  Stmt out_ir = Elementwise(out, rows, cols, [&](Expr i, Expr row) { return Load(e, i) / Load(sum, row); });
+  g.parts = {max_ir, exp_ir, sum_ir, out_ir};
+  g.part_args = {{x, max}, {x, max, e}, {e, sum}, {e, sum, out}};
+
+  std::mt19937 rng(1);
+  auto data = static_cast<float *>(x->array->data);
+  for (int64_t k = 0; k < int64_t{rows} * cols; ++k) {
+    data[k] = std::uniform_real_distribution<float>(-8.0f, 8.0f)(rng);
+  }
+  g.reference.assign(int64_t{rows} * cols, 0);
+  for (int r = 0; r < rows; ++r) {
+    const float *row = data + int64_t{r} * cols;
+    double m = *std::max_element(row, row + cols);
+    double s = 0;
+    for (int c = 0; c < cols; ++c) s += std::exp(row[c] - m);
+    for (int c = 0; c < cols; ++c) g.reference[int64_t{r} * cols + c] = std::exp(row[c] - m) / s;
+  }
+}
+
+std::vector<const Tensor *> KernelArgs(const Graph &g) {
+  auto args = g.inputs;
+  args.insert(args.end(), g.outputs.begin(), g.outputs.end());
+  return args;
+}
+
+// One kernel, the tensors between the parts stay in the kernel.
+Stmt Stitch(const Graph &g) {
+  std::unordered_map<std::string, air::NodeRef> outputs2args;
+  std::unordered_map<std::string, air::NodeRef> real_outputs;
+  for (auto t : g.temps) {
+    outputs2args[t->buffer->name] = t->buffer;
+  }
+  for (auto t : g.outputs) {
+    outputs2args[t->buffer->name] = t->buffer;
+    real_outputs[t->buffer->name] = t->buffer;
+  }
+  air::Array<air::NodeRef> args;
+  for (auto t : KernelArgs(g)) {
+    args.push_back(t->buffer);
+  }
+  auto parts = g.parts;
+  return akg::StitchFusionCpu(parts, g.name, outputs2args, real_outputs, args,
+                              air::GetCpuThreadNum(air::GetHostCpuInfo()));
+}
+
+bool IsFused(const Stmt &stmt) {
+  bool fused = false;
+  air::ir::PostOrderVisit(stmt, [&fused](const air::NodeRef &node) {
+    auto loop = node.as<air::ir::For>();
+    fused = fused || (loop != nullptr && loop->loop_var->name_hint == "stitch_idx");
+  });
+  return fused;
+}
+
+void Check(const Graph &g, const char *mode) {
+  akg::bench::CheckClose(*g.outputs[0], g.reference, 1e-4, std::string(g.name) + " " + mode);
+}
+
+void Clear(const Graph &g) {
+  for (auto t : g.outputs) {
+    std::fill_n(static_cast<float *>(t->array->data), t->array->shape[0], 0.0f);
+  }
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  int rows = argc > 1 ? atoi(argv[1]) : 4096;
+  int cols = argc > 2 ? atoi(argv[2]) : 1024;
+  int repeats = argc > 3 ? atoi(argv[3]) : 20;
+  CHECK_EQ(rows % kRowTile, 0);
+  CHECK_EQ(cols % kLanes, 0);
+
+  std::vector<std::unique_ptr<Tensor>> pool;
+  std::vector<Graph> graphs(2);
+  BuildLayerNorm(graphs[0], pool, rows, cols);
+  BuildSoftmax(graphs[1], pool, rows, cols);
+
+  printf("%-11s%12s%12s%8s%10s\n", "graph", "split(ms)", "stitch(ms)", "fused", "speedup");
+  std::vector<Stmt> stitched;
+  std::vector<PackedFunc> stitch_kernels;
+  for (const auto &g : graphs) {
+    std::vector<PackedFunc> part_kernels;
+    for (size_t i = 0; i < g.parts.size(); ++i) {
+      part_kernels.push_back(Build(g.parts[i], std::string(g.name) + "_part" + std::to_string(i), g.part_args[i]));
+    }
+    auto run_split = [&]() {
+      for (size_t i = 0; i < part_kernels.size(); ++i) {
+        Call(part_kernels[i], g.part_args[i]);
+      }
+    };
+    Clear(g);
+    run_split();
+    Check(g, "split");
+    double split = BestSeconds(repeats, run_split);
+
+    stitched.push_back(Stitch(g));
+    stitch_kernels.push_back(Build(stitched.back(), std::string(g.name) + "_stitch", KernelArgs(g)));
+    auto run_stitch = [&]() { Call(stitch_kernels.back(), KernelArgs(g)); };
+    Clear(g);
+    run_stitch();
+    Check(g, "stitch");
+    double stitch = BestSeconds(repeats, run_stitch);
+    printf("%-11s%12.3f%12.3f%8s%9.2fx\n", g.name, split * 1e3, stitch * 1e3, IsFused(stitched.back()) ? "yes" : "no",
+           split / stitch);
+  }
+
+  auto parallel_args = KernelArgs(graphs[0]);
+  auto softmax_args = KernelArgs(graphs[1]);
+  parallel_args.insert(parallel_args.end(), softmax_args.begin(), softmax_args.end());
+  auto parallel_kernel = Build(akg::ir::BlockFusion(stitched, "llvm"), "parallel", parallel_args);
+  auto run_launches = [&]() {
+    for (size_t i = 0; i < graphs.size(); ++i) {
+      Call(stitch_kernels[i], KernelArgs(graphs[i]));
+    }
+  };
+  auto run_parallel = [&]() { Call(parallel_kernel, parallel_args); };
+  for (const auto &g : graphs) Clear(g);
+  run_parallel();
+  for (const auto &g : graphs) Check(g, "parallel");
+  double launches = BestSeconds(repeats, run_launches);
+  double parallel = BestSeconds(repeats, run_parallel);
+  printf("%-11s%12.3f%12.3f%8s%9.2fx\n", "parallel", launches * 1e3, parallel * 1e3, "-", launches / parallel);
+  return 0;
+}
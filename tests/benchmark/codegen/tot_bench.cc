@@ -0,0 +1,180 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Run time of float32 index-driven kernels, built as the flattened irs of the Gather and UnsortedSegmentSum ir
+ * builders:
+ *   embedding  out[j, :] = table[indices[j], :] for lookups rows of a table of vocab x dim, dim 1 being a scalar gather
+ *   segment    out[ids[i], :] += data[i, :] for rows x dim data summed into segments rows
+ * compared as
+ *   serial  the loops of the ir builder
+ *   tot     ScheduleTotLoop, the schedule it chose in the last column
+ * Each result is checked against a double reference.
+ *
+ * Usage: tot_bench [repeats]
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "build_module.h"
+#include "ir_pass.h"
+
+namespace {
+using air::Buffer;
+using air::Expr;
+using air::Stmt;
+using air::Var;
+using akg::bench::BestSeconds;
+using akg::bench::Build;
+using akg::bench::Call;
+using akg::bench::Load;
+using akg::bench::Loop;
+using akg::bench::NewTensor;
+using akg::bench::Store;
+using akg::bench::Tensor;
+
+struct Kernel {
+  std::string name;
+  Stmt ir;
+  std::vector<const Tensor *> args;
+  const Tensor *out;
+  std::vector<double> reference;
+};
+
+// The loops of the Gather ir builder with axis 0.
+Kernel Embedding(const Tensor &table, const Tensor &indices, const Tensor &out, int vocab, int dim, int lookups) {
+  Kernel k{"embedding", Stmt(), {&table, &indices, &out}, &out, {}};
+  Var j("j", air::Int(32));
+  Var c("k", air::Int(32));
+  Expr index = Load(indices, j);
+  Stmt body = air::ir::IfThenElse::make(index >= 0 && index < vocab,
+                                        Store(out, Load(table, index * dim + c), j * dim + c),
+                                        Store(out, air::make_zero(air::Float(32)), j * dim + c));
+  k.ir = dim > 1 ? Loop(j, lookups, Loop(c, dim, body)) : Loop(j, lookups, air::ir::Substitute(body, {{c, 0}}));
+  auto ids = static_cast<const int *>(indices.array->data);
+  auto values = static_cast<const float *>(table.array->data);
+  for (int64_t i = 0; i < static_cast<int64_t>(lookups) * dim; ++i) {
+    k.reference.push_back(values[static_cast<int64_t>(ids[i / dim]) * dim + i % dim]);
+  }
+  return k;
+}
+
+// The loops of the UnsortedSegmentSum ir builder, with out zeroed before.
+Kernel Segment(const Tensor &data, const Tensor &ids, const Tensor &out, int rows, int dim, int segments) {
+  Kernel k{"segment", Stmt(), {&data, &ids, &out}, &out, {}};
+  Var i("i", air::Int(32));
+  Var j("j", air::Int(32));
+  Var e("e", air::Int(32));
+  Expr id = Load(ids, i);
+  Stmt update = Store(out, Load(data, i * dim + j) + Load(out, id * dim + j), id * dim + j);
+  Stmt body = Loop(i, rows, Loop(j, dim, air::ir::IfThenElse::make(id >= 0 && id < segments, update)));
+  k.ir = air::ir::Block::make(Loop(e, segments * dim, Store(out, air::make_zero(air::Float(32)), e)), body);
+  auto id_values = static_cast<const int *>(ids.array->data);
+  auto values = static_cast<const float *>(data.array->data);
+  k.reference.assign(static_cast<size_t>(segments) * dim, 0);
+  for (int64_t r = 0; r < rows; ++r) {
+    for (int64_t c = 0; c < dim; ++c) k.reference[id_values[r] * dim + c] += values[r * dim + c];
+  }
+  return k;
+}
+
+double Run(const Kernel &k, const Stmt &ir, const std::string &mode, int repeats) {
+  auto kernel = Build(ir, k.name + "_" + mode, k.args);
+  auto out = static_cast<float *>(k.out->array->data);
+  std::fill_n(out, k.out->array->shape[0], NAN);
+  Call(kernel, k.args);
+  akg::bench::CheckClose(*k.out, k.reference, 1e-3, k.name + " " + mode);
+  return BestSeconds(repeats, [&]() { Call(kernel, k.args); });
+}
+
+std::string Schedule(const Stmt &ir) {
+  std::string schedule = "serial";
+  air::ir::PostOrderVisit(ir, [&schedule](const air::NodeRef &node) {
+    auto alloc = node.as<air::ir::Allocate>();
+    auto call = node.as<air::ir::Call>();
+    if (alloc != nullptr && alloc->buffer_var->name_hint == "tot_partial") {
+      schedule = "partial";
+    } else if (alloc != nullptr && alloc->buffer_var->name_hint == "tot_order") {
+      schedule = "bucket";
+    } else if (call != nullptr && call->is_intrinsic(air::ir::Call::prefetch)) {
+      schedule = "prefetch";
+    } else if (schedule == "serial" && node.as<air::ir::For>() != nullptr &&
+               node.as<air::ir::For>()->for_type == air::ir::ForType::Parallel) {
+      schedule = "parallel";
+    }
+  });
+  return schedule;
+}
+
+void Bench(const Kernel &k, const std::string &shape, int repeats) {
+  air::Map<air::Tensor, Buffer> binds;
+  for (auto t : k.args) {
+    binds.Set(t->placeholder, t->buffer);
+  }
+  Stmt tot = akg::ir::ScheduleTotLoop(k.ir, binds);
+  double serial = Run(k, k.ir, "serial", repeats);
+  double scheduled = Run(k, tot, "tot", repeats);
+  printf("%-11s%-26s%12.3f%12.3f%9.2fx  %s\n", k.name.c_str(), shape.c_str(), serial * 1e3, scheduled * 1e3,
+         serial / scheduled, Schedule(tot).c_str());
+}
+
+std::string Shape(const std::vector<int> &dims) {
+  std::string s;
+  for (auto d : dims) s += (s.empty() ? "" : "x") + std::to_string(d);
+  return s;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  int repeats = argc > 1 ? atoi(argv[1]) : 20;
+  std::mt19937 rng(0);
+  auto Fill = [&rng](Tensor &t, float lo, float hi) {
+    auto values = static_cast<float *>(t.array->data);
+    for (int64_t i = 0; i < t.array->shape[0]; ++i) values[i] = std::uniform_real_distribution<float>(lo, hi)(rng);
+  };
+  auto Ids = [&rng](Tensor &t, int range) {
+    auto values = static_cast<int *>(t.array->data);
+    for (int64_t i = 0; i < t.array->shape[0]; ++i) values[i] = static_cast<int>(rng() % range);
+  };
+
+  printf("%-11s%-26s%12s%12s%10s  %s\n", "op", "shape", "serial(ms)", "tot(ms)", "speedup", "schedule");
+  // vocab, dim, lookups
+  for (const auto &s : std::vector<std::vector<int>>{{1 << 16, 64, 1 << 16}, {1 << 18, 128, 1 << 15},
+                                                     {1 << 24, 1, 1 << 20}}) {
+    auto table = NewTensor("table", air::Float(32), static_cast<int64_t>(s[0]) * s[1]);
+    auto indices = NewTensor("indices", air::Int(32), s[2]);
+    auto out = NewTensor("out", air::Float(32), static_cast<int64_t>(s[2]) * s[1]);
+    Fill(table, -1, 1);
+    Ids(indices, s[0]);
+    Bench(Embedding(table, indices, out, s[0], s[1], s[2]), Shape(s), repeats);
+  }
+  // rows, dim, segments
+  for (const auto &s : std::vector<std::vector<int>>{{1 << 18, 16, 64}, {1 << 18, 16, 1 << 17},
+                                                     {1 << 16, 128, 1 << 14}}) {
+    auto data = NewTensor("data", air::Float(32), static_cast<int64_t>(s[0]) * s[1]);
+    auto ids = NewTensor("ids", air::Int(32), s[0]);
+    auto out = NewTensor("out", air::Float(32), static_cast<int64_t>(s[2]) * s[1]);
+    Fill(data, -1, 1);
+    Ids(ids, s[2]);
+    Bench(Segment(data, ids, out, s[0], s[1], s[2]), Shape(s), repeats);
+  }
+  return 0;
+}
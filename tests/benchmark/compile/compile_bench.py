@@ -0,0 +1,281 @@
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Compile time of composite kernels. Every json of a directory is built in a fresh process, the fastest of --repeat
+runs is kept, and the results are written as json:
+    wall_ms        the whole composite.build
+    stages         ms per lower stage (BEGIN, POLY, FLATTERN, ...), summed over the sub kernels
+    self_ms        self ms per compile profiler category (pass, poly, backend, ...)
+    peak_rss_mb    peak resident memory of the process, base_rss_mb of it was there before the build
+    poly_heap_mb   the largest heap poly held for one sub kernel
+Kernel and stage times slower than the baseline by more than --threshold and --min-ms, peak memory larger by more
+than --threshold and --min-mb, and kernels that fail to build now, are regressions and make the exit code 1.
+The hooks command builds every json with the debug hooks unset (AKG_REPLACE_POLY_SCHEDULE=0, no DUMP_C_PASS) and set
+(schedule replacement on, DUMP_C_PASS matching no pass), hooks that slow a kernel down the same way are regressions.
+Schedule replacement only lists the dump dir of kernels with a dump_poly_dir attr, so a json without one costs none.
+
+Usage:
+    $ python3 compile_bench.py run <json_dir> [--target llvm|cuda|aicore] [--repeat N] [-o result.json]
+                                              [--baseline base.json] [--threshold 0.1] [--min-ms 5] [--min-mb 16]
+    $ python3 compile_bench.py compare <base.json> <result.json> [--threshold 0.1] [--min-ms 5] [--min-mb 16]
+    $ python3 compile_bench.py hooks <json_dir> [--target llvm|cuda|aicore] [--repeat N] [--threshold 0.1] [--min-ms 5]
+Note:
+    The kernel and poly caches are disabled unless --with-caches is given. Jsons of another process are built for
+    --target, which fails for the ops the target does not support.
+"""
+
+import argparse
+import json
+import logging
+import multiprocessing
+import os
+import platform
+import resource
+import sys
+import tempfile
+import time
+from collections import defaultdict
+
+import akg.tvm as tvm
+from akg import composite
+
+PROCESS = {"llvm": "cpu", "cuda": "cuda", "aicore": "aicore"}
+HOOK_ENVS = {"none": {"AKG_REPLACE_POLY_SCHEDULE": "0", "DUMP_C_PASS": None},
+             "hooks": {"AKG_REPLACE_POLY_SCHEDULE": "1", "DUMP_C_PASS": "compile_bench_no_such_pass"}}
+
+
+def _rss_mb():
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss / 1024
+
+
+def _summarize(events):
+    stages = defaultdict(float)
+    self_ms = defaultdict(float)
+    poly_heap = 0
+    for e in events:
+        if e["ph"] == "X":
+            self_ms[e["cat"]] += e["args"]["self_us"] / 1000
+            if e["cat"] == "stage":
+                stages[e["name"]] += e["dur"] / 1000
+        elif e["ph"] == "C" and e["name"] == "poly.heap_bytes":
+            poly_heap = max(poly_heap, e["args"]["value"])
+    return {"stages": dict(stages), "self_ms": dict(self_ms), "poly_heap_mb": poly_heap / (1 << 20)}
+
+
+def _build(desc, attrs, conn):
+    """Runs in the forked process."""
+    result = {"base_rss_mb": _rss_mb()}
+    try:
+        tvm.get_global_func("akg_compile_profiler_enable")(True)
+        tvm.get_global_func("akg_compile_profiler_reset")()
+        start = time.perf_counter()
+        composite.build(desc, dict(attrs))
+        result["wall_ms"] = (time.perf_counter() - start) * 1000
+        result["peak_rss_mb"] = _rss_mb()
+        with tempfile.TemporaryDirectory() as trace_dir:
+            trace_file = os.path.join(trace_dir, "trace.json")
+            tvm.get_global_func("akg_compile_profiler_dump")(trace_file)
+            with open(trace_file) as f:
+                result.update(_summarize(json.load(f)["traceEvents"]))
+    except Exception as e:  # pylint: disable=broad-except
+        lines = str(e).strip().splitlines()
+        result["error"] = "{}: {}".format(type(e).__name__, lines[-1] if lines else "")
+    conn.send(result)
+    conn.close()
+
+
+def _build_in_process(desc, attrs, timeout):
+    ctx = multiprocessing.get_context("fork")
+    reader, writer = ctx.Pipe(duplex=False)
+    proc = ctx.Process(target=_build, args=(desc, attrs, writer))
+    proc.start()
+    writer.close()
+    result = None
+    if reader.poll(timeout):
+        try:
+            result = reader.recv()
+        except EOFError:
+            # The build crashed.
+            pass
+    proc.join(1 if result is None else None)
+    if proc.is_alive():
+        proc.kill()
+        proc.join()
+    if result is None:
+        result = {"error": "timeout" if proc.exitcode in (None, -9) else "exit code {}".format(proc.exitcode)}
+    return result
+
+
+def _descs(json_dir, target):
+    for file_name in sorted(os.listdir(json_dir)):
+        if not file_name.endswith(".json"):
+            continue
+        with open(os.path.join(json_dir, file_name)) as f:
+            desc = json.load(f)
+        if not isinstance(desc, dict) or "op_desc" not in desc:
+            continue
+        desc["process"] = PROCESS[target]
+        yield file_name, json.dumps(desc)
+
+
+def _best(desc_s, attrs, args):
+    runs = [_build_in_process(desc_s, attrs, args.timeout) for _ in range(args.repeat)]
+    ok = [r for r in runs if "error" not in r]
+    result = min(ok, key=lambda r: r["wall_ms"]) if ok else runs[0]
+    if ok:
+        result["peak_rss_mb"] = max(r["peak_rss_mb"] for r in ok)
+    return result
+
+
+def _set_env(env):
+    for key, value in env.items():
+        if value is None:
+            os.environ.pop(key, None)
+        else:
+            os.environ[key] = value
+
+
+def run(args):
+    if not args.with_caches:
+        os.environ.pop("AKG_KERNEL_CACHE_DIR", None)
+        os.environ.pop("AKG_POLY_CACHE_DIR", None)
+    attrs = {"enable_poly_cache": args.with_caches}
+    kernels = {}
+    for file_name, desc_s in _descs(args.json_dir, args.target):
+        result = _best(desc_s, attrs, args)
+        kernels[file_name] = result
+        logging.info("%-64s %s", file_name, result.get("error") or "%.1f ms" % result["wall_ms"])
+    return {
+        "target": args.target,
+        "host": platform.node(),
+        "time": time.strftime("%Y-%m-%d %H:%M:%S"),
+        "repeat": args.repeat,
+        "total_wall_ms": sum(r.get("wall_ms", 0) for r in kernels.values()),
+        "kernels": kernels,
+    }
+
+
+def compare(base, new, threshold, min_ms, min_mb):
+    """Returns the regressions of new against base as (kernel, metric, base, new) rows."""
+    def _slower(old, cur, floor):
+        return cur - old > floor and cur > old * (1 + threshold)
+
+    regressions = []
+    for name, cur in sorted(new["kernels"].items()):
+        old = base["kernels"].get(name)
+        if old is None or "error" in old:
+            continue
+        if "error" in cur:
+            regressions.append((name, "error", 0, cur["error"]))
+            continue
+        metrics = [("wall_ms", old["wall_ms"], cur["wall_ms"], min_ms)]
+        metrics += [("stage " + s, old["stages"].get(s, 0), v, min_ms) for s, v in sorted(cur["stages"].items())]
+        metrics.append(("peak_rss_mb", old["peak_rss_mb"], cur["peak_rss_mb"], min_mb))
+        metrics.append(("poly_heap_mb", old["poly_heap_mb"], cur["poly_heap_mb"], min_mb))
+        regressions += [(name, m, a, b) for m, a, b, floor in metrics if _slower(a, b, floor)]
+    if _slower(base["total_wall_ms"], new["total_wall_ms"], min_ms):
+        regressions.append(("total", "wall_ms", base["total_wall_ms"], new["total_wall_ms"]))
+    return regressions
+
+
+def hooks(args):
+    """Returns the kernels the debug hooks slow down as (kernel, metric, none, hooks) rows."""
+    os.environ.pop("AKG_KERNEL_CACHE_DIR", None)
+    os.environ.pop("AKG_POLY_CACHE_DIR", None)
+    attrs = {"enable_poly_cache": False}
+    regressions = []
+    totals = defaultdict(float)
+    for file_name, desc_s in _descs(args.json_dir, args.target):
+        results = {}
+        for mode, env in sorted(HOOK_ENVS.items()):
+            _set_env(env)
+            results[mode] = _best(desc_s, attrs, args)
+        none, hooked = results["none"], results["hooks"]
+        if "error" in none or "error" in hooked:
+            logging.info("%-64s %s", file_name, none.get("error") or hooked.get("error"))
+            continue
+        for mode, result in results.items():
+            totals[mode] += result["wall_ms"]
+        logging.info("%-64s none %10.1f ms  hooks %10.1f ms", file_name, none["wall_ms"], hooked["wall_ms"])
+        for metric in ("pass", "poly"):
+            old, cur = none["self_ms"].get(metric, 0), hooked["self_ms"].get(metric, 0)
+            if cur - old > args.min_ms and cur > old * (1 + args.threshold):
+                regressions.append((file_name, "self_ms " + metric, old, cur))
+    logging.info("total none %.1f ms, hooks %.1f ms", totals["none"], totals["hooks"])
+    return regressions
+
+
+def report(regressions):
+    for name, metric, old, cur in regressions:
+        if metric == "error":
+            logging.error("%-64s fails to build: %s", name, cur)
+        else:
+            logging.error("%-64s %-24s %10.1f -> %10.1f (%+.0f%%)", name, metric, old, cur,
+                          (cur - old) / max(old, 1e-9) * 100)
+    logging.info("%d regressions", len(regressions))
+    return 1 if regressions else 0
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Compile time benchmark of composite jsons.")
+    sub = parser.add_subparsers(dest="command")
+    run_parser = sub.add_parser("run")
+    run_parser.add_argument("json_dir")
+    run_parser.add_argument("--target", choices=sorted(PROCESS), default="llvm")
+    run_parser.add_argument("--repeat", type=int, default=1)
+    run_parser.add_argument("--timeout", type=float, default=1800, help="seconds per build")
+    run_parser.add_argument("--with-caches", action="store_true")
+    run_parser.add_argument("-o", "--output", default="compile_bench.json")
+    run_parser.add_argument("--baseline")
+    compare_parser = sub.add_parser("compare")
+    compare_parser.add_argument("baseline")
+    compare_parser.add_argument("result")
+    hooks_parser = sub.add_parser("hooks")
+    hooks_parser.add_argument("json_dir")
+    hooks_parser.add_argument("--target", choices=sorted(PROCESS), default="llvm")
+    hooks_parser.add_argument("--repeat", type=int, default=3)
+    hooks_parser.add_argument("--timeout", type=float, default=1800, help="seconds per build")
+    for p in (run_parser, compare_parser, hooks_parser):
+        p.add_argument("--threshold", type=float, default=0.1, help="relative slowdown that is a regression")
+        p.add_argument("--min-ms", type=float, default=5, help="smaller slowdowns are noise")
+        p.add_argument("--min-mb", type=float, default=16, help="smaller memory growths are noise")
+    args = parser.parse_args(argv)
+    logging.basicConfig(level=logging.INFO, format="%(message)s")
+
+    if args.command == "run":
+        result = run(args)
+        with open(args.output, "w") as f:
+            json.dump(result, f, indent=2, sort_keys=True)
+        logging.info("%d kernels, %.1f ms, written to %s", len(result["kernels"]), result["total_wall_ms"],
+                     args.output)
+        if args.baseline is None:
+            return 0
+        baseline_file = args.baseline
+    elif args.command == "hooks":
+        return report(hooks(args))
+    elif args.command == "compare":
+        with open(args.result) as f:
+            result = json.load(f)
+        baseline_file = args.baseline
+    else:
+        parser.print_help()
+        return 2
+    with open(baseline_file) as f:
+        baseline = json.load(f)
+    return report(compare(baseline, result, args.threshold, args.min_ms, args.min_mb))
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,569 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Execution time and hardware counters of one kernel of a built llvm module, e.g. a .ll of AKG_KERNEL_CACHE_DIR or
+ *   composite.build(desc).save("kernel.ll")
+ * Each run after the warm-up is timed on its own:
+ *   latency      min, median and p99 in us
+ *   GB/s args    bytes of all arguments over the median, each read or written once
+ *   GB/s ir      bytes the kernel loads and stores over the median
+ *   GFLOP/s      float operations over the median
+ * The float operations and bytes of the IR are recorded by the llvm codegen for kernels with constant loop extents
+ * built with the kernel_cost attr, e.g. composite.build(desc, {"kernel_cost": True}). --flops and --bytes override
+ * them, kernels that call the cpu gemm kernels need --flops.
+ *
+ * Counters are read with perf_event_open from every thread of the process, the parallel workers included, while a run
+ * executes and are given per run: cycles, instructions, LLC read misses and, on Intel, packed float instructions
+ * retired (FP_ARITH_INST_RETIRED.*_PACKED). Other cpus can add raw events with --event. Counting user space of the own
+ * threads needs kernel.perf_event_paranoid <= 2. Cycles include the workers waiting at the end of a parallel loop.
+ *
+ * Usage: kernel_bench <module.ll|.so> [--func name] [--desc kernel.json] [--arg dtype:d0xd1...]... [--warmup 10]
+ *                     [--repeat 200] [--flush] [--threads n] [--no-pin] [--flops n] [--bytes n]
+ *                     [--event name=config]... [--json result.json]
+ *   --func     kernel to run, default the op of --desc or the first kernel of a module with the kernel cost
+ *   --arg      arguments in call order, default the input_desc and output_desc of --desc
+ *   --flush    evicts the arguments from the caches before each run
+ *   --threads  threads of the AKG pool (AKG_NUM_THREADS), the workers are bound to their numa node and the main
+ *              thread to the first core unless --no-pin (AKG_THREAD_AFFINITY=0)
+ */
+#include <dmlc/logging.h>
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/packed_func.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/target_info.h"
+#include "picojson.h"
+
+namespace {
+using air::runtime::NDArray;
+using air::runtime::PackedFunc;
+
+// Set in the environment of the process that runs the kernel, after the thread settings.
+constexpr auto kThreadsConfigured = "AKG_KERNEL_BENCH_CONFIGURED";
+
+struct Options {
+  std::string module;
+  std::string func;
+  std::string desc;
+  std::vector<std::string> args;
+  int warmup = 10;
+  int repeat = 200;
+  bool flush = false;
+  int threads = 0;
+  bool pin = true;
+  int64_t flops = -1;
+  int64_t bytes = -1;
+  std::vector<std::string> events;
+  std::string json;
+};
+
+struct Arg {
+  DLDataType dtype;
+  std::vector<int64_t> shape;
+};
+
+int64_t ArgBytes(const NDArray &array) {
+  int64_t size = (array->dtype.bits * array->dtype.lanes + 7) / 8;
+  for (int i = 0; i < array->ndim; ++i) {
+    size *= array->shape[i];
+  }
+  return size;
+}
+
+Arg ParseArg(const std::string &text) {
+  auto colon = text.find(':');
+  CHECK_NE(colon, std::string::npos) << "--arg takes dtype:d0xd1..., got " << text;
+  Arg arg;
+  arg.dtype = air::runtime::String2TVMType(text.substr(0, colon));
+  std::stringstream dims(text.substr(colon + 1));
+  std::string dim;
+  while (std::getline(dims, dim, 'x')) {
+    arg.shape.push_back(std::stoll(dim));
+  }
+  return arg;
+}
+
+Arg ParseTensor(const picojson::value &tensor) {
+  Arg arg;
+  arg.dtype = air::runtime::String2TVMType(tensor.get("data_type").get<std::string>());
+  for (const auto &dim : tensor.get("shape").get<picojson::array>()) {
+    arg.shape.push_back(dim.get<int64_t>());
+  }
+  return arg;
+}
+
+// The inputs and outputs of a composite json, in the order mod_launch passes them. Scalar inputs with a value are
+// folded into the kernel.
+std::vector<Arg> DescArgs(const std::string &file, std::string *op) {
+  std::ifstream in(file);
+  CHECK(in.good()) << "Can not read " << file;
+  picojson::value desc;
+  std::string err = picojson::parse(desc, in);
+  CHECK(err.empty()) << file << ": " << err;
+  std::vector<Arg> args;
+  for (const auto &input : desc.get("input_desc").get<picojson::array>()) {
+    for (const auto &tensor : input.get<picojson::array>()) {
+      if (!tensor.contains("value")) {
+        args.push_back(ParseTensor(tensor));
+      }
+    }
+  }
+  for (const auto &tensor : desc.get("output_desc").get<picojson::array>()) {
+    args.push_back(ParseTensor(tensor));
+  }
+  *op = desc.get("op").get<std::string>();
+  return args;
+}
+
+// Floats in [0.5, 1) and small integers, so that no run hits denormals, infinities or overflows.
+NDArray RandomArray(const Arg &arg, std::mt19937 *rng) {
+  auto array = NDArray::Empty(arg.shape, arg.dtype, {kDLCPU, 0});
+  int width = (arg.dtype.bits + 7) / 8;
+  int64_t size = ArgBytes(array) / width;
+  std::uniform_real_distribution<double> real(0.5, 1.0);
+  for (int64_t k = 0; k < size; ++k) {
+    if (arg.dtype.code == kDLFloat && arg.dtype.bits == 32) {
+      static_cast<float *>(array->data)[k] = static_cast<float>(real(*rng));
+    } else if (arg.dtype.code == kDLFloat && arg.dtype.bits == 64) {
+      static_cast<double *>(array->data)[k] = real(*rng);
+    } else if (arg.dtype.code == kDLFloat && arg.dtype.bits == 16) {
+      static_cast<uint16_t *>(array->data)[k] = static_cast<uint16_t>(0x3800 | ((*rng)() & 0x3ff));
+    } else {
+      int64_t value = static_cast<int64_t>((*rng)() % (arg.dtype.bits == 1 ? 2 : 16));
+      memcpy(static_cast<char *>(array->data) + k * width, &value, width);
+    }
+  }
+  return array;
+}
+
+// Lines of "name flops bytes" the llvm codegen recorded.
+bool KernelCost(air::runtime::Module module, std::string *func, int64_t *flops, int64_t *bytes) {
+  PackedFunc cost_func = module.GetFunction("__akg_kernel_cost", false);
+  if (cost_func == nullptr) {
+    return false;
+  }
+  std::string text = cost_func();
+  std::stringstream lines(text);
+  std::string name;
+  int64_t f = 0;
+  int64_t b = 0;
+  while (lines >> name >> f >> b) {
+    if (func->empty()) {
+      *func = name;
+    }
+    if (name == *func) {
+      *flops = f;
+      *bytes = b;
+      return true;
+    }
+  }
+  return false;
+}
+
+class CacheFlusher {
+ public:
+  explicit CacheFlusher(const std::vector<NDArray> &arrays) : arrays_(arrays) {
+    auto cpu = air::GetHostCpuInfo();
+    line_ = std::max(cpu->cache_line_bytes, 16);
+#if !defined(__x86_64__) && !defined(__i386__)
+    // Twice the caches of all cores, written from this one.
+    int64_t caches = static_cast<int64_t>(cpu->l3_bytes) + static_cast<int64_t>(cpu->l2_bytes) * cpu->core_num;
+    buffer_.resize(static_cast<size_t>(std::max<int64_t>(caches, 1 << 20) * 2));
+#endif
+  }
+
+  void operator()() {
+#if defined(__x86_64__) || defined(__i386__)
+    // clflush evicts a line from the caches of all cores.
+    for (const auto &array : arrays_) {
+      auto data = static_cast<const char *>(array->data);
+      for (int64_t k = 0; k < ArgBytes(array); k += line_) {
+        _mm_clflush(data + k);
+      }
+    }
+    _mm_mfence();
+#else
+    for (size_t k = 0; k < buffer_.size(); k += line_) {
+      buffer_[k] += 1;
+    }
+#endif
+  }
+
+ private:
+  std::vector<NDArray> arrays_;
+  int line_;
+  std::vector<char> buffer_;
+};
+
+struct Event {
+  std::string name;
+  uint32_t type;
+  uint64_t config;
+};
+
+bool IsIntel() {
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(cpuinfo, line)) {
+    if (line.compare(0, 9, "vendor_id") == 0) {
+      return line.find("GenuineIntel") != std::string::npos;
+    }
+  }
+  return false;
+}
+
+std::vector<Event> DefaultEvents() {
+  std::vector<Event> events = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"llc_misses", PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+  };
+  if (IsIntel()) {
+    // FP_ARITH_INST_RETIRED, umask of the 128, 256 and 512 bit packed single and double events.
+    events.push_back({"vector_fp_inst", PERF_TYPE_RAW, 0xfcc7});
+  }
+  return events;
+}
+
+// One group of counters per thread, enabled only while a run executes.
+class Counters {
+ public:
+  explicit Counters(const std::vector<Event> &events) : events_(events), totals_(events.size(), 0) {}
+  ~Counters() {
+    for (auto &group : groups_) {
+      for (int fd : group.fds) {
+        close(fd);
+      }
+    }
+  }
+
+  // Counts the threads that exist now, so call it after the warm-up started the workers.
+  std::string Open() {
+    DIR *tasks = opendir("/proc/self/task");
+    if (tasks == nullptr) {
+      return strerror(errno);
+    }
+    std::string error;
+    while (auto entry = readdir(tasks)) {
+      if (entry->d_name[0] == '.') {
+        continue;
+      }
+      Group group;
+      for (size_t i = 0; i < events_.size(); ++i) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events_[i].type;
+        attr.config = events_[i].config;
+        attr.disabled = group.fds.empty() ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, atoi(entry->d_name), -1,
+                                          group.fds.empty() ? -1 : group.fds[0], 0));
+        if (fd < 0) {
+          if (error.empty()) {
+            error = events_[i].name + ": " + strerror(errno);
+          }
+          continue;
+        }
+        group.fds.push_back(fd);
+        group.events.push_back(i);
+      }
+      if (!group.fds.empty()) {
+        groups_.push_back(group);
+      }
+    }
+    closedir(tasks);
+    return groups_.empty() ? error : "";
+  }
+
+  void Enable() {
+    for (const auto &group : groups_) {
+      ioctl(group.fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+  }
+
+  void Disable() {
+    for (const auto &group : groups_) {
+      ioctl(group.fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+  }
+
+  // Sums over the threads, scaled up when the events had to share the counters.
+  void Read() {
+    for (const auto &group : groups_) {
+      std::vector<uint64_t> values(3 + group.fds.size());
+      if (read(group.fds[0], values.data(), values.size() * sizeof(uint64_t)) <= 0) {
+        continue;
+      }
+      double scale = values[2] > 0 ? static_cast<double>(values[1]) / values[2] : 0;
+      for (size_t i = 0; i < group.events.size(); ++i) {
+        totals_[group.events[i]] += values[3 + i] * scale;
+      }
+    }
+  }
+
+  bool Counted(size_t i) const {
+    return std::any_of(groups_.begin(), groups_.end(), [i](const Group &group) {
+      return std::find(group.events.begin(), group.events.end(), i) != group.events.end();
+    });
+  }
+
+  const std::vector<Event> &events() const { return events_; }
+  const std::vector<double> &totals() const { return totals_; }
+
+ private:
+  struct Group {
+    std::vector<int> fds;
+    std::vector<size_t> events;
+  };
+  std::vector<Event> events_;
+  std::vector<Group> groups_;
+  std::vector<double> totals_;
+};
+
+// The AKG thread pool reads its settings when it is created, so the process is started again with them.
+void ConfigureThreads(const Options &options, char **argv) {
+  if (getenv(kThreadsConfigured) != nullptr) {
+    return;
+  }
+  if (options.threads > 0) {
+    setenv("AKG_NUM_THREADS", std::to_string(options.threads).c_str(), 1);
+  }
+  if (options.pin) {
+    unsetenv("AKG_THREAD_AFFINITY");
+  } else {
+    setenv("AKG_THREAD_AFFINITY", "0", 1);
+  }
+  setenv(kThreadsConfigured, "1", 1);
+  execv("/proc/self/exe", argv);
+  LOG(WARNING) << "Failed to restart with the thread settings: " << strerror(errno);
+}
+
+// Kernels without parallel loops run on the main thread only.
+void PinMainThread() {
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  if (sched_getaffinity(0, sizeof(cpus), &cpus) != 0) {
+    return;
+  }
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &cpus)) {
+      CPU_ZERO(&cpus);
+      CPU_SET(cpu, &cpus);
+      static_cast<void>(sched_setaffinity(0, sizeof(cpus), &cpus));
+      return;
+    }
+  }
+}
+
+// Nan is an unknown IR cost.
+std::string Number(double value, const char *unknown) {
+  if (std::isnan(value)) {
+    return unknown;
+  }
+  char text[32];
+  snprintf(text, sizeof(text), "%.2f", value);
+  return text;
+}
+
+double Percentile(const std::vector<double> &sorted, double p) {
+  auto rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+  return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+Options ParseOptions(int argc, char **argv) {
+  Options options;
+  CHECK_GE(argc, 2) << "Usage: kernel_bench <module.ll|.so> [--func name] [--desc kernel.json] [--arg dtype:shape]...";
+  options.module = argv[1];
+  for (int i = 2; i < argc; ++i) {
+    std::string flag = argv[i];
+    auto value = [&]() -> std::string {
+      CHECK_LT(i + 1, argc) << flag << " needs a value";
+      return argv[++i];
+    };
+    if (flag == "--func") {
+      options.func = value();
+    } else if (flag == "--desc") {
+      options.desc = value();
+    } else if (flag == "--arg") {
+      options.args.push_back(value());
+    } else if (flag == "--warmup") {
+      options.warmup = std::stoi(value());
+    } else if (flag == "--repeat") {
+      options.repeat = std::stoi(value());
+    } else if (flag == "--flush") {
+      options.flush = true;
+    } else if (flag == "--threads") {
+      options.threads = std::stoi(value());
+    } else if (flag == "--no-pin") {
+      options.pin = false;
+    } else if (flag == "--flops") {
+      options.flops = std::stoll(value());
+    } else if (flag == "--bytes") {
+      options.bytes = std::stoll(value());
+    } else if (flag == "--event") {
+      options.events.push_back(value());
+    } else if (flag == "--json") {
+      options.json = value();
+    } else {
+      LOG(FATAL) << "Unknown option " << flag;
+    }
+  }
+  CHECK_GE(options.repeat, 1);
+  return options;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options options = ParseOptions(argc, argv);
+  ConfigureThreads(options, argv);
+  if (options.pin) {
+    PinMainThread();
+  }
+
+  std::vector<Arg> arg_types;
+  if (!options.desc.empty()) {
+    std::string op;
+    arg_types = DescArgs(options.desc, &op);
+    if (options.func.empty()) {
+      options.func = op;
+    }
+  }
+  if (!options.args.empty()) {
+    arg_types.clear();
+    for (const auto &text : options.args) {
+      arg_types.push_back(ParseArg(text));
+    }
+  }
+  CHECK(!arg_types.empty()) << "Give the arguments with --desc or --arg";
+
+  auto module = air::runtime::Module::LoadFromFile(options.module);
+  int64_t flops = -1;
+  int64_t bytes = -1;
+  static_cast<void>(KernelCost(module, &options.func, &flops, &bytes));
+  flops = options.flops >= 0 ? options.flops : flops;
+  bytes = options.bytes >= 0 ? options.bytes : bytes;
+  CHECK(!options.func.empty()) << "Give the kernel with --func";
+  PackedFunc kernel = module.GetFunction(options.func, false);
+  CHECK(kernel != nullptr) << options.func << " is not in " << options.module;
+
+  std::mt19937 rng(0);
+  std::vector<NDArray> arrays;
+  std::vector<TVMValue> values(arg_types.size());
+  std::vector<int> codes(arg_types.size(), kArrayHandle);
+  int64_t arg_bytes = 0;
+  for (size_t i = 0; i < arg_types.size(); ++i) {
+    arrays.push_back(RandomArray(arg_types[i], &rng));
+    values[i].v_handle = const_cast<DLTensor *>(arrays.back().operator->());
+    arg_bytes += ArgBytes(arrays.back());
+  }
+  air::runtime::TVMArgs kernel_args(values.data(), codes.data(), static_cast<int>(values.size()));
+  air::runtime::TVMRetValue rv;
+  auto run = [&]() { kernel.CallPacked(kernel_args, &rv); };
+
+  for (int i = 0; i < options.warmup; ++i) {
+    run();
+  }
+
+  std::vector<Event> events = DefaultEvents();
+  for (const auto &text : options.events) {
+    auto equal = text.find('=');
+    CHECK_NE(equal, std::string::npos) << "--event takes name=config, got " << text;
+    events.push_back({text.substr(0, equal), PERF_TYPE_RAW, std::stoull(text.substr(equal + 1), nullptr, 0)});
+  }
+  Counters counters(events);
+  std::string counter_error = counters.Open();
+
+  CacheFlusher flush(arrays);
+  std::vector<double> latency;
+  for (int i = 0; i < options.repeat; ++i) {
+    if (options.flush) {
+      flush();
+    }
+    counters.Enable();
+    auto start = std::chrono::steady_clock::now();
+    run();
+    auto end = std::chrono::steady_clock::now();
+    counters.Disable();
+    latency.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+  }
+  counters.Read();
+
+  std::sort(latency.begin(), latency.end());
+  double min_us = latency.front();
+  double median_us = Percentile(latency, 0.5);
+  double p99_us = Percentile(latency, 0.99);
+  double args_gbs = arg_bytes / median_us * 1e-3;
+  double ir_gbs = bytes >= 0 ? bytes / median_us * 1e-3 : NAN;
+  double gflops = flops >= 0 ? flops / median_us * 1e-3 : NAN;
+  int threads = air::GetCpuThreadNum(air::GetHostCpuInfo());
+
+  printf("kernel        %s\n", options.func.c_str());
+  printf("runs          %d after %d warm-up, flush %s, %d threads%s\n", options.repeat, options.warmup,
+         options.flush ? "on" : "off", threads, options.pin ? " pinned" : "");
+  printf("latency(us)   min %.2f  median %.2f  p99 %.2f\n", min_us, median_us, p99_us);
+  printf("GB/s          args %.2f  ir %s\n", args_gbs, Number(ir_gbs, "-").c_str());
+  printf("GFLOP/s       %s\n", Number(gflops, "-").c_str());
+  if (!counter_error.empty()) {
+    printf("counters      unavailable, %s\n", counter_error.c_str());
+  }
+  std::stringstream counter_json;
+  for (size_t i = 0; i < counters.events().size(); ++i) {
+    if (!counters.Counted(i)) {
+      continue;
+    }
+    double per_run = counters.totals()[i] / options.repeat;
+    printf("%-14s%.0f per run\n", counters.events()[i].name.c_str(), per_run);
+    counter_json << (counter_json.tellp() > 0 ? ", " : "") << "\"" << counters.events()[i].name << "\": " << per_run;
+  }
+
+  if (!options.json.empty()) {
+    FILE *out = fopen(options.json.c_str(), "w");
+    CHECK(out != nullptr) << "Can not write " << options.json;
+    fprintf(out,
+            "{\"kernel\": \"%s\", \"repeat\": %d, \"flush\": %s, \"min_us\": %f, \"median_us\": %f, \"p99_us\": %f, "
+            "\"args_gbs\": %f, \"ir_gbs\": %s, \"gflops\": %s, \"counters\": {%s}}\n",
+            options.func.c_str(), options.repeat, options.flush ? "true" : "false", min_us, median_us, p99_us, args_gbs,
+            Number(ir_gbs, "null").c_str(), Number(gflops, "null").c_str(), counter_json.str().c_str());
+    fclose(out);
+  }
+  return 0;
+}
@@ -0,0 +1,105 @@
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Latency of a cpu dense layer out[b, n] = sum_k data[b, k] * weight[n, k] with a dynamic batch b over a sweep of batch
+sizes, built as
+    dynamic  the generic kernel of the dynamic shape, with the largest batch as the poly upper bound
+    multi    op_build_multi_version, a kernel specialized to each bucket and the generic one for the other batches
+The buckets are the most frequent batches of a trace of serving calls, whose batch sizes follow a zipf law over
+1 ... max_batch. Each result is checked against numpy.
+
+Usage:
+    $ python3 multi_version_bench.py [--hidden 1024] [--out 1024] [--max-batch 256] [--buckets 8] [--trace 10000]
+                                     [--repeat 100]
+"""
+
+import argparse
+import logging
+import sys
+
+import numpy as np
+import akg.tvm as tvm
+from akg.utils import kernel_exec
+from akg.utils.dynamic_shape import create_dynamic_shape_node, shape_buckets_from_trace
+
+
+def dense(data, weight):
+    k = tvm.reduce_axis((0, data.shape[1]), name="k")
+    return tvm.compute((data.shape[0], weight.shape[0]),
+                       lambda b, n: tvm.sum(data[b, k] * weight[n, k], axis=k), name="dense")
+
+
+def _trace(max_batch, calls, rng):
+    batches = np.arange(1, max_batch + 1)
+    prob = 1.0 / batches
+    return rng.choice(batches, size=calls, p=prob / prob.sum()).tolist()
+
+
+def _sweep(max_batch):
+    batches = set()
+    size = 1
+    while size <= max_batch:
+        batches.update(b for b in (size, size * 3 // 2) if b <= max_batch)
+        size *= 2
+    return sorted(batches)
+
+
+def _run(mod, data, weight, repeat):
+    ctx = tvm.cpu(0)
+    args = [tvm.nd.array(data, ctx), tvm.nd.array(weight, ctx),
+            tvm.nd.empty((data.shape[0], weight.shape[0]), "float32", ctx)]
+    mod(*args)
+    np.testing.assert_allclose(args[-1].asnumpy(), data @ weight.T, rtol=1e-3, atol=1e-3)
+    return mod.time_evaluator(mod.entry_name, ctx, number=repeat)(*args).mean * 1e6
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Latency of shape bucketed multi-version kernels.")
+    parser.add_argument("--hidden", type=int, default=1024)
+    parser.add_argument("--out", type=int, default=1024)
+    parser.add_argument("--max-batch", type=int, default=256)
+    parser.add_argument("--buckets", type=int, default=8)
+    parser.add_argument("--trace", type=int, default=10000, help="calls of the serving trace")
+    parser.add_argument("--repeat", type=int, default=100)
+    args = parser.parse_args(argv)
+    logging.basicConfig(level=logging.INFO, format="%(message)s")
+
+    rng = np.random.RandomState(0)
+    batch = tvm.var("batch")
+    shapes = [(batch, args.hidden), (args.out, args.hidden)]
+    types = ["float32", "float32"]
+    attrs = {"target": "llvm",
+             "dynamic_shape": [create_dynamic_shape_node(batch.name, 0, poly_upper_bound=args.max_batch)]}
+    buckets = shape_buckets_from_trace(_trace(args.max_batch, args.trace, rng), args.buckets)
+    logging.info("buckets %s", [b[0] for b in buckets])
+
+    dynamic = kernel_exec.op_build(dense, shapes, types, kernel_name="dense_dynamic_only", attrs=dict(attrs),
+                                   dump_ir=False, dump_code=False)
+    multi = kernel_exec.op_build_multi_version(dense, shapes, types, buckets, kernel_name="dense", attrs=attrs,
+                                               dump_ir=False)
+
+    weight = rng.uniform(-1, 1, (args.out, args.hidden)).astype("float32")
+    logging.info("%8s%8s%14s%14s%10s", "batch", "bucket", "dynamic(us)", "multi(us)", "speedup")
+    for size in _sweep(args.max_batch):
+        data = rng.uniform(-1, 1, (size, args.hidden)).astype("float32")
+        dynamic_us = _run(dynamic, data, weight, args.repeat)
+        multi_us = _run(multi, data, weight, args.repeat)
+        logging.info("%8d%8s%14.1f%14.1f%9.2fx", size, "yes" if (size,) in buckets else "", dynamic_us, multi_us,
+                     dynamic_us / multi_us)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,162 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Launch overhead of AKGBackendParallelLaunch backends for 1 to 64 tasks:
+ *   akg_pool   work-stealing runtime/thread_pool.cc
+ *   legacy     the former single queue + std::function pool, kept here as the baseline
+ *   openmp     the AKG_USE_OPENMP path
+ *
+ * Usage: thread_pool_bench [iterations] [concurrent_launchers]
+ */
+#include <dmlc/logging.h>
+#include <omp.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <queue>
+#include "runtime/thread_pool.h"
+
+// The benchmark links thread_pool.cc without libakg, which normally provides the log sink.
+void dmlc::CustomLogMessage::Log(const std::string &msg) { fprintf(stderr, "%s\n", msg.c_str()); }
+
+namespace {
+using mindspore::common::Task;
+
+class LegacyThreadPool {
+ public:
+  explicit LegacyThreadPool(size_t max_thread_num) : max_thread_num_(max_thread_num) {}
+  ~LegacyThreadPool() {
+    exit_run_ = true;
+    task_cond_var_.notify_all();
+    for (auto &it : threads_) {
+      it.join();
+    }
+  }
+
+  void SyncRun(const std::vector<Task> &tasks) {
+    if (tasks.size() == 1) {
+      tasks[0]();
+      return;
+    }
+    std::unique_lock<std::mutex> lock(pool_mtx_);
+    size_t task_num = tasks.size();
+    size_t new_thread_num = std::min(max_thread_num_, task_num);
+    for (size_t i = threads_.size(); i < new_thread_num; ++i) {
+      threads_.emplace_back(std::thread(&LegacyThreadPool::SyncRunLoop, this));
+    }
+    for (auto &task : tasks) {
+      std::lock_guard<std::mutex> task_lock(task_mutex_);
+      task_queue_.push(task);
+      task_cond_var_.notify_one();
+    }
+    std::unique_lock<std::mutex> task_lock(task_mutex_);
+    finished_cond_var_.wait(task_lock, [this, task_num] { return task_num == task_finished_count_; });
+    task_finished_count_ = 0;
+  }
+
+ private:
+  void SyncRunLoop() {
+    while (true) {
+      Task task;
+      {
+        std::unique_lock<std::mutex> lock(task_mutex_);
+        task_cond_var_.wait(lock, [this] { return !task_queue_.empty() || exit_run_; });
+        if (exit_run_) {
+          return;
+        }
+        task = task_queue_.front();
+        task_queue_.pop();
+      }
+      task();
+      {
+        std::unique_lock<std::mutex> task_lock(task_mutex_);
+        task_finished_count_ = task_finished_count_ + 1;
+      }
+      finished_cond_var_.notify_one();
+    }
+  }
+
+  size_t max_thread_num_;
+  std::mutex pool_mtx_;
+  std::atomic_bool exit_run_ = {false};
+  std::queue<Task> task_queue_;
+  std::mutex task_mutex_;
+  std::condition_variable task_cond_var_;
+  size_t task_finished_count_{0};
+  std::condition_variable finished_cond_var_;
+  std::vector<std::thread> threads_;
+};
+
+// A small fused elementwise body: each task touches its own cache line sized slice.
+constexpr int kSliceSize = 16;
+float g_data[64 * kSliceSize];
+
+int Lambda(int task_id, int num_task, void *cdata) {
+  auto data = static_cast<float *>(cdata);
+  for (int i = 0; i < kSliceSize; ++i) {
+    data[task_id * kSliceSize + i] += 1.0f;
+  }
+  return 0;
+}
+
+template <typename F>
+double MeasureUs(int iterations, int launchers, F launch) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < launchers; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < iterations; ++i) {
+        launch();
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 10000;
+  int launchers = argc > 2 ? atoi(argv[2]) : 1;
+  auto &pool = mindspore::common::ThreadPool::GetInstance();
+  int max_thread = static_cast<int>(pool.GetSyncRunThreadNum());
+  LegacyThreadPool legacy(max_thread);
+
+  printf("max threads %d, iterations %d, concurrent launchers %d\n", max_thread, iterations, launchers);
+  printf("%8s %14s %14s %14s\n", "tasks", "akg_pool(us)", "legacy(us)", "openmp(us)");
+  for (int num_task = 1; num_task <= 64; num_task *= 2) {
+    int task_num = std::min(num_task, max_thread);
+    double pool_us = MeasureUs(iterations, launchers, [&]() { pool.ParallelLaunch(Lambda, g_data, task_num); });
+    double legacy_us = MeasureUs(iterations, launchers, [&]() {
+      std::vector<Task> tasks;
+      for (int i = 0; i < task_num; ++i) {
+        tasks.emplace_back([i, task_num]() { return Lambda(i, task_num, g_data); });
+      }
+      legacy.SyncRun(tasks);
+    });
+    double omp_us = MeasureUs(iterations, launchers, [&]() {
+#pragma omp parallel num_threads(task_num)
+      { Lambda(omp_get_thread_num(), task_num, g_data); }
+    });
+    printf("%8d %14.2f %14.2f %14.2f\n", num_task, pool_us, legacy_us, omp_us);
+  }
+  return 0;
+}
@@ -52,10 +52,12 @@ from .log_run import log_run
 from .maximum_run import maximum_run
 from .minimum_run import minimum_run
 from .mul_run import mul_run
+from .multi_version_run import multi_version_run
 from .neg_run import neg_run
 from .one_hot_run import one_hot_run
 from .pow_run import pow_run
 from .reciprocal_run import reciprocal_run
+from .reduce_accumulators_run import reduce_accumulators_run
 from .reduce_all_run import reduce_all_run
 from .reduce_and_run import reduce_and_run
 from .reduce_max_run import reduce_max_run
@@ -36,6 +36,9 @@ def exp_run(shape, dtype, attrs={}):
         expect, input, output = gen_data(dtype, shape)
         output = utils.mod_launch(mod, (input, output), expect=expect)
         rtol, atol = get_rtol_atol("exp", dtype)
+        if dtype == "float64":
+            # float64 must not be computed in float32
+            rtol = atol = 1e-10
         if attrs.get("profiling", False):
             target_name = attrs["target"].split()[0]
             args_list = to_tvm_nd_array([input, output], akg.tvm.context(target_name, 0))
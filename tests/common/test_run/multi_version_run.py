@@ -0,0 +1,50 @@
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import numpy as np
+import akg.tvm
+from akg.utils import kernel_exec as utils
+from tests.common.tensorio import compare_tensor
+from tests.common.base import get_rtol_atol
+
+
+def scale_row_sum(data, weight):
+    scaled = akg.tvm.compute(data.shape, lambda b, n: data[b, n] * weight[n], name="scaled")
+    k = akg.tvm.reduce_axis((0, data.shape[1]), name="k")
+    return akg.tvm.compute((data.shape[0],), lambda b: akg.tvm.sum(scaled[b, k], axis=k), name="scale_row_sum")
+
+
+def multi_version_run(cols, buckets, rows, dtype, attrs=None):
+    """
+    Builds scale_row_sum with a dynamic number of rows, a kernel per bucket of rows and the generic one, and runs
+    it with each of rows, in a bucket or not, checked against numpy.
+    """
+    attrs = dict(attrs) if attrs else {}
+    attrs["target"] = utils.LLVM
+    batch = akg.tvm.var("batch")
+    mod = utils.op_build_multi_version(scale_row_sum, [(batch, cols), (cols,)], [dtype, dtype],
+                                       [(b,) for b in buckets], kernel_name="scale_row_sum", attrs=attrs)
+    rtol, atol = get_rtol_atol("reduce_sum", dtype)
+    weight = np.random.uniform(-1, 1, (cols,)).astype(dtype)
+    inputs, outputs, expects = [], [], []
+    result = True
+    for size in rows:
+        data = np.random.uniform(-1, 1, (size, cols)).astype(dtype)
+        expect = (data * weight).sum(axis=1)
+        output = utils.mod_launch(mod, (data, weight, np.full((size,), np.nan, dtype)), expect=expect)
+        result = result and compare_tensor(output, expect, rtol=rtol, atol=atol)
+        inputs.append(data)
+        outputs.append(output)
+        expects.append(expect)
+    return (inputs, weight), outputs, expects, result
@@ -0,0 +1,30 @@
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from tests.common.test_run.reduce_max_run import reduce_max_run
+from tests.common.test_run.reduce_prod_run import reduce_prod_run
+from tests.common.test_run.reduce_sum_run import reduce_sum_run
+
+
+def reduce_accumulators_run(op, shape, axis, accumulators, dtype, attrs=None):
+    """Runs the reduction op ("sum", "max" or "prod") over axis with reduce_accumulators, checked against numpy."""
+    attrs = dict(attrs) if attrs else {}
+    attrs["reduce_accumulators"] = accumulators
+    if op == "sum":
+        return reduce_sum_run(shape, axis, True, dtype, attrs)
+    if op == "max":
+        return reduce_max_run(shape, dtype, axis, True, kernel_name="reduce_max", attrs=attrs)
+    if op == "prod":
+        return reduce_prod_run(shape, dtype, axis, True, attrs=attrs)
+    raise ValueError("Unsupported reduce op {}".format(op))
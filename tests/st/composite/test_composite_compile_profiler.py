@@ -0,0 +1,70 @@
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Compile profiler: per pass times of a composite build, exported as a Chrome trace."""
+
+import os
+import json
+import tempfile
+import pytest
+import akg.tvm as tvm
+from akg import composite
+
+SHAPE = [32, 64]
+
+
+def _tensor(name):
+    return {"data_type": "float32", "format": "DefaultFormat", "shape": SHAPE, "tensor_name": name}
+
+
+def _desc():
+    return json.dumps({
+        "composite": True, "composite_graph": "0", "id": 0, "op": "Fused_compile_profiler_Add",
+        "platform": "AKG", "process": "cpu",
+        "input_desc": [[_tensor("input_0")], [_tensor("input_1")]],
+        "output_desc": [_tensor("output_0_0")],
+        "op_desc": [{"attr": None, "impl_path": "", "name": "Add",
+                     "input_desc": [[dict(_tensor("input_0"), name="x")], [dict(_tensor("input_1"), name="y")]],
+                     "output_desc": [dict(_tensor("output_0_0"), name="output")]}]})
+
+
+@pytest.mark.level1
+@pytest.mark.platform_x86_cpu
+@pytest.mark.env_onecard
+def test_compile_profiler():
+    tvm.get_global_func("akg_compile_profiler_enable")(True)
+    tvm.get_global_func("akg_compile_profiler_reset")()
+    # A cached poly result would skip the poly passes.
+    tvm.get_global_func("akg_poly_cache_reset")()
+    try:
+        composite.build(_desc())
+        summary = tvm.get_global_func("akg_compile_profiler_summary")()
+        assert "LowerCompositeToModule" in summary and "Fused_compile_profiler_Add" in summary
+
+        with tempfile.TemporaryDirectory() as trace_dir:
+            trace_file = os.path.join(trace_dir, "trace.json")
+            assert tvm.get_global_func("akg_compile_profiler_dump")(trace_file)
+            with open(trace_file) as f:
+                events = json.load(f)["traceEvents"]
+        spans = [e for e in events if e["ph"] == "X"]
+        assert {"composite", "lower", "stage", "poly", "pass", "backend"} <= {e["cat"] for e in spans}
+        assert all(e["dur"] >= 0 for e in spans)
+        counters = [e for e in events if e["ph"] == "C"]
+        assert any(e["name"] == "poly.heap_bytes" and e["args"]["value"] >= 0 for e in counters)
+    finally:
+        tvm.get_global_func("akg_compile_profiler_enable")(False)
+
+
+if __name__ == "__main__":
+    test_compile_profiler()
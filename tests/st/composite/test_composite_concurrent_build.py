@@ -0,0 +1,90 @@
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Stress test: lower many composite kernels concurrently in one process and compare with serial builds."""
+
+import json
+import logging
+from concurrent.futures import ThreadPoolExecutor
+import pytest
+from akg import composite
+
+logging.getLogger().setLevel(logging.INFO)
+
+KERNEL_NUM = 100
+THREAD_NUM = 16
+BINARY_OPS = ["Add", "Mul", "Sub", "Maximum", "Minimum"]
+UNARY_OPS = ["Abs", "Neg", "Exp"]
+
+
+def _tensor(name, shape, dtype="float32"):
+    return {"data_type": dtype, "format": "DefaultFormat", "shape": shape, "tensor_name": name}
+
+
+def gen_elemwise_desc(idx):
+    """Distinct elementwise chain: shape and op sequence both depend on idx."""
+    shape = [16 * (1 + idx % 10), 8 * (1 + idx // 10)]
+    inputs = [_tensor("input_0", shape), _tensor("input_1", shape)]
+    op_desc = []
+    cur = "input_0"
+    chain_len = 2 + idx % 3
+    for i in range(chain_len):
+        out = "output_0_0" if i == chain_len - 1 else "t_%d" % i
+        if (idx + i) % 2 == 0:
+            name = BINARY_OPS[(idx + i) % len(BINARY_OPS)]
+            op_inputs = [[dict(_tensor(cur, shape), name="x")], [dict(_tensor("input_1", shape), name="y")]]
+        else:
+            name = UNARY_OPS[(idx + i) % len(UNARY_OPS)]
+            op_inputs = [[dict(_tensor(cur, shape), name="x")]]
+        op_desc.append({"attr": None, "impl_path": "", "input_desc": op_inputs, "name": name,
+                        "output_desc": [dict(_tensor(out, shape), name="output")]})
+        cur = out
+    desc = {"composite": True, "composite_graph": str(idx), "id": idx, "op": "Fused_concurrent_%d" % idx,
+            "platform": "AKG", "process": "cpu", "input_desc": [[t] for t in inputs],
+            "output_desc": [_tensor("output_0_0", shape)], "op_desc": op_desc}
+    return json.dumps(desc)
+
+
+def _build_source(desc):
+    return composite.build(desc, poly=True).get_source()
+
+
+@pytest.mark.level1
+@pytest.mark.platform_x86_cpu
+@pytest.mark.env_onecard
+def test_concurrent_build():
+    descs = [gen_elemwise_desc(i) for i in range(KERNEL_NUM)]
+    serial = [_build_source(desc) for desc in descs]
+    with ThreadPoolExecutor(max_workers=THREAD_NUM) as executor:
+        concurrent = list(executor.map(_build_source, descs))
+    mismatch = [i for i in range(KERNEL_NUM) if serial[i] != concurrent[i]]
+    if mismatch:
+        logging.info("Kernels differ from serial compilation: %s", str(mismatch))
+    assert not mismatch
+
+
+@pytest.mark.level1
+@pytest.mark.platform_x86_cpu
+@pytest.mark.env_onecard
+def test_repeated_build():
+    """Name counters are per compilation, a kernel built again on the same thread gets the same code."""
+    desc = gen_elemwise_desc(7)
+    first = _build_source(desc)
+    _build_source(gen_elemwise_desc(8))
+    assert _build_source(desc) == first
+
+
+if __name__ == "__main__":
+    test_concurrent_build()
+    test_repeated_build()
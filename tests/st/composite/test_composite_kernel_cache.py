@@ -0,0 +1,104 @@
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""On-disk kernel cache: a second build of the same composite json is loaded from AKG_KERNEL_CACHE_DIR."""
+
+import os
+import json
+import tempfile
+import pytest
+import numpy as np
+import akg.tvm as tvm
+from akg import composite
+from akg.utils import kernel_exec as utils
+
+SHAPE = [32, 64]
+
+
+def _tensor(name):
+    return {"data_type": "float32", "format": "DefaultFormat", "shape": SHAPE, "tensor_name": name}
+
+
+def _desc(op_name="Add"):
+    return json.dumps({
+        "composite": True, "composite_graph": "0", "id": 0, "op": "Fused_kernel_cache_" + op_name,
+        "platform": "AKG", "process": "cpu",
+        "input_desc": [[_tensor("input_0")], [_tensor("input_1")]],
+        "output_desc": [_tensor("output_0_0")],
+        "op_desc": [{"attr": None, "impl_path": "", "name": op_name,
+                     "input_desc": [[dict(_tensor("input_0"), name="x")], [dict(_tensor("input_1"), name="y")]],
+                     "output_desc": [dict(_tensor("output_0_0"), name="output")]}]})
+
+
+def _stats():
+    return {k: int(v.value) for k, v in tvm.get_global_func("akg_kernel_cache_stats")().items()}
+
+
+def _run(mod):
+    x = np.random.random(SHAPE).astype("float32")
+    y = np.random.random(SHAPE).astype("float32")
+    out = utils.mod_launch(mod, [x, y, np.zeros(SHAPE, "float32")], [-1])
+    return np.allclose(out, x + y)
+
+
+@pytest.mark.level1
+@pytest.mark.platform_x86_cpu
+@pytest.mark.env_onecard
+def test_kernel_cache():
+    old_dir = os.environ.get("AKG_KERNEL_CACHE_DIR")
+    with tempfile.TemporaryDirectory() as cache_dir:
+        os.environ["AKG_KERNEL_CACHE_DIR"] = cache_dir
+        try:
+            tvm.get_global_func("akg_kernel_cache_reset_stats")()
+            cold = composite.build(_desc())
+            assert _stats()["misses"] == 1 and _stats()["stores"] == 1
+            # The module and its kernel name.
+            assert len(os.listdir(cache_dir)) == 2
+
+            warm = composite.build(_desc())
+            assert _stats()["hits"] == 1
+            assert _run(cold) and _run(warm)
+
+            # A hit dumps the code like a build does.
+            with tempfile.TemporaryDirectory() as meta_dir:
+                os.makedirs(os.path.join(meta_dir, "kernel_meta"))
+                os.environ["MS_COMPILER_CACHE_PATH"] = meta_dir
+                os.environ["MS_DEV_DUMP_CODE"] = "on"
+                composite.build(_desc())
+                assert _stats()["hits"] == 2
+                assert os.path.isfile(os.path.join(meta_dir, "kernel_meta", "Fused_kernel_cache_Add.ll"))
+                os.environ.pop("MS_DEV_DUMP_CODE")
+                os.environ.pop("MS_COMPILER_CACHE_PATH")
+
+            # The build config is part of the key.
+            with tvm.build_config(disable_vectorize=True):
+                composite.build(_desc())
+            assert _stats()["misses"] == 2
+
+            # Another kernel is a miss, a zero sized cache keeps nothing.
+            os.environ["AKG_KERNEL_CACHE_SIZE_MB"] = "0"
+            composite.build(_desc("Mul"))
+            assert _stats()["misses"] == 3
+            assert not os.listdir(cache_dir)
+        finally:
+            for env in ["AKG_KERNEL_CACHE_SIZE_MB", "MS_DEV_DUMP_CODE", "MS_COMPILER_CACHE_PATH"]:
+                os.environ.pop(env, None)
+            if old_dir is None:
+                os.environ.pop("AKG_KERNEL_CACHE_DIR")
+            else:
+                os.environ["AKG_KERNEL_CACHE_DIR"] = old_dir
+
+
+if __name__ == "__main__":
+    test_kernel_cache()
@@ -0,0 +1,95 @@
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Poly compile budget: a cpu kernel whose poly runs out of time is lowered without poly."""
+
+import os
+import json
+import tempfile
+import pytest
+import numpy as np
+import akg.tvm as tvm
+from akg import composite
+from akg.utils import kernel_exec as utils
+
+SHAPE = [32, 64]
+
+
+def _tensor(name):
+    return {"data_type": "float32", "format": "DefaultFormat", "shape": SHAPE, "tensor_name": name}
+
+
+def _desc():
+    return json.dumps({
+        "composite": True, "composite_graph": "0", "id": 0, "op": "Fused_poly_budget_Add",
+        "platform": "AKG", "process": "cpu",
+        "input_desc": [[_tensor("input_0")], [_tensor("input_1")]],
+        "output_desc": [_tensor("output_0_0")],
+        "op_desc": [{"attr": None, "impl_path": "", "name": "Add",
+                     "input_desc": [[dict(_tensor("input_0"), name="x")], [dict(_tensor("input_1"), name="y")]],
+                     "output_desc": [dict(_tensor("output_0_0"), name="output")]}]})
+
+
+def _fallbacks():
+    with tempfile.TemporaryDirectory() as trace_dir:
+        trace_file = os.path.join(trace_dir, "trace.json")
+        assert tvm.get_global_func("akg_compile_profiler_dump")(trace_file)
+        with open(trace_file) as f:
+            events = json.load(f)["traceEvents"]
+    return [e["args"]["value"] for e in events if e["ph"] == "C" and e["name"] == "poly.fallback"]
+
+
+@pytest.mark.level1
+@pytest.mark.platform_x86_cpu
+@pytest.mark.env_onecard
+def test_poly_budget():
+    tvm.get_global_func("akg_compile_profiler_enable")(True)
+    tvm.get_global_func("akg_compile_profiler_reset")()
+    try:
+        # Both the default and the cheap schedule run out of time after building the isl schedule.
+        mod = composite.build(_desc(), {"enable_poly_cache": False, "poly_max_seconds": 1e-6})
+        assert _fallbacks() == [1, 2]
+        x = np.random.random(SHAPE).astype("float32")
+        y = np.random.random(SHAPE).astype("float32")
+        out = utils.mod_launch(mod, [x, y, np.zeros(SHAPE, "float32")], [-1])
+        assert np.allclose(out, x + y)
+
+        tvm.get_global_func("akg_compile_profiler_reset")()
+        composite.build(_desc(), {"enable_poly_cache": False})
+        assert not _fallbacks()
+    finally:
+        tvm.get_global_func("akg_compile_profiler_enable")(False)
+
+
+@pytest.mark.level1
+@pytest.mark.platform_x86_cpu
+@pytest.mark.env_onecard
+def test_poly_budget_not_cached():
+    """A kernel built by a fallback is kept out of the kernel cache, the next build may fit its budget."""
+    stats = tvm.get_global_func("akg_kernel_cache_stats")
+    with tempfile.TemporaryDirectory() as cache_dir:
+        os.environ["AKG_KERNEL_CACHE_DIR"] = cache_dir
+        try:
+            tvm.get_global_func("akg_kernel_cache_reset_stats")()
+            composite.build(_desc(), {"enable_poly_cache": False, "poly_max_seconds": 1e-6})
+            assert stats()["stores"].value == 0
+            composite.build(_desc(), {"enable_poly_cache": False})
+            assert stats()["stores"].value == 1
+        finally:
+            del os.environ["AKG_KERNEL_CACHE_DIR"]
+
+
+if __name__ == "__main__":
+    test_poly_budget()
+    test_poly_budget_not_cached()
@@ -0,0 +1,74 @@
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Poly schedule cache: kernels that only differ in names share one poly result."""
+
+import json
+import pytest
+import numpy as np
+import akg.tvm as tvm
+from akg import composite
+from akg.utils import kernel_exec as utils
+
+SHAPE = [32, 64]
+
+
+def _tensor(name, shape=None):
+    return {"data_type": "float32", "format": "DefaultFormat", "shape": shape or SHAPE, "tensor_name": name}
+
+
+def _desc(kernel, x, y, out, shape=None):
+    return json.dumps({
+        "composite": True, "composite_graph": "0", "id": 0, "op": "Fused_poly_cache_" + kernel,
+        "platform": "AKG", "process": "cpu",
+        "input_desc": [[_tensor(x, shape)], [_tensor(y, shape)]],
+        "output_desc": [_tensor(out, shape)],
+        "op_desc": [{"attr": None, "impl_path": "", "name": "Add",
+                     "input_desc": [[dict(_tensor(x, shape), name="x")], [dict(_tensor(y, shape), name="y")]],
+                     "output_desc": [dict(_tensor(out, shape), name="output")]}]})
+
+
+def _stats():
+    return {k: int(v.value) for k, v in tvm.get_global_func("akg_poly_cache_stats")().items()}
+
+
+def _run(mod, shape=None):
+    shape = shape or SHAPE
+    x = np.random.random(shape).astype("float32")
+    y = np.random.random(shape).astype("float32")
+    out = utils.mod_launch(mod, [x, y, np.zeros(shape, "float32")], [-1])
+    return np.allclose(out, x + y)
+
+
+@pytest.mark.level1
+@pytest.mark.platform_x86_cpu
+@pytest.mark.env_onecard
+def test_poly_cache():
+    tvm.get_global_func("akg_poly_cache_reset")()
+    attrs = {"enable_poly_cache": True}
+    first = composite.build(_desc("a", "input_0", "input_1", "output_0_0"), dict(attrs))
+    assert _stats()["misses"] == 1 and _stats()["stores"] == 1
+
+    # Renumbered tensors reuse the schedule, other shapes and disabled caches do not. The cache is off by default.
+    second = composite.build(_desc("b", "input_3", "input_5", "output_0_2"), dict(attrs))
+    assert _stats()["hits"] == 1
+    other = composite.build(_desc("c", "input_0", "input_1", "output_0_0", [16, 64]), dict(attrs))
+    assert _stats()["misses"] == 2
+    composite.build(_desc("d", "input_0", "input_1", "output_0_0"))
+    assert _stats()["hits"] == 1 and _stats()["misses"] == 2
+    assert _run(first) and _run(second) and _run(other, [16, 64])
+
+
+if __name__ == "__main__":
+    test_poly_cache()
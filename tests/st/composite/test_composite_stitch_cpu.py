@@ -0,0 +1,122 @@
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Cpu composite graphs split by buffer_stitch or parallel_fusion are built into one kernel."""
+
+import json
+import os
+import pytest
+import numpy as np
+from akg import composite
+from akg.utils import kernel_exec as utils
+
+ROWS = 256
+COLS = 128
+
+
+def _tensor(name, shape, arg_name=None):
+    desc = {"data_type": "float32", "format": "DefaultFormat", "shape": shape, "tensor_name": name}
+    if arg_name is not None:
+        desc["name"] = arg_name
+    return desc
+
+
+def _op(name, inputs, output, shape, attr=None):
+    return {"attr": attr, "impl_path": "", "name": name,
+            "input_desc": [[_tensor(t, s, "input_{}".format(i))] for i, (t, s) in enumerate(inputs)],
+            "output_desc": [_tensor(output, shape, "output_0")]}
+
+
+def _reduce_attr():
+    return [{"data_type": "str", "name": "stitch", "value": "common"},
+            {"data_type": "listInt", "name": "axis", "value": [1]},
+            {"data_type": "bool", "name": "keep_dims", "value": True}]
+
+
+def _softmax_desc():
+    full = [ROWS, COLS]
+    row = [ROWS, 1]
+    return json.dumps({
+        "composite": True, "composite_graph": "0", "id": 0, "op": "Fused_ReduceMax_Sub_Exp_ReduceSum_RealDiv_cpu",
+        "platform": "AKG", "process": "cpu",
+        "buffer_stitch": {"stitch_op": [["output_0_1"], ["output_0_4"]]},
+        "input_desc": [[_tensor("input_0", full)]],
+        "output_desc": [_tensor("output_0_5", full)],
+        "op_desc": [
+            _op("ReduceMax", [("input_0", full)], "output_0_1", row, _reduce_attr()),
+            _op("Sub", [("input_0", full), ("output_0_1", row)], "output_0_2", full),
+            _op("Exp", [("output_0_2", full)], "output_0_3", full),
+            _op("ReduceSum", [("output_0_3", full)], "output_0_4", row, _reduce_attr()),
+            _op("RealDiv", [("output_0_3", full), ("output_0_4", row)], "output_0_5", full)]})
+
+
+def _parallel_desc():
+    full = [ROWS, COLS]
+    return json.dumps({
+        "composite": True, "composite_graph": "0", "id": 0, "op": "Fused_Add_Mul_parallel_cpu",
+        "platform": "AKG", "process": "cpu",
+        "parallel_fusion": {"fusion_type": "block_fusion", "type_info": None,
+                            "sub_graph": [["output_0_0"], ["output_0_1"]], "core_num": [1, 1]},
+        "input_desc": [[_tensor("input_0", full)], [_tensor("input_1", full)]],
+        "output_desc": [_tensor("output_0_0", full), _tensor("output_0_1", full)],
+        "op_desc": [
+            _op("Add", [("input_0", full), ("input_1", full)], "output_0_0", full),
+            _op("Mul", [("input_0", full), ("input_1", full)], "output_0_1", full)]})
+
+
+@pytest.mark.level0
+@pytest.mark.platform_x86_cpu
+@pytest.mark.env_onecard
+def test_composite_stitch_cpu():
+    mod = composite.build(_softmax_desc())
+    x = np.random.uniform(-8, 8, [ROWS, COLS]).astype("float32")
+    out = utils.mod_launch(mod, [x, np.zeros([ROWS, COLS], "float32")], [-1])
+    e = np.exp(x - x.max(axis=1, keepdims=True))
+    assert np.allclose(out, e / e.sum(axis=1, keepdims=True), rtol=1e-4, atol=1e-6)
+
+
+@pytest.mark.level0
+@pytest.mark.platform_x86_cpu
+@pytest.mark.env_onecard
+def test_composite_parallel_fusion_cpu():
+    mod = composite.build(_parallel_desc())
+    x = np.random.random([ROWS, COLS]).astype("float32")
+    y = np.random.random([ROWS, COLS]).astype("float32")
+    outs = utils.mod_launch(mod, [x, y, np.zeros([ROWS, COLS], "float32"), np.zeros([ROWS, COLS], "float32")],
+                            [-2, -1])
+    assert np.allclose(outs[0], x + y)
+    assert np.allclose(outs[1], x * y)
+
+
+def _source(desc, compile_threads):
+    os.environ["AKG_COMPILE_THREADS"] = str(compile_threads)
+    try:
+        return composite.build(desc).get_source()
+    finally:
+        del os.environ["AKG_COMPILE_THREADS"]
+
+
+@pytest.mark.level0
+@pytest.mark.platform_x86_cpu
+@pytest.mark.env_onecard
+def test_composite_parallel_compile_cpu():
+    """Children lowered on compile threads merge into the same kernel as children lowered one after another."""
+    for desc in [_softmax_desc(), _parallel_desc()]:
+        assert _source(desc, 4) == _source(desc, 1)
+
+
+if __name__ == "__main__":
+    test_composite_stitch_cpu()
+    test_composite_parallel_fusion_cpu()
+    test_composite_parallel_compile_cpu()
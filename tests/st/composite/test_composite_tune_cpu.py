@@ -0,0 +1,132 @@
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Cpu tuner: the best tiling found is stored in the repository and picked up by the build."""
+
+import os
+import json
+import tempfile
+import pytest
+import numpy as np
+from akg import composite
+from akg.composite.build_module import generate_trait
+from akg.composite.tune_cpu import CpuTuner, tune_cpu, update_repository
+from akg.utils import kernel_exec as utils
+from akg.utils.kernel_exec import ReturnType
+from akg.utils.cost_model import CostModel, evaluate
+
+SHAPE = [256, 512]
+
+
+def _tensor(name):
+    return {"data_type": "float32", "format": "DefaultFormat", "shape": SHAPE, "tensor_name": name}
+
+
+def _desc():
+    return json.dumps({
+        "composite": True, "composite_graph": "0", "id": 0, "op": "Fused_tune_cpu_Add",
+        "platform": "AKG", "process": "cpu",
+        "input_desc": [[_tensor("input_0")], [_tensor("input_1")]],
+        "output_desc": [_tensor("output_0_0")],
+        "op_desc": [{"attr": None, "impl_path": "", "name": "Add",
+                     "input_desc": [[dict(_tensor("input_0"), name="x")], [dict(_tensor("input_1"), name="y")]],
+                     "output_desc": [dict(_tensor("output_0_0"), name="output")]}]})
+
+
+@pytest.mark.level1
+@pytest.mark.platform_x86_cpu
+@pytest.mark.env_onecard
+def test_tune_cpu():
+    desc = _desc()
+    tuner = CpuTuner(desc, trials=6, population=3)
+    tuner.tune()
+    assert tuner.baseline is not None
+    assert 0 < len(tuner.costs) <= 6
+    assert all(c in tuner.space for c in tuner.costs)
+
+    measured = [c for c in tuner.costs if tuner.costs[c] != float("inf")]
+    assert measured
+    best = {"dim": tuner.to_dim(min(measured, key=tuner.costs.get))}
+
+    with tempfile.TemporaryDirectory() as repo_dir:
+        repo_path = os.path.join(repo_dir, "repository_cpu.json")
+        update_repository(repo_path, desc, best)
+        compute, shape, dtype = generate_trait(json.loads(desc))
+        with open(repo_path) as f:
+            assert json.load(f)[compute][shape][dtype] == best
+
+        # The rebuild takes the stored dim, so it lowers like a build given that dim.
+        os.environ["MS_GRAPH_KERNEL_TILING"] = repo_path
+        try:
+            feature = composite.build(desc, {"ret_mode": ReturnType.FEAT})
+            mod = composite.build(desc)
+        finally:
+            del os.environ["MS_GRAPH_KERNEL_TILING"]
+        assert np.array_equal(feature, composite.build(desc, dict(best, ret_mode=ReturnType.FEAT)))
+        x = np.random.random(SHAPE).astype("float32")
+        y = np.random.random(SHAPE).astype("float32")
+        out = utils.mod_launch(mod, [x, y, np.zeros(SHAPE, "float32")], [-1])
+        assert np.allclose(out, x + y)
+
+        # tune_cpu stores what it returns.
+        tuned = tune_cpu(desc, repo_path=repo_path, trials=6, population=3)
+        with open(repo_path) as f:
+            assert json.load(f)[compute][shape][dtype] == (tuned or best)
+
+
+@pytest.mark.level0
+@pytest.mark.platform_x86_cpu
+@pytest.mark.env_onecard
+def test_update_repository_batch_matmul():
+    """Batch matmul dims are looked up under any_shape, so they are stored there."""
+    desc = json.loads(_desc())
+    desc["op_desc"][0]["name"] = "BatchMatMul"
+    desc_s = json.dumps(desc)
+    with tempfile.TemporaryDirectory() as repo_dir:
+        repo_path = os.path.join(repo_dir, "repository_cpu.json")
+        update_repository(repo_path, desc_s, {"dim": "0 0 16 16"})
+        compute, _, dtype = generate_trait(desc)
+        with open(repo_path) as f:
+            assert json.load(f)[compute]["any_shape"][dtype] == {"dim": "0 0 16 16"}
+
+@pytest.mark.level1
+@pytest.mark.platform_x86_cpu
+@pytest.mark.env_onecard
+def test_tune_cpu_cost_model():
+    desc = _desc()
+    tuner = CpuTuner(desc, trials=8, population=4, record=True)
+    tuner.tune()
+    assert tuner.records
+    features = [r[1] for r in tuner.records]
+    costs = [r[2] for r in tuner.records]
+    model = CostModel(num_trees=20, min_leaf=1).fit(features, costs)
+    assert sorted(model.rank(features)) == list(range(len(features)))
+    report = evaluate(model, tuner.records)
+    assert report["records"] == len(costs) and np.isfinite(report["rmse_log"])
+
+    with tempfile.TemporaryDirectory() as model_dir:
+        model_path = os.path.join(model_dir, "cost_model.txt")
+        model.save(model_path)
+        assert np.allclose(CostModel.load(model_path).predict(features), model.predict(features))
+
+    # Only the configs the model ranks first are measured.
+    ranked = CpuTuner(desc, trials=2, cost_model=model, pool_size=8)
+    ranked.tune()
+    assert len(ranked.costs) <= 2
+
+
+if __name__ == "__main__":
+    test_tune_cpu()
+    test_update_repository_batch_matmul()
+    test_tune_cpu_cost_model()
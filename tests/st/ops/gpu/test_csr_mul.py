@@ -46,4 +46,10 @@ class TestCase(TestBase):
     @pytest.mark.platform_x86_gpu_training
     @pytest.mark.env_onecard
     def test_gpu_level0(self):
-        return self.run_cases(self.test_args, utils.CUDA, "level0")
\ No newline at end of file
+        return self.run_cases(self.test_args, utils.CUDA, "level0")
+
+    @pytest.mark.level0
+    @pytest.mark.platform_x86_cpu
+    @pytest.mark.env_onecard
+    def test_cpu_level0(self):
+        return self.run_cases(self.test_args, utils.LLVM, "level0")
\ No newline at end of file
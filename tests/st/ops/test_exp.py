@@ -35,6 +35,11 @@ class TestExp(TestBase):
             # testflag, opfuncname, testRunArgs, dimArgs
             ("exp_02", exp_run, ((64, 2), "float32"), ["level0"]),
         ]
+        self.args_cpu = [
+            # testflag, opfuncname, testRunArgs, dimArgs
+            ("exp_02", exp_run, ((64, 2), "float32"), ["level0"]),
+            ("exp_03", exp_run, ((64, 2), "float64"), ["level0"]),
+        ]
         self.testarg_cloud = [
             # testflag, opfuncname, testRunArgs, dimArgs
             ("exp_01", exp_run, ((64, 2), "float32"), ((64, 64), (2, 2))),
@@ -57,7 +62,7 @@ class TestExp(TestBase):
     @pytest.mark.platform_x86_cpu
     @pytest.mark.env_onecard
     def test_cpu_level0(self):
-        return self.run_cases(self.args_default, utils.LLVM, "level0")
+        return self.run_cases(self.args_cpu, utils.LLVM, "level0")
 
     @pytest.mark.level0
     @pytest.mark.platform_arm_ascend_training
@@ -0,0 +1,47 @@
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+cpu multi-version kernels of a dynamic shape, run with shapes of the buckets and with shapes left to the generic kernel
+"""
+
+import os
+import pytest
+import akg.utils as utils
+from tests.common.base import TestBase
+from tests.common.test_run import multi_version_run
+
+
+class TestCase(TestBase):
+    def setup(self):
+        case_name = "test_multi_version"
+        case_path = os.getcwd()
+        self.params_init(case_name, case_path)
+        self.caseresult = True
+        self._log.info("============= {0} Setup case============".format(self.casename))
+        self.test_args = [
+            # testflag, opfuncname, testRunArgs(cols, buckets, rows, dtype), setdimArgs
+            ("multi_version_001", multi_version_run, (256, (16, 64), (16, 64, 5, 100), "float32"), ["level0"]),
+        ]
+        return True
+
+    @pytest.mark.level0
+    @pytest.mark.platform_x86_cpu
+    @pytest.mark.env_onecard
+    def test_cpu_level0(self):
+        return self.run_cases(self.test_args, utils.LLVM, "level0")
+
+    def teardown(self):
+        self._log.info("============= {0} Teardown============".format(self.casename))
+        return
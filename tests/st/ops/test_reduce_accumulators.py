@@ -0,0 +1,60 @@
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+cpu reductions with 1, 4 and a non power of two number of accumulators
+"""
+
+import os
+import pytest
+import akg.utils as utils
+from tests.common.base import TestBase
+from tests.common.test_run import reduce_accumulators_run
+
+
+class TestCase(TestBase):
+    def setup(self):
+        case_name = "test_reduce_accumulators"
+        case_path = os.getcwd()
+        self.params_init(case_name, case_path)
+        self.caseresult = True
+        self._log.info("============= {0} Setup case============".format(self.casename))
+        self.test_args = []
+        for accumulators in (1, 4, 3):
+            self.test_args += [
+                # testflag, opfuncname, testRunArgs(op, shape, axis, accumulators, dtype), setdimArgs
+                ("reduce_x_sum", reduce_accumulators_run, ("sum", (64, 1031), (1,), accumulators, "float32"),
+                 ["level0"]),
+                ("reduce_x_max", reduce_accumulators_run, ("max", (64, 1031), (1,), accumulators, "float32"),
+                 ["level0"]),
+                ("reduce_x_prod", reduce_accumulators_run, ("prod", (64, 61), (1,), accumulators, "float32"),
+                 ["level0"]),
+                ("all_reduce_sum", reduce_accumulators_run, ("sum", (33, 517), None, accumulators, "float32"),
+                 ["level0"]),
+                ("all_reduce_max", reduce_accumulators_run, ("max", (10247,), None, accumulators, "float32"),
+                 ["level0"]),
+                ("all_reduce_prod", reduce_accumulators_run, ("prod", (96,), None, accumulators, "float32"),
+                 ["level0"]),
+            ]
+        return True
+
+    @pytest.mark.level0
+    @pytest.mark.platform_x86_cpu
+    @pytest.mark.env_onecard
+    def test_cpu_level0(self):
+        return self.run_cases(self.test_args, utils.LLVM, "level0")
+
+    def teardown(self):
+        self._log.info("============= {0} Teardown============".format(self.casename))
+        return
@@ -124,6 +124,12 @@ class TestCase(TestBase):
             ("001_case", transpose_run, ((8, 24, 38, 38), (0, 2, 1, 3), 'float16'), ["level0"]),
         ]
 
+        # One side of these transposes is accessed with a stride of several cache lines along the vectorized axis.
+        self.args_cpu_perf = [
+            ("002_case", transpose_run, ((1024, 1024), (1, 0), 'float32'), ["level1"]),
+            ("003_case", transpose_run, ((64, 12, 128, 64), (0, 2, 3, 1), 'float32'), ["level1"]),
+        ]
+
         return True
 
     def teardown(self):
@@ -151,4 +157,10 @@ class TestCase(TestBase):
     @pytest.mark.platform_x86_cpu
     @pytest.mark.env_onecard
     def test_cpu_level0(self):
-        return self.run_cases(self.args_outhers, utils.LLVM, "level0")
\ No newline at end of file
+        assert self.run_cases(self.args_outhers, utils.LLVM, "level0")
+
+    @pytest.mark.level1
+    @pytest.mark.platform_x86_cpu
+    @pytest.mark.env_onecard
+    def test_cpu_level1_profiling(self):
+        assert self.run_cases(self.args_cpu_perf, utils.LLVM, "level1", profiling=True)
\ No newline at end of file
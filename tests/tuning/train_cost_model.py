@@ -0,0 +1,33 @@
+import json
+import argparse
+import logging
+
+from akg.utils.cost_model import CostModel, load_records, split_records, evaluate
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Train the tiling cost model on records of tune_cpu_with_akg.py")
+    parser.add_argument("records", type=str, nargs="+", help="json lines files of measured configs")
+    parser.add_argument("-o", "--output", type=str, default="cost_model.txt", help="the model file to save")
+    parser.add_argument("-ho", "--held_out", type=float, default=0.2, help="ratio of kernels held out for the report")
+    parser.add_argument("-k", "--top_k", type=int, default=8, help="k of the top k recall in the report")
+    parser.add_argument("-t", "--trees", type=int, default=200, help="number of trees")
+    parser.add_argument("-md", "--max_depth", type=int, default=6, help="depth of each tree")
+    parser.add_argument("-lr", "--learning_rate", type=float, default=0.1, help="shrinkage of each tree")
+    args = parser.parse_args()
+
+    logging.getLogger().setLevel(logging.INFO)
+    records = []
+    for path in args.records:
+        records.extend(load_records(path))
+    train, test = split_records(records, args.held_out)
+
+    def fit(rs):
+        return CostModel(args.trees, args.max_depth, learning_rate=args.learning_rate).fit(
+            [r[1] for r in rs], [r[2] for r in rs])
+
+    if test:
+        report = evaluate(fit(train), test, args.top_k)
+        logging.info("Held out kernels: %s", json.dumps(report, indent=4))
+    # The saved model learns from all records.
+    fit(records).save(args.output)
+    logging.info("Saved the model of %d records to %s", len(records), args.output)
@@ -0,0 +1,51 @@
+import os
+import glob
+import argparse
+import logging
+
+from akg.composite.tune_cpu import CpuTuner, update_repository
+from akg.composite.build_module import get_repository_file_path
+from akg.utils.cost_model import CostModel, save_records
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Tune the tiling of cpu composite kernels on this machine")
+    parser.add_argument("-d", "--info_dir", type=str, default="", help="info files dir")
+    parser.add_argument("-f", "--file", type=str, default="", help="info file name")
+    parser.add_argument("-r", "--repo_path", type=str, default=None,
+                        help="the repository to update, MS_GRAPH_KERNEL_TILING or repository_cpu.json by default")
+    parser.add_argument("-tr", "--trials", type=int, default=64, help="number of configs to measure per kernel")
+    parser.add_argument("-s", "--seconds", type=float, default=600, help="tuning time limit per kernel")
+    parser.add_argument("-p", "--population", type=int, default=8, help="number of parents of the search")
+    parser.add_argument("-cm", "--cost_model", type=str, default=None,
+                        help="cost model file, only the configs it ranks first are measured")
+    parser.add_argument("-ps", "--pool_size", type=int, default=1024, help="number of configs the cost model ranks")
+    parser.add_argument("-rec", "--records", type=str, default=None,
+                        help="json lines file to append the features and run times of the measured configs to")
+    args = parser.parse_args()
+
+    logging.getLogger().setLevel(logging.INFO)
+    if args.file != "":
+        all_files = [os.path.split(os.path.abspath(args.file))]
+    else:
+        all_files = []
+        # tune_with_akg.py needs auto_tune, so its file walk is not shared.
+        for d in args.info_dir.split(","):
+            infos = glob.glob(os.path.join(d, "**", "*.info"), recursive=True)
+            all_files.extend(os.path.split(os.path.abspath(f)) for f in sorted(infos)
+                             if "parallel" not in os.path.basename(f))
+    repo_path = args.repo_path or os.getenv("MS_GRAPH_KERNEL_TILING") or \
+        get_repository_file_path("repository_cpu.json")
+    cost_model = CostModel.load(args.cost_model) if args.cost_model else None
+
+    for i, (path, info_file) in enumerate(all_files):
+        logging.info("Begin tune No.%d/%d files: [%s]", i + 1, len(all_files), info_file)
+        with open(os.path.join(path, info_file), "r") as f:
+            desc = f.read()
+        tuner = CpuTuner(desc, trials=args.trials, time_limit=args.seconds, population=args.population,
+                         cost_model=cost_model, pool_size=args.pool_size, record=args.records is not None)
+        best_config = tuner.tune()
+        if best_config:
+            update_repository(repo_path, desc, best_config)
+        if args.records:
+            save_records(args.records, tuner.records)
+        logging.info("FILE %s, BEST CONFIG = %s", info_file, best_config or "auto tiling")
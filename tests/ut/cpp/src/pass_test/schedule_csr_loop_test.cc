@@ -0,0 +1,321 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <tvm/build_module.h>
+#include <tvm/buffer.h>
+#include <tvm/ir.h>
+#include <tvm/ir_mutator.h>
+#include <tvm/ir_pass.h>
+#include <tvm/operation.h>
+#include <tvm/runtime/ndarray.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "build_module.h"
+#include "ir_pass.h"
+
+namespace akg {
+using air::ir::Add;
+using air::ir::For;
+using air::ir::ForType;
+using air::ir::Load;
+using air::ir::Store;
+
+// Empty rows at the front, in the middle and at the end, and one row with most of the nonzeros.
+const std::vector<int> kRowNnz = {0, 0, 0, 5, 1000, 3, 3, 0, 0, 0, 0, 7, 1, 2, 9, 8, 0, 4, 4, 4, 11, 0, 0,
+                                  6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 0, 0, 0};
+
+class ScheduleCsrLoopTest : public testing::Test {
+ public:
+  ScheduleCsrLoopTest() = default;
+  ~ScheduleCsrLoopTest() = default;
+
+  void SetUp() override {
+    saved_attrs_ = g_attrs;
+    g_attrs.Set("cpu_info", air::ir::StringImm::make("cores=4,simd=32,l2=256K,l3=8M"));
+  }
+  void TearDown() override { g_attrs = saved_attrs_; }
+
+  air::Buffer Buffer(const std::string &name, int64_t size, air::DataType type = air::Float(32)) {
+    auto buffer = air::decl_buffer({air::Expr(static_cast<int>(size))}, type, name);
+    buffers_.push_back(buffer);
+    return buffer;
+  }
+
+  static air::Stmt Loop(const air::Var &var, const air::Expr &extent, const air::Stmt &body) {
+    return For::make(var, 0, extent, ForType::Serial, air::ir::DeviceAPI::None, body);
+  }
+
+  static air::Expr Ld(const air::Buffer &buffer, const air::Expr &index) {
+    return Load::make(buffer->dtype, buffer->data, index, air::const_true());
+  }
+
+  static air::Stmt St(const air::Buffer &buffer, const air::Expr &value, const air::Expr &index) {
+    return Store::make(buffer->data, value, index, air::const_true());
+  }
+
+  // The flattened loop nest of a csr kernel, body(nonzero) runs for the nonzeros of each row.
+  template <typename F>
+  air::Stmt Rows(F &&body) {
+    int rows = static_cast<int>(*air::as_const_int(indptr_->shape[0])) - 1;
+    row_ = air::Var("row");
+    air::Var idx("idx");
+    air::Expr begin = Ld(indptr_, row_);
+    air::Expr end = Ld(indptr_, row_ + 1);
+    return Loop(row_, rows, Loop(idx, end - begin, body(begin + idx, begin + idx < end)));
+  }
+
+  // out[row] = sum of data over the nonzeros of row, guarded the way the csr ops are lowered.
+  air::Stmt ReduceSum(int rows, int64_t nnz) {
+    indptr_ = Buffer("indptr", rows + 1, air::Int(32));
+    out_ = Buffer("out", rows);
+    data_ = Buffer("data", nnz);
+    auto stmt = Rows([this](const air::Expr &k, const air::Expr &guard) {
+      auto value = air::ir::Select::make(guard, Ld(data_, k), air::make_zero(air::Float(32)));
+      return St(out_, Add::make(value, Ld(out_, row_)), row_);
+    });
+    auto loop = stmt.as<For>();
+    return For::make(loop->loop_var, loop->min, loop->extent, loop->for_type, loop->device_api,
+                     air::ir::Block::make(St(out_, air::make_zero(air::Float(32)), row_), loop->body));
+  }
+
+  // out[k] = data[k] * 2 over the nonzeros k.
+  air::Stmt Elementwise(int rows, int64_t nnz) {
+    indptr_ = Buffer("indptr", rows + 1, air::Int(32));
+    out_ = Buffer("out", nnz);
+    data_ = Buffer("data", nnz);
+    return Rows([this](const air::Expr &k, const air::Expr &) {
+      return St(out_, Ld(data_, k) * air::make_const(air::Float(32), 2), k);
+    });
+  }
+
+  // out[col[k]] += data[k] over the nonzeros k.
+  air::Stmt Scatter(int rows, int64_t nnz, int cols) {
+    indptr_ = Buffer("indptr", rows + 1, air::Int(32));
+    out_ = Buffer("out", cols);
+    data_ = Buffer("data", nnz);
+    auto col = Buffer("col", nnz, air::Int(32));
+    return Rows([this, col](const air::Expr &k, const air::Expr &) {
+      air::Expr dst = Ld(col, k);
+      return St(out_, Add::make(Ld(out_, dst), Ld(data_, k)), dst);
+    });
+  }
+
+  // The loops by var name and the names of the allocated buffers.
+  static std::map<std::string, const For *> Loops(const air::Stmt &stmt, std::set<std::string> *allocs = nullptr) {
+    std::map<std::string, const For *> loops;
+    air::ir::PostOrderVisit(stmt, [&loops, allocs](const air::NodeRef &node) {
+      if (auto op = node.as<For>()) {
+        loops[op->loop_var->name_hint] = op;
+      } else if (auto op = node.as<air::ir::Allocate>()) {
+        if (allocs != nullptr) {
+          allocs->insert(op->buffer_var->name_hint);
+        }
+      }
+    });
+    return loops;
+  }
+
+  // Builds stmt as an llvm kernel over the buffers, in the order they were declared.
+  air::runtime::PackedFunc Build(const air::Stmt &stmt, const std::string &name) {
+    air::Array<air::NodeRef> args;
+    for (const auto &buffer : buffers_) {
+      args.push_back(buffer);
+    }
+    auto func = air::ir::MakeAPI(air::ir::Simplify(air::ir::VectorizeLoop(stmt)), name, args, 0, true);
+    auto target = air::Target::Create("llvm");
+    module_ = air::build({func}, target, target, air::BuildConfig::Create());
+    return module_.GetFunction(name, true);
+  }
+
+  static air::runtime::NDArray Array(const std::vector<int> &values) {
+    auto array = air::runtime::NDArray::Empty({static_cast<int64_t>(values.size())}, {kDLInt, 32, 1}, {kDLCPU, 0});
+    std::copy(values.begin(), values.end(), static_cast<int *>(array->data));
+    return array;
+  }
+
+  static std::vector<int> Indptr() {
+    std::vector<int> indptr = {0};
+    for (auto nnz : kRowNnz) {
+      indptr.push_back(indptr.back() + nnz);
+    }
+    return indptr;
+  }
+
+  AttrMap saved_attrs_;
+  std::vector<air::Buffer> buffers_;
+  air::Buffer indptr_, out_, data_;
+  air::Var row_;
+  air::runtime::Module module_;
+};
+
+// Replaces the body of the row loop by a record of the task that runs each row.
+class RowOwner : public air::ir::IRMutator {
+ public:
+  RowOwner(const air::Var &row, const air::Buffer &hits, const air::Buffer &owner)
+      : row_(row), hits_(hits), owner_(owner) {}
+
+  air::Stmt Mutate_(const For *op, const air::Stmt &s) final {
+    if (op->loop_var->name_hint == "csr_task") {
+      task_ = op->loop_var;
+    } else if (op->loop_var.same_as(row_)) {
+      CHECK(task_.defined());
+      auto hit = Load::make(air::Int(32), hits_->data, row_, air::const_true()) + 1;
+      auto body = air::ir::Block::make(Store::make(hits_->data, hit, row_, air::const_true()),
+                                       Store::make(owner_->data, task_, row_, air::const_true()));
+      return For::make(op->loop_var, op->min, op->extent, op->for_type, op->device_api, body);
+    }
+    return IRMutator::Mutate_(op, s);
+  }
+
+ private:
+  air::Var row_;
+  air::Buffer hits_;
+  air::Buffer owner_;
+  air::Var task_;
+};
+
+TEST_F(ScheduleCsrLoopTest, ReduceRowsBalanced) {
+  std::set<std::string> allocs;
+  auto stmt = ir::ScheduleCsrLoop(ReduceSum(1024, 1 << 16));
+  auto loops = Loops(stmt, &allocs);
+  EXPECT_EQ(allocs, std::set<std::string>({"csr_rows", "csr_acc"}));
+  ASSERT_TRUE(loops.count("csr_task"));
+  EXPECT_EQ(loops["csr_task"]->for_type, ForType::Parallel);
+  EXPECT_TRUE(air::ir::Equal(loops["csr_task"]->extent, 16));
+  EXPECT_EQ(loops["row"]->for_type, ForType::Serial);
+  EXPECT_EQ(loops["csr_step"]->for_type, ForType::Serial);
+  // 2^11 > 1024 rows, the binary search needs eleven steps.
+  EXPECT_TRUE(air::ir::Equal(loops["csr_step"]->extent, 11));
+}
+
+TEST_F(ScheduleCsrLoopTest, TaskBoundsEmptyAndSkewedRows) {
+  int rows = static_cast<int>(kRowNnz.size());
+  auto indptr = Indptr();
+  auto stmt = ir::ScheduleCsrLoop(ReduceSum(rows, indptr.back()));
+  auto hits = Buffer("hits", rows, air::Int(32));
+  auto owner = Buffer("owner", rows, air::Int(32));
+  auto kernel = Build(RowOwner(row_, hits, owner).Mutate(stmt), "csr_owner");
+  ASSERT_NE(kernel, nullptr);
+
+  auto out = air::runtime::NDArray::Empty({rows}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  auto data = air::runtime::NDArray::Empty({indptr.back()}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  auto hits_array = Array(std::vector<int>(rows, 0));
+  auto owner_array = Array(std::vector<int>(rows, -1));
+  kernel(Array(indptr), out, data, hits_array, owner_array);
+
+  // Every row runs once, the tasks take consecutive rows, and the nonzeros of a task before its last row are at
+  // most its share.
+  auto hit = static_cast<const int *>(hits_array->data);
+  auto task = static_cast<const int *>(owner_array->data);
+  int tasks = 16;
+  int share = (indptr.back() + tasks - 1) / tasks;
+  std::vector<int> first(tasks, -1), last(tasks, -1);
+  for (int row = 0; row < rows; ++row) {
+    EXPECT_EQ(hit[row], 1) << "row " << row;
+    ASSERT_GE(task[row], 0);
+    ASSERT_LT(task[row], tasks);
+    EXPECT_GE(task[row], row > 0 ? task[row - 1] : 0) << "row " << row;
+    first[task[row]] = first[task[row]] < 0 ? row : first[task[row]];
+    last[task[row]] = row;
+  }
+  for (int t = 0; t < tasks; ++t) {
+    if (first[t] >= 0) {
+      EXPECT_LE(indptr[last[t]] - indptr[first[t]], share) << "task " << t;
+    }
+  }
+  // The skewed row ends its task, the next tasks whose share falls in it are empty.
+  int skewed = static_cast<int>(std::max_element(kRowNnz.begin(), kRowNnz.end()) - kRowNnz.begin());
+  EXPECT_EQ(last[task[skewed]], skewed);
+  EXPECT_EQ(first[task[skewed] + 1], -1);
+  EXPECT_GT(std::count(first.begin(), first.end(), -1), 0);
+}
+
+TEST_F(ScheduleCsrLoopTest, ReduceSumSkewedRows) {
+  int rows = static_cast<int>(kRowNnz.size());
+  auto indptr = Indptr();
+  auto kernel = Build(ir::ScheduleCsrLoop(ReduceSum(rows, indptr.back())), "csr_reduce_sum");
+  ASSERT_NE(kernel, nullptr);
+
+  auto out = air::runtime::NDArray::Empty({rows}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  auto data = air::runtime::NDArray::Empty({indptr.back()}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  auto values = static_cast<float *>(data->data);
+  for (int k = 0; k < indptr.back(); ++k) {
+    values[k] = static_cast<float>(k % 13) - 6.0f;
+  }
+  kernel(Array(indptr), out, data);
+
+  auto result = static_cast<const float *>(out->data);
+  for (int row = 0; row < rows; ++row) {
+    double expect = 0;
+    for (int k = indptr[row]; k < indptr[row + 1]; ++k) {
+      expect += values[k];
+    }
+    EXPECT_NEAR(result[row], expect, 1e-3) << "row " << row;
+  }
+}
+
+TEST_F(ScheduleCsrLoopTest, ElementwiseVectorAndTail) {
+  std::set<std::string> allocs;
+  auto stmt = ir::ScheduleCsrLoop(Elementwise(1024, 1 << 16));
+  auto loops = Loops(stmt, &allocs);
+  EXPECT_EQ(allocs, std::set<std::string>({"csr_rows"}));
+  EXPECT_EQ(loops["csr_task"]->for_type, ForType::Parallel);
+  // Eight float lanes of 32 bytes, the remainder of each row runs in the scalar tail.
+  ASSERT_TRUE(loops.count("idx.outer") && loops.count("idx.inner") && loops.count("idx.tail"));
+  EXPECT_EQ(loops["idx.outer"]->for_type, ForType::Serial);
+  EXPECT_EQ(loops["idx.inner"]->for_type, ForType::Vectorized);
+  EXPECT_TRUE(air::ir::Equal(loops["idx.inner"]->extent, 8));
+  EXPECT_EQ(loops["idx.tail"]->for_type, ForType::Serial);
+  EXPECT_FALSE(loops.count("idx"));
+}
+
+TEST_F(ScheduleCsrLoopTest, ReduceLaneAccumulator) {
+  auto stmt = ir::ScheduleCsrLoop(ReduceSum(1024, 1 << 16));
+  auto loops = Loops(stmt);
+  EXPECT_EQ(loops["csr_lane"]->for_type, ForType::Vectorized);
+  EXPECT_EQ(loops["idx.inner"]->for_type, ForType::Vectorized);
+  EXPECT_EQ(loops["idx.tail"]->for_type, ForType::Serial);
+  // One accumulator per lane, in local storage.
+  const air::ir::Allocate *acc = nullptr;
+  air::ir::PostOrderVisit(stmt, [&acc](const air::NodeRef &node) {
+    auto op = node.as<air::ir::Allocate>();
+    if (op != nullptr && op->buffer_var->name_hint == "csr_acc") {
+      acc = op;
+    }
+  });
+  ASSERT_NE(acc, nullptr);
+  ASSERT_EQ(acc->extents.size(), 1U);
+  EXPECT_TRUE(air::ir::Equal(acc->extents[0], 8));
+  EXPECT_EQ(acc->type, air::Float(32));
+}
+
+TEST_F(ScheduleCsrLoopTest, ScatterRowsSerial) {
+  std::set<std::string> allocs;
+  auto stmt = ir::ScheduleCsrLoop(Scatter(1024, 1 << 16, 512));
+  auto loops = Loops(stmt, &allocs);
+  EXPECT_TRUE(allocs.empty());
+  EXPECT_FALSE(loops.count("csr_task"));
+  ASSERT_TRUE(loops.count("row"));
+  EXPECT_EQ(loops["row"]->for_type, ForType::Serial);
+  // A scatter neither writes the nonzeros element-wise nor accumulates into one element.
+  EXPECT_TRUE(loops.count("idx"));
+  EXPECT_FALSE(loops.count("idx.inner"));
+}
+}  // namespace akg
@@ -0,0 +1,154 @@
+/**
+ * Copyright 2021 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <tvm/buffer.h>
+#include <tvm/ir.h>
+#include <tvm/ir_pass.h>
+#include <tvm/operation.h>
+#include <map>
+#include <set>
+#include <string>
+#include "build_module.h"
+#include "ir_pass.h"
+
+namespace akg {
+using air::ir::Add;
+using air::ir::For;
+using air::ir::ForType;
+using air::ir::Load;
+using air::ir::Mul;
+using air::ir::Store;
+
+class ScheduleTotLoopTest : public testing::Test {
+ public:
+  ScheduleTotLoopTest() = default;
+  ~ScheduleTotLoopTest() = default;
+
+  void SetUp() override {
+    saved_attrs_ = g_attrs;
+    SetCores(4);
+  }
+  void TearDown() override { g_attrs = saved_attrs_; }
+
+  void SetCores(int cores) {
+    g_attrs.Set("cpu_info", air::ir::StringImm::make("cores=" + std::to_string(cores) + ",simd=32,l2=256K,l3=8M"));
+  }
+
+  air::Var Buffer(const std::string &name, int64_t size, air::DataType type = air::Float(32)) {
+    auto tensor = air::placeholder({air::Expr(static_cast<int>(size))}, type, name);
+    auto buffer = air::decl_buffer(tensor->shape, type, name);
+    binds_.Set(tensor, buffer);
+    return buffer->data;
+  }
+
+  static air::Stmt Loop(const air::Var &var, int extent, const air::Stmt &body) {
+    return For::make(var, 0, extent, ForType::Serial, air::ir::DeviceAPI::None, body);
+  }
+
+  static air::Expr Ld(const air::Var &buffer, const air::Expr &index, air::DataType type = air::Float(32)) {
+    return Load::make(type, buffer, index, air::const_true());
+  }
+
+  static air::Stmt St(const air::Var &buffer, const air::Expr &value, const air::Expr &index) {
+    return Store::make(buffer, value, index, air::const_true());
+  }
+
+  // out[i * row + j] = table[idx[i] * row + j]
+  air::Stmt Gather(int rows, int row) {
+    auto out = Buffer("out", static_cast<int64_t>(rows) * row);
+    auto table = Buffer("table", 1024 * row);
+    auto idx = Buffer("idx", rows, air::Int(32));
+    air::Var i("i"), j("j");
+    return Loop(i, rows, Loop(j, row, St(out, Ld(table, Ld(idx, i, air::Int(32)) * row + j), i * row + j)));
+  }
+
+  // out[idx[i] * row + j] += updates[i * row + j]
+  air::Stmt Scatter(int updates, int row, int64_t out_size) {
+    auto out = Buffer("out", out_size);
+    auto src = Buffer("updates", static_cast<int64_t>(updates) * row);
+    auto idx = Buffer("idx", updates, air::Int(32));
+    air::Var i("i"), j("j");
+    air::Expr dst = Ld(idx, i, air::Int(32)) * row + j;
+    return Loop(i, updates, Loop(j, row, St(out, Add::make(Ld(out, dst), Ld(src, i * row + j)), dst)));
+  }
+
+  // The for type of each loop var and the names of the allocated buffers.
+  static std::map<std::string, ForType> Loops(const air::Stmt &stmt, std::set<std::string> *allocs = nullptr) {
+    std::map<std::string, ForType> loops;
+    air::ir::PostOrderVisit(stmt, [&loops, allocs](const air::NodeRef &node) {
+      if (auto op = node.as<For>()) {
+        loops[op->loop_var->name_hint] = op->for_type;
+      } else if (auto op = node.as<air::ir::Allocate>()) {
+        if (allocs != nullptr) {
+          allocs->insert(op->buffer_var->name_hint);
+        }
+      }
+    });
+    return loops;
+  }
+
+  AttrMap saved_attrs_;
+  air::Map<air::Tensor, air::Buffer> binds_;
+};
+
+TEST_F(ScheduleTotLoopTest, LargeGatherParallel) {
+  auto loops = Loops(ir::ScheduleTotLoop(Gather(4096, 64), binds_));
+  EXPECT_EQ(loops["i"], ForType::Parallel);
+  EXPECT_EQ(loops["j.outer"], ForType::Serial);
+  EXPECT_EQ(loops["j.inner"], ForType::Vectorized);
+}
+
+TEST_F(ScheduleTotLoopTest, SmallGatherSerial) {
+  auto loops = Loops(ir::ScheduleTotLoop(Gather(16, 64), binds_));
+  EXPECT_EQ(loops["i"], ForType::Serial);
+  EXPECT_EQ(loops["j.inner"], ForType::Vectorized);
+}
+
+TEST_F(ScheduleTotLoopTest, GatherSingleCoreSerial) {
+  SetCores(1);
+  auto loops = Loops(ir::ScheduleTotLoop(Gather(4096, 64), binds_));
+  EXPECT_EQ(loops["i"], ForType::Serial);
+}
+
+TEST_F(ScheduleTotLoopTest, ScatterPartial) {
+  // Four copies of 64 elements cost less than 4096 updates.
+  std::set<std::string> allocs;
+  auto loops = Loops(ir::ScheduleTotLoop(Scatter(4096, 1, 64), binds_), &allocs);
+  EXPECT_EQ(allocs, std::set<std::string>({"tot_partial"}));
+  EXPECT_EQ(loops["tot_task"], ForType::Parallel);
+  EXPECT_EQ(loops["tot_part"], ForType::Serial);
+}
+
+TEST_F(ScheduleTotLoopTest, ScatterBucket) {
+  // Copies of the output cost more than the updates, the rows of 16 elements are bucketed.
+  std::set<std::string> allocs;
+  auto loops = Loops(ir::ScheduleTotLoop(Scatter(256, 16, 1 << 20), binds_), &allocs);
+  EXPECT_EQ(allocs, std::set<std::string>({"tot_count", "tot_cursor", "tot_order"}));
+  EXPECT_EQ(loops["tot_task"], ForType::Parallel);
+  EXPECT_EQ(loops["i.count"], ForType::Serial);
+  EXPECT_EQ(loops["i.fill"], ForType::Serial);
+}
+
+TEST_F(ScheduleTotLoopTest, ScatterSingleCoreSerial) {
+  SetCores(1);
+  std::set<std::string> allocs;
+  auto stmt = Scatter(4096, 1, 64);
+  auto res = ir::ScheduleTotLoop(stmt, binds_);
+  Loops(res, &allocs);
+  EXPECT_TRUE(allocs.empty());
+  EXPECT_TRUE(res.same_as(stmt));
+}
+}  // namespace akg
@@ -0,0 +1,74 @@
+# Copyright 2021 Huawei Technologies Co., Ltd
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import akg.tvm
+
+SIZE = 1024
+
+
+def _temporaries(last_use_of_a):
+    '''
+     A = 1
+     B = A + 1
+     C = B * 2
+     out = C, or C + A when last_use_of_a
+    '''
+    ib = akg.tvm.ir_builder.create()
+    out = ib.pointer("float32", name="out")
+    a = ib.allocate("float32", SIZE, name="A", scope="global")
+    b = ib.allocate("float32", SIZE, name="B", scope="global")
+    c = ib.allocate("float32", SIZE, name="C", scope="global")
+    with ib.for_range(0, SIZE, name="i0") as i:
+        a[i] = akg.tvm.const(1, "float32")
+    with ib.for_range(0, SIZE, name="i1") as i:
+        b[i] = a[i] + akg.tvm.const(1, "float32")
+    with ib.for_range(0, SIZE, name="i2") as i:
+        c[i] = b[i] * akg.tvm.const(2, "float32")
+    with ib.for_range(0, SIZE, name="i3") as i:
+        out[i] = c[i] + a[i] if last_use_of_a else c[i]
+    return ib.get()
+
+
+def _allocations(stmt):
+    allocs = {}
+
+    def visit(n):
+        if isinstance(n, akg.tvm.stmt.Allocate):
+            allocs[n.buffer_var.name] = n.extents[0].value
+    akg.tvm.ir_pass.PostOrderVisit(stmt, visit)
+    return allocs
+
+
+def test_cpu_storage_plan_disjoint():
+    '''A and C are never live together, they share the first slot of the arena and B takes the second.'''
+    stmt = akg.tvm.ir_pass.CpuStoragePlan(_temporaries(False), "disjoint")
+    assert _allocations(stmt) == {"arena_float32": 2 * SIZE}
+    offsets = []
+
+    def visit(n):
+        if isinstance(n, akg.tvm.stmt.Store) and n.buffer_var.name == "arena_float32":
+            offsets.append(str(n.index))
+    akg.tvm.ir_pass.PostOrderVisit(stmt, visit)
+    assert offsets == ["i0", "(i1 + %d)" % SIZE, "i2"]
+
+
+def test_cpu_storage_plan_overlapping():
+    '''A is read at the end, so the three buffers are live together and keep their own storage.'''
+    stmt = akg.tvm.ir_pass.CpuStoragePlan(_temporaries(True), "overlapping")
+    assert _allocations(stmt) == {"A": SIZE, "B": SIZE, "C": SIZE}
+
+
+if __name__ == "__main__":
+    test_cpu_storage_plan_disjoint()
+    test_cpu_storage_plan_overlapping()
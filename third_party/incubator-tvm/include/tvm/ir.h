@@ -1665,6 +1665,10 @@ constexpr const char* akg_fragment_elem = "akg_fragment_elem";
 constexpr const char* tvm_cce_string_print = "tvm_cce_string_print";
 
 constexpr const char* sgemm_kernel_avx = "SgemmKernelAvx";
+/*! \brief SgemmKernelAvx on float16 A and B, needs avx512f. */
+constexpr const char* hgemm_kernel_avx512 = "HgemmKernelAvx512";
+/*! \brief SgemmKernelAvx on int8 A and B packed in groups of 4 k, int32 C, needs avx512vnni. */
+constexpr const char* igemm_kernel_vnni = "IgemmKernelVnni";
 }   // namespace intrinsic
 
 /*!
@@ -26,6 +26,8 @@
  *   Adapt LLVM 12 interface support
  * 2021.12.15
  *   Change buffer manager interface as argument
+ * 2026.10.17
+ *   Pass the shape vars of dynamic shape kernels to the compute function
  */
 
 #ifdef TVM_LLVM_VERSION
@@ -461,6 +463,7 @@ void CodeGenCPU::CreateComputeScope(const AttrStmt* op) {
   using llvm::BasicBlock;
   std::unordered_map<const Variable*, llvm::Value*> new_vmap;
   Array<Var> vargs = args_real_;
+  Array<Var> bound_vargs;
   Array<Var> undef_vargs = ir::UndefinedVars(op->body, {});
   for (const auto var : undef_vargs) {
     auto it = find_if(vargs.begin(), vargs.end(), [var](const Var &rhs)->bool { return var.get() == rhs.get(); });
@@ -469,6 +472,11 @@ void CodeGenCPU::CreateComputeScope(const AttrStmt* op) {
         new_vmap[var.get()] = ConstInt32(0);
 	continue;
       }
+      // The shape vars of dynamic shape kernels, bound from the tensor arguments.
+      if (var_map_.count(var.get()) != 0) {
+        bound_vargs.push_back(var);
+        continue;
+      }
       LOG(FATAL) << "Cant not find var " << var;
     }
   }
@@ -482,6 +490,10 @@ void CodeGenCPU::CreateComputeScope(const AttrStmt* op) {
   llvm::Value *links_data = PackClosureData(link_vars, &nbytes);
   var_map_[extern_links_.get()] = builder_->CreatePointerCast(links_data, t_void_p_);
   vargs.push_back(extern_links_);
+  // After the fields of the static kernels.
+  for (const auto &var : bound_vargs) {
+    vargs.push_back(var);
+  }
 
   llvm::Value* cdata = PackClosureData(vargs, &nbytes);
   llvm::FunctionType* ftype =
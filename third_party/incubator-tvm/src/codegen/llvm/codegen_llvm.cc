@@ -29,6 +29,12 @@
  *   Add sgemm kernel intrinsics
  * 2021.12.21
  *   Fixed prefetch intrinsic
+ * 2026.10.17
+ *   Use the AVX-512 sgemm kernels on avx512f targets, check the target of the float16 and int8 kernels
+ *   Add float16 and int8 (VNNI) gemm kernel intrinsics
+ *   Derive the native vector width from the target features
+ *   Emit exp by the polynomial of vector_math.h, other float types by llvm.exp
+ *   Define functions declared by extern calls of earlier functions
  */
 
 #ifdef TVM_LLVM_VERSION
@@ -38,8 +44,11 @@
 
 #include <algorithm>
 
+#include <llvm/MC/MCSubtargetInfo.h>
+
 #include "codegen_llvm.h"
 #include "codegen_cpu.h"
+#include "vector_math.h"
 #include "../build_common.h"
 #include "../../pass/ir_util.h"
 #include "../../arithmetic/compute_expr.h"
@@ -52,6 +61,9 @@ extern const std::string SGEMM_KERNEL_AVX_N8;
 extern const std::string SGEMM_KERNEL_AVX_N4;
 extern const std::string SGEMM_KERNEL_AVX_N2;
 extern const std::string SGEMM_KERNEL_AVX_N1;
+extern std::string SgemmKernelAvx512(int n_dim);
+extern std::string HgemmKernelAvx512(int n_dim);
+extern std::string IgemmKernelAvx512Vnni(int n_dim);
 
 std::unique_ptr<CodeGenLLVM> CodeGenLLVM::Create(llvm::TargetMachine *tm) {
   std::string target = tm->getTarget().getName();
@@ -103,8 +115,19 @@ void CodeGenLLVM::InitTarget(llvm::TargetMachine* tm) {
   if (native_vector_bits_ == 0) {
     const auto& arch = tm->getTargetTriple().getArch();
     if (arch == llvm::Triple::x86_64) {
+#if TVM_LLVM_VERSION >= 60
+      const auto* subtarget = tm->getMCSubtargetInfo();
+      if (subtarget->checkFeatures("+avx512f")) {
+        native_vector_bits_ = 512;
+      } else if (subtarget->checkFeatures("+avx")) {
+        native_vector_bits_ = 256;
+      } else {
+        native_vector_bits_ = 128;
+      }
+#else
       // for avx512
       native_vector_bits_ = 512;
+#endif
     } else if (arch == llvm::Triple::x86) {
       native_vector_bits_ = 256;
     } else if (arch == llvm::Triple::arm || arch == llvm::Triple::aarch64) {
@@ -153,11 +176,16 @@ void CodeGenLLVM::AddFunctionInternal(const LoweredFunc& f, bool ret_void) {
   }
   llvm::FunctionType* ftype = llvm::FunctionType::get(
       ret_void ? t_void_ : t_int_, arg_types, false);
-  CHECK(module_->getFunction(f->name) == nullptr)
-      << "Function " << f->name << " already exist in module";
-  function_ = llvm::Function::Create(
-      ftype, llvm::Function::ExternalLinkage,
-      f->name, module_.get());
+  function_ = module_->getFunction(f->name);
+  if (function_ != nullptr) {
+    // Declared by an extern call of an earlier function of the module.
+    CHECK(function_->isDeclaration() && function_->getFunctionType() == ftype)
+        << "Function " << f->name << " already exist in module";
+  } else {
+    function_ = llvm::Function::Create(
+        ftype, llvm::Function::ExternalLinkage,
+        f->name, module_.get());
+  }
   function_->setCallingConv(llvm::CallingConv::C);
   function_->setDLLStorageClass(llvm::GlobalValue::DLLStorageClassTypes::DLLExportStorageClass);
   // set var map and align information
@@ -868,35 +896,18 @@ llvm::Value* CodeGenLLVM::CreateIntrinsic(const Call* op) {
       }
     }
     return builder_->CreateShuffleVector(v0, v0, indices);
-  } else if (op->is_intrinsic("SgemmKernelAvx")) {
+  } else if (op->is_intrinsic("SgemmKernelAvx") || op->is_intrinsic("HgemmKernelAvx512") ||
+             op->is_intrinsic("IgemmKernelVnni")) {
     return EmitSgemmKernel(op);
   } else if (op->is_intrinsic("exp")) {
-    auto x_type = op->args[0].type();
-    auto float_type = DataType(kDLFloat, x_type.bits(), x_type.lanes());
-    auto int_type = DataType(kDLInt, x_type.bits(), x_type.lanes());
-    Expr x = ir::Cast::make(float_type, op->args[0]);
-    Expr param_0 = make_const(float_type, 0.693147f);
-    Expr param_1 = make_const(float_type, 1.f / 120.f);
-    Expr param_2 = make_const(float_type, 1.f / 24.f);
-    Expr param_3 = make_const(float_type, 1.f / 6.f);
-    Expr param_4 = make_const(float_type, 0.5f);
-    Expr param_5 = make_const(float_type, 1.f);
-    Expr param_6 = make_const(float_type, 88.f);
-    Expr param_7 = make_const(float_type, -88.f);
-    Expr param_8 = make_const(int_type, 127);
-    Expr param_9 = make_const(int_type, 23);
-
-    Expr input = ir::Max::make(param_7, ir::Min::make(param_6, x));
-    Expr integer = ir::Cast::make(int_type, input / param_0);
-    Expr decimal = input - integer * param_0;
-    Expr int_exp = ir::Call::make(int_type, ir::Call::shift_left, {integer + param_8, param_9}, ir::Call::Intrinsic);
-    Expr tmp = (param_1 * decimal + param_2) * decimal;
-    tmp = decimal * (param_4 + (param_3 + tmp) * decimal);
-    Expr decimal_exp = param_5 + decimal * (param_5 + tmp);
-    llvm::Value *decimal_value = MakeValue(decimal_exp);
-    llvm::Value *int_value = MakeValue(int_exp);
-    llvm::Value *float_value = builder_->CreateBitCast(int_value, decimal_value->getType());
-    return CreateMul(float_type, decimal_value, float_value);
+    // Left by a target without an exp rule. Types without vector math keep their precision through llvm.exp.
+    const Expr& x = op->args[0];
+    if (!HasFastMath(x.type())) {
+      return MakeValue(Call::make(op->type, "llvm_intrin", {UIntImm::make(UInt(32), ::llvm::Intrinsic::exp),
+                                                            UIntImm::make(UInt(32), 1), x},
+                                  Call::PureIntrinsic));
+    }
+    return MakeValue(FastExp(x));
   } else {
     LOG(FATAL) << "unknown intrinsic " << op->name;
     return nullptr;
@@ -1392,7 +1403,7 @@ void CodeGenLLVM::EmitSgemmKernelForBody(std::string inline_asm, const int n_dim
                                          llvm::Value *ldc_pointer, llvm::Value *a_pointer, llvm::Value *b_pointer,
                                          llvm::Value *c_pointer, llvm::Value *c_store_pointer,
                                          llvm::Value *b_pref_pointer, llvm::Value *alpha_pointer,
-                                         llvm::Function *sgemm_kernel) {
+                                         llvm::Function *sgemm_kernel, bool avx512, int elem_bytes) {
   llvm::Value *k_value = builder_->CreateLoad(t_int64_, k_pointer);
   std::vector<llvm::Type *> ret_types = {t_float32_p_, t_float32_p_, t_float32_p_, t_float32_p_, t_float32_p_,
                                          t_int64_,   t_int64_};
@@ -1422,14 +1433,28 @@ void CodeGenLLVM::EmitSgemmKernelForBody(std::string inline_asm, const int n_dim
   llvm::Value *k = builder_->CreateLoad(t_int64_, k_count_pointer);
   llvm::Value *ldc = builder_->CreateLoad(t_int64_, ldc_pointer);
 
+  // A and B pointers step by elements of elem_bytes.
+  auto advance = [this, elem_bytes](llvm::Value *ptr, llvm::Value *offset) {
+    offset = builder_->CreateMul(offset, builder_->getInt64(elem_bytes));
+    ptr = builder_->CreateGEP(builder_->CreatePointerCast(ptr, t_int8_->getPointerTo()), offset);
+    return builder_->CreatePointerCast(ptr, t_float32_p_);
+  };
   llvm::Value *b_tmp_offset = builder_->CreateMul(builder_->getInt64(n_dim), k_value);
-  b_pref = builder_->CreateGEP(b, b_tmp_offset);
+  b_pref = advance(b, b_tmp_offset);
   builder_->CreateStore(b_pref, b_pref_pointer);
 
-  std::string constraints_str =
-    "=r,=r,=r,=r,=r,=r,=r,*m,*m,*m,0,1,2,3,4,5,6,~{r10},~{r11},~{r12},~{r13},~{r14},~{r15},~{xmm0},~{xmm1},~{xmm2},~{"
-    "xmm3},~{xmm4},~{xmm5},~{xmm6},~{xmm7},~{xmm8},~{xmm9},~{xmm10},~{xmm11},~{xmm12},~{xmm13},~{xmm14},~{xmm15},~{cc},"
-    "~{memory},~{dirflag},~{fpsr},~{flags}";
+  std::string constraints_str = "=r,=r,=r,=r,=r,=r,=r,*m,*m,*m,0,1,2,3,4,5,6,~{r10},~{r11},~{r12},~{r13},~{r14},~{r15},";
+  if (avx512) {
+    for (int i = 0; i < 32; ++i) {
+      constraints_str += "~{zmm" + std::to_string(i) + "},";
+    }
+    constraints_str += "~{k1},";
+  } else {
+    for (int i = 0; i < 16; ++i) {
+      constraints_str += "~{xmm" + std::to_string(i) + "},";
+    }
+  }
+  constraints_str += "~{cc},~{memory},~{dirflag},~{fpsr},~{flags}";
   bool side_effects = true;
   llvm::InlineAsm *asm_fun = llvm::InlineAsm::get(ftype, inline_asm, constraints_str, side_effects);
 
@@ -1454,12 +1479,12 @@ void CodeGenLLVM::EmitSgemmKernelForBody(std::string inline_asm, const int n_dim
 
   llvm::Value *a_tmp = builder_->CreateLoad(t_float32_p_, a_pointer);
   llvm::Value *a_offset = builder_->CreateSub(builder_->getInt64(0), builder_->CreateMul(m_value, k_value));
-  a_tmp = builder_->CreateGEP(a_tmp, a_offset);
+  a_tmp = advance(a_tmp, a_offset);
   builder_->CreateStore(a_tmp, a_pointer);
 
   llvm::Value *b_tmp = builder_->CreateLoad(t_float32_p_, b_pointer);
   llvm::Value *b_offset = builder_->CreateMul(builder_->getInt64(n_dim), k_value);
-  b_tmp = builder_->CreateGEP(b_tmp, b_offset);
+  b_tmp = advance(b_tmp, b_offset);
   builder_->CreateStore(b_tmp, b_pointer);
 
   llvm::Value *c_tmp = builder_->CreateLoad(t_float32_p_, c_pointer);
@@ -1475,7 +1500,9 @@ void CodeGenLLVM::EmitSgemmKernelForBody(std::string inline_asm, const int n_dim
 }
 
 // This implementation refers to OpenBlas(http://www.openblas.net/).
+// HgemmKernelAvx512 and IgemmKernelVnni take the same arguments with float16 and int8 A, B (int32 C).
 llvm::Value* CodeGenLLVM::EmitSgemmKernel(const Call* op) {
+  int elem_bytes = op->is_intrinsic("HgemmKernelAvx512") ? 2 : (op->is_intrinsic("IgemmKernelVnni") ? 1 : 4);
   llvm::Value *a = builder_->CreatePointerCast(MakeValue(op->args[0]), t_float32_p_);
   llvm::Value *b = builder_->CreatePointerCast(MakeValue(op->args[1]), t_float32_p_);
   llvm::Value *c = builder_->CreatePointerCast(MakeValue(op->args[2]), t_float32_p_);
@@ -1488,9 +1515,11 @@ llvm::Value* CodeGenLLVM::EmitSgemmKernel(const Call* op) {
   std::vector<llvm::Type *> sgemm_args = {t_float32_p_, t_float32_p_, t_float32_p_,  t_int64_,
                                           t_int64_,     t_int64_,     t_int64_,      t_float32_};
 
+  std::string kernel_name =
+    elem_bytes == 4 ? "akg_sgemm_kernel" : (elem_bytes == 2 ? "akg_hgemm_kernel" : "akg_igemm_kernel");
   llvm::Function *sgemm_kernel =
     llvm::Function::Create(llvm::FunctionType::get(t_int32_, sgemm_args, false), llvm::Function::ExternalLinkage,
-                           "akg_sgemm_kernel", module_.get());
+                           kernel_name, module_.get());
   llvm::CallInst *sgemm_ret = builder_->CreateCall(sgemm_kernel, {a, b, c, m, n, k, ldc, alpha});
   llvm::BasicBlock *pre_block = builder_->GetInsertBlock();
 
@@ -1542,21 +1571,43 @@ llvm::Value* CodeGenLLVM::EmitSgemmKernel(const Call* op) {
   llvm::Value *end_2 = builder_->CreateSDiv(n_rem, builder_->getInt64(2));
   llvm::Value *end_1 = builder_->CreateSRem(n_rem, builder_->getInt64(2));
 
-  EmitSgemmKernelForBody(SGEMM_KERNEL_AVX_N12, 12, end_12, m_value, k_pointer, ldc_value, m_pointer, n_pointer,
-                         k_count_pointer, ldc_pointer, a_pointer, b_pointer, c_pointer, c_store_pointer,
-                         b_pref_pointer, alpha_pointer, sgemm_kernel);
-  EmitSgemmKernelForBody(SGEMM_KERNEL_AVX_N8, 8, end_8, m_value, k_pointer, ldc_value, m_pointer, n_pointer,
-                         k_count_pointer, ldc_pointer, a_pointer, b_pointer, c_pointer, c_store_pointer,
-                         b_pref_pointer, alpha_pointer, sgemm_kernel);
-  EmitSgemmKernelForBody(SGEMM_KERNEL_AVX_N4, 4, end_4, m_value, k_pointer, ldc_value, m_pointer, n_pointer,
-                         k_count_pointer, ldc_pointer, a_pointer, b_pointer, c_pointer, c_store_pointer,
-                         b_pref_pointer, alpha_pointer, sgemm_kernel);
-  EmitSgemmKernelForBody(SGEMM_KERNEL_AVX_N2, 2, end_2, m_value, k_pointer, ldc_value, m_pointer, n_pointer,
-                         k_count_pointer, ldc_pointer, a_pointer, b_pointer, c_pointer, c_store_pointer,
-                         b_pref_pointer, alpha_pointer, sgemm_kernel);
-  EmitSgemmKernelForBody(SGEMM_KERNEL_AVX_N1, 1, end_1, m_value, k_pointer, ldc_value, m_pointer, n_pointer,
-                         k_count_pointer, ldc_pointer, a_pointer, b_pointer, c_pointer, c_store_pointer,
-                         b_pref_pointer, alpha_pointer, sgemm_kernel);
+  // The AVX-512 kernels read the same packed layout, only the target decides which ones are emitted. The float16
+  // and int8 kernels have no AVX version, CpuIslEmitter only packs them for a target cpu with avx512 (avx512_vnni),
+  // a target machine without those extensions would fault on them.
+  bool avx512 = elem_bytes != 4;
+#if TVM_LLVM_VERSION >= 60
+  if (target_machine_ != nullptr) {
+    const auto *subtarget = target_machine_->getMCSubtargetInfo();
+    const char *required = elem_bytes == 2 ? "+avx512f" : (elem_bytes == 1 ? "+avx512f,+avx512vnni" : nullptr);
+    CHECK(required == nullptr || subtarget->checkFeatures(required))
+      << op->name << " needs " << required << " in the llvm target, give the cpu_info attr instead of -mcpu or -mattr";
+    avx512 = avx512 || subtarget->checkFeatures("+avx512f");
+  }
+#endif
+  auto kernel = [avx512, elem_bytes](int n_dim, const std::string &avx_kernel) {
+    if (elem_bytes == 2) {
+      return HgemmKernelAvx512(n_dim);
+    } else if (elem_bytes == 1) {
+      return IgemmKernelAvx512Vnni(n_dim);
+    }
+    return avx512 ? SgemmKernelAvx512(n_dim) : avx_kernel;
+  };
+
+  EmitSgemmKernelForBody(kernel(12, SGEMM_KERNEL_AVX_N12), 12, end_12, m_value, k_pointer, ldc_value, m_pointer,
+                         n_pointer, k_count_pointer, ldc_pointer, a_pointer, b_pointer, c_pointer, c_store_pointer,
+                         b_pref_pointer, alpha_pointer, sgemm_kernel, avx512, elem_bytes);
+  EmitSgemmKernelForBody(kernel(8, SGEMM_KERNEL_AVX_N8), 8, end_8, m_value, k_pointer, ldc_value, m_pointer,
+                         n_pointer, k_count_pointer, ldc_pointer, a_pointer, b_pointer, c_pointer, c_store_pointer,
+                         b_pref_pointer, alpha_pointer, sgemm_kernel, avx512, elem_bytes);
+  EmitSgemmKernelForBody(kernel(4, SGEMM_KERNEL_AVX_N4), 4, end_4, m_value, k_pointer, ldc_value, m_pointer,
+                         n_pointer, k_count_pointer, ldc_pointer, a_pointer, b_pointer, c_pointer, c_store_pointer,
+                         b_pref_pointer, alpha_pointer, sgemm_kernel, avx512, elem_bytes);
+  EmitSgemmKernelForBody(kernel(2, SGEMM_KERNEL_AVX_N2), 2, end_2, m_value, k_pointer, ldc_value, m_pointer,
+                         n_pointer, k_count_pointer, ldc_pointer, a_pointer, b_pointer, c_pointer, c_store_pointer,
+                         b_pref_pointer, alpha_pointer, sgemm_kernel, avx512, elem_bytes);
+  EmitSgemmKernelForBody(kernel(1, SGEMM_KERNEL_AVX_N1), 1, end_1, m_value, k_pointer, ldc_value, m_pointer,
+                         n_pointer, k_count_pointer, ldc_pointer, a_pointer, b_pointer, c_pointer, c_store_pointer,
+                         b_pref_pointer, alpha_pointer, sgemm_kernel, avx512, elem_bytes);
   builder_->CreateRet(ConstInt32(0));
 
   builder_->SetInsertPoint(pre_block);
@@ -314,7 +314,7 @@ class CodeGenLLVM :
                               llvm::Value *ldc_pointer, llvm::Value *a_pointer, llvm::Value *b_pointer,
                               llvm::Value *c_pointer, llvm::Value *c_store_pointer,
                               llvm::Value *b_pref_pointer, llvm::Value *alpha_pointer,
-                              llvm::Function *sgemm_kernel);
+                              llvm::Function *sgemm_kernel, bool avx512, int elem_bytes);
   llvm::Value* EmitSgemmKernel(const Call* op);
 };
 }  // namespace codegen
@@ -22,10 +22,13 @@
  *
  * 2021.12.21
  *   Fixed prefetch intrinsic
+ * 2026.10.17
+ *   Lower exp, log, tanh, sigmoid, erf, rsqrt and pow of float16 and float32 to the vector math of vector_math.h
  */
 #ifdef TVM_LLVM_VERSION
 
 #include "intrin_rule_llvm.h"
+#include "vector_math.h"
 
 namespace air {
 namespace codegen {
@@ -37,9 +40,6 @@ TVM_REGISTER_GLOBAL("tvm.intrin.rule.llvm.prefetch")
 TVM_REGISTER_GLOBAL("tvm.intrin.rule.llvm.fma")
 .set_body(DispatchLLVMPureIntrin<::llvm::Intrinsic::fmuladd, 1>);
 
-TVM_REGISTER_GLOBAL("tvm.intrin.rule.llvm.log")
-.set_body(DispatchLLVMPureIntrin<::llvm::Intrinsic::log, 1>);
-
 TVM_REGISTER_GLOBAL("tvm.intrin.rule.llvm.sqrt")
 .set_body(DispatchLLVMPureIntrin<::llvm::Intrinsic::sqrt, 1>);
 
@@ -61,12 +61,40 @@ TVM_REGISTER_GLOBAL("tvm.intrin.rule.llvm.round")
 TVM_REGISTER_GLOBAL("tvm.intrin.rule.llvm.nearbyint")
 .set_body(DispatchLLVMPureIntrin<::llvm::Intrinsic::nearbyint, 1>);
 
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.llvm.exp")
+.set_body([](const TVMArgs& targs, TVMRetValue* rv) {
+  Expr e = targs[0];
+  const ir::Call* call = e.as<ir::Call>();
+  CHECK(call != nullptr);
+  if (HasFastMath(call->type)) {
+    *rv = FastExp(call->args[0]);
+  } else {
+    DispatchLLVMPureIntrin<::llvm::Intrinsic::exp, 1>(targs, rv);
+  }
+});
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.llvm.log")
+.set_body([](const TVMArgs& targs, TVMRetValue* rv) {
+  Expr e = targs[0];
+  const ir::Call* call = e.as<ir::Call>();
+  CHECK(call != nullptr);
+  if (HasFastMath(call->type)) {
+    *rv = FastLog(call->args[0]);
+  } else {
+    DispatchLLVMPureIntrin<::llvm::Intrinsic::log, 1>(targs, rv);
+  }
+});
+
 TVM_REGISTER_GLOBAL("tvm.intrin.rule.llvm.tanh")
 .set_body([](const TVMArgs& targs, TVMRetValue* rv) {
   Expr e = targs[0];
   const ir::Call* call = e.as<ir::Call>();
   CHECK(call != nullptr);
   const Expr& x = call->args[0];
+  if (HasFastMath(x.type())) {
+    *rv = FastTanh(x);
+    return;
+  }
   Expr one = make_const(x.type(), 1);
   Expr two = make_const(x.type(), 2);
   Expr neg_two = make_const(x.type(), -2);
@@ -82,8 +110,26 @@ TVM_REGISTER_GLOBAL("tvm.intrin.rule.llvm.tanh")
       x >= make_zero(x.type()), tanh_pos, tanh_neg);
 });
 
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.llvm.sigmoid")
+.set_body(DispatchVectorMath<FastSigmoid>);
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.llvm.erf")
+.set_body(DispatchVectorMath<FastErf>);
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.llvm.rsqrt")
+.set_body(DispatchVectorMath<FastRsqrt>);
+
 TVM_REGISTER_GLOBAL("tvm.intrin.rule.llvm.pow")
-.set_body(DispatchLLVMPureIntrin<::llvm::Intrinsic::pow, 1>);
+.set_body([](const TVMArgs& targs, TVMRetValue* rv) {
+  Expr e = targs[0];
+  const ir::Call* call = e.as<ir::Call>();
+  CHECK(call != nullptr);
+  if (HasFastMath(call->type)) {
+    *rv = FastPow(call->args[0], call->args[1]);
+  } else {
+    DispatchLLVMPureIntrin<::llvm::Intrinsic::pow, 1>(targs, rv);
+  }
+});
 
 TVM_REGISTER_GLOBAL("tvm.intrin.rule.llvm.popcount")
 .set_body(DispatchLLVMPureIntrin<::llvm::Intrinsic::ctpop, 1>);
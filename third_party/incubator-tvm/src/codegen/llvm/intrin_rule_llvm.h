@@ -21,6 +21,11 @@
  * \file intrin_rule_llvm.h
  * \brief Common utilities for llvm intrinsics.
  */
+
+/*
+ * 2026.10.17
+ *   Add DispatchVectorMath
+ */
 #ifndef TVM_CODEGEN_LLVM_INTRIN_RULE_LLVM_H_
 #define TVM_CODEGEN_LLVM_INTRIN_RULE_LLVM_H_
 #ifdef TVM_LLVM_VERSION
@@ -30,6 +35,7 @@
 #include <tvm/codegen.h>
 #include <string>
 #include "llvm_common.h"
+#include "vector_math.h"
 
 namespace air {
 namespace codegen {
@@ -67,6 +73,15 @@ inline void DispatchLLVMIntrin(const TVMArgs& targs, TVMRetValue* rv) {
       call->type, "llvm_intrin", cargs, ir::Call::Intrinsic);
 }
 
+// float16 and float32 calls are replaced by the vector math expression, the others are left to the default rule.
+template<Expr (*fast)(const Expr&)>
+inline void DispatchVectorMath(const TVMArgs& targs, TVMRetValue* rv) {
+  Expr e = targs[0];
+  const ir::Call* call = e.as<ir::Call>();
+  CHECK(call != nullptr);
+  *rv = HasFastMath(call->type) ? fast(call->args[0]) : e;
+}
+
 }  // namespace codegen
 }  // namespace air
 
@@ -24,6 +24,9 @@
 /*
  * 2021.11.01
  *   Adapt LLVM 12 interface support
+ * 2026.10.17
+ *   Build for the host cpu with -mcpu=native
+ *   Accept -kernel-cost, which asks the llvm module for the cost metadata of its functions
  */
 
 #ifdef TVM_LLVM_VERSION
@@ -47,6 +50,30 @@ struct LLVMEnv {
   }
 };
 
+namespace {
+struct HostCPU {
+  std::string name;
+  std::string features;
+};
+
+// Detected once per process, builds do not probe the host again.
+const HostCPU& GetHostCPU() {
+  static const HostCPU host = []() {
+    HostCPU cpu;
+    cpu.name = llvm::sys::getHostCPUName().str();
+    llvm::StringMap<bool> features;
+    if (llvm::sys::getHostCPUFeatures(features)) {
+      for (const auto& feature : features) {
+        cpu.features += (cpu.features.empty() ? "" : ",") + std::string(feature.second ? "+" : "-") +
+                        feature.first().str();
+      }
+    }
+    return cpu;
+  }();
+  return host;
+}
+}  // namespace
+
 void InitializeLLVM() {
   LLVMEnv* e = LLVMEnv::Global();
   if (!e->all_initialized.load(std::memory_order::memory_order_acquire)) {
@@ -83,7 +110,7 @@ void ParseLLVMTargetOptions(const std::string& target_str,
   std::istringstream is(target_str.substr(start, target_str.length() - start));
 
   while (is >> key) {
-    if (key == "--system-lib" || key == "-system-lib") {
+    if (key == "--system-lib" || key == "-system-lib" || key == "-kernel-cost") {
       continue;
     }
     size_t pos = key.find('=');
@@ -125,6 +152,17 @@ void ParseLLVMTargetOptions(const std::string& target_str,
       *triple == "default") {
     *triple = llvm::sys::getDefaultTargetTriple();
   }
+  // -mcpu=native builds for the host cpu and its features, -mattr may still override them. Without -mcpu the code
+  // stays generic, so exported kernels run on other machines too.
+  if (*mcpu == "native") {
+    const HostCPU& host = GetHostCPU();
+    *mcpu = host.name;
+    if (mattr->length() == 0) {
+      *mattr = host.features;
+    } else if (host.features.length() != 0) {
+      *mattr = host.features + "," + *mattr;
+    }
+  }
   // set target option
   llvm::TargetOptions& opt = *options;
   opt = llvm::TargetOptions();
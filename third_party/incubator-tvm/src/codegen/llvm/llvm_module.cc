@@ -25,11 +25,15 @@
 /*
  * 2021.11.01
  *   Add dump cpu info.
+ * 2026.10.17
+ *   Record the float operations and memory bytes of each function as module metadata for -kernel-cost targets.
  */
 
 #ifdef TVM_LLVM_VERSION
 #include <tvm/runtime/packed_func.h>
 #include <tvm/codegen.h>
+#include <tvm/expr_operator.h>
+#include <tvm/ir_visitor.h>
 #include <mutex>
 #include "llvm_common.h"
 #include "codegen_llvm.h"
@@ -43,6 +47,75 @@ using runtime::TVMArgs;
 using runtime::TVMRetValue;
 using runtime::PackedFunc;
 
+// Named metadata of (function name, float operations, bytes loaded and stored) tuples, emitted for targets with the
+// -kernel-cost option.
+constexpr const char* kKernelCostMetadata = "akg.kernel_cost";
+
+// Float operations and bytes accessed by one call of a function, counting every iteration of the loops and both
+// branches of conditions. Loop extents that are not constant make the cost unknown.
+class KernelCost : public ir::IRVisitor {
+ public:
+  bool Compute(const Stmt& body, int64_t* flops, int64_t* bytes) {
+    Visit(body);
+    *flops = flops_;
+    *bytes = bytes_;
+    return known_;
+  }
+
+  void Visit_(const ir::For* op) final {
+    const int64_t* extent = as_const_int(op->extent);
+    if (extent == nullptr) {
+      known_ = false;
+      return;
+    }
+    int64_t scale = scale_;
+    scale_ *= *extent;
+    IRVisitor::Visit_(op);
+    scale_ = scale;
+  }
+  void Visit_(const ir::Load* op) final {
+    bytes_ += scale_ * op->type.bytes() * op->type.lanes();
+    IRVisitor::Visit_(op);
+  }
+  void Visit_(const ir::Store* op) final {
+    bytes_ += scale_ * op->value.type().bytes() * op->value.type().lanes();
+    IRVisitor::Visit_(op);
+  }
+  void Visit_(const ir::Call* op) final {
+    if (op->call_type == ir::Call::PureIntrinsic || op->call_type == ir::Call::PureExtern) {
+      CountFloat(op->type, IsFma(op) ? 2 : 1);
+    }
+    IRVisitor::Visit_(op);
+  }
+  void Visit_(const ir::Add* op) final { CountFloat(op->type); IRVisitor::Visit_(op); }
+  void Visit_(const ir::Sub* op) final { CountFloat(op->type); IRVisitor::Visit_(op); }
+  void Visit_(const ir::Mul* op) final { CountFloat(op->type); IRVisitor::Visit_(op); }
+  void Visit_(const ir::Div* op) final { CountFloat(op->type); IRVisitor::Visit_(op); }
+  void Visit_(const ir::Min* op) final { CountFloat(op->type); IRVisitor::Visit_(op); }
+  void Visit_(const ir::Max* op) final { CountFloat(op->type); IRVisitor::Visit_(op); }
+
+ private:
+  // LowerIntrin has turned a * b + c into fma and the llvm intrinsic rules into llvm.fmuladd.
+  static bool IsFma(const ir::Call* op) {
+    if (op->name == "fma") {
+      return true;
+    }
+    const uint64_t* id = op->name == "llvm_intrin" ? as_const_uint(op->args[0]) : nullptr;
+    return id != nullptr && (*id == llvm::Intrinsic::fmuladd || *id == llvm::Intrinsic::fma);
+  }
+
+  void CountFloat(const Type& t, int ops = 1) {
+    if (t.is_float()) {
+      flops_ += scale_ * ops * t.lanes();
+    }
+  }
+
+  int64_t scale_{1};
+  int64_t flops_{0};
+  int64_t bytes_{0};
+  bool known_{true};
+};
+
 class LLVMModuleNode final : public runtime::ModuleNode {
  public:
   ~LLVMModuleNode() {
@@ -67,6 +140,21 @@ class LLVMModuleNode final : public runtime::ModuleNode {
           * rv = flag;
         });
     }
+    if (name == "__akg_kernel_cost") {
+      // One "name flops bytes" line per function with a known cost.
+      std::ostringstream os;
+      if (llvm::NamedMDNode* costs = mptr_->getNamedMetadata(kKernelCostMetadata)) {
+        for (llvm::MDNode* cost : costs->operands()) {
+          os << llvm::cast<llvm::MDString>(cost->getOperand(0))->getString().str() << " "
+             << llvm::mdconst::extract<llvm::ConstantInt>(cost->getOperand(1))->getSExtValue() << " "
+             << llvm::mdconst::extract<llvm::ConstantInt>(cost->getOperand(2))->getSExtValue() << "\n";
+        }
+      }
+      std::string text = os.str();
+      return PackedFunc([text](TVMArgs args, TVMRetValue *rv) {
+          * rv = text;
+        });
+    }
     if (ee_ == nullptr) LazyInitJIT();
     std::lock_guard<std::mutex> lock(mutex_);
     const std::string& fname = (name == runtime::symbol::tvm_module_main ?
@@ -226,6 +314,7 @@ class LLVMModuleNode final : public runtime::ModuleNode {
     InitializeLLVM();
     tm_ = GetLLVMTargetMachine(target);
     bool system_lib = (target.find("-system-lib") != std::string::npos);
+    bool kernel_cost = (target.find("-kernel-cost") != std::string::npos);
     CHECK_NE(funcs.size(), 0U);
     ctx_ = std::make_shared<llvm::LLVMContext>();
     std::unique_ptr<CodeGenLLVM> cg = CodeGenLLVM::Create(tm_.get());
@@ -244,6 +333,9 @@ class LLVMModuleNode final : public runtime::ModuleNode {
     if (tm_->getTargetTriple().isOSDarwin()) {
       module_->addModuleFlag(llvm::Module::Override, "Dwarf Version", 2);
     }
+    if (kernel_cost) {
+      AddKernelCost(funcs);
+    }
 
     std::string verify_errors_storage;
     llvm::raw_string_ostream verify_errors(verify_errors_storage);
@@ -331,6 +423,21 @@ class LLVMModuleNode final : public runtime::ModuleNode {
         return GetGlobalAddr(name);
       });
   }
+  void AddKernelCost(const Array<LoweredFunc>& funcs) {
+    llvm::NamedMDNode* costs = module_->getOrInsertNamedMetadata(kKernelCostMetadata);
+    llvm::Type* t_int64 = llvm::Type::getInt64Ty(*ctx_);
+    for (LoweredFunc f : funcs) {
+      int64_t flops = 0;
+      int64_t bytes = 0;
+      if (!KernelCost().Compute(f->body, &flops, &bytes)) {
+        continue;
+      }
+      llvm::Metadata* cost[] = {llvm::MDString::get(*ctx_, f->name),
+                                llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(t_int64, flops)),
+                                llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(t_int64, bytes))};
+      costs->addOperand(llvm::MDNode::get(*ctx_, cost));
+    }
+  }
   // Get global address from execution engine.
   uint64_t GetGlobalAddr(const std::string& name) {
     // first verifies if GV exists.
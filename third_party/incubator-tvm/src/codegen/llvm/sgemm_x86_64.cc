@@ -19,12 +19,14 @@
 
 /*
  * 2021.12.8 - Add new file.
+ * 2026.10.17 - Add AVX-512 kernels, float16 and int8 (VNNI) kernels, alpha for int8.
  */
 
 /*
  * \file sgemm_x86_64.cc
  */
 
+#include <sstream>
 #include <string>
 
 namespace air {
@@ -843,5 +845,226 @@ extern const std::string SGEMM_KERNEL_AVX_N1 =
     "vmovss %xmm0,($2); addq $$1*4,$2; 89:\n\tmovq %r14,$1;"
     "vzeroupper;";
 
+namespace {
+// Element type of the packed A and B operands of the AVX-512 kernels, C is float32 (int32 for int8).
+enum class GemmInput { kFloat32, kFloat16, kInt8 };
+
+// Registers of the AVX-512 kernels: zmm0/zmm1 hold 16 rows of A each, zmm2 the broadcast B value, zmm3 alpha and
+// zmm8 onwards the accumulators, so a 32 x 12 tile uses all 32 zmm registers. The int8 kernels compute 16 rows at a
+// time: zmm1 is a scratch register, zmm3 holds 0x80 and zmm4 0x01 bytes, zmm5 alpha as double, zmm20 onwards 128 *
+// column sums of B.
+constexpr int kAvx512AccBase = 8;
+constexpr int kAvx512CompBase = 20;
+
+std::string Zmm(int idx) { return "%zmm" + std::to_string(idx); }
+
+std::string Ymm(int idx) { return "%ymm" + std::to_string(idx); }
+
+std::string Num(int64_t value) { return "$$" + std::to_string(value); }
+
+int ElemBytes(GemmInput input) { return input == GemmInput::kFloat32 ? 4 : (input == GemmInput::kFloat16 ? 2 : 1); }
+
+int PanelWidth(int n_dim) { return n_dim >= 4 ? 4 : n_dim; }
+
+// B is packed in panels of 4 columns (2 or 1 for the last ones), %r12 is K * element bytes, so a panel is %r12 * 4
+// bytes. int8 packs k in groups of 4 (the VNNI layout), a group of a column is one dword; the last K % 4 values of
+// each column follow the groups one per k.
+std::string BColumn(GemmInput input, int n_dim, int j, bool grouped_k) {
+  static const char *panels[] = {"($1)", "($1,%r12,4)", "($1,%r12,8)"};
+  int col_bytes = grouped_k ? 4 : ElemBytes(input);
+  return std::to_string((j % PanelWidth(n_dim)) * col_bytes) + panels[j / PanelWidth(n_dim)];
+}
+
+// Loads bytes (at most 32) of one A panel at addr into the low part of zmm reg, the rest is zeroed.
+void LoadBytes(std::stringstream &ss, int bytes, const std::string &addr, int reg) {
+  auto idx = std::to_string(reg);
+  if (bytes == 32) {
+    ss << "vmovdqu " << addr << ",%ymm" << idx << ";";
+  } else if (bytes == 16) {
+    ss << "vmovdqu " << addr << ",%xmm" << idx << ";";
+  } else if (bytes == 8) {
+    ss << "vmovq " << addr << ",%xmm" << idx << ";";
+  } else if (bytes == 4) {
+    ss << "vmovd " << addr << ",%xmm" << idx << ";";
+  } else {
+    ss << (bytes == 2 ? "movzwl " : "movzbl ") << addr << ",%r15d; vmovd %r15d,%xmm" << idx << ";";
+  }
+}
+
+// Loads one k (one group of 4 k for int8) of the next rows of A into zmm0 (and zmm1 for 32 rows) as float32, or as
+// unsigned bytes a + 128 for int8, and steps $0 to the next k. 16 and 32 rows are two and four panels of 8 rows,
+// %r10 apart.
+void LoadA(std::stringstream &ss, GemmInput input, int rows) {
+  int k_bytes = input == GemmInput::kInt8 ? 4 : ElemBytes(input);
+  int panel_rows = rows >= 16 ? 8 : rows;
+  static const char *addrs[] = {"($0)", "($0,%r10,1)", "($0,%r10,2)", "($0,%r13,1)"};
+  for (int reg = 0; reg < (rows == 32 ? 2 : 1); ++reg) {
+    auto x = std::to_string(reg);
+    LoadBytes(ss, panel_rows * k_bytes, addrs[reg * 2], reg);
+    if (rows >= 16) {
+      if (input == GemmInput::kFloat16) {
+        ss << "vinserti128 $$1," << addrs[reg * 2 + 1] << ",%ymm" << x << ",%ymm" << x << ";";
+      } else {
+        ss << "vinserti64x4 $$1," << addrs[reg * 2 + 1] << "," << Zmm(reg) << "," << Zmm(reg) << ";";
+      }
+    }
+    if (input == GemmInput::kFloat16) {
+      ss << "vcvtph2ps %ymm" << x << "," << Zmm(reg) << ";";
+    } else if (input == GemmInput::kInt8) {
+      ss << "vpxord %zmm3," << Zmm(reg) << "," << Zmm(reg) << ";";
+    }
+  }
+  ss << "addq " << Num(panel_rows * k_bytes) << ",$0;";
+}
+
+// One of the last K % 4 k of int8 A, sign extended to int32 in zmm0.
+void LoadATailK(std::stringstream &ss, int rows) {
+  if (rows == 16) {
+    ss << "vmovq ($0),%xmm0; vpinsrq $$1,($0,%r10,1),%xmm0,%xmm0;";
+  } else {
+    LoadBytes(ss, rows, "($0)", 0);
+  }
+  ss << "vpmovsxbd %xmm0,%zmm0; addq " << Num(rows >= 16 ? 8 : rows) << ",$0;";
+}
+
+void ZeroRegs(std::stringstream &ss, int base, int num) {
+  for (int i = base; i < base + num; ++i) {
+    ss << "vpxord " << Zmm(i) << "," << Zmm(i) << "," << Zmm(i) << ";";
+  }
+}
+
+void FmaK(std::stringstream &ss, GemmInput input, int n_dim, int a_regs) {
+  for (int j = 0; j < n_dim; ++j) {
+    auto b = BColumn(input, n_dim, j, input == GemmInput::kInt8);
+    if (input == GemmInput::kInt8) {
+      // acc += u8(a + 128) * s8(b) over the 4 k of the group.
+      ss << "vpdpbusd " << b << "{1to16},%zmm0," << Zmm(kAvx512AccBase + j) << ";";
+      continue;
+    }
+    if (input == GemmInput::kFloat16) {
+      ss << "vpbroadcastw " << b << ",%ymm2; vcvtph2ps %ymm2,%zmm2;";
+    } else {
+      ss << "vbroadcastss " << b << ",%zmm2;";
+    }
+    for (int r = 0; r < a_regs; ++r) {
+      ss << "vfmadd231ps %zmm2," << Zmm(r) << "," << Zmm(kAvx512AccBase + r * n_dim + j) << ";";
+    }
+  }
+}
+
+void MulAddTailK(std::stringstream &ss, int n_dim) {
+  for (int j = 0; j < n_dim; ++j) {
+    auto acc = Zmm(kAvx512AccBase + j);
+    ss << "movsbl " << BColumn(GemmInput::kInt8, n_dim, j, false) << ",%r15d; vpbroadcastd %r15d,%zmm2;"
+       << "vpmulld %zmm2,%zmm0,%zmm1; vpaddd %zmm1," << acc << "," << acc << ";";
+  }
+}
+
+// C += alpha * acc (C += alpha * (acc - 128 * column sums of B) for int8), column by column, $4 walks the columns.
+// The int8 sums are scaled in double precision, so they stay exact for alpha 1.
+void StoreC(std::stringstream &ss, GemmInput input, int n_dim, int a_regs, const std::string &mask) {
+  ss << "movq $2,$4;";
+  for (int j = 0; j < n_dim; ++j) {
+    for (int r = 0; r < a_regs; ++r) {
+      auto acc = Zmm(kAvx512AccBase + r * n_dim + j);
+      auto offset = std::to_string(r * 64);
+      if (input == GemmInput::kInt8) {
+        ss << "vpsubd " << Zmm(kAvx512CompBase + j) << "," << acc << "," << acc << ";";
+        ss << "vcvtdq2pd " << Ymm(kAvx512AccBase + r * n_dim + j) << ",%zmm1; vmulpd %zmm5,%zmm1,%zmm1;"
+           << "vcvtpd2dq %zmm1,%ymm1; vextracti64x4 $$1," << acc << ",%ymm2; vcvtdq2pd %ymm2,%zmm2;"
+           << "vmulpd %zmm5,%zmm2,%zmm2; vcvtpd2dq %zmm2,%ymm2; vinserti64x4 $$1,%ymm2,%zmm1," << acc << ";";
+        ss << "vpaddd " << offset << "($4)," << acc << "," << acc << mask << ";";
+        ss << "vmovdqu32 " << acc << "," << offset << "($4)" << mask << ";";
+      } else {
+        ss << "vfmadd213ps " << offset << "($4),%zmm3," << acc << mask << ";";
+        ss << "vmovups " << acc << "," << offset << "($4)" << mask << ";";
+      }
+    }
+    ss << "addq $5,$4;";
+  }
+}
+
+// rows x n_dim block of C from the next A panels, leaves $0 at the end of the last panel loaded.
+void Block(std::stringstream &ss, GemmInput input, int n_dim, int rows, int label, const std::string &mask) {
+  int a_regs = rows == 32 ? 2 : 1;
+  int width = PanelWidth(n_dim);
+  auto l = [label](int i) { return std::to_string(label + i); };
+  ss << "movq %r14,$1;";
+  ZeroRegs(ss, kAvx512AccBase, a_regs * n_dim);
+  // K values, or K / 4 groups for int8.
+  ss << "movq %r12,$6;" << (input == GemmInput::kFloat16 ? "sarq $$1,$6;" : "sarq $$2,$6;");
+  ss << "testq $6,$6; jz " << l(1) << "f;" << l(0) << ":\n\t";
+  LoadA(ss, input, rows);
+  FmaK(ss, input, n_dim, a_regs);
+  ss << "addq " << Num(width * (input == GemmInput::kInt8 ? 4 : ElemBytes(input))) << ",$1; decq $6; jnz " << l(0)
+     << "b;" << l(1) << ":\n\t";
+  if (input == GemmInput::kInt8) {
+    ss << "movq %r12,$6; andq $$3,$6; jz " << l(3) << "f;" << l(2) << ":\n\t";
+    LoadATailK(ss, rows);
+    MulAddTailK(ss, n_dim);
+    ss << "addq " << Num(width) << ",$1; decq $6; jnz " << l(2) << "b;" << l(3) << ":\n\t";
+  }
+  StoreC(ss, input, n_dim, a_regs, mask);
+}
+
+// AVX-512 kernel for n_dim (12, 8, 4, 2 or 1) columns of C, with the same operands as the AVX kernels above. A is
+// packed in panels of 8 rows, two adjacent panels are merged into one zmm register, so the rows are computed 32 and
+// 16 at a time and the last 8, 4, 2, 1 rows of the tail panels with masked stores.
+std::string GemmKernelAvx512(GemmInput input, int n_dim) {
+  std::stringstream ss;
+  ss << "movq $9,%r12;";
+  if (input == GemmInput::kFloat32) {
+    ss << "salq $$2,%r12;";
+  } else if (input == GemmInput::kFloat16) {
+    ss << "salq $$1,%r12;";
+  }
+  ss << "movq $1,%r14; movq $8,%r11; leaq (,%r12,8),%r10; leaq (%r10,%r10,2),%r13;";
+  if (input == GemmInput::kInt8) {
+    // vpdpbusd multiplies unsigned by signed bytes, A is biased by 128 and 128 * column sums of B subtracted at the
+    // end.
+    int width = PanelWidth(n_dim);
+    ss << "movl $$0x80808080,%r15d; vpbroadcastd %r15d,%zmm3; movl $$0x01010101,%r15d; vpbroadcastd %r15d,%zmm4;"
+       << "vcvtss2sd $7,%xmm5,%xmm5; vbroadcastsd %xmm5,%zmm5;";
+    ZeroRegs(ss, kAvx512CompBase, n_dim);
+    ss << "movq %r12,$6; sarq $$2,$6; testq $6,$6; jz 91f; 90:\n\t";
+    for (int j = 0; j < n_dim; ++j) {
+      ss << "vpdpbusd " << BColumn(input, n_dim, j, true) << "{1to16},%zmm4," << Zmm(kAvx512CompBase + j) << ";";
+    }
+    ss << "addq " << Num(width * 4) << ",$1; decq $6; jnz 90b; 91:\n\t";
+    for (int j = 0; j < n_dim; ++j) {
+      ss << "vpslld $$7," << Zmm(kAvx512CompBase + j) << "," << Zmm(kAvx512CompBase + j) << ";";
+    }
+  } else {
+    ss << "vbroadcastss $7,%zmm3;";
+  }
+  if (input != GemmInput::kInt8) {
+    ss << "100:\n\tcmpq $$32,%r11; jb 110f;";
+    Block(ss, input, n_dim, 32, 101, "");
+    ss << "addq $$128,$2; addq %r13,$0; subq $$32,%r11; jmp 100b;";
+  }
+  ss << "110:\n\tcmpq $$16,%r11; jb 120f;";
+  Block(ss, input, n_dim, 16, 111, "");
+  ss << "addq $$64,$2; addq %r10,$0; subq $$16,%r11; jmp 110b; 120:\n\t";
+  // Tail panels of 8, 4, 2 and 1 rows, each at most once.
+  int label = 121;
+  for (int rows = 8; rows >= 1; rows /= 2, label += 10) {
+    ss << "cmpq " << Num(rows) << ",%r11; jb " << label + 9 << "f; movl " << Num((1 << rows) - 1)
+       << ",%r15d; kmovw %r15d,%k1;";
+    Block(ss, input, n_dim, rows, label, "{%k1}");
+    ss << "addq " << Num(rows * 4) << ",$2; subq " << Num(rows) << ",%r11;" << label + 9 << ":\n\t";
+  }
+  ss << "movq %r14,$1; vzeroupper;";
+  return ss.str();
+}
+}  // namespace
+
+extern std::string SgemmKernelAvx512(int n_dim) { return GemmKernelAvx512(GemmInput::kFloat32, n_dim); }
+
+// float16 A and B, converted to float32 as they are loaded, C is float32.
+extern std::string HgemmKernelAvx512(int n_dim) { return GemmKernelAvx512(GemmInput::kFloat16, n_dim); }
+
+// int8 A and B with k packed in groups of 4, C is int32, needs avx512vnni.
+extern std::string IgemmKernelAvx512Vnni(int n_dim) { return GemmKernelAvx512(GemmInput::kInt8, n_dim); }
+
 }  // namespace codegen
 }  // namespace air
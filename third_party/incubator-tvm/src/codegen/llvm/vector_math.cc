@@ -0,0 +1,271 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * 2026.10.17 - Add new file.
+ */
+
+/*!
+ * \file vector_math.cc
+ */
+#ifdef TVM_LLVM_VERSION
+
+#include "vector_math.h"
+#include <tvm/ir.h>
+#include <tvm/expr_operator.h>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <vector>
+#include "llvm_common.h"
+
+namespace air {
+namespace codegen {
+namespace {
+using ir::Call;
+using ir::Let;
+using ir::Select;
+using Body = std::function<Expr(const Expr &)>;
+
+constexpr double kLog2e = 1.44269504088896341;
+// ln(2) split in a part exact in multiplies by small integers and the rest.
+constexpr double kLn2Hi = 0.693359375;
+constexpr double kLn2Lo = -2.12194440e-4;
+constexpr double kInf = std::numeric_limits<double>::infinity();
+constexpr double kNan = std::numeric_limits<double>::quiet_NaN();
+
+Expr Const(const Expr &like, double value) { return make_const(like.type(), value); }
+
+// Binds value to a variable, so that body may use it several times without duplicating the expression.
+Expr Bind(const Expr &value, const Body &body) {
+  if (value.as<Variable>() != nullptr || is_const(value)) {
+    return body(value);
+  }
+  Var var("vm", value.type());
+  return Let::make(var, value, body(var));
+}
+
+Expr LLVMIntrin(llvm::Intrinsic::ID id, const Expr &x) {
+  return Call::make(x.type(), "llvm_intrin",
+                    {ir::UIntImm::make(UInt(32), id), ir::UIntImm::make(UInt(32), 1), x}, Call::PureIntrinsic);
+}
+
+Expr Floor(const Expr &x) { return LLVMIntrin(llvm::Intrinsic::floor, x); }
+Expr Fabs(const Expr &x) { return LLVMIntrin(llvm::Intrinsic::fabs, x); }
+Expr Sqrt(const Expr &x) { return LLVMIntrin(llvm::Intrinsic::sqrt, x); }
+
+// coefs[0] + coefs[1] * x + ..., in the multiply-add chain LowerIntrin turns into fma.
+Expr Poly(const Expr &x, const std::vector<double> &coefs) {
+  Expr p = Const(x, coefs.back());
+  for (auto it = coefs.rbegin() + 1; it != coefs.rend(); ++it) {
+    p = p * x + Const(x, *it);
+  }
+  return p;
+}
+
+// Lanes of the bit pattern of float32 x.
+Type BitsType(const Expr &x) { return Int(32, x.type().lanes()); }
+
+// Runs body on the float32 value of x and returns the result in the type of x.
+Expr InFloat32(const Expr &x, const Body &body) {
+  Type f32 = Float(32, x.type().lanes());
+  if (x.type() == f32) {
+    return Bind(x, body);
+  }
+  return ir::Cast::make(x.type(), Bind(ir::Cast::make(f32, x), body));
+}
+
+// Cephes expf: x = n * ln(2) + r with |r| <= ln(2) / 2, exp(r) by a degree 7 polynomial and 2^n as two exponent
+// fields, which keeps subnormal results and overflows to inf on its own.
+Expr Exp32(const Expr &x) {
+  return Bind(ir::Max::make(Const(x, -104), ir::Min::make(Const(x, 89), x)), [](const Expr &v) {
+    return Bind(Floor(v * Const(v, kLog2e) + Const(v, 0.5)), [&v](const Expr &n) {
+      Expr reduced = n * Const(v, -kLn2Hi) + v;
+      return Bind(n * Const(v, -kLn2Lo) + reduced, [&n](const Expr &r) {
+        Expr p = Poly(r, {5.0000001201E-1, 1.6666665459E-1, 4.1665795894E-2, 8.3334519073E-3, 1.3981999507E-3,
+                          1.9875691500E-4});
+        p = p * (r * r) + r + Const(r, 1);
+        return Bind(ir::Cast::make(BitsType(n), n), [&p](const Expr &ni) {
+          return Bind(ni >> make_const(ni.type(), 1), [&p, &ni](const Expr &half) {
+            Type f32 = p.type();
+            Expr bias = make_const(ni.type(), 127);
+            Expr mantissa_bits = make_const(ni.type(), 23);
+            Expr scale_0 = reinterpret(f32, (half + bias) << mantissa_bits);
+            Expr scale_1 = reinterpret(f32, (ni - half + bias) << mantissa_bits);
+            return p * scale_0 * scale_1;
+          });
+        });
+      });
+    });
+  });
+}
+
+// Cephes logf: x = m * 2^e with sqrt(1/2) <= m < sqrt(2) and log(m) by a polynomial of m - 1. x has to be bound.
+Expr Log32(const Expr &x) {
+  Type it = BitsType(x);
+  return Bind(x < Const(x, 1.17549435e-38), [&](const Expr &subnormal) {
+    Expr scaled = Select::make(subnormal, x * Const(x, 8388608.0), x);
+    return Bind(reinterpret(it, scaled), [&](const Expr &bits) {
+      Expr mantissa = reinterpret(x.type(), (bits & make_const(it, 0x7fffff)) | make_const(it, 0x3f800000));
+      return Bind(mantissa, [&](const Expr &m) {
+        return Bind(m > Const(m, 1.41421356), [&](const Expr &big) {
+          Expr bias = Select::make(subnormal, make_const(it, 150), make_const(it, 127));
+          Expr e = (bits >> make_const(it, 23)) - bias + Select::make(big, make_const(it, 1), make_const(it, 0));
+          Expr fraction = Select::make(big, m * Const(m, 0.5), m) - Const(m, 1);
+          return Bind(ir::Cast::make(x.type(), e), [&](const Expr &ef) {
+            return Bind(fraction, [&](const Expr &f) {
+              return Bind(f * f, [&](const Expr &z) {
+                Expr y = Poly(f, {3.3333331174E-1, -2.4999993993E-1, 2.0000714765E-1, -1.6668057665E-1,
+                                  1.4249322787E-1, -1.2420140846E-1, 1.1676998740E-1, -1.1514610310E-1,
+                                  7.0376836292E-2}) *
+                         f * z;
+                y = ef * Const(x, kLn2Lo) + y;
+                y = z * Const(x, -0.5) + y;
+                Expr r = ef * Const(x, kLn2Hi) + (f + y);
+                r = Select::make(x == Const(x, kInf), x, r);
+                r = Select::make(x == Const(x, 0), Const(x, -kInf), r);
+                return Select::make(x >= Const(x, 0), r, Const(x, kNan));
+              });
+            });
+          });
+        });
+      });
+    });
+  });
+}
+
+// Cephes tanhf: odd polynomial below 0.625, 1 - 2 / (exp(2|x|) + 1) above.
+Expr Tanh32(const Expr &x) {
+  return Bind(x * x, [&x](const Expr &z) {
+    Expr small = Poly(z, {-3.33332819422E-1, 1.33314422036E-1, -5.37397155531E-2, 2.06390887954E-2,
+                          -5.70498872745E-3}) *
+                   z * x +
+                 x;
+    return Bind(Fabs(x), [&](const Expr &ax) {
+      Expr e = Exp32(Const(x, 2) * ir::Min::make(Const(x, 9), ax));
+      return Bind(Const(x, 1) - Const(x, 2) / (e + Const(x, 1)), [&](const Expr &large) {
+        Expr signed_large = Select::make(x < Const(x, 0), -large, large);
+        return Select::make(ax < Const(x, 0.625), small, signed_large);
+      });
+    });
+  });
+}
+
+// exp(-|x|) never overflows: 1 / (1 + e) for x >= 0 and e / (1 + e) below.
+Expr Sigmoid32(const Expr &x) {
+  return Bind(Exp32(-Fabs(x)), [&x](const Expr &e) {
+    return Bind(Const(x, 1) / (Const(x, 1) + e), [&](const Expr &s) {
+      return Select::make(x < Const(x, 0), e * s, s);
+    });
+  });
+}
+
+// x + x * P(x^2) below 1, sign(x) * (1 - exp(Q(|x|))) up to 3.92 where erf rounds to 1. P and Q are least squares fits
+// of erf(x) / x - 1 on x^2 and of log(erfc(x)) weighted by erfc(x).
+Expr Erf32(const Expr &x) {
+  return Bind(Fabs(x), [&x](const Expr &ax) {
+    Expr p = Poly(x * x, {1.2837916590e-01, -3.7612626904e-01, 1.1283597463e-01, -2.6854328796e-02,
+                          5.1893119427e-03, -8.0188549928e-04, 7.8824971101e-05});
+    Expr small = x * p + x;
+    Expr q = Poly(ir::Min::make(Const(x, 3.92), ax), {-2.6518247523e-03, -1.1175118444e+00, -6.5438242879e-01,
+                                                       -8.8710139641e-02, 1.4804698222e-02, -1.1540674787e-03});
+    return Bind(Const(x, 1) - Exp32(q), [&](const Expr &large) {
+      Expr signed_large = Select::make(x < Const(x, 0), -large, large);
+      return Select::make(ax < Const(x, 1), small, signed_large);
+    });
+  });
+}
+
+// x^y for a constant y that is an integer up to 4 or +-0.5, undefined otherwise.
+Expr ConstPow(const Expr &x, const Expr &y) {
+  Expr value = y;
+  if (const auto broadcast = y.as<ir::Broadcast>()) {
+    value = broadcast->value;
+  }
+  double exponent;
+  if (const auto imm = value.as<ir::FloatImm>()) {
+    exponent = imm->value;
+  } else if (const auto imm = value.as<IntImm>()) {
+    exponent = static_cast<double>(imm->value);
+  } else {
+    return Expr();
+  }
+  if (std::fabs(exponent) == 0.5) {
+    Expr root = Sqrt(x);
+    return exponent > 0 ? root : Const(x, 1) / root;
+  }
+  double magnitude = std::fabs(exponent);
+  if (magnitude != std::floor(magnitude) || magnitude > 4) {
+    return Expr();
+  }
+  if (magnitude == 0) {
+    return Const(x, 1);
+  }
+  return Bind(x, [&](const Expr &v) {
+    Expr power = v;
+    if (magnitude >= 2) {
+      power = Bind(v * v, [magnitude, &v](const Expr &square) {
+        return magnitude == 4 ? square * square : (magnitude == 3 ? square * v : square);
+      });
+    }
+    return exponent > 0 ? power : Const(v, 1) / power;
+  });
+}
+
+// exp(y * log|x|), negative for a negative x and odd integer y, nan for a negative x and fractional y, 1 for y = 0.
+Expr Pow32(const Expr &x, const Expr &exponent) {
+  return Bind(exponent, [&x](const Expr &y) {
+    return Bind(Exp32(y * Bind(Fabs(x), Log32)), [&](const Expr &r) {
+      return Bind(Floor(y) == y, [&](const Expr &integral) {
+        Expr half = y * Const(y, 0.5);
+        Expr odd = integral && Floor(half) != half;
+        Expr negative = Select::make(integral, Select::make(odd, -r, r), Const(x, kNan));
+        return Select::make(y == Const(y, 0), Const(y, 1), Select::make(x < Const(x, 0), negative, r));
+      });
+    });
+  });
+}
+}  // namespace
+
+bool HasFastMath(const Type &t) { return t.is_float() && (t.bits() == 16 || t.bits() == 32); }
+
+Expr FastExp(const Expr &x) { return InFloat32(x, Exp32); }
+
+Expr FastLog(const Expr &x) { return InFloat32(x, Log32); }
+
+Expr FastTanh(const Expr &x) { return InFloat32(x, Tanh32); }
+
+Expr FastSigmoid(const Expr &x) { return InFloat32(x, Sigmoid32); }
+
+Expr FastErf(const Expr &x) { return InFloat32(x, Erf32); }
+
+Expr FastRsqrt(const Expr &x) {
+  return InFloat32(x, [](const Expr &v) { return Const(v, 1) / Sqrt(v); });
+}
+
+Expr FastPow(const Expr &x, const Expr &y) {
+  return InFloat32(x, [&y](const Expr &v) {
+    Expr power = ConstPow(v, y);
+    return power.defined() ? power : Pow32(v, ir::Cast::make(v.type(), y));
+  });
+}
+}  // namespace codegen
+}  // namespace air
+
+#endif  // TVM_LLVM_VERSION
@@ -0,0 +1,63 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * 2026.10.17 - Add new file.
+ */
+
+/*!
+ * \file vector_math.h
+ * \brief Branch free approximations of the transcendental functions for the CPU backend.
+ *
+ * They are built of plain arithmetic, selects, bit casts and the LLVM floor/sqrt/fabs intrinsics, so they have the
+ * lanes of the argument, are vectorized with the loop around them and inlined by LLVM instead of calling libm per
+ * element. float32 is computed natively, float16 is widened to float32 and the result narrowed (within 1 ulp of the
+ * float16 result). Maximum errors of the float32 results against the exact value over all float32 inputs, with and
+ * without fma contraction (tests/benchmark/codegen/vector_math_bench.cc):
+ *   FastExp      1.01 ulp  (subnormal results below 2^-126, 0 below -104, inf above 88.72)
+ *   FastLog      0.81 ulp  (-inf at 0, nan below 0)
+ *   FastTanh     1.30 ulp
+ *   FastSigmoid  2.67 ulp
+ *   FastErf      1.39 ulp
+ *   FastRsqrt    1.5 ulp
+ *   FastPow      2 + 2 * |y * ln(x)| ulp for normal results, the error of exp(y * log(x)) in float32. Integral
+ *                constant exponents up to 4 and +-0.5 are expanded into multiplies and sqrt instead.
+ */
+#ifndef TVM_CODEGEN_LLVM_VECTOR_MATH_H_
+#define TVM_CODEGEN_LLVM_VECTOR_MATH_H_
+#ifdef TVM_LLVM_VERSION
+
+#include <tvm/expr.h>
+
+namespace air {
+namespace codegen {
+Expr FastExp(const Expr &x);
+Expr FastLog(const Expr &x);
+Expr FastTanh(const Expr &x);
+Expr FastSigmoid(const Expr &x);
+Expr FastErf(const Expr &x);
+Expr FastRsqrt(const Expr &x);
+Expr FastPow(const Expr &x, const Expr &y);
+// float16 and float32 values have a fast version.
+bool HasFastMath(const Type &t);
+}  // namespace codegen
+}  // namespace air
+
+#endif  // TVM_LLVM_VERSION
+#endif  // TVM_CODEGEN_LLVM_VECTOR_MATH_H_